@@ -0,0 +1,328 @@
+/**************************************************************************************************
+  Filename:       bench_power.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Energy model. Runs the same long run under each power
+                  setting on the host simulation, with the phone staying
+                  connected or going away after the write, and counts what
+                  the device woke for: connection and advertising events,
+                  application wakes, time the power manager was held and
+                  time a line was pulled. A charge per item for the CC2540
+                  turns that into mAh per 1000 frames. Exits non-zero when a
+                  case misses a frame.
+
+                  bench_power [-f frames] [-e exposure_ms]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bcomdef.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter line of channel 0, active low
+#define POWER_SHUTTER                       BV(1)
+
+// The first frame comes this long after the write
+#define POWER_DELAY_MS                      1000
+
+// Charge model of the CC2540 at 3 V, uC per item and uA while in a state:
+// a connection event with empty packets, an advertising event on all three
+// channels, the crystal start and a short run for an application timer,
+// the MCU kept running while the power manager is held (a Timer 1 pulse
+// stops in PM2), PM2 between all of those, and the camera's shutter input
+// pulled through the line driver
+#define POWER_CONN_EVENT_UC                 18.0
+#define POWER_ADV_EVENT_UC                  30.0
+#define POWER_WAKE_UC                       4.0
+#define POWER_HELD_UA                       6700.0
+#define POWER_SLEEP_UA                      1.0
+#define POWER_LINE_UA                       1000.0
+
+// uC in a mAh
+#define POWER_UC_PER_MAH                    3600000.0
+
+#define POWER_INTERVALS                     3
+
+#define SEC                                 1000UL
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    const char *name;
+    uint8 mode;         // BLESHUTTER_POWER_*
+    uint8 alone;        // the phone goes away after the write
+} powerCase_t;
+
+typedef struct
+{
+    uint32 frames;
+    uint32 connEvents;
+    uint32 advEvents;
+    uint32 wakes;
+    uint64_t heldUs;
+    uint64_t lineUs;
+    uint64_t runUs;
+} powerResult_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static CONST powerCase_t powerCases[] =
+{
+    { "normal, connected", BLESHUTTER_POWER_NORMAL, FALSE },
+    { "save, connected",   BLESHUTTER_POWER_SAVE,   FALSE },
+    { "normal, alone",     BLESHUTTER_POWER_NORMAL, TRUE },
+    { "save, alone",       BLESHUTTER_POWER_SAVE,   TRUE },
+};
+
+// Shooting intervals, ms
+static CONST uint32 powerIntervals[POWER_INTERVALS] = { 10 * SEC, 60 * SEC, 600 * SEC };
+
+static uint32 powerFrames = 100;
+static uint32 powerExposure = 100;  // ms
+
+// Measuring the case in this process
+static powerResult_t caseResult;
+static uint64_t casePress;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void powerRun( CONST powerCase_t *pPower, uint32 interval, powerResult_t *pResult );
+static void powerEdge( uint64_t timeUs, uint8 port, uint8 changed );
+static double powerCharge( CONST powerResult_t *pResult );
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run every setting at every interval in a child process and
+ *          print the charge per 1000 frames.
+ *
+ * @return  0 when every case took every frame
+ */
+int main( int argc, char **argv )
+{
+    static powerResult_t results[sizeof( powerCases ) / sizeof( powerCases[0] )][POWER_INTERVALS];
+    uint32 failed = 0;
+    uint32 c;
+    uint32 i;
+
+    for ( i = 1; i < (uint32)argc; i += 2 )
+    {
+        const char *pArg = argv[i];
+        const char *pValue = (i + 1 < (uint32)argc) ? argv[i + 1] : NULL;
+
+        if ( pValue == NULL || pArg[0] != '-' || strlen( pArg ) != 2 ||
+             strchr( "fe", pArg[1] ) == NULL )
+        {
+            fprintf( stderr, "usage: %s [-f frames] [-e exposure_ms]\n", argv[0] );
+            return ( 2 );
+        }
+
+        switch ( pArg[1] )
+        {
+            case 'f': powerFrames = strtoul( pValue, NULL, 0 ); break;
+            case 'e': powerExposure = strtoul( pValue, NULL, 0 ); break;
+        }
+    }
+
+    powerFrames = MAX( 1, MIN( powerFrames, 0xFFFF ) );
+    powerExposure = MAX( 1, powerExposure );
+
+    printf( "%u frames of %u ms; %.0f uC per connection event, %.0f uC per advertising event,\n"
+            "%.0f uC per wake, %.0f uA held, %.0f uA asleep, %.0f uA while a line is pulled\n\n",
+            powerFrames, powerExposure, POWER_CONN_EVENT_UC, POWER_ADV_EVENT_UC, POWER_WAKE_UC,
+            POWER_HELD_UA, POWER_SLEEP_UA, POWER_LINE_UA );
+
+    printf( "mAh per 1000 frames at an interval of" );
+    for ( i = 0; i < POWER_INTERVALS; i++ )
+    {
+        printf( " %8lus", (unsigned long)(powerIntervals[i] / SEC) );
+    }
+    printf( "\n" );
+
+    for ( c = 0; c < sizeof( powerCases ) / sizeof( powerCases[0] ); c++ )
+    {
+        uint8 pass = TRUE;
+
+        printf( "%-37s", powerCases[c].name );
+        for ( i = 0; i < POWER_INTERVALS; i++ )
+        {
+            powerRun( &powerCases[c], powerIntervals[i], &results[c][i] );
+            pass &= (results[c][i].frames == powerFrames);
+            printf( " %9.3f", powerCharge( &results[c][i] ) * 1000 / powerFrames / POWER_UC_PER_MAH );
+            fflush( stdout );
+        }
+        printf( " %s\n", pass ? "ok" : "FAIL" );
+        failed += !pass;
+    }
+
+    // What the charge is made of at the longest interval
+    printf( "\nat %lus, per frame:     conn   adv  wakes  held_ms  line_ms\n",
+            (unsigned long)(powerIntervals[POWER_INTERVALS - 1] / SEC) );
+    for ( c = 0; c < sizeof( powerCases ) / sizeof( powerCases[0] ); c++ )
+    {
+        CONST powerResult_t *pResult = &results[c][POWER_INTERVALS - 1];
+        double frames = MAX( pResult->frames, 1 );
+
+        printf( "%-20s %9.1f %5.0f %6.1f %8.1f %8.1f\n", powerCases[c].name,
+                pResult->connEvents / frames, pResult->advEvents / frames, pResult->wakes / frames,
+                pResult->heldUs / frames / 1000, pResult->lineUs / frames / 1000 );
+    }
+
+    printf( "\n%u failed\n", failed );
+
+    return ( failed != 0 );
+}
+
+/*********************************************************************
+ * @fn      powerRun
+ *
+ * @brief   Run one setting on a fresh device in a child process, from
+ *          the write (or the phone leaving) to the last release.
+ *
+ * @param   pPower - the setting
+ * @param   interval - shooting interval, ms
+ * @param   pResult - filled in with what the device woke for
+ *
+ * @return  none
+ */
+static void powerRun( CONST powerCase_t *pPower, uint32 interval, powerResult_t *pResult )
+{
+    int fd[2];
+    pid_t pid;
+
+    memset( pResult, 0, sizeof( *pResult ) );
+    fflush( NULL );
+
+    if ( pipe( fd ) != 0 || (pid = fork()) < 0 )
+    {
+        perror( "fork" );
+        exit( 2 );
+    }
+
+    if ( pid == 0 )
+    {
+        uint64_t start;
+        uint64_t heldUs;
+        uint32 connEvents;
+        uint32 advEvents;
+        uint32 wakes;
+        uint8 mode = pPower->mode;
+
+        close( fd[0] );
+
+        DCBSHost_Init();
+        DCBSHost_SetEdgeCB( powerEdge );
+
+        // The phone connects, picks the setting, writes the run and
+        // either stays or goes
+        DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+        DCBSHost_Run( 1000 );
+        DCBSHost_Write( BLESHUTTER_POWER_UUID, &mode, BLESHUTTER_POWER_LEN, 0 );
+        DCBSHost_Shoot( (uint16)powerFrames, POWER_DELAY_MS, powerExposure, interval, 0, BV(0) );
+        if ( pPower->alone )
+        {
+            DCBSHost_Disconnect();
+        }
+
+        start = DCBSHost_Now();
+        connEvents = DCBSHost_ConnEvents();
+        advEvents = DCBSHost_AdvEvents();
+        wakes = DCBSHost_Wakes();
+        heldUs = DCBSHost_PowerHeldUs();
+
+        DCBSHost_Run( POWER_DELAY_MS + (powerFrames - 1) * (powerExposure + interval) +
+                      powerExposure + 1000 );
+
+        caseResult.runUs = DCBSHost_Now() - start;
+        caseResult.connEvents = DCBSHost_ConnEvents() - connEvents;
+        caseResult.advEvents = DCBSHost_AdvEvents() - advEvents;
+        caseResult.wakes = DCBSHost_Wakes() - wakes;
+        caseResult.heldUs = DCBSHost_PowerHeldUs() - heldUs;
+
+        if ( write( fd[1], &caseResult, sizeof( caseResult ) ) != sizeof( caseResult ) )
+        {
+            _exit( 2 );
+        }
+        _exit( 0 );
+    }
+
+    close( fd[1] );
+    if ( read( fd[0], pResult, sizeof( *pResult ) ) != sizeof( *pResult ) )
+    {
+        // The child crashed, nothing was measured
+        memset( pResult, 0, sizeof( *pResult ) );
+    }
+    close( fd[0] );
+    waitpid( pid, NULL, 0 );
+}
+
+/*********************************************************************
+ * @fn      powerEdge
+ *
+ * @brief   Shutter line changed: count the frame and how long it was
+ *          pulled.
+ *
+ * @param   timeUs - device time
+ * @param   port - new level of every line
+ * @param   changed - lines that changed
+ *
+ * @return  none
+ */
+static void powerEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( !(changed & POWER_SHUTTER) )
+    {
+        return;
+    }
+
+    if ( !(port & POWER_SHUTTER) )
+    {
+        casePress = timeUs;
+        caseResult.frames++;
+    }
+    else
+    {
+        caseResult.lineUs += timeUs - casePress;
+    }
+}
+
+/*********************************************************************
+ * @fn      powerCharge
+ *
+ * @brief   Charge drawn over a run.
+ *
+ * @param   pResult - what the device woke for
+ *
+ * @return  uC
+ */
+static double powerCharge( CONST powerResult_t *pResult )
+{
+    return ( pResult->connEvents * POWER_CONN_EVENT_UC +
+             pResult->advEvents * POWER_ADV_EVENT_UC +
+             pResult->wakes * POWER_WAKE_UC +
+             pResult->heldUs * POWER_HELD_UA / 1000000 +
+             pResult->runUs * POWER_SLEEP_UA / 1000000 +
+             pResult->lineUs * POWER_LINE_UA / 1000000 );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,447 @@
+/**************************************************************************************************
+  Filename:       bench_sync.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Multi-adaptor sync simulation. Several adaptors, each on its
+                  own crystal error and powered on at a different time, are
+                  kept on the phone's clock with SYNC / FOLLOW_UP over links
+                  with random latency, then given the same SYNCED Shooting
+                  value. Every adaptor runs in its own process on the host
+                  simulation; their shutter presses are brought back to true
+                  time and compared with the master schedule and with each
+                  other. Exits non-zero when an adaptor misses a frame or the
+                  spread goes past the limit.
+
+                  bench_sync [-n adaptors] [-i conn_interval_ms] [-s sync_s]
+                             [-d minutes] [-r seed] [-l limit_us]
+                             [-c frames.csv]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bcomdef.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Sync.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter line of channel 0, active low
+#define SIM_SHUTTER                         BV(1)
+
+#define SIM_MAX_ADAPTORS                    8
+#define SIM_MAX_FRAMES                      4096
+
+// The phone starts syncing 10 s in and writes the run 2 min later, for a
+// first frame 10 s after that, every 10 s
+#define SIM_SYNC_START_US                   10000000ULL
+#define SIM_WRITE_US                        130000000ULL
+#define SIM_FIRST_FRAME_MS                  140000UL
+#define SIM_EXPOSURE_MS                     100
+#define SIM_PERIOD_MS                       10000UL
+
+// Time to handle a response and send the next write on the phone, us
+#define SIM_PHONE_US                        1000
+
+#define SEC                                 1000000ULL
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    uint32 frames;
+    int16 skew;         // estimate at the end, DCBS_SYNC_SKEW_SHIFT units
+    int16 lastError;    // phase error of the last sample, ms
+    int64_t press[SIM_MAX_FRAMES];  // true time of each press, us
+} simResult_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Crystal errors and power on times of the adaptors
+static CONST int32 simPpm[SIM_MAX_ADAPTORS] = { 40, -35, 12, -20, 50, -50, 5, -8 };
+static CONST uint64_t simBoot[SIM_MAX_ADAPTORS] =
+{
+    0, 1370000, 2810000, 450000, 3990000, 730000, 2020000, 3300000
+};
+
+static uint32 simAdaptors = 4;
+static uint32 simInterval = 15;     // ms
+static uint32 simSyncPeriod = 5;    // s, 0 syncs only until the run is written
+static uint32 simMinutes = 60;
+static uint32 simSeed = 1;
+static int64_t simLimit = 10000;    // us
+static const char *simCsv = NULL;
+
+// The adaptor simulated in this process
+static uint64_t simBootUs;
+static simResult_t simResult;
+static uint32 simRand;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void simAdaptor( uint8 n, uint32 frames, simResult_t *pResult );
+static void simEdge( uint64_t timeUs, uint8 port, uint8 changed );
+static void simRunTo( uint64_t trueUs );
+static void simSync( uint8 seq, uint64_t sendUs );
+static uint32 simLatency( void );
+static int simCompare( const void *a, const void *b );
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Simulate every adaptor in a child process, then compare their
+ *          frames.
+ *
+ * @return  0 when every adaptor took every frame within the limit
+ */
+int main( int argc, char **argv )
+{
+    static simResult_t results[SIM_MAX_ADAPTORS];
+    static int64_t spread[SIM_MAX_FRAMES];
+    int64_t worst[SIM_MAX_ADAPTORS];
+    FILE *pCsv = NULL;
+    uint32 frames;
+    uint32 failed = 0;
+    uint32 f;
+    uint8 n;
+
+    for ( f = 1; f < (uint32)argc; f += 2 )
+    {
+        const char *pArg = argv[f];
+        const char *pValue = (f + 1 < (uint32)argc) ? argv[f + 1] : NULL;
+
+        if ( pValue == NULL || pArg[0] != '-' || strlen( pArg ) != 2 ||
+             strchr( "nisdrlc", pArg[1] ) == NULL )
+        {
+            fprintf( stderr, "usage: %s [-n adaptors] [-i conn_interval_ms] [-s sync_s] "
+                             "[-d minutes] [-r seed] [-l limit_us] [-c frames.csv]\n", argv[0] );
+            return ( 2 );
+        }
+
+        switch ( pArg[1] )
+        {
+            case 'n': simAdaptors = strtoul( pValue, NULL, 0 ); break;
+            case 'i': simInterval = strtoul( pValue, NULL, 0 ); break;
+            case 's': simSyncPeriod = strtoul( pValue, NULL, 0 ); break;
+            case 'd': simMinutes = strtoul( pValue, NULL, 0 ); break;
+            case 'r': simSeed = strtoul( pValue, NULL, 0 ); break;
+            case 'l': simLimit = strtoll( pValue, NULL, 0 ); break;
+            case 'c': simCsv = pValue; break;
+        }
+    }
+
+    simAdaptors = MAX( 2, MIN( simAdaptors, SIM_MAX_ADAPTORS ) );
+    simInterval = MAX( 8, simInterval );
+    frames = MIN( simMinutes * 60000UL / SIM_PERIOD_MS, SIM_MAX_FRAMES );
+    frames = MAX( frames, 1 );
+
+    printf( "%u adaptors, %u ms connection interval, ", simAdaptors, simInterval );
+    if ( simSyncPeriod )
+    {
+        printf( "SYNC every %u s", simSyncPeriod );
+    }
+    else
+    {
+        printf( "no SYNC once the run is written" );
+    }
+    printf( ", %u frames every %lu s; limit %lld us\n\n", frames, SIM_PERIOD_MS / 1000,
+            (long long)simLimit );
+
+    for ( n = 0; n < simAdaptors; n++ )
+    {
+        simAdaptor( n, frames, &results[n] );
+        worst[n] = 0;
+    }
+
+    if ( simCsv != NULL && (pCsv = fopen( simCsv, "w" )) != NULL )
+    {
+        fprintf( pCsv, "frame,adaptor,error_us\n" );
+    }
+
+    // Every frame against the master schedule, and the spread across adaptors
+    for ( f = 0; f < frames; f++ )
+    {
+        int64_t ideal = (int64_t)(SIM_FIRST_FRAME_MS + f * SIM_PERIOD_MS) * 1000;
+        int64_t lo = INT64_MAX;
+        int64_t hi = INT64_MIN;
+
+        for ( n = 0; n < simAdaptors; n++ )
+        {
+            int64_t error;
+
+            if ( f >= results[n].frames )
+            {
+                continue;
+            }
+
+            error = results[n].press[f] - ideal;
+            worst[n] = MAX( worst[n], llabs( error ) );
+            lo = MIN( lo, error );
+            hi = MAX( hi, error );
+
+            if ( pCsv != NULL )
+            {
+                fprintf( pCsv, "%u,%u,%lld\n", f, n, (long long)error );
+            }
+        }
+        spread[f] = (hi >= lo) ? hi - lo : INT64_MAX;
+    }
+
+    if ( pCsv != NULL )
+    {
+        fclose( pCsv );
+    }
+
+    printf( "%-8s %6s %10s %10s %8s %10s %s\n", "adaptor", "ppm", "skew_ppm", "phase_ms",
+            "frames", "max_us", "" );
+    for ( n = 0; n < simAdaptors; n++ )
+    {
+        uint8 ok = (results[n].frames == frames);
+
+        failed += !ok;
+        printf( "%-8u %6d %10.1f %10d %8u %10lld %s\n", n, simPpm[n],
+                // Skew is master per local minus one, a fast crystal reads negative
+                (double)results[n].skew * 1e6 / (1UL << DCBS_SYNC_SKEW_SHIFT),
+                results[n].lastError, results[n].frames, (long long)worst[n],
+                ok ? "ok" : "FAIL" );
+    }
+
+    qsort( spread, frames, sizeof( spread[0] ), simCompare );
+    printf( "\nspread between adaptors: p50 %lld us, p99 %lld us, max %lld us %s\n",
+            (long long)spread[(frames - 1) / 2], (long long)spread[(frames * 99 + 99) / 100 - 1],
+            (long long)spread[frames - 1], (spread[frames - 1] <= simLimit) ? "ok" : "FAIL" );
+    failed += (spread[frames - 1] > simLimit);
+
+    return ( failed != 0 );
+}
+
+/*********************************************************************
+ * @fn      simAdaptor
+ *
+ * @brief   Simulate one adaptor from power on to the end of the run in a
+ *          child process.
+ *
+ * @param   n - adaptor number, picks its crystal, power on time and link
+ * @param   frames - frames in the run
+ * @param   pResult - filled in with its presses
+ *
+ * @return  none
+ */
+static void simAdaptor( uint8 n, uint32 frames, simResult_t *pResult )
+{
+    int fd[2];
+    pid_t pid;
+
+    memset( pResult, 0, sizeof( *pResult ) );
+    fflush( NULL );
+
+    if ( pipe( fd ) != 0 || (pid = fork()) < 0 )
+    {
+        perror( "fork" );
+        exit( 2 );
+    }
+
+    if ( pid == 0 )
+    {
+        uint64_t endUs = (SIM_FIRST_FRAME_MS + frames * SIM_PERIOD_MS) * 1000ULL + 10 * SEC;
+        uint64_t syncUs = SIM_SYNC_START_US;
+        uint8 written = FALSE;
+        uint8 seq = 0;
+        uint8 state[BLESHUTTER_SYNC_STATE_LEN];
+        uint8 len;
+        ssize_t left = sizeof( simResult );
+        uint8 *p = (uint8 *)&simResult;
+
+        close( fd[0] );
+        simBootUs = simBoot[n];
+        simRand = 0x2545F491 * (n + 1) ^ simSeed;
+
+        DCBSHost_Init();
+        DCBSHost_SetDrift( simPpm[n] );
+        DCBSHost_SetEdgeCB( simEdge );
+        DCBSHost_Connect( (uint16)(simInterval * 1000 / 1250) );
+
+        while ( syncUs < endUs )
+        {
+            if ( !written && syncUs >= SIM_WRITE_US )
+            {
+                simRunTo( SIM_WRITE_US + simLatency() );
+                DCBSHost_Shoot( (uint16)frames, SIM_FIRST_FRAME_MS, SIM_EXPOSURE_MS,
+                                SIM_PERIOD_MS - SIM_EXPOSURE_MS,
+                                BLESHUTTER_SHOOTING_OPT_ANCHORED | BLESHUTTER_SHOOTING_OPT_SYNCED,
+                                BV(0) );
+                written = TRUE;
+            }
+
+            if ( written && simSyncPeriod == 0 )
+            {
+                break;
+            }
+
+            // The phone goes round the adaptors one after another
+            simSync( seq++, syncUs + n * 4 * simInterval * 1000 );
+            syncUs += (simSyncPeriod ? simSyncPeriod : 5) * SEC;
+        }
+        simRunTo( endUs );
+
+        if ( DCBSHost_Read( BLESHUTTER_SYNC_UUID, state, &len, 0 ) == SUCCESS &&
+             len == BLESHUTTER_SYNC_STATE_LEN )
+        {
+            simResult.skew = (int16)BUILD_UINT16( state[1], state[2] );
+            simResult.lastError = (int16)BUILD_UINT16( state[3], state[4] );
+        }
+
+        while ( left > 0 )
+        {
+            ssize_t done = write( fd[1], p, left );
+
+            if ( done <= 0 )
+            {
+                _exit( 2 );
+            }
+            p += done;
+            left -= done;
+        }
+        _exit( 0 );
+    }
+
+    close( fd[1] );
+    {
+        ssize_t left = sizeof( *pResult );
+        uint8 *p = (uint8 *)pResult;
+
+        while ( left > 0 )
+        {
+            ssize_t done = read( fd[0], p, left );
+
+            if ( done <= 0 )
+            {
+                // The child crashed, count no frames
+                memset( pResult, 0, sizeof( *pResult ) );
+                break;
+            }
+            p += done;
+            left -= done;
+        }
+    }
+    close( fd[0] );
+    waitpid( pid, NULL, 0 );
+}
+
+/*********************************************************************
+ * @fn      simSync
+ *
+ * @brief   One SYNC / FOLLOW_UP exchange as the phone runs it. The SYNC
+ *          write and its response each wait for a connection event, so
+ *          the two legs of the round trip differ.
+ *
+ * @param   seq - sequence number
+ * @param   sendUs - true time the phone sends the SYNC
+ *
+ * @return  none
+ */
+static void simSync( uint8 seq, uint64_t sendUs )
+{
+    uint8 value[BLESHUTTER_SYNC_LEN];
+    uint64_t arriveUs = sendUs + simLatency();
+    uint64_t backUs = arriveUs + simLatency();
+    uint32 rttMs = (uint32)((backUs - sendUs + 500) / 1000);
+    uint32 master = (uint32)((sendUs + backUs) / 2 / 1000);
+
+    simRunTo( arriveUs );
+    value[0] = BLESHUTTER_SYNC_SYNC;
+    value[1] = seq;
+    DCBSHost_Write( BLESHUTTER_SYNC_UUID, value, 2, 0 );
+
+    simRunTo( backUs + SIM_PHONE_US + simLatency() );
+    value[0] = BLESHUTTER_SYNC_FOLLOW_UP;
+    value[1] = seq;
+    value[2] = BREAK_UINT32( master, 0 );
+    value[3] = BREAK_UINT32( master, 1 );
+    value[4] = BREAK_UINT32( master, 2 );
+    value[5] = BREAK_UINT32( master, 3 );
+    value[6] = LO_UINT16( rttMs );
+    value[7] = HI_UINT16( rttMs );
+    DCBSHost_Write( BLESHUTTER_SYNC_UUID, value, BLESHUTTER_SYNC_LEN, 0 );
+}
+
+/*********************************************************************
+ * @fn      simLatency
+ *
+ * @brief   Time a packet waits for a connection event and goes over the
+ *          air, us.
+ *
+ * @return  latency
+ */
+static uint32 simLatency( void )
+{
+    simRand ^= simRand << 13;
+    simRand ^= simRand >> 17;
+    simRand ^= simRand << 5;
+
+    return ( simRand % (simInterval * 1000) + 500 );
+}
+
+/*********************************************************************
+ * @fn      simRunTo
+ *
+ * @brief   Run the adaptor up to a true time.
+ *
+ * @param   trueUs - true time, us
+ *
+ * @return  none
+ */
+static void simRunTo( uint64_t trueUs )
+{
+    DCBSHost_RunUntil( (trueUs > simBootUs) ? DCBSHost_DeviceTime( trueUs - simBootUs ) : 0 );
+}
+
+/*********************************************************************
+ * @fn      simEdge
+ *
+ * @brief   Shutter line changed: note the true time of a press.
+ *
+ * @param   timeUs - device time
+ * @param   port - new level of every line
+ * @param   changed - lines that changed
+ *
+ * @return  none
+ */
+static void simEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( (changed & SIM_SHUTTER) && !(port & SIM_SHUTTER) && simResult.frames < SIM_MAX_FRAMES )
+    {
+        simResult.press[simResult.frames++] = (int64_t)(DCBSHost_TrueTime( timeUs ) + simBootUs);
+    }
+}
+
+/*********************************************************************
+ * @fn      simCompare
+ *
+ * @brief   Order spreads for qsort.
+ */
+static int simCompare( const void *a, const void *b )
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return ( (x > y) - (x < y) );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,495 @@
+/**************************************************************************************************
+  Filename:       bench_timing.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Shutter timing benchmark. Replays a matrix of Shooting
+                  values on the host simulation, each on a fresh device in
+                  its own process, with stack task load injected, and
+                  measures every frame on the shutter line: how far each
+                  press lands from where the value puts it (drift), how far
+                  the last one has moved (schedule skew) and how long each
+                  exposure really was. Exits non-zero when a case misses a
+                  frame or goes past the limit, so timing regressions can
+                  gate a change.
+
+                  bench_timing [-p period_us] [-h hold_us] [-s seed]
+                               [-l limit_us] [-c frames.csv]
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bcomdef.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter line of channel 0, active low
+#define BENCH_SHUTTER                       BV(1)
+
+#define BENCH_BULB                          0xFFFFFFFF
+
+// Every case starts its first frame this long after the write
+#define BENCH_DELAY_MS                      1000
+
+// A bulb frame is held this long, then stopped
+#define BENCH_BULB_HOLD_MS                  30000
+
+#define BENCH_MAX_FRAMES                    10000
+
+// Default stack task load: up to 2.5 ms of every 7.5 ms connection event
+#define BENCH_LOAD_PERIOD_US                7500
+#define BENCH_LOAD_HOLD_US                  2500
+
+// The task runs on a 1 ms clock, a frame may land up to 1 ms past the load
+// it waited for, and the windows of two periods may meet
+#define BENCH_CLOCK_US                      1000
+#define BENCH_LIMIT( hold )                 ( 2 * (int64_t)(hold) + BENCH_CLOCK_US )
+
+// Drift histogram bins, upper bounds in us
+#define BENCH_BINS                          10
+
+#define MINUTE                              (60UL * 1000)
+#define HOUR                                (60 * MINUTE)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    const char *name;
+    uint16 count;
+    uint32 exposure;    // ms, us with BLESHUTTER_SHOOTING_OPT_EXPOSURE_US
+    uint32 interval;    // ms
+    uint8 options;
+} benchCase_t;
+
+typedef struct
+{
+    uint32 frames;
+    int64_t p50;        // |drift| percentiles, us
+    int64_t p99;
+    int64_t max;
+    int64_t skew;       // last press against the anchored schedule, us
+    int64_t exposureMax;    // largest |exposure error|, us
+    uint16 deviceMaxMs; // the device's own worst lateness, Timing characteristic
+    uint32 hist[BENCH_BINS];
+    double seconds;     // host time the case took
+} benchResult_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static CONST benchCase_t benchCases[] =
+{
+    { "1x100ms",     1,    100,       100,        BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10x100ms",    10,   100,       100,        BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "100x100ms",   100,  100,       100,        BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1000x100ms",  1000, 100,       100,        BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10000x100ms", 10000, 100,       100,        BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1x1s",        1,    100,       1000,       BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10x1s",       10,   100,       1000,       BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "100x1s",      100,  100,       1000,       BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1000x1s",     1000, 100,       1000,       BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10000x1s",    10000, 100,       1000,       BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1x10min",     1,    100,       10 * MINUTE, BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10x10min",    10,   100,       10 * MINUTE, BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "100x10min",   100,  100,       10 * MINUTE, BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1000x10min",  1000, 100,       10 * MINUTE, BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10000x10min", 10000, 100,       10 * MINUTE, BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1x2h",        1,    100,       2 * HOUR,   BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10x2h",       10,   100,       2 * HOUR,   BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "100x2h",      100,  100,       2 * HOUR,   BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1000x2h",     1000, 100,       2 * HOUR,   BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "10000x2h",    10000, 100,       2 * HOUR,   BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "default-exp", 100,  0,         1000,       BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "bulb",        1,    BENCH_BULB, 0,          BLESHUTTER_SHOOTING_OPT_ANCHORED },
+    { "1ms-pulse",   1000, 1000,      100,        BLESHUTTER_SHOOTING_OPT_ANCHORED |
+                                                           BLESHUTTER_SHOOTING_OPT_EXPOSURE_US },
+    { "relative-1s", 1000, 100,       1000,       0 },
+};
+
+// Upper bounds of the drift histogram bins after "<0" and "0", us; the
+// last bin is open
+static CONST int64_t benchBinLimit[BENCH_BINS - 3] = { 10, 100, 1000, 2000, 5000, 10000, 100000 };
+static CONST char *benchBinName[BENCH_BINS] =
+{
+    "<0", "0", "<10us", "<100us", "<1ms", "<2ms", "<5ms", "<10ms", "<100ms", ">=100ms"
+};
+
+static uint32 benchPeriod = BENCH_LOAD_PERIOD_US;
+static uint32 benchHold = BENCH_LOAD_HOLD_US;
+static uint32 benchSeed = 1;
+static int64_t benchLimit = -1;
+static const char *benchCsv = NULL;
+
+// Measuring the case in this process
+static CONST benchCase_t *pCase;
+static uint64_t caseStart;          // device time of the write, us
+static uint64_t caseExposureUs;
+static uint64_t casePress;
+static uint64_t caseRelease;
+static uint32 casePresses;
+static int64_t caseDrift[BENCH_MAX_FRAMES];
+static benchResult_t caseResult;
+static FILE *caseCsv = NULL;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void benchEdge( uint64_t timeUs, uint8 port, uint8 changed );
+static void benchRun( CONST benchCase_t *pBench, uint32 index, benchResult_t *pResult );
+static uint64_t benchIdeal( uint32 frame );
+static int benchCompare( const void *a, const void *b );
+static uint8 benchBin( int64_t drift );
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run every case in a child process and print the results.
+ *
+ * @return  0 when every case passed
+ */
+int main( int argc, char **argv )
+{
+    uint32 failed = 0;
+    uint32 i;
+    uint8 b;
+
+    for ( i = 1; i < (uint32)argc; i++ )
+    {
+        const char *pArg = argv[i];
+        const char *pValue = (i + 1 < (uint32)argc) ? argv[i + 1] : NULL;
+
+        if ( pValue == NULL || pArg[0] != '-' || strlen( pArg ) != 2 ||
+             strchr( "phslc", pArg[1] ) == NULL )
+        {
+            fprintf( stderr, "usage: %s [-p period_us] [-h hold_us] [-s seed] "
+                             "[-l limit_us] [-c frames.csv]\n", argv[0] );
+            return ( 2 );
+        }
+
+        switch ( pArg[1] )
+        {
+            case 'p': benchPeriod = strtoul( pValue, NULL, 0 ); break;
+            case 'h': benchHold = strtoul( pValue, NULL, 0 ); break;
+            case 's': benchSeed = strtoul( pValue, NULL, 0 ); break;
+            case 'l': benchLimit = strtoll( pValue, NULL, 0 ); break;
+            case 'c': benchCsv = pValue; break;
+        }
+        i++;
+    }
+
+    if ( benchLimit < 0 )
+    {
+        benchLimit = BENCH_LIMIT( benchPeriod ? benchHold : 0 );
+    }
+
+    if ( benchCsv != NULL )
+    {
+        FILE *pFile = fopen( benchCsv, "w" );
+
+        if ( pFile == NULL )
+        {
+            perror( benchCsv );
+            return ( 2 );
+        }
+        fprintf( pFile, "case,frame,press_us,drift_us,exposure_error_us\n" );
+        fclose( pFile );
+    }
+
+    printf( "load: up to %u us of every %u us, seed %u; limit %lld us\n\n",
+            benchHold, benchPeriod, benchSeed, (long long)benchLimit );
+    printf( "%-12s %6s %6s %9s %9s %9s %10s %9s %7s %7s %s\n", "case", "count", "frames",
+            "p50_us", "p99_us", "max_us", "skew_us", "exp_us", "dev_ms", "host_s", "" );
+
+    for ( i = 0; i < sizeof( benchCases ) / sizeof( benchCases[0] ); i++ )
+    {
+        CONST benchCase_t *pBench = &benchCases[i];
+        benchResult_t result;
+        uint8 pass;
+
+        benchRun( pBench, i, &result );
+
+        pass = (result.frames == pBench->count) &&
+               (result.max <= benchLimit) &&
+               (result.exposureMax <= benchLimit) &&
+               (!(pBench->options & BLESHUTTER_SHOOTING_OPT_ANCHORED) ||
+                llabs( result.skew ) <= benchLimit);
+        failed += !pass;
+
+        printf( "%-12s %6u %6u %9lld %9lld %9lld %10lld %9lld %7u %7.2f %s\n",
+                pBench->name, pBench->count, result.frames,
+                (long long)result.p50, (long long)result.p99, (long long)result.max,
+                (long long)result.skew, (long long)result.exposureMax,
+                result.deviceMaxMs, result.seconds, pass ? "ok" : "FAIL" );
+
+        // Drift histogram, only the bins with frames
+        printf( "%12s", "" );
+        for ( b = 0; b < BENCH_BINS; b++ )
+        {
+            if ( result.hist[b] )
+            {
+                printf( " %s:%u", benchBinName[b], result.hist[b] );
+            }
+        }
+        printf( "\n" );
+        fflush( stdout );
+    }
+
+    printf( "\n%u failed\n", failed );
+
+    return ( failed != 0 );
+}
+
+/*********************************************************************
+ * @fn      benchRun
+ *
+ * @brief   Run one case on a fresh device in a child process.
+ *
+ * @param   pBench - the case
+ * @param   index - its number, seeds the load
+ * @param   pResult - filled in with what was measured
+ *
+ * @return  none
+ */
+static void benchRun( CONST benchCase_t *pBench, uint32 index, benchResult_t *pResult )
+{
+    int fd[2];
+    pid_t pid;
+
+    memset( pResult, 0, sizeof( *pResult ) );
+    fflush( NULL );
+
+    if ( pipe( fd ) != 0 || (pid = fork()) < 0 )
+    {
+        perror( "fork" );
+        exit( 2 );
+    }
+
+    if ( pid == 0 )
+    {
+        uint64_t runUs;
+        uint8 timing[BLESHUTTER_TIMING_LEN];
+        clock_t began = clock();
+        uint32 n;
+
+        close( fd[0] );
+        pCase = pBench;
+        caseExposureUs = (pBench->exposure == 0) ? DCBS_DEFAULT_ACTIVE_PERIOD * 1000ULL :
+                         (pBench->options & BLESHUTTER_SHOOTING_OPT_EXPOSURE_US) ? pBench->exposure :
+                         pBench->exposure * 1000ULL;
+        caseCsv = (benchCsv != NULL) ? fopen( benchCsv, "a" ) : NULL;
+
+        DCBSHost_Init();
+        DCBSHost_SetLoad( benchPeriod, benchHold, benchSeed + index );
+        DCBSHost_SetEdgeCB( benchEdge );
+
+        // The phone connects, writes the value and stays connected
+        DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+        DCBSHost_Run( 1000 );
+        caseStart = DCBSHost_Now();
+        DCBSHost_Shoot( pBench->count, BENCH_DELAY_MS, pBench->exposure, pBench->interval,
+                        pBench->options, BV(0) );
+
+        if ( pBench->exposure == BENCH_BULB )
+        {
+            uint8 stop = 0;
+
+            DCBSHost_Run( BENCH_DELAY_MS + BENCH_BULB_HOLD_MS );
+            caseExposureUs = DCBSHost_Now() - casePress;
+            DCBSHost_Write( BLESHUTTER_STOP_UUID, &stop, sizeof( stop ), 0 );
+            caseResult.frames = casePresses;
+        }
+        else
+        {
+            // Up to the last frame's release, plus the limit for every
+            // frame, as a relative run adds up what each one is late
+            runUs = ((uint64_t)BENCH_DELAY_MS + (uint64_t)(pBench->count - 1) *
+                     (caseExposureUs / 1000 + pBench->interval)) * 1000 +
+                    caseExposureUs + (uint64_t)pBench->count * benchLimit + 1000000;
+            DCBSHost_RunUntil( caseStart + runUs );
+        }
+
+        if ( casePresses > 0 )
+        {
+            int64_t abs[BENCH_MAX_FRAMES];
+
+            for ( n = 0; n < casePresses; n++ )
+            {
+                abs[n] = llabs( caseDrift[n] );
+            }
+            qsort( abs, casePresses, sizeof( abs[0] ), benchCompare );
+            caseResult.p50 = abs[(casePresses - 1) / 2];
+            caseResult.p99 = abs[(casePresses * 99 + 99) / 100 - 1];
+            caseResult.max = abs[casePresses - 1];
+        }
+
+        if ( DCBSHost_ReadLong( BLESHUTTER_TIMING_UUID, timing, sizeof( timing ) ) == sizeof( timing ) )
+        {
+            caseResult.deviceMaxMs = BUILD_UINT16( timing[16], timing[17] );
+        }
+        caseResult.seconds = (double)(clock() - began) / CLOCKS_PER_SEC;
+
+        if ( caseCsv != NULL )
+        {
+            fclose( caseCsv );
+        }
+        if ( write( fd[1], &caseResult, sizeof( caseResult ) ) != sizeof( caseResult ) )
+        {
+            _exit( 2 );
+        }
+        _exit( 0 );
+    }
+
+    close( fd[1] );
+    if ( read( fd[0], pResult, sizeof( *pResult ) ) != sizeof( *pResult ) )
+    {
+        // The child crashed, nothing was measured
+        memset( pResult, 0, sizeof( *pResult ) );
+        pResult->max = INT64_MAX;
+    }
+    close( fd[0] );
+    waitpid( pid, NULL, 0 );
+}
+
+/*********************************************************************
+ * @fn      benchEdge
+ *
+ * @brief   Shutter line changed: measure the press against where the
+ *          value puts it, or the exposure just ended.
+ *
+ * @param   timeUs - device time
+ * @param   port - new level of every line
+ * @param   changed - lines that changed
+ *
+ * @return  none
+ */
+static void benchEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( !(changed & BENCH_SHUTTER) )
+    {
+        return;
+    }
+
+    if ( !(port & BENCH_SHUTTER) )
+    {
+        int64_t drift = (int64_t)(timeUs - benchIdeal( casePresses ));
+
+        casePress = timeUs;
+        if ( casePresses < BENCH_MAX_FRAMES )
+        {
+            caseDrift[casePresses] = drift;
+        }
+        caseResult.hist[benchBin( drift )]++;
+        casePresses++;
+
+        // Every press lands on the anchored schedule or the skew shows it
+        caseResult.skew = (int64_t)(timeUs - caseStart) -
+                          (int64_t)(((uint64_t)BENCH_DELAY_MS + (uint64_t)(casePresses - 1) *
+                                     (caseExposureUs / 1000 + pCase->interval)) * 1000);
+    }
+    else
+    {
+        int64_t error = (int64_t)(timeUs - casePress) - (int64_t)caseExposureUs;
+
+        caseRelease = timeUs;
+        caseResult.frames = casePresses;
+        if ( llabs( error ) > caseResult.exposureMax )
+        {
+            caseResult.exposureMax = llabs( error );
+        }
+
+        if ( caseCsv != NULL )
+        {
+            fprintf( caseCsv, "%s,%u,%llu,%lld,%lld\n", pCase->name, casePresses - 1,
+                     (unsigned long long)(casePress - caseStart),
+                     (long long)caseDrift[MIN( casePresses, BENCH_MAX_FRAMES ) - 1], (long long)error );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      benchIdeal
+ *
+ * @brief   Find where the value puts a press. An anchored run has every
+ *          frame on start + n * (exposure + interval); otherwise a frame
+ *          follows the release of the one before by the interval.
+ *
+ * @param   frame - frame number from 0
+ *
+ * @return  device time, us
+ */
+static uint64_t benchIdeal( uint32 frame )
+{
+    if ( frame == 0 )
+    {
+        return ( caseStart + BENCH_DELAY_MS * 1000ULL );
+    }
+
+    if ( pCase->options & BLESHUTTER_SHOOTING_OPT_ANCHORED )
+    {
+        return ( caseStart + (BENCH_DELAY_MS + (uint64_t)frame *
+                              (caseExposureUs / 1000 + pCase->interval)) * 1000 );
+    }
+
+    return ( caseRelease + (uint64_t)pCase->interval * 1000 );
+}
+
+/*********************************************************************
+ * @fn      benchCompare
+ *
+ * @brief   Order drifts for qsort.
+ */
+static int benchCompare( const void *a, const void *b )
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+
+    return ( (x > y) - (x < y) );
+}
+
+/*********************************************************************
+ * @fn      benchBin
+ *
+ * @brief   Find the histogram bin of a drift.
+ *
+ * @param   drift - us, negative when early
+ *
+ * @return  bin
+ */
+static uint8 benchBin( int64_t drift )
+{
+    uint8 b;
+
+    if ( drift <= 0 )
+    {
+        return ( (drift < 0) ? 0 : 1 );
+    }
+
+    for ( b = 0; b < BENCH_BINS - 3; b++ )
+    {
+        if ( drift < benchBinLimit[b] )
+        {
+            return ( b + 2 );
+        }
+    }
+
+    return ( BENCH_BINS - 1 );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,586 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Host.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the host simulation of the adaptor: the
+                  application task on the host OSAL, HAL and BLE stand-ins,
+                  seen from the outside the way a central and a logic
+                  analyser on port 0 would see it.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "att.h"
+#include "hal_mcu.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+#include "Stack/host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Attribute value bytes in a write request
+#define HOST_WRITE_LEN                      ( ATT_MTU_SIZE - 3 )
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static int32 hostDriftPpm = 0;
+
+static dcbsHostEdgeCB_t hostEdgeCB = NULL;
+static FILE *hostTraceFile = NULL;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void hostEdge( uint64_t timeUs, uint8 port, uint8 changed );
+static uint16 hostCRC16( uint8 *pData, uint8 len );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSHost_Init
+ *
+ * @brief   Reset the stand-ins, initialize the application and run its
+ *          start event. Device time starts at 0. The application's
+ *          own variables are only initialized once per process, so a
+ *          simulation runs one device from power on.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSHost_Init( void )
+{
+    osalHostReset( DCBS_HOST_TASK_ID, DSLRCameraBLEShutter_ProcessEvent );
+    halHostReset();
+    bleHostReset();
+    halHostSetEdgeCB( hostEdge );
+
+    DSLRCameraBLEShutter_Init( DCBS_HOST_TASK_ID );
+    halHostSample();
+
+    osalHostRun( 0 );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Run
+ *
+ * @brief   Run the device for a while.
+ *
+ * @param   ms - milliseconds of device time
+ *
+ * @return  none
+ */
+void DCBSHost_Run( uint32 ms )
+{
+    osalHostRun( osalHostNow() + (uint64_t)ms * 1000 );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_RunUntil
+ *
+ * @brief   Run the device up to a time. A time already passed runs
+ *          only the work that is due now.
+ *
+ * @param   timeUs - device time in microseconds
+ *
+ * @return  none
+ */
+void DCBSHost_RunUntil( uint64_t timeUs )
+{
+    osalHostRun( timeUs );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Now
+ *
+ * @brief   Get the device time.
+ *
+ * @param   none
+ *
+ * @return  microseconds since DCBSHost_Init
+ */
+uint64_t DCBSHost_Now( void )
+{
+    return ( osalHostNow() );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_SetDrift
+ *
+ * @brief   Set the crystal error of the device.
+ *
+ * @param   ppm - parts per million the device clock runs fast, negative
+ *                when it runs slow
+ *
+ * @return  none
+ */
+void DCBSHost_SetDrift( int32 ppm )
+{
+    hostDriftPpm = ppm;
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_TrueTime
+ *
+ * @brief   Convert a device time to true time.
+ *
+ * @param   deviceUs - device time in microseconds
+ *
+ * @return  true time in microseconds
+ */
+uint64_t DCBSHost_TrueTime( uint64_t deviceUs )
+{
+    return ( (uint64_t)((double)deviceUs * 1e6 / (1e6 + hostDriftPpm) + 0.5) );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_DeviceTime
+ *
+ * @brief   Convert a true time to device time.
+ *
+ * @param   trueUs - true time in microseconds
+ *
+ * @return  device time in microseconds
+ */
+uint64_t DCBSHost_DeviceTime( uint64_t trueUs )
+{
+    return ( (uint64_t)((double)trueUs * (1e6 + hostDriftPpm) / 1e6 + 0.5) );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_SetLoad
+ *
+ * @brief   Inject stack task load, see osalHostSetLoad.
+ *
+ * @param   periodUs - how often the stack task takes the CPU
+ * @param   holdUs - the longest it holds it for, 0 for no load
+ * @param   seed - varies the share taken in each period
+ *
+ * @return  none
+ */
+void DCBSHost_SetLoad( uint32 periodUs, uint32 holdUs, uint32 seed )
+{
+    osalHostSetLoad( periodUs, holdUs, seed );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_SetWork
+ *
+ * @brief   Give the application task's work a time, see osalHostSetWork.
+ *
+ * @param   workUs - time each run of the task takes, 0 for none
+ *
+ * @return  none
+ */
+void DCBSHost_SetWork( uint32 workUs )
+{
+    osalHostSetWork( workUs );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Connect
+ *
+ * @brief   Have a central connect and let the application see it.
+ *
+ * @param   interval - connection interval, 1.25 ms units
+ *
+ * @return  none
+ */
+void DCBSHost_Connect( uint16 interval )
+{
+    bleHostConnect( interval );
+    osalHostRun( osalHostNow() );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Disconnect
+ *
+ * @brief   Have the central drop the link and let the application see
+ *          it.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSHost_Disconnect( void )
+{
+    bleHostDisconnect();
+    osalHostRun( osalHostNow() );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Write
+ *
+ * @brief   Write a characteristic and run the work it causes now.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   pValue - value
+ * @param   len - its length
+ * @param   offset - offset of a long write
+ *
+ * @return  SUCCESS or the ATT error
+ */
+bStatus_t DCBSHost_Write( uint16 uuid, uint8 *pValue, uint8 len, uint16 offset )
+{
+    bStatus_t status = bleHostWrite( uuid, pValue, len, offset );
+
+    halHostSample();
+    osalHostRun( osalHostNow() );
+
+    return ( status );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Read
+ *
+ * @brief   Read a characteristic.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   pValue - buffer of ATT_MTU_SIZE bytes
+ * @param   pLen - set to the length read
+ * @param   offset - offset of a blob read
+ *
+ * @return  SUCCESS or the ATT error
+ */
+bStatus_t DCBSHost_Read( uint16 uuid, uint8 *pValue, uint8 *pLen, uint16 offset )
+{
+    return ( bleHostRead( uuid, pValue, pLen, offset ) );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_ReadLong
+ *
+ * @brief   Read a whole characteristic, blob by blob until one comes
+ *          back short, as a central's Read Long does.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   pValue - buffer
+ * @param   maxLen - its size
+ *
+ * @return  the length read, or -1 on an ATT error
+ */
+int DCBSHost_ReadLong( uint16 uuid, uint8 *pValue, uint16 maxLen )
+{
+    uint8 buf[ATT_MTU_SIZE];
+    uint16 offset = 0;
+    uint8 len;
+
+    do
+    {
+        if ( DCBSHost_Read( uuid, buf, &len, offset ) != SUCCESS )
+        {
+            return ( -1 );
+        }
+
+        memcpy( pValue + offset, buf, MIN( len, maxLen - offset ) );
+        offset += len;
+    } while ( len == ATT_MTU_SIZE - 1 && offset < maxLen );
+
+    return ( MIN( offset, maxLen ) );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Subscribe
+ *
+ * @brief   Enable or disable notifications of a characteristic.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   enable - TRUE to enable
+ *
+ * @return  SUCCESS or the ATT error
+ */
+bStatus_t DCBSHost_Subscribe( uint16 uuid, uint8 enable )
+{
+    return ( bleHostSubscribe( uuid, enable ) );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Shoot
+ *
+ * @brief   Write a Shooting value up to its channel mask.
+ *
+ * @param   count - frames
+ * @param   delay - ms before the first
+ * @param   exposure - ms, or us with BLESHUTTER_SHOOTING_OPT_EXPOSURE_US
+ * @param   interval - ms between frames
+ * @param   options - BLESHUTTER_SHOOTING_OPT_*
+ * @param   mask - channels, 0 for channel 0
+ *
+ * @return  SUCCESS or the ATT error
+ */
+bStatus_t DCBSHost_Shoot( uint16 count, uint32 delay, uint32 exposure, uint32 interval,
+                          uint8 options, uint8 mask )
+{
+    uint8 value[BLESHUTTER_SHOOTING_BASE_LEN + 2];
+    uint8 i;
+
+    value[0] = LO_UINT16( count );
+    value[1] = HI_UINT16( count );
+    for ( i = 0; i < 4; i++ )
+    {
+        value[2 + i] = BREAK_UINT32( delay, i );
+        value[6 + i] = BREAK_UINT32( exposure, i );
+        value[10 + i] = BREAK_UINT32( interval, i );
+    }
+    value[14] = options;
+    value[15] = mask;
+
+    return ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, sizeof( value ), 0 ) );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Upload
+ *
+ * @brief   Send a blob through Upload: BEGIN with its CRC, DATA records
+ *          of as much as a write request holds, then COMMIT.
+ *
+ * @param   type - BLESHUTTER_UPLOAD_TYPE_*
+ * @param   pData - the blob
+ * @param   len - its length
+ *
+ * @return  SUCCESS or the first ATT error
+ */
+bStatus_t DCBSHost_Upload( uint8 type, uint8 *pData, uint8 len )
+{
+    uint8 record[HOST_WRITE_LEN];
+    uint16 crc = hostCRC16( pData, len );
+    uint8 sent = 0;
+    bStatus_t status;
+
+    record[0] = BLESHUTTER_UPLOAD_BEGIN;
+    record[1] = type;
+    record[2] = len;
+    record[3] = 0;
+    record[4] = LO_UINT16( crc );
+    record[5] = HI_UINT16( crc );
+    status = DCBSHost_Write( BLESHUTTER_UPLOAD_UUID, record, BLESHUTTER_UPLOAD_BEGIN_LEN, 0 );
+
+    while ( status == SUCCESS && sent < len )
+    {
+        uint8 chunk = MIN( len - sent, HOST_WRITE_LEN - BLESHUTTER_UPLOAD_DATA_HDR_LEN );
+
+        record[0] = BLESHUTTER_UPLOAD_DATA;
+        record[1] = sent;
+        record[2] = 0;
+        memcpy( record + BLESHUTTER_UPLOAD_DATA_HDR_LEN, pData + sent, chunk );
+        status = DCBSHost_Write( BLESHUTTER_UPLOAD_UUID, record, BLESHUTTER_UPLOAD_DATA_HDR_LEN + chunk, 0 );
+        sent += chunk;
+    }
+
+    if ( status == SUCCESS )
+    {
+        record[0] = BLESHUTTER_UPLOAD_COMMIT;
+        status = DCBSHost_Write( BLESHUTTER_UPLOAD_UUID, record, 1, 0 );
+    }
+
+    return ( status );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_SetEdgeCB
+ *
+ * @brief   Have every port 0 change passed to a function.
+ *
+ * @param   pfnEdge - the function, NULL for none
+ *
+ * @return  none
+ */
+void DCBSHost_SetEdgeCB( dcbsHostEdgeCB_t pfnEdge )
+{
+    hostEdgeCB = pfnEdge;
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_TraceEdges
+ *
+ * @brief   Write every port 0 edge to a file as CSV from now on.
+ *
+ * @param   pFile - the file, NULL to stop
+ *
+ * @return  none
+ */
+void DCBSHost_TraceEdges( FILE *pFile )
+{
+    hostTraceFile = pFile;
+
+    if ( hostTraceFile != NULL )
+    {
+        fprintf( hostTraceFile, "time_us,line,level\n" );
+    }
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_SetNotifyCB
+ *
+ * @brief   Have every notification passed to a function.
+ *
+ * @param   pfnNotify - the function, NULL for none
+ *
+ * @return  none
+ */
+void DCBSHost_SetNotifyCB( dcbsHostNotifyCB_t pfnNotify )
+{
+    bleHostSetNotifyCB( pfnNotify );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_EchoLcd
+ *
+ * @brief   Echo LCD writes to a file.
+ *
+ * @param   pFile - the file, NULL for none
+ *
+ * @return  none
+ */
+void DCBSHost_EchoLcd( FILE *pFile )
+{
+    halHostSetLcd( pFile );
+}
+
+/*********************************************************************
+ * @fn      DCBSHost_Lcd
+ *
+ * @brief   Get what an LCD line shows.
+ *
+ * @param   line - HAL_LCD_LINE_1 ... HAL_LCD_LINE_8
+ *
+ * @return  the text
+ */
+const char *DCBSHost_Lcd( uint8 line )
+{
+    return ( halHostLcdLine( line ) );
+}
+
+uint8 DCBSHost_Port( void )
+{
+    return ( P0 );
+}
+
+uint32 DCBSHost_SnvWrites( void )
+{
+    return ( osalHostSnvWrites() );
+}
+
+void DCBSHost_SaveSnv( FILE *pFile )
+{
+    osalHostSaveSnv( pFile );
+}
+
+void DCBSHost_LoadSnv( FILE *pFile )
+{
+    osalHostLoadSnv( pFile );
+}
+
+uint32 DCBSHost_AdvEvents( void )
+{
+    return ( bleHostAdvEvents() );
+}
+
+uint32 DCBSHost_ConnEvents( void )
+{
+    return ( bleHostConnEvents() );
+}
+
+uint16 DCBSHost_ConnInterval( void )
+{
+    return ( bleHostConnInterval() );
+}
+
+uint16 DCBSHost_ConnLatency( void )
+{
+    return ( bleHostConnLatency() );
+}
+
+uint8 DCBSHost_PowerHeld( void )
+{
+    return ( osalHostPowerHeld() );
+}
+
+uint64_t DCBSHost_PowerHeldUs( void )
+{
+    return ( osalHostPowerHeldUs() );
+}
+
+uint32 DCBSHost_Wakes( void )
+{
+    return ( osalHostWakes() );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostEdge
+ *
+ * @brief   Port 0 changed: trace it and pass it on.
+ *
+ * @param   timeUs - device time
+ * @param   port - new level of every line
+ * @param   changed - lines that changed
+ *
+ * @return  none
+ */
+static void hostEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( hostTraceFile != NULL )
+    {
+        uint8 line;
+
+        for ( line = 0; line < 8; line++ )
+        {
+            if ( changed & BV(line) )
+            {
+                fprintf( hostTraceFile, "%llu,P0.%u,%u\n", (unsigned long long)timeUs, line,
+                         (port >> line) & 1 );
+            }
+        }
+    }
+
+    if ( hostEdgeCB != NULL )
+    {
+        hostEdgeCB( timeUs, port, changed );
+    }
+}
+
+/*********************************************************************
+ * @fn      hostCRC16
+ *
+ * @brief   CRC-16/CCITT-FALSE, as Upload checks it.
+ *
+ * @param   pData - data
+ * @param   len - its length
+ *
+ * @return  CRC
+ */
+static uint16 hostCRC16( uint8 *pData, uint8 len )
+{
+    uint16 crc = 0xFFFF;
+    uint8 i;
+
+    while ( len-- )
+    {
+        crc ^= (uint16)(*pData++) << 8;
+        for ( i = 0; i < 8; i++ )
+        {
+            crc = (crc & 0x8000) ? (uint16)((crc << 1) ^ 0x1021) : (uint16)(crc << 1);
+        }
+    }
+
+    return ( crc );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,242 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Host.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the host simulation definitions and
+                  prototypes. The application and service are built unchanged
+                  for Linux against the stand-ins in Stack/ and run on a
+                  virtual clock: one simulated device per process.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_HOST_H
+#define DSLRCAMERABLESHUTTER_HOST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Task ID the application runs as
+#define DCBS_HOST_TASK_ID                   0
+
+// Connection interval a central connects with, 1.25 ms units
+#define DCBS_HOST_CONN_INTERVAL             80
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Port 0 changed: device time, the new level of every line and the lines
+// that changed
+typedef void (*dcbsHostEdgeCB_t)( uint64_t timeUs, uint8 port, uint8 changed );
+
+// A notification went out on the link
+typedef void (*dcbsHostNotifyCB_t)( uint16 uuid, uint8 *pValue, uint8 len );
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSHost_Init - Reset the stand-ins, initialize the application and
+ *                 run its start event. Device time starts at 0.
+ */
+extern void DCBSHost_Init( void );
+
+/*
+ * DCBSHost_Run - Run the device for ms milliseconds of its own time.
+ */
+extern void DCBSHost_Run( uint32 ms );
+
+/*
+ * DCBSHost_RunUntil - Run the device up to a device time in microseconds.
+ */
+extern void DCBSHost_RunUntil( uint64_t timeUs );
+
+/*
+ * DCBSHost_Now - Get the device time in microseconds.
+ */
+extern uint64_t DCBSHost_Now( void );
+
+/*
+ * DCBSHost_SetDrift - Set the crystal error. Device time runs fast by
+ *                     ppm parts per million against true time.
+ */
+extern void DCBSHost_SetDrift( int32 ppm );
+
+/*
+ * DCBSHost_TrueTime - Convert a device time to true time, microseconds.
+ */
+extern uint64_t DCBSHost_TrueTime( uint64_t deviceUs );
+
+/*
+ * DCBSHost_DeviceTime - Convert a true time to device time, microseconds.
+ */
+extern uint64_t DCBSHost_DeviceTime( uint64_t trueUs );
+
+/*
+ * DCBSHost_SetLoad - Inject stack task load: every periodUs the stack task
+ *                    holds the CPU for a share of up to holdUs, which
+ *                    seed varies. 0 removes it.
+ */
+extern void DCBSHost_SetLoad( uint32 periodUs, uint32 holdUs, uint32 seed );
+
+/*
+ * DCBSHost_SetWork - Have each run of the application task take workUs, as
+ *                    the sleep timer the stats time it on sees. 0, the
+ *                    default, makes work take no time.
+ */
+extern void DCBSHost_SetWork( uint32 workUs );
+
+/*
+ * DCBSHost_Connect - Have a central connect, interval in 1.25 ms units.
+ */
+extern void DCBSHost_Connect( uint16 interval );
+
+/*
+ * DCBSHost_Disconnect - Have the central drop the link.
+ */
+extern void DCBSHost_Disconnect( void );
+
+/*
+ * DCBSHost_Write - Write a characteristic of the service.
+ *
+ *    returns SUCCESS or the ATT error
+ */
+extern bStatus_t DCBSHost_Write( uint16 uuid, uint8 *pValue, uint8 len, uint16 offset );
+
+/*
+ * DCBSHost_Read - Read up to ATT_MTU_SIZE - 1 bytes of a characteristic
+ *                 from offset.
+ *
+ *    returns SUCCESS or the ATT error
+ */
+extern bStatus_t DCBSHost_Read( uint16 uuid, uint8 *pValue, uint8 *pLen, uint16 offset );
+
+/*
+ * DCBSHost_ReadLong - Read a whole characteristic with blob reads.
+ *
+ *    returns the length read, or -1 on an ATT error
+ */
+extern int DCBSHost_ReadLong( uint16 uuid, uint8 *pValue, uint16 maxLen );
+
+/*
+ * DCBSHost_Subscribe - Enable or disable notifications of a characteristic.
+ */
+extern bStatus_t DCBSHost_Subscribe( uint16 uuid, uint8 enable );
+
+/*
+ * DCBSHost_Shoot - Write a Shooting value: count, delay, exposure and
+ *                  interval in ms (exposure in us with
+ *                  BLESHUTTER_SHOOTING_OPT_EXPOSURE_US), options and
+ *                  channel mask.
+ */
+extern bStatus_t DCBSHost_Shoot( uint16 count, uint32 delay, uint32 exposure, uint32 interval,
+                                 uint8 options, uint8 mask );
+
+/*
+ * DCBSHost_Upload - Stage, send and commit a blob through Upload.
+ */
+extern bStatus_t DCBSHost_Upload( uint8 type, uint8 *pData, uint8 len );
+
+/*
+ * DCBSHost_SetEdgeCB - Have every port 0 change passed to a function.
+ */
+extern void DCBSHost_SetEdgeCB( dcbsHostEdgeCB_t pfnEdge );
+
+/*
+ * DCBSHost_TraceEdges - Write every port 0 edge to a file as CSV:
+ *                       time_us,line,level.
+ */
+extern void DCBSHost_TraceEdges( FILE *pFile );
+
+/*
+ * DCBSHost_SetNotifyCB - Have every notification passed to a function.
+ */
+extern void DCBSHost_SetNotifyCB( dcbsHostNotifyCB_t pfnNotify );
+
+/*
+ * DCBSHost_EchoLcd - Echo LCD writes to a file.
+ */
+extern void DCBSHost_EchoLcd( FILE *pFile );
+
+/*
+ * DCBSHost_Lcd - Get what an LCD line shows.
+ */
+extern const char *DCBSHost_Lcd( uint8 line );
+
+/*
+ * DCBSHost_Port - Get port 0.
+ */
+extern uint8 DCBSHost_Port( void );
+
+/*
+ * DCBSHost_SnvWrites - Get the number of SNV writes so far.
+ */
+extern uint32 DCBSHost_SnvWrites( void );
+
+/*
+ * DCBSHost_SaveSnv - Write every SNV item to a file.
+ */
+extern void DCBSHost_SaveSnv( FILE *pFile );
+
+/*
+ * DCBSHost_LoadSnv - Replace the SNV items with those of a file, the next
+ *                    DCBSHost_Init starts from them.
+ */
+extern void DCBSHost_LoadSnv( FILE *pFile );
+
+/*
+ * DCBSHost_AdvEvents - Get the advertising events sent so far.
+ */
+extern uint32 DCBSHost_AdvEvents( void );
+
+/*
+ * DCBSHost_ConnEvents - Get the connection events woken for so far.
+ */
+extern uint32 DCBSHost_ConnEvents( void );
+
+/*
+ * DCBSHost_ConnInterval - Get the connection interval, 0 when not connected.
+ */
+extern uint16 DCBSHost_ConnInterval( void );
+
+/*
+ * DCBSHost_ConnLatency - Get the slave latency in use.
+ */
+extern uint16 DCBSHost_ConnLatency( void );
+
+/*
+ * DCBSHost_PowerHeld - Check whether the power manager is held off.
+ */
+extern uint8 DCBSHost_PowerHeld( void );
+
+/*
+ * DCBSHost_PowerHeldUs - Get how long the power manager has been held off.
+ */
+extern uint64_t DCBSHost_PowerHeldUs( void );
+
+/*
+ * DCBSHost_Wakes - Get the times the application ran after being idle.
+ */
+extern uint32 DCBSHost_Wakes( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_HOST_H */
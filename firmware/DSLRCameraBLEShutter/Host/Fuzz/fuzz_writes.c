@@ -0,0 +1,287 @@
+/**************************************************************************************************
+  Filename:       fuzz_writes.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Write fuzzer. Each input is decoded into a short session a
+                  central could run against the service: writes and long
+                  writes of any characteristic, reads, subscriptions,
+                  connects and disconnects and time passing. Built with
+                  AddressSanitizer and UBSan, an out of bounds access or
+                  undefined behaviour anywhere a write reaches aborts the run.
+
+                  The entry point is the one libFuzzer calls, built with
+                  -DDCBS_HOST_LIBFUZZER it links against libFuzzer's main.
+                  Without it, this file has its own main that runs random
+                  inputs and the files named:
+
+                  fuzz_writes [-n runs] [-r seed] [file...]
+
+                  Every input starts from DCBSHost_Init, which resets the
+                  stand-ins and initializes the application again. Module
+                  state the application only sets when its value is used
+                  (the last upload, the sync estimate) can carry over from
+                  one input to the next, so a finding may need the inputs
+                  run before it to show again.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "att.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// What the stack lets through: a write of up to ATT_MTU_SIZE - 3 bytes, a
+// prepared fragment of up to ATT_MTU_SIZE - 5 bytes, and a long value of
+// up to 512 bytes
+#define FUZZ_WRITE_MAX                      (ATT_MTU_SIZE - 3)
+#define FUZZ_PREPARE_MAX                    (ATT_MTU_SIZE - 5)
+#define FUZZ_LONG_MAX                       512
+
+// Longest input the standalone main makes up
+#define FUZZ_INPUT_MAX                      512
+
+// Ops an input is made of, the first byte of each picks one
+enum
+{
+    FUZZ_OP_WRITE,          // uuid, len, value
+    FUZZ_OP_LONG_WRITE,     // uuid, offset (2), len, value
+    FUZZ_OP_READ,           // uuid, offset
+    FUZZ_OP_RUN,            // 16 ms units
+    FUZZ_OP_LINK,           // connect with an interval, or disconnect when 0
+    FUZZ_OP_SUBSCRIBE,      // uuid, enable
+    FUZZ_OPS
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Every characteristic of the service, and one it doesn't have
+static CONST uint16 fuzzUuids[] =
+{
+    BLESHUTTER_FOCUS_UUID,
+    BLESHUTTER_SHOOTING_UUID,
+    BLESHUTTER_STOP_UUID,
+    BLESHUTTER_PROGRESS_UUID,
+    BLESHUTTER_PROGRAM_UUID,
+    BLESHUTTER_UPLOAD_UUID,
+    BLESHUTTER_STATUS_UUID,
+    BLESHUTTER_RATE_UUID,
+    BLESHUTTER_TIMING_UUID,
+    BLESHUTTER_SYNC_UUID,
+    BLESHUTTER_TIME_UUID,
+    BLESHUTTER_POWER_UUID,
+    BLESHUTTER_STATS_UUID,
+    BLESHUTTER_TRACE_UUID,
+    BLESHUTTER_COMMAND_UUID,
+    BLESHUTTER_SERV_UUID,
+};
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 fuzzByte( const uint8_t **ppData, size_t *pSize );
+
+int LLVMFuzzerTestOneInput( const uint8_t *data, size_t size );
+
+/*********************************************************************
+ * @fn      LLVMFuzzerTestOneInput
+ *
+ * @brief   Run one input on a fresh device. An input running out part
+ *          way through an op reads as zeros from there on.
+ *
+ * @param   data - the input
+ * @param   size - its length
+ *
+ * @return  0
+ */
+int LLVMFuzzerTestOneInput( const uint8_t *data, size_t size )
+{
+    uint8 value[FUZZ_LONG_MAX];
+    uint8 connected = FALSE;
+
+    DCBSHost_Init();
+
+    while ( size > 0 )
+    {
+        uint8 op = fuzzByte( &data, &size ) % FUZZ_OPS;
+        uint16 uuid = fuzzUuids[fuzzByte( &data, &size ) % (sizeof( fuzzUuids ) / sizeof( fuzzUuids[0] ))];
+        uint16 offset;
+        uint8 len;
+        uint8 i;
+
+        switch ( op )
+        {
+            case FUZZ_OP_WRITE:
+                len = fuzzByte( &data, &size ) % (FUZZ_WRITE_MAX + 1);
+                for ( i = 0; i < len; i++ )
+                {
+                    value[i] = fuzzByte( &data, &size );
+                }
+                DCBSHost_Write( uuid, value, len, 0 );
+                break;
+
+            case FUZZ_OP_LONG_WRITE:
+                offset = fuzzByte( &data, &size );
+                offset = (offset | ((uint16)fuzzByte( &data, &size ) << 8)) % FUZZ_LONG_MAX;
+                len = fuzzByte( &data, &size ) % (FUZZ_PREPARE_MAX + 1);
+                len = MIN( len, FUZZ_LONG_MAX - offset );
+                for ( i = 0; i < len; i++ )
+                {
+                    value[i] = fuzzByte( &data, &size );
+                }
+                DCBSHost_Write( uuid, value, len, offset );
+                break;
+
+            case FUZZ_OP_READ:
+                offset = fuzzByte( &data, &size );
+                DCBSHost_Read( uuid, value, &len, offset );
+                break;
+
+            case FUZZ_OP_RUN:
+                DCBSHost_Run( (uint32)fuzzByte( &data, &size ) * 16 );
+                break;
+
+            case FUZZ_OP_LINK:
+                i = fuzzByte( &data, &size );
+                if ( connected )
+                {
+                    DCBSHost_Disconnect();
+                    connected = FALSE;
+                }
+                if ( i != 0 )
+                {
+                    // 7.5 ms up to 326 ms
+                    DCBSHost_Connect( 6 + i );
+                    connected = TRUE;
+                }
+                break;
+
+            case FUZZ_OP_SUBSCRIBE:
+                DCBSHost_Subscribe( uuid, fuzzByte( &data, &size ) & 0x01 );
+                break;
+        }
+    }
+
+    return ( 0 );
+}
+
+/*********************************************************************
+ * @fn      fuzzByte
+ *
+ * @brief   Take the next byte of the input.
+ *
+ * @param   ppData - the input left, advanced
+ * @param   pSize - its length, decreased
+ *
+ * @return  the byte, 0 past the end
+ */
+static uint8 fuzzByte( const uint8_t **ppData, size_t *pSize )
+{
+    if ( *pSize == 0 )
+    {
+        return ( 0 );
+    }
+
+    (*pSize)--;
+    return ( *(*ppData)++ );
+}
+
+#ifndef DCBS_HOST_LIBFUZZER
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the files named, or random inputs from a seed.
+ *
+ * @return  0, a finding aborts
+ */
+int main( int argc, char **argv )
+{
+    static uint8_t input[FUZZ_INPUT_MAX];
+    unsigned long runs = 10000;
+    uint32 seed = 1;
+    unsigned long n;
+    int i;
+
+    for ( i = 1; i < argc; i++ )
+    {
+        if ( argv[i][0] != '-' )
+        {
+            FILE *pFile = fopen( argv[i], "rb" );
+            size_t size;
+
+            if ( pFile == NULL )
+            {
+                perror( argv[i] );
+                return ( 2 );
+            }
+            size = fread( input, 1, sizeof( input ), pFile );
+            fclose( pFile );
+
+            printf( "%s: %u bytes\n", argv[i], (unsigned)size );
+            LLVMFuzzerTestOneInput( input, size );
+            runs = 0;
+            continue;
+        }
+
+        if ( i + 1 >= argc || strlen( argv[i] ) != 2 || strchr( "nr", argv[i][1] ) == NULL )
+        {
+            fprintf( stderr, "usage: %s [-n runs] [-r seed] [file...]\n", argv[0] );
+            return ( 2 );
+        }
+
+        switch ( argv[i][1] )
+        {
+            case 'n': runs = strtoul( argv[i + 1], NULL, 0 ); break;
+            case 'r': seed = strtoul( argv[i + 1], NULL, 0 ); break;
+        }
+        i++;
+    }
+
+    for ( n = 0; n < runs; n++ )
+    {
+        size_t size;
+        size_t j;
+
+        // xorshift32, the same inputs for a seed on every host
+        seed = seed ? seed : 1;
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        size = seed % (sizeof( input ) + 1);
+
+        for ( j = 0; j < size; j++ )
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            input[j] = (uint8_t)seed;
+        }
+
+        LLVMFuzzerTestOneInput( input, size );
+    }
+
+    if ( runs > 0 )
+    {
+        printf( "%lu inputs, no findings\n", runs );
+    }
+
+    return ( 0 );
+}
+
+#endif // DCBS_HOST_LIBFUZZER
+
+/*********************************************************************
+*********************************************************************/
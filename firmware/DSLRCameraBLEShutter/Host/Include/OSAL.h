@@ -0,0 +1,62 @@
+/**************************************************************************************************
+  Filename:       OSAL.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the OSAL API. Timers and events are kept
+                  by Stack/osal_host.c against the virtual clock.
+**************************************************************************************************/
+
+#ifndef OSAL_H
+#define OSAL_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define SYS_EVENT_MSG                       0x8000
+
+#define INVALID_TASK_ID                     0xFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+    uint8  event;
+    uint8  status;
+} osal_event_hdr_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Message queue, always empty on the host
+ */
+extern uint8 *osal_msg_receive( uint8 task_id );
+extern uint8 osal_msg_deallocate( uint8 *msg_ptr );
+
+/*
+ * Task events
+ */
+extern uint8 osal_set_event( uint8 task_id, uint16 event_flag );
+extern uint8 osal_clear_event( uint8 task_id, uint16 event_flag );
+
+/*
+ * Timers, in milliseconds of the virtual clock
+ */
+extern uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value );
+extern uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id );
+extern uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id );
+extern uint32 osal_GetSystemClock( void );
+
+/*
+ * Memory
+ */
+extern void *osal_memcpy( void *dst, const void *src, unsigned int len );
+extern void *osal_memset( void *dest, uint8 value, int len );
+extern uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len );
+extern void *osal_mem_alloc( uint16 size );
+extern void osal_mem_free( void *ptr );
+
+#endif /* OSAL_H */
@@ -0,0 +1,28 @@
+/**************************************************************************************************
+  Filename:       OSAL_PwrMgr.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the OSAL power manager. The host only
+                  records the holds, the energy model reads them back.
+**************************************************************************************************/
+
+#ifndef OSAL_PWRMGR_H
+#define OSAL_PWRMGR_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define PWRMGR_ALWAYS_ON                    0
+#define PWRMGR_BATTERY                      1
+
+#define PWRMGR_CONSERVE                     0
+#define PWRMGR_HOLD                         1
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state );
+extern void osal_pwrmgr_device( uint8 pwrmgr_device );
+
+#endif /* OSAL_PWRMGR_H */
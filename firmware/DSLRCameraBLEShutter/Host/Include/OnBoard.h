@@ -0,0 +1,12 @@
+/**************************************************************************************************
+  Filename:       OnBoard.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the board definitions.
+**************************************************************************************************/
+
+#ifndef ONBOARD_H
+#define ONBOARD_H
+
+#include "hal_mcu.h"
+
+#endif /* ONBOARD_H */
@@ -0,0 +1,42 @@
+/**************************************************************************************************
+  Filename:       att.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the ATT definitions.
+**************************************************************************************************/
+
+#ifndef ATT_H
+#define ATT_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define ATT_BT_UUID_SIZE                    2
+#define ATT_UUID_SIZE                       16
+
+#define ATT_MTU_SIZE                        23
+
+// Error codes
+#define ATT_ERR_INVALID_HANDLE              0x01
+#define ATT_ERR_READ_NOT_PERMITTED          0x02
+#define ATT_ERR_WRITE_NOT_PERMITTED         0x03
+#define ATT_ERR_INVALID_PDU                 0x04
+#define ATT_ERR_INSUFFICIENT_AUTHEN         0x05
+#define ATT_ERR_UNSUPPORTED_REQ             0x06
+#define ATT_ERR_INVALID_OFFSET              0x07
+#define ATT_ERR_INSUFFICIENT_AUTHOR         0x08
+#define ATT_ERR_PREPARE_QUEUE_FULL          0x09
+#define ATT_ERR_ATTR_NOT_FOUND              0x0A
+#define ATT_ERR_ATTR_NOT_LONG               0x0B
+#define ATT_ERR_INSUFFICIENT_KEY_SIZE       0x0C
+#define ATT_ERR_INVALID_VALUE_SIZE          0x0D
+#define ATT_ERR_UNLIKELY                    0x0E
+#define ATT_ERR_INSUFFICIENT_ENCRYPT        0x0F
+#define ATT_ERR_UNSUPPORTED_GRP_TYPE        0x10
+#define ATT_ERR_INSUFFICIENT_RESOURCES      0x11
+
+// Application error codes
+#define ATT_ERR_INVALID_VALUE               0x80
+
+#endif /* ATT_H */
@@ -0,0 +1,81 @@
+/**************************************************************************************************
+  Filename:       bcomdef.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the BLE stack common definitions: status
+                  codes, byte helpers and the NV item range.
+**************************************************************************************************/
+
+#ifndef BCOMDEF_H
+#define BCOMDEF_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define SUCCESS                             0x00
+#define FAILURE                             0x01
+#define INVALIDPARAMETER                    0x02
+#define INVALID_TASK                        0x03
+#define MSG_BUFFER_NOT_AVAIL                0x04
+#define INVALID_MSG_POINTER                 0x05
+#define INVALID_EVENT_ID                    0x06
+#define INVALID_INTERRUPT_ID                0x07
+#define NO_TIMER_AVAIL                      0x08
+#define NV_ITEM_UNINIT                      0x09
+#define NV_OPER_FAILED                      0x0A
+#define INVALID_MEM_SIZE                    0x0B
+#define NV_BAD_ITEM_LEN                     0x0C
+
+#define bleNotReady                         0x10
+#define bleAlreadyInRequestedMode           0x11
+#define bleIncorrectMode                    0x12
+#define bleMemAllocError                    0x13
+#define bleNotConnected                     0x14
+#define bleNoResources                      0x15
+#define blePending                          0x16
+#define bleTimeout                          0x17
+#define bleInvalidRange                     0x18
+
+#define B_ADDR_LEN                          6
+
+// NV items the application may use
+#define BLE_NVID_CUST_START                 0x80
+#define BLE_NVID_CUST_END                   0x8F
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef uint8 bStatus_t;
+
+/*********************************************************************
+ * MACROS
+ */
+#define BV( n )                             ( 1 << (n) )
+
+#define LO_UINT16( a )                      ( (a) & 0xFF )
+#define HI_UINT16( a )                      ( ((a) >> 8) & 0xFF )
+
+#define BUILD_UINT16( loByte, hiByte ) \
+          ( (uint16)(((loByte) & 0x00FF) + (((hiByte) & 0x00FF) << 8)) )
+
+#define BUILD_UINT32( Byte0, Byte1, Byte2, Byte3 ) \
+          ( (uint32)((uint32)((Byte0) & 0x00FF) \
+          + ((uint32)((Byte1) & 0x00FF) << 8) \
+          + ((uint32)((Byte2) & 0x00FF) << 16) \
+          + ((uint32)((Byte3) & 0x00FF) << 24)) )
+
+#define BREAK_UINT32( var, ByteNum ) \
+          (uint8)((uint32)(((var) >> ((ByteNum) * 8)) & 0x00FF))
+
+#define VOID                                (void)
+
+#ifndef MIN
+#define MIN( n, m )                         ( ((n) < (m)) ? (n) : (m) )
+#endif
+
+#ifndef MAX
+#define MAX( n, m )                         ( ((n) < (m)) ? (m) : (n) )
+#endif
+
+#endif /* BCOMDEF_H */
@@ -0,0 +1,24 @@
+/**************************************************************************************************
+  Filename:       devinfoservice.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the Device Information Service.
+**************************************************************************************************/
+
+#ifndef DEVINFOSERVICE_H
+#define DEVINFOSERVICE_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define DEVINFO_SYSTEM_ID                   0
+#define DEVINFO_SYSTEM_ID_LEN               8
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern bStatus_t DevInfo_AddService( void );
+extern bStatus_t DevInfo_SetParameter( uint8 param, uint8 len, void *value );
+
+#endif /* DEVINFOSERVICE_H */
@@ -0,0 +1,55 @@
+/**************************************************************************************************
+  Filename:       gap.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the GAP definitions.
+**************************************************************************************************/
+
+#ifndef GAP_H
+#define GAP_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// GAP parameters, see GAP_SetParamValue
+#define TGAP_GEN_DISC_ADV_MIN               0
+#define TGAP_LIM_ADV_TIMEOUT                1
+#define TGAP_GEN_DISC_SCAN                  2
+#define TGAP_LIM_DISC_SCAN                  3
+#define TGAP_CONN_EST_ADV_TIMEOUT           4
+#define TGAP_CONN_PARAM_TIMEOUT             5
+#define TGAP_LIM_DISC_ADV_INT_MIN           6
+#define TGAP_LIM_DISC_ADV_INT_MAX           7
+#define TGAP_GEN_DISC_ADV_INT_MIN           8
+#define TGAP_GEN_DISC_ADV_INT_MAX           9
+#define TGAP_CONN_ADV_INT_MIN               10
+#define TGAP_CONN_ADV_INT_MAX               11
+#define TGAP_CONN_PAUSE_CENTRAL             25
+#define TGAP_CONN_PAUSE_PERIPHERAL          26
+#define TGAP_PARAMID_MAX                    38
+
+#define GAP_DEVICE_NAME_LEN                 21
+
+// Advertising data types
+#define GAP_ADTYPE_FLAGS                    0x01
+#define GAP_ADTYPE_16BIT_MORE               0x02
+#define GAP_ADTYPE_16BIT_COMPLETE           0x03
+#define GAP_ADTYPE_LOCAL_NAME_SHORT         0x08
+#define GAP_ADTYPE_LOCAL_NAME_COMPLETE      0x09
+#define GAP_ADTYPE_POWER_LEVEL              0x0A
+#define GAP_ADTYPE_SLAVE_CONN_INTERVAL_RANGE 0x12
+#define GAP_ADTYPE_MANUFACTURER_SPECIFIC    0xFF
+
+#define GAP_ADTYPE_FLAGS_LIMITED            0x01
+#define GAP_ADTYPE_FLAGS_GENERAL            0x02
+#define GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED 0x04
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern bStatus_t GAP_SetParamValue( uint16 paramID, uint16 paramValue );
+extern uint16 GAP_GetParamValue( uint16 paramID );
+
+#endif /* GAP_H */
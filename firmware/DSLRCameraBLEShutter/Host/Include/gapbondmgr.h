@@ -0,0 +1,52 @@
+/**************************************************************************************************
+  Filename:       gapbondmgr.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the GAP bond manager. The host link is
+                  never paired.
+**************************************************************************************************/
+
+#ifndef GAPBONDMGR_H
+#define GAPBONDMGR_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define GAPBOND_PAIRING_MODE                0x400
+#define GAPBOND_INITIATE_WAIT               0x401
+#define GAPBOND_MITM_PROTECTION             0x402
+#define GAPBOND_IO_CAPABILITIES             0x403
+#define GAPBOND_OOB_ENABLED                 0x404
+#define GAPBOND_OOB_DATA                    0x405
+#define GAPBOND_BONDING_ENABLED             0x406
+#define GAPBOND_KEY_DIST_LIST               0x407
+#define GAPBOND_DEFAULT_PASSCODE            0x408
+
+#define GAPBOND_PAIRING_MODE_NO_PAIRING     0x00
+#define GAPBOND_PAIRING_MODE_WAIT_FOR_REQ   0x01
+#define GAPBOND_PAIRING_MODE_INITIATE       0x02
+
+#define GAPBOND_IO_CAP_DISPLAY_ONLY         0x00
+#define GAPBOND_IO_CAP_NO_INPUT_NO_OUTPUT   0x03
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef void (*pfnPasscodeCB_t)( uint8 *deviceAddr, uint16 connectionHandle,
+                                 uint8 uiInputs, uint8 uiOutputs );
+typedef void (*pfnPairStateCB_t)( uint16 connectionHandle, uint8 state, uint8 status );
+
+typedef struct
+{
+    pfnPasscodeCB_t passcodeCB;
+    pfnPairStateCB_t pairStateCB;
+} gapBondCBs_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern bStatus_t GAPBondMgr_SetParameter( uint16 param, uint8 len, void *pValue );
+extern bStatus_t GAPBondMgr_Register( gapBondCBs_t *pCB );
+
+#endif /* GAPBONDMGR_H */
@@ -0,0 +1,26 @@
+/**************************************************************************************************
+  Filename:       gapgattserver.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the GAP GATT Server.
+**************************************************************************************************/
+
+#ifndef GAPGATTSERVER_H
+#define GAPGATTSERVER_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define GAP_SERVICE                         0x00000001
+
+#define GGS_DEVICE_NAME_ATT                 0
+#define GGS_APPEARANCE_ATT                  1
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern bStatus_t GGS_AddService( uint32 services );
+extern bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value );
+
+#endif /* GAPGATTSERVER_H */
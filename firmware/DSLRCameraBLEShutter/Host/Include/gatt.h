@@ -0,0 +1,62 @@
+/**************************************************************************************************
+  Filename:       gatt.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the GATT definitions.
+**************************************************************************************************/
+
+#ifndef GATT_H
+#define GATT_H
+
+#include "bcomdef.h"
+#include "att.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Characteristic properties
+#define GATT_PROP_BCAST                     0x01
+#define GATT_PROP_READ                      0x02
+#define GATT_PROP_WRITE_NO_RSP              0x04
+#define GATT_PROP_WRITE                     0x08
+#define GATT_PROP_NOTIFY                    0x10
+#define GATT_PROP_INDICATE                  0x20
+
+// Attribute permissions
+#define GATT_PERMIT_READ                    0x01
+#define GATT_PERMIT_WRITE                   0x02
+#define GATT_PERMIT_AUTHEN_READ             0x04
+#define GATT_PERMIT_AUTHEN_WRITE            0x08
+#define GATT_PERMIT_AUTHOR_READ             0x10
+#define GATT_PERMIT_AUTHOR_WRITE            0x20
+
+#define GATT_MAX_NUM_CONN                   1
+
+/*********************************************************************
+ * MACROS
+ */
+#define GATT_NUM_ATTRS( attrs )             ( sizeof( attrs ) / sizeof( gattAttribute_t ) )
+
+#define gattPermitRead( a )                 ( (a) & GATT_PERMIT_READ )
+#define gattPermitWrite( a )                ( (a) & GATT_PERMIT_WRITE )
+#define gattPermitAuthorRead( a )           ( (a) & GATT_PERMIT_AUTHOR_READ )
+#define gattPermitAuthorWrite( a )          ( (a) & GATT_PERMIT_AUTHOR_WRITE )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+    uint8 len;
+    const uint8 *uuid;
+} gattAttrType_t;
+
+typedef struct attAttribute_t
+{
+    gattAttrType_t type;
+    uint8 permissions;
+    uint16 handle;
+    uint8 * const pValue;
+} gattAttribute_t;
+
+#endif /* GATT_H */
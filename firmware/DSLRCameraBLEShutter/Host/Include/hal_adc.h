@@ -0,0 +1,13 @@
+/**************************************************************************************************
+  Filename:       hal_adc.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the ADC driver, which the application
+                  doesn't use.
+**************************************************************************************************/
+
+#ifndef HAL_ADC_H
+#define HAL_ADC_H
+
+#include "hal_types.h"
+
+#endif /* HAL_ADC_H */
@@ -0,0 +1,19 @@
+/**************************************************************************************************
+  Filename:       hal_key.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the key driver. The host board has no
+                  keys.
+**************************************************************************************************/
+
+#ifndef HAL_KEY_H
+#define HAL_KEY_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define HAL_KEY_SW_1                        0x01
+#define HAL_KEY_SW_2                        0x02
+
+#endif /* HAL_KEY_H */
@@ -0,0 +1,37 @@
+/**************************************************************************************************
+  Filename:       hal_lcd.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the LCD driver. Lines are kept as text
+                  by Stack/hal_host.c.
+**************************************************************************************************/
+
+#ifndef HAL_LCD_H
+#define HAL_LCD_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define HAL_LCD_LINE_1                      0x01
+#define HAL_LCD_LINE_2                      0x02
+#define HAL_LCD_LINE_3                      0x03
+#define HAL_LCD_LINE_4                      0x04
+#define HAL_LCD_LINE_5                      0x05
+#define HAL_LCD_LINE_6                      0x06
+#define HAL_LCD_LINE_7                      0x07
+#define HAL_LCD_LINE_8                      0x08
+
+#define HAL_LCD_MAX_LINES                   8
+#define HAL_LCD_MAX_CHARS                   16
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern void HalLcdWriteString( char *str, uint8 option );
+extern void HalLcdWriteValue( uint32 value, const uint8 radix, uint8 option );
+extern void HalLcdWriteStringValue( char *title, uint16 value, uint8 format, uint8 line );
+extern void HalLcdWriteStringValueValue( char *title, uint16 value1, uint8 format1,
+                                         uint16 value2, uint8 format2, uint8 line );
+
+#endif /* HAL_LCD_H */
@@ -0,0 +1,28 @@
+/**************************************************************************************************
+  Filename:       hal_led.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the LED driver.
+**************************************************************************************************/
+
+#ifndef HAL_LED_H
+#define HAL_LED_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define HAL_LED_1                           0x01
+#define HAL_LED_2                           0x02
+#define HAL_LED_3                           0x04
+#define HAL_LED_ALL                         ( HAL_LED_1 | HAL_LED_2 | HAL_LED_3 )
+
+#define HAL_LED_MODE_OFF                    0x00
+#define HAL_LED_MODE_ON                     0x01
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern uint8 HalLedSet( uint8 led, uint8 mode );
+
+#endif /* HAL_LED_H */
@@ -0,0 +1,67 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the CC254x registers the application and
+                  pulse engine touch. Port and timer registers are plain
+                  variables kept by Stack/hal_host.c; writing T1CNTL restarts
+                  the emulated Timer 1 and reading ST0 latches the sleep
+                  timer, as on the chip.
+**************************************************************************************************/
+
+#ifndef HAL_MCU_H
+#define HAL_MCU_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Interrupts are only taken between firmware calls, nothing to mask
+#define HAL_ENABLE_INTERRUPTS()
+#define HAL_DISABLE_INTERRUPTS()
+#define HAL_ENTER_CRITICAL_SECTION( x )     st( x = 0; )
+#define HAL_EXIT_CRITICAL_SECTION( x )      st( (void)(x); )
+
+// An interrupt handler is a plain function, listed in the host vector
+// table under its vector name so the timer emulation can call it
+#define HAL_ISR_FUNCTION( f, v ) \
+    void f( void ); \
+    void (* const halHostVector_##v)( void ) = f; \
+    void f( void )
+
+#define T1_VECTOR                           9
+
+/*********************************************************************
+ * REGISTERS
+ */
+
+// Ports
+extern volatile uint8 P0, P1, P2;
+extern volatile uint8 P0DIR, P1DIR, P2DIR;
+extern volatile uint8 P0SEL, P1SEL, P2SEL;
+
+// Timer 1
+extern volatile uint8 T1CTL, T1STAT;
+extern volatile uint8 T1CC0L, T1CC0H;
+extern volatile uint8 T1CCTL0;
+extern volatile uint8 TIMIF;
+extern volatile uint8 T1IE, T1IF;
+
+#define T1CNTL                              ( *halHostTimer1Count() )
+extern volatile uint8 *halHostTimer1Count( void );
+
+// Sleep timer, 32768 Hz
+#define ST0                                 halHostSleepTimer( 0 )
+#define ST1                                 halHostSleepTimer( 1 )
+#define ST2                                 halHostSleepTimer( 2 )
+extern uint8 halHostSleepTimer( uint8 index );
+
+/*********************************************************************
+ * HOST
+ */
+
+// Records port 0 edges, the build points DCBS_LINE_HOOK at it
+extern void halHostSample( void );
+
+#endif /* HAL_MCU_H */
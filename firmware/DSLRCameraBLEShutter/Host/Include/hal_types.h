@@ -0,0 +1,48 @@
+/**************************************************************************************************
+  Filename:       hal_types.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the TI HAL types. Sizes match the 8051
+                  target so the application's arithmetic wraps the same way.
+**************************************************************************************************/
+
+#ifndef HAL_TYPES_H
+#define HAL_TYPES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef int8_t      int8;
+typedef uint8_t     uint8;
+typedef int16_t     int16;
+typedef uint16_t    uint16;
+typedef int32_t     int32;
+typedef uint32_t    uint32;
+
+typedef uint8       halIntState_t;
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#ifndef TRUE
+#define TRUE        1
+#endif
+
+#ifndef FALSE
+#define FALSE       0
+#endif
+
+#ifndef NULL
+#define NULL        0
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+#define CONST       const
+
+#define st( x )     do { x } while (__LINE__ == -1)
+
+#endif /* HAL_TYPES_H */
@@ -0,0 +1,34 @@
+/**************************************************************************************************
+  Filename:       hci.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the HCI vendor specific commands the
+                  application uses.
+**************************************************************************************************/
+
+#ifndef HCI_H
+#define HCI_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define HCI_EXT_DISABLE_CLK_DIVIDE_ON_HALT  0
+#define HCI_EXT_ENABLE_CLK_DIVIDE_ON_HALT   1
+
+#define HCI_EXT_PM_IO_PORT_P0               0
+#define HCI_EXT_PM_IO_PORT_PIN7             7
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef uint8 hciStatus_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern hciStatus_t HCI_EXT_ClkDivOnHaltCmd( uint8 control );
+extern hciStatus_t HCI_EXT_MapPmIoPortCmd( uint8 ioPort, uint8 ioPin );
+extern hciStatus_t HCI_EXT_AdvEventNoticeCmd( uint8 taskID, uint16 taskEvent );
+
+#endif /* HCI_H */
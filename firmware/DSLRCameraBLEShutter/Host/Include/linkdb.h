@@ -0,0 +1,30 @@
+/**************************************************************************************************
+  Filename:       linkdb.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the link database, one link at most.
+**************************************************************************************************/
+
+#ifndef LINKDB_H
+#define LINKDB_H
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define LINKDB_STATUS_UPDATE_NEW            0
+#define LINKDB_STATUS_UPDATE_REMOVED        1
+#define LINKDB_STATUS_UPDATE_STATEFLAGS     2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef void (*pfnLinkDBCB_t)( uint16 connectionHandle, uint8 changeType );
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern uint8 linkDB_Register( pfnLinkDBCB_t pFunc );
+extern uint8 linkDB_Up( uint16 connectionHandle );
+
+#endif /* LINKDB_H */
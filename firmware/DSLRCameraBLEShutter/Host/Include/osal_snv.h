@@ -0,0 +1,26 @@
+/**************************************************************************************************
+  Filename:       osal_snv.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the simple NV API, items are kept in RAM
+                  for the life of the process.
+**************************************************************************************************/
+
+#ifndef OSAL_SNV_H
+#define OSAL_SNV_H
+
+#include "hal_types.h"
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef uint8 osalSnvId_t;
+typedef uint8 osalSnvLen_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern uint8 osal_snv_init( void );
+extern uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf );
+extern uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf );
+
+#endif /* OSAL_SNV_H */
@@ -0,0 +1,88 @@
+/**************************************************************************************************
+  Filename:       peripheral.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host stand-in for the GAP peripheral role. Stack/ble_host.c
+                  plays the role and the central on the other end of the
+                  link: it advertises, connects when told to and grants
+                  parameter updates.
+**************************************************************************************************/
+
+#ifndef PERIPHERAL_H
+#define PERIPHERAL_H
+
+#include "bcomdef.h"
+#include "gap.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Profile parameters
+#define GAPROLE_PROFILEROLE                 0x300
+#define GAPROLE_IRK                         0x301
+#define GAPROLE_SRK                         0x302
+#define GAPROLE_SIGNCOUNTER                 0x303
+#define GAPROLE_BD_ADDR                     0x304
+#define GAPROLE_ADVERT_ENABLED              0x305
+#define GAPROLE_ADVERT_OFF_TIME             0x306
+#define GAPROLE_ADVERT_DATA                 0x307
+#define GAPROLE_SCAN_RSP_DATA               0x308
+#define GAPROLE_ADV_EVENT_TYPE              0x309
+#define GAPROLE_ADV_DIRECT_TYPE             0x30A
+#define GAPROLE_ADV_DIRECT_ADDR             0x30B
+#define GAPROLE_ADV_CHANNEL_MAP             0x30C
+#define GAPROLE_ADV_FILTER_POLICY           0x30D
+#define GAPROLE_CONNHANDLE                  0x30E
+#define GAPROLE_RSSI_READ_RATE              0x30F
+#define GAPROLE_PARAM_UPDATE_ENABLE         0x310
+#define GAPROLE_MIN_CONN_INTERVAL           0x311
+#define GAPROLE_MAX_CONN_INTERVAL           0x312
+#define GAPROLE_SLAVE_LATENCY               0x313
+#define GAPROLE_TIMEOUT_MULTIPLIER          0x314
+#define GAPROLE_CONN_BD_ADDR                0x315
+#define GAPROLE_CONN_INTERVAL               0x316
+#define GAPROLE_CONN_LATENCY                0x317
+#define GAPROLE_CONN_TIMEOUT                0x318
+#define GAPROLE_PARAM_UPDATE_REQ            0x319
+#define GAPROLE_STATE                       0x31A
+
+#define GAPROLE_NO_ACTION                   0
+#define GAPROLE_RESEND_PARAM_UPDATE         1
+#define GAPROLE_TERMINATE_LINK              2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef enum
+{
+    GAPROLE_INIT = 0,
+    GAPROLE_STARTED,
+    GAPROLE_ADVERTISING,
+    GAPROLE_WAITING,
+    GAPROLE_WAITING_AFTER_TIMEOUT,
+    GAPROLE_CONNECTED,
+    GAPROLE_CONNECTED_ADV,
+    GAPROLE_ERROR
+} gaprole_States_t;
+
+typedef void (*gapRolesStateNotify_t)( gaprole_States_t newState );
+typedef void (*gapRolesRssiRead_t)( int8 newRSSI );
+
+typedef struct
+{
+    gapRolesStateNotify_t pfnStateChange;
+    gapRolesRssiRead_t pfnRssiRead;
+} gapRolesCBs_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+extern bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue );
+extern bStatus_t GAPRole_GetParameter( uint16 param, void *pValue );
+extern bStatus_t GAPRole_StartDevice( gapRolesCBs_t *pAppCallbacks );
+extern bStatus_t GAPRole_TerminateConnection( void );
+extern bStatus_t GAPRole_SendUpdateParam( uint16 minConnInterval, uint16 maxConnInterval,
+                                          uint16 latency, uint16 connTimeout,
+                                          uint8 handleFailure );
+
+#endif /* PERIPHERAL_H */
@@ -0,0 +1,908 @@
+/**************************************************************************************************
+  Filename:       ble_host.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host BLE stack. Plays the GATT server for the one registered
+                  service, the peripheral role, the central at the other end
+                  of the link and the radio: advertising events come at the
+                  advertising interval, parameter updates are granted as
+                  asked and connection events are counted from the interval
+                  and slave latency in use.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gattservapp.h"
+#include "linkdb.h"
+#include "gap.h"
+#include "gapgattserver.h"
+#include "gapbondmgr.h"
+#include "devinfoservice.h"
+#include "peripheral.h"
+#include "hci.h"
+
+#include "host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define BLE_HOST_CONN_HANDLE                0x0000
+
+// Parameter storage of the role
+#define BLE_HOST_ROLE_PARAMS                ( GAPROLE_STATE - GAPROLE_PROFILEROLE + 1 )
+#define BLE_HOST_ROLE_PARAM_LEN             31
+
+// Advertising and connection intervals are in 625 us and 1.25 ms units
+#define BLE_HOST_ADV_UNIT_US                625
+#define BLE_HOST_CONN_UNIT_US               1250
+
+// Advertising interval when the application sets none, 100 ms
+#define BLE_HOST_DEFAULT_ADV_INTERVAL       160
+
+// Random delay added to each advertising event, up to 10 ms
+#define BLE_HOST_ADV_DELAY_US               10000
+
+// Role state changes waiting for the stack task
+#define BLE_HOST_STATE_QUEUE                4
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+CONST uint8 primaryServiceUUID[ATT_BT_UUID_SIZE] =
+{
+    LO_UINT16( GATT_PRIMARY_SERVICE_UUID ), HI_UINT16( GATT_PRIMARY_SERVICE_UUID )
+};
+
+CONST uint8 characterUUID[ATT_BT_UUID_SIZE] =
+{
+    LO_UINT16( GATT_CHARACTER_UUID ), HI_UINT16( GATT_CHARACTER_UUID )
+};
+
+CONST uint8 charUserDescUUID[ATT_BT_UUID_SIZE] =
+{
+    LO_UINT16( GATT_CHAR_USER_DESC_UUID ), HI_UINT16( GATT_CHAR_USER_DESC_UUID )
+};
+
+CONST uint8 clientCharCfgUUID[ATT_BT_UUID_SIZE] =
+{
+    LO_UINT16( GATT_CLIENT_CHAR_CFG_UUID ), HI_UINT16( GATT_CLIENT_CHAR_CFG_UUID )
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// GATT server
+static gattAttribute_t *serverAttrs = NULL;
+static uint16 serverNumAttrs = 0;
+static CONST gattServiceCBs_t *serverCBs = NULL;
+static pfnLinkDBCB_t linkCB = NULL;
+static hostNotifyCB_t notifyCB = NULL;
+
+// Peripheral role
+static gapRolesCBs_t *roleCBs = NULL;
+static gaprole_States_t roleState = GAPROLE_INIT;
+static gaprole_States_t roleQueue[BLE_HOST_STATE_QUEUE];
+static uint8 roleQueued = 0;
+static uint8 roleParams[BLE_HOST_ROLE_PARAMS][BLE_HOST_ROLE_PARAM_LEN];
+static uint8 roleParamLen[BLE_HOST_ROLE_PARAMS];
+static uint8 advertEnabled = TRUE;
+static uint16 gapParams[TGAP_PARAMID_MAX];
+
+// Link
+static uint8 linkUp = FALSE;
+static uint16 linkInterval = 0;
+static uint16 linkLatency = 0;
+static uint16 linkTimeout = 0;
+static uint64_t linkSince = 0;             // device time the parameters took effect
+static uint32 linkEventsBefore = 0;         // events under earlier parameters
+
+// Radio
+static uint8 advNoticeTask = INVALID_TASK_ID;
+static uint16 advNoticeEvent = 0;
+static uint64_t advNext = HOST_NEVER;
+static uint32 advEvents = 0;
+static uint32 advRandom = 1;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void roleChange( gaprole_States_t newState );
+static void advertise( void );
+static void linkParams( uint16 interval, uint16 latency, uint16 timeout );
+static gattAttribute_t *findValue( uint16 uuid );
+
+/*********************************************************************
+ * HOST FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      bleHostReset
+ *
+ * @brief   Drop the service, callbacks, link and role state.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void bleHostReset( void )
+{
+    serverAttrs = NULL;
+    serverNumAttrs = 0;
+    serverCBs = NULL;
+    linkCB = NULL;
+
+    roleCBs = NULL;
+    roleState = GAPROLE_INIT;
+    roleQueued = 0;
+    memset( roleParams, 0, sizeof( roleParams ) );
+    memset( roleParamLen, 0, sizeof( roleParamLen ) );
+    advertEnabled = TRUE;
+    memset( gapParams, 0, sizeof( gapParams ) );
+
+    linkUp = FALSE;
+    linkInterval = 0;
+    linkLatency = 0;
+    linkTimeout = 0;
+    linkSince = 0;
+    linkEventsBefore = 0;
+
+    advNoticeTask = INVALID_TASK_ID;
+    advNext = HOST_NEVER;
+    advEvents = 0;
+}
+
+/*********************************************************************
+ * @fn      bleHostNext
+ *
+ * @brief   Find when the stack next has work: a role state change to
+ *          report or an advertising event.
+ *
+ * @param   none
+ *
+ * @return  device time of the work, HOST_NEVER if none
+ */
+uint64_t bleHostNext( void )
+{
+    if ( roleQueued )
+    {
+        return ( osalHostNow() );
+    }
+
+    return ( advNext );
+}
+
+/*********************************************************************
+ * @fn      bleHostPoll
+ *
+ * @brief   Report role state changes to the application and send the
+ *          advertising event that is due.
+ *
+ * @param   nowUs - device time
+ *
+ * @return  none
+ */
+void bleHostPoll( uint64_t nowUs )
+{
+    while ( roleQueued )
+    {
+        gaprole_States_t state = roleQueue[0];
+
+        roleQueued--;
+        memmove( roleQueue, roleQueue + 1, roleQueued * sizeof( roleQueue[0] ) );
+
+        if ( roleCBs != NULL && roleCBs->pfnStateChange != NULL )
+        {
+            roleCBs->pfnStateChange( state );
+        }
+    }
+
+    if ( advNext <= nowUs )
+    {
+        uint16 interval = gapParams[TGAP_GEN_DISC_ADV_INT_MIN];
+
+        if ( interval == 0 )
+        {
+            interval = BLE_HOST_DEFAULT_ADV_INTERVAL;
+        }
+
+        advEvents++;
+        if ( advNoticeTask != INVALID_TASK_ID )
+        {
+            VOID osal_set_event( advNoticeTask, advNoticeEvent );
+        }
+
+        advRandom ^= advRandom << 13;
+        advRandom ^= advRandom >> 17;
+        advRandom ^= advRandom << 5;
+        advNext = nowUs + (uint64_t)interval * BLE_HOST_ADV_UNIT_US + advRandom % BLE_HOST_ADV_DELAY_US;
+    }
+}
+
+/*********************************************************************
+ * @fn      bleHostConnect
+ *
+ * @brief   Have a central connect while the device advertises.
+ *
+ * @param   interval - connection interval, 1.25 ms units
+ *
+ * @return  none
+ */
+void bleHostConnect( uint16 interval )
+{
+    if ( linkUp || roleState != GAPROLE_ADVERTISING )
+    {
+        return;
+    }
+
+    linkParams( interval, 0, 1000 );
+    linkUp = TRUE;
+    advNext = HOST_NEVER;
+    roleChange( GAPROLE_CONNECTED );
+
+    if ( linkCB != NULL )
+    {
+        linkCB( BLE_HOST_CONN_HANDLE, LINKDB_STATUS_UPDATE_NEW );
+    }
+}
+
+/*********************************************************************
+ * @fn      bleHostDisconnect
+ *
+ * @brief   Have the central drop the link. The role advertises again
+ *          if advertising is enabled.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void bleHostDisconnect( void )
+{
+    if ( !linkUp )
+    {
+        return;
+    }
+
+    linkEventsBefore = bleHostConnEvents();
+    linkUp = FALSE;
+
+    if ( linkCB != NULL )
+    {
+        linkCB( BLE_HOST_CONN_HANDLE, LINKDB_STATUS_UPDATE_REMOVED );
+    }
+
+    roleChange( GAPROLE_WAITING );
+    advertise();
+}
+
+/*********************************************************************
+ * @fn      bleHostConnected
+ *
+ * @brief   Check whether the link is up.
+ *
+ * @param   none
+ *
+ * @return  TRUE when connected
+ */
+uint8 bleHostConnected( void )
+{
+    return ( linkUp );
+}
+
+/*********************************************************************
+ * @fn      bleHostWrite
+ *
+ * @brief   Write a characteristic value as the central would, through
+ *          the service's write callback.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   pValue - value
+ * @param   len - its length
+ * @param   offset - offset of a long write
+ *
+ * @return  the callback's status, or ATT_ERR_ATTR_NOT_FOUND
+ */
+bStatus_t bleHostWrite( uint16 uuid, uint8 *pValue, uint8 len, uint16 offset )
+{
+    gattAttribute_t *pAttr = findValue( uuid );
+
+    if ( pAttr == NULL )
+    {
+        return ( ATT_ERR_ATTR_NOT_FOUND );
+    }
+
+    if ( !gattPermitWrite( pAttr->permissions ) )
+    {
+        return ( ATT_ERR_WRITE_NOT_PERMITTED );
+    }
+
+    return ( serverCBs->pfnWriteAttrCB( BLE_HOST_CONN_HANDLE, pAttr, pValue, len, offset ) );
+}
+
+/*********************************************************************
+ * @fn      bleHostRead
+ *
+ * @brief   Read a characteristic value as the central would, one
+ *          (blob) read request of up to ATT_MTU_SIZE - 1 bytes.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   pValue - buffer of ATT_MTU_SIZE bytes
+ * @param   pLen - set to the length read
+ * @param   offset - offset of a blob read
+ *
+ * @return  the callback's status, or ATT_ERR_ATTR_NOT_FOUND
+ */
+bStatus_t bleHostRead( uint16 uuid, uint8 *pValue, uint8 *pLen, uint16 offset )
+{
+    gattAttribute_t *pAttr = findValue( uuid );
+
+    *pLen = 0;
+
+    if ( pAttr == NULL )
+    {
+        return ( ATT_ERR_ATTR_NOT_FOUND );
+    }
+
+    if ( !gattPermitRead( pAttr->permissions ) )
+    {
+        return ( ATT_ERR_READ_NOT_PERMITTED );
+    }
+
+    return ( serverCBs->pfnReadAttrCB( BLE_HOST_CONN_HANDLE, pAttr, pValue, pLen, offset,
+                                       ATT_MTU_SIZE - 1 ) );
+}
+
+/*********************************************************************
+ * @fn      bleHostSubscribe
+ *
+ * @brief   Write the Client Characteristic Configuration that follows
+ *          a characteristic value.
+ *
+ * @param   uuid - characteristic UUID
+ * @param   enable - TRUE for notifications, FALSE for none
+ *
+ * @return  the callback's status, or ATT_ERR_ATTR_NOT_FOUND
+ */
+bStatus_t bleHostSubscribe( uint16 uuid, uint8 enable )
+{
+    gattAttribute_t *pAttr = findValue( uuid );
+    uint8 cfg[2] = { enable ? LO_UINT16( GATT_CLIENT_CFG_NOTIFY ) : 0, 0 };
+
+    if ( pAttr == NULL || pAttr + 1 >= serverAttrs + serverNumAttrs ||
+         pAttr[1].type.uuid != clientCharCfgUUID )
+    {
+        return ( ATT_ERR_ATTR_NOT_FOUND );
+    }
+
+    return ( serverCBs->pfnWriteAttrCB( BLE_HOST_CONN_HANDLE, pAttr + 1, cfg, sizeof( cfg ), 0 ) );
+}
+
+/*********************************************************************
+ * @fn      bleHostSetNotifyCB
+ *
+ * @brief   Have every notification passed to a function.
+ *
+ * @param   pfnNotify - the function, NULL for none
+ *
+ * @return  none
+ */
+void bleHostSetNotifyCB( hostNotifyCB_t pfnNotify )
+{
+    notifyCB = pfnNotify;
+}
+
+/*********************************************************************
+ * @fn      bleHostAdvEvents
+ *
+ * @brief   Get the advertising events sent since reset.
+ *
+ * @param   none
+ *
+ * @return  events
+ */
+uint32 bleHostAdvEvents( void )
+{
+    return ( advEvents );
+}
+
+/*********************************************************************
+ * @fn      bleHostConnEvents
+ *
+ * @brief   Get the connection events the device woke for since reset.
+ *          With slave latency it sleeps through all it may skip.
+ *
+ * @param   none
+ *
+ * @return  events
+ */
+uint32 bleHostConnEvents( void )
+{
+    uint64_t period = (uint64_t)linkInterval * BLE_HOST_CONN_UNIT_US * (linkLatency + 1);
+
+    if ( !linkUp || period == 0 )
+    {
+        return ( linkEventsBefore );
+    }
+
+    return ( linkEventsBefore + (uint32)((osalHostNow() - linkSince) / period) );
+}
+
+/*********************************************************************
+ * @fn      bleHostConnInterval
+ *
+ * @brief   Get the connection interval in use.
+ *
+ * @param   none
+ *
+ * @return  interval in 1.25 ms units, 0 when not connected
+ */
+uint16 bleHostConnInterval( void )
+{
+    return ( linkUp ? linkInterval : 0 );
+}
+
+/*********************************************************************
+ * @fn      bleHostConnLatency
+ *
+ * @brief   Get the slave latency in use.
+ *
+ * @param   none
+ *
+ * @return  connection events the device may skip
+ */
+uint16 bleHostConnLatency( void )
+{
+    return ( linkUp ? linkLatency : 0 );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      roleChange
+ *
+ * @brief   Move the role to a new state, reported to the application
+ *          from the stack task rather than from inside the call that
+ *          caused it.
+ *
+ * @param   newState - the state
+ *
+ * @return  none
+ */
+static void roleChange( gaprole_States_t newState )
+{
+    roleState = newState;
+
+    if ( roleQueued < BLE_HOST_STATE_QUEUE )
+    {
+        roleQueue[roleQueued++] = newState;
+    }
+}
+
+/*********************************************************************
+ * @fn      advertise
+ *
+ * @brief   Start or stop advertising to match the enable parameter,
+ *          unless the role isn't started or is connected.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void advertise( void )
+{
+    if ( roleState == GAPROLE_INIT || linkUp )
+    {
+        return;
+    }
+
+    if ( advertEnabled && roleState != GAPROLE_ADVERTISING )
+    {
+        advNext = osalHostNow();
+        roleChange( GAPROLE_ADVERTISING );
+    }
+    else if ( !advertEnabled && roleState == GAPROLE_ADVERTISING )
+    {
+        advNext = HOST_NEVER;
+        roleChange( GAPROLE_WAITING );
+    }
+}
+
+/*********************************************************************
+ * @fn      linkParams
+ *
+ * @brief   Put new connection parameters in use, keeping the count of
+ *          connection events under the old ones.
+ *
+ * @param   interval - 1.25 ms units
+ * @param   latency - connection events that may be skipped
+ * @param   timeout - supervision timeout, 10 ms units
+ *
+ * @return  none
+ */
+static void linkParams( uint16 interval, uint16 latency, uint16 timeout )
+{
+    linkEventsBefore = bleHostConnEvents();
+    linkSince = osalHostNow();
+    linkInterval = interval;
+    linkLatency = latency;
+    linkTimeout = timeout;
+}
+
+/*********************************************************************
+ * @fn      findValue
+ *
+ * @brief   Find the value attribute of a characteristic.
+ *
+ * @param   uuid - characteristic UUID
+ *
+ * @return  the attribute, NULL if the service has none
+ */
+static gattAttribute_t *findValue( uint16 uuid )
+{
+    uint16 i;
+
+    for ( i = 0; i < serverNumAttrs; i++ )
+    {
+        gattAttribute_t *pAttr = &serverAttrs[i];
+
+        if ( pAttr->type.len == ATT_BT_UUID_SIZE &&
+             pAttr->type.uuid != characterUUID &&
+             BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1] ) == uuid )
+        {
+            return ( pAttr );
+        }
+    }
+
+    return ( NULL );
+}
+
+/*********************************************************************
+ * GATT SERVER APPLICATION
+ */
+
+bStatus_t GATTServApp_AddService( uint32 services )
+{
+    VOID services;
+
+    return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_RegisterService( gattAttribute_t *pAttrs, uint16 numAttrs,
+                                       CONST gattServiceCBs_t *pServiceCBs )
+{
+    if ( serverAttrs != NULL )
+    {
+        return ( bleNoResources );
+    }
+
+    serverAttrs = pAttrs;
+    serverNumAttrs = numAttrs;
+    serverCBs = pServiceCBs;
+
+    return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_SetParameter( uint8 param, uint8 len, void *value )
+{
+    VOID param;
+    VOID len;
+    VOID value;
+
+    return ( SUCCESS );
+}
+
+void GATTServApp_InitCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+    uint8 i;
+
+    for ( i = 0; i < GATT_MAX_NUM_CONN; i++ )
+    {
+        if ( connHandle == INVALID_CONNHANDLE || charCfgTbl[i].connHandle == connHandle )
+        {
+            charCfgTbl[i].connHandle = INVALID_CONNHANDLE;
+            charCfgTbl[i].value = GATT_CFG_NO_OPERATION;
+        }
+    }
+}
+
+uint16 GATTServApp_ReadCharCfg( uint16 connHandle, gattCharCfg_t *charCfgTbl )
+{
+    uint8 i;
+
+    for ( i = 0; i < GATT_MAX_NUM_CONN; i++ )
+    {
+        if ( charCfgTbl[i].connHandle == connHandle )
+        {
+            return ( charCfgTbl[i].value );
+        }
+    }
+
+    return ( GATT_CFG_NO_OPERATION );
+}
+
+bStatus_t GATTServApp_ProcessCCCWriteReq( uint16 connHandle, gattAttribute_t *pAttr,
+                                          uint8 *pValue, uint8 len, uint16 offset,
+                                          uint16 validCfg )
+{
+    gattCharCfg_t *pCfg = (gattCharCfg_t *)pAttr->pValue;
+    uint16 value;
+
+    if ( offset != 0 )
+    {
+        return ( ATT_ERR_ATTR_NOT_LONG );
+    }
+
+    if ( len != 2 )
+    {
+        return ( ATT_ERR_INVALID_VALUE_SIZE );
+    }
+
+    value = BUILD_UINT16( pValue[0], pValue[1] );
+    if ( value != GATT_CFG_NO_OPERATION && value != validCfg )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    pCfg[0].connHandle = connHandle;
+    pCfg[0].value = (uint8)value;
+
+    return ( SUCCESS );
+}
+
+bStatus_t GATTServApp_ProcessCharCfg( gattCharCfg_t *charCfgTbl, uint8 *pValue,
+                                      uint8 authenticated, gattAttribute_t *attrTbl,
+                                      uint16 numAttrs, uint8 taskId )
+{
+    uint8 buf[ATT_MTU_SIZE];
+    uint8 len = 0;
+    uint16 i;
+
+    VOID authenticated;
+    VOID taskId;
+
+    if ( !linkUp || GATTServApp_ReadCharCfg( BLE_HOST_CONN_HANDLE, charCfgTbl ) != GATT_CLIENT_CFG_NOTIFY )
+    {
+        return ( SUCCESS );
+    }
+
+    for ( i = 0; i < numAttrs; i++ )
+    {
+        if ( attrTbl[i].pValue == pValue )
+        {
+            if ( serverCBs->pfnReadAttrCB( BLE_HOST_CONN_HANDLE, &attrTbl[i], buf, &len, 0,
+                                           ATT_MTU_SIZE - 3 ) == SUCCESS && notifyCB != NULL )
+            {
+                notifyCB( BUILD_UINT16( attrTbl[i].type.uuid[0], attrTbl[i].type.uuid[1] ), buf, len );
+            }
+            break;
+        }
+    }
+
+    return ( SUCCESS );
+}
+
+uint8 linkDB_Register( pfnLinkDBCB_t pFunc )
+{
+    linkCB = pFunc;
+
+    return ( SUCCESS );
+}
+
+uint8 linkDB_Up( uint16 connectionHandle )
+{
+    return ( linkUp && connectionHandle == BLE_HOST_CONN_HANDLE );
+}
+
+/*********************************************************************
+ * GAP AND THE PERIPHERAL ROLE
+ */
+
+bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
+{
+    if ( param < GAPROLE_PROFILEROLE || param > GAPROLE_STATE || len > BLE_HOST_ROLE_PARAM_LEN )
+    {
+        return ( INVALIDPARAMETER );
+    }
+
+    memcpy( roleParams[param - GAPROLE_PROFILEROLE], pValue, len );
+    roleParamLen[param - GAPROLE_PROFILEROLE] = len;
+
+    if ( param == GAPROLE_ADVERT_ENABLED )
+    {
+        advertEnabled = *(uint8 *)pValue;
+        advertise();
+    }
+
+    return ( SUCCESS );
+}
+
+bStatus_t GAPRole_GetParameter( uint16 param, void *pValue )
+{
+    static CONST uint8 bdAddr[B_ADDR_LEN] = { 0x01, 0x00, 0x00, 0x00, 0x54, 0x1C };
+
+    switch ( param )
+    {
+        case GAPROLE_BD_ADDR:
+            memcpy( pValue, bdAddr, B_ADDR_LEN );
+            break;
+
+        case GAPROLE_ADVERT_ENABLED:
+            *(uint8 *)pValue = advertEnabled;
+            break;
+
+        case GAPROLE_CONNHANDLE:
+            *(uint16 *)pValue = linkUp ? BLE_HOST_CONN_HANDLE : INVALID_CONNHANDLE;
+            break;
+
+        case GAPROLE_CONN_INTERVAL:
+            *(uint16 *)pValue = linkInterval;
+            break;
+
+        case GAPROLE_CONN_LATENCY:
+            *(uint16 *)pValue = linkLatency;
+            break;
+
+        case GAPROLE_CONN_TIMEOUT:
+            *(uint16 *)pValue = linkTimeout;
+            break;
+
+        case GAPROLE_STATE:
+            *(uint8 *)pValue = (uint8)roleState;
+            break;
+
+        default:
+            if ( param < GAPROLE_PROFILEROLE || param > GAPROLE_STATE )
+            {
+                return ( INVALIDPARAMETER );
+            }
+            memcpy( pValue, roleParams[param - GAPROLE_PROFILEROLE], roleParamLen[param - GAPROLE_PROFILEROLE] );
+            break;
+    }
+
+    return ( SUCCESS );
+}
+
+bStatus_t GAPRole_StartDevice( gapRolesCBs_t *pAppCallbacks )
+{
+    if ( roleState != GAPROLE_INIT )
+    {
+        return ( bleAlreadyInRequestedMode );
+    }
+
+    roleCBs = pAppCallbacks;
+    roleChange( GAPROLE_STARTED );
+    advertise();
+
+    return ( SUCCESS );
+}
+
+bStatus_t GAPRole_TerminateConnection( void )
+{
+    if ( !linkUp )
+    {
+        return ( bleIncorrectMode );
+    }
+
+    bleHostDisconnect();
+
+    return ( SUCCESS );
+}
+
+bStatus_t GAPRole_SendUpdateParam( uint16 minConnInterval, uint16 maxConnInterval,
+                                   uint16 latency, uint16 connTimeout,
+                                   uint8 handleFailure )
+{
+    VOID minConnInterval;
+    VOID handleFailure;
+
+    if ( !linkUp )
+    {
+        return ( bleNotConnected );
+    }
+
+    // The central grants the longest interval asked for
+    linkParams( maxConnInterval, latency, connTimeout );
+
+    return ( SUCCESS );
+}
+
+bStatus_t GAP_SetParamValue( uint16 paramID, uint16 paramValue )
+{
+    if ( paramID >= TGAP_PARAMID_MAX )
+    {
+        return ( INVALIDPARAMETER );
+    }
+
+    gapParams[paramID] = paramValue;
+
+    return ( SUCCESS );
+}
+
+uint16 GAP_GetParamValue( uint16 paramID )
+{
+    return ( (paramID < TGAP_PARAMID_MAX) ? gapParams[paramID] : 0 );
+}
+
+bStatus_t GAPBondMgr_SetParameter( uint16 param, uint8 len, void *pValue )
+{
+    VOID param;
+    VOID len;
+    VOID pValue;
+
+    return ( SUCCESS );
+}
+
+bStatus_t GAPBondMgr_Register( gapBondCBs_t *pCB )
+{
+    VOID pCB;
+
+    return ( SUCCESS );
+}
+
+bStatus_t GGS_AddService( uint32 services )
+{
+    VOID services;
+
+    return ( SUCCESS );
+}
+
+bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value )
+{
+    VOID param;
+    VOID len;
+    VOID value;
+
+    return ( SUCCESS );
+}
+
+bStatus_t DevInfo_AddService( void )
+{
+    return ( SUCCESS );
+}
+
+bStatus_t DevInfo_SetParameter( uint8 param, uint8 len, void *value )
+{
+    VOID param;
+    VOID len;
+    VOID value;
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * HCI AND LINK LAYER
+ */
+
+hciStatus_t HCI_EXT_ClkDivOnHaltCmd( uint8 control )
+{
+    VOID control;
+
+    return ( SUCCESS );
+}
+
+hciStatus_t HCI_EXT_MapPmIoPortCmd( uint8 ioPort, uint8 ioPin )
+{
+    VOID ioPort;
+    VOID ioPin;
+
+    return ( SUCCESS );
+}
+
+hciStatus_t HCI_EXT_AdvEventNoticeCmd( uint8 taskID, uint16 taskEvent )
+{
+    advNoticeTask = taskID;
+    advNoticeEvent = taskEvent;
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,350 @@
+/**************************************************************************************************
+  Filename:       hal_host.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host HAL. Keeps the port, Timer 1 and sleep timer registers,
+                  raises the Timer 1 compare interrupt at its due time on the
+                  virtual clock and records every port 0 edge. LCD lines are
+                  kept as text.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "hal_mcu.h"
+#include "hal_lcd.h"
+#include "hal_led.h"
+
+#include "host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// T1CTL
+#define T1CTL_DIV_SHIFT                     2
+#define T1CTL_DIV_MASK                      0x0C
+#define T1CTL_MODE_MASK                     0x03
+
+// T1CCTL0, T1STAT
+#define T1CCTL_IM                           0x40
+#define T1STAT_CH0IF                        0x01
+
+// Timer 1 runs from the 32 MHz tick
+#define HAL_HOST_TICK_MHZ                   32
+
+#define HAL_HOST_SLEEP_TIMER_HZ             32768
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// Reset values
+volatile uint8 P0 = 0xFF, P1 = 0xFF, P2 = 0x1F;
+volatile uint8 P0DIR = 0, P1DIR = 0, P2DIR = 0;
+volatile uint8 P0SEL = 0, P1SEL = 0, P2SEL = 0;
+
+volatile uint8 T1CTL = 0, T1STAT = 0;
+volatile uint8 T1CC0L = 0, T1CC0H = 0;
+volatile uint8 T1CCTL0 = 0;
+volatile uint8 TIMIF = 0;
+volatile uint8 T1IE = 0, T1IF = 0;
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+// Vector table, filled in by HAL_ISR_FUNCTION
+extern void (* const halHostVector_T1_VECTOR)( void );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static volatile uint8 t1Count = 0;
+static uint8 t1Restart = FALSE;
+static uint64_t t1Due = HOST_NEVER;
+
+static uint32 sleepTimerLatch = 0;
+
+static uint8 lastP0 = 0xFF;
+static hostEdgeCB_t edgeCB = NULL;
+
+static char lcdLines[HAL_LCD_MAX_LINES][HAL_LCD_MAX_CHARS + 1];
+static FILE *lcdFile = NULL;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint32 timer1TickNs( void );
+
+/*********************************************************************
+ * HOST FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      halHostReset
+ *
+ * @brief   Put the registers back to their reset values and clear the
+ *          display. The edge callback and LCD output are kept.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void halHostReset( void )
+{
+    P0 = 0xFF;
+    P1 = 0xFF;
+    P2 = 0x1F;
+    P0DIR = P1DIR = P2DIR = 0;
+    P0SEL = P1SEL = P2SEL = 0;
+    lastP0 = P0;
+
+    T1CTL = T1STAT = 0;
+    T1CC0L = T1CC0H = 0;
+    T1CCTL0 = 0;
+    TIMIF = 0;
+    T1IE = T1IF = 0;
+    t1Count = 0;
+    t1Restart = FALSE;
+    t1Due = HOST_NEVER;
+
+    memset( lcdLines, 0, sizeof( lcdLines ) );
+}
+
+/*********************************************************************
+ * @fn      halHostNext
+ *
+ * @brief   Find when Timer 1 next matches its channel 0 compare value.
+ *          The timer is restarted by a write to T1CNTL; the due time
+ *          is worked out once the firmware has returned, when the
+ *          compare value and mode written with it are in place.
+ *
+ * @param   none
+ *
+ * @return  device time of the compare, HOST_NEVER while suspended
+ */
+uint64_t halHostNext( void )
+{
+    uint16 compare = BUILD_UINT16( T1CC0L, T1CC0H );
+
+    if ( (T1CTL & T1CTL_MODE_MASK) == 0 )
+    {
+        t1Restart = FALSE;
+        t1Due = HOST_NEVER;
+        return ( HOST_NEVER );
+    }
+
+    if ( t1Restart || t1Due == HOST_NEVER )
+    {
+        t1Restart = FALSE;
+        t1Due = osalHostNow() + ((uint64_t)compare * timer1TickNs() + 999) / 1000;
+    }
+
+    return ( t1Due );
+}
+
+/*********************************************************************
+ * @fn      halHostPoll
+ *
+ * @brief   Take the Timer 1 interrupt if its compare is due. The
+ *          interrupt preempts whatever else is running.
+ *
+ * @param   nowUs - device time
+ *
+ * @return  none
+ */
+void halHostPoll( uint64_t nowUs )
+{
+    if ( halHostNext() > nowUs )
+    {
+        return;
+    }
+
+    // A free running timer matches again after wrapping
+    t1Due += (0x10000ULL * timer1TickNs()) / 1000;
+
+    T1STAT |= T1STAT_CH0IF;
+    T1IF = 1;
+
+    if ( T1IE && (T1CCTL0 & T1CCTL_IM) )
+    {
+        halHostVector_T1_VECTOR();
+        halHostSample();
+    }
+}
+
+/*********************************************************************
+ * @fn      halHostSample
+ *
+ * @brief   Record the port 0 lines that changed since the last sample.
+ *          Called after every piece of firmware work and from the
+ *          application's line hook.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void halHostSample( void )
+{
+    uint8 changed = P0 ^ lastP0;
+
+    if ( changed == 0 )
+    {
+        return;
+    }
+
+    lastP0 = P0;
+
+    if ( edgeCB != NULL )
+    {
+        edgeCB( osalHostNow(), lastP0, changed );
+    }
+}
+
+/*********************************************************************
+ * @fn      halHostSetEdgeCB
+ *
+ * @brief   Have every port 0 change passed to a function.
+ *
+ * @param   pfnEdge - the function, NULL for none
+ *
+ * @return  none
+ */
+void halHostSetEdgeCB( hostEdgeCB_t pfnEdge )
+{
+    edgeCB = pfnEdge;
+}
+
+/*********************************************************************
+ * @fn      halHostSetLcd
+ *
+ * @brief   Echo LCD writes to a file, with the time of each.
+ *
+ * @param   pFile - the file, NULL for none
+ *
+ * @return  none
+ */
+void halHostSetLcd( FILE *pFile )
+{
+    lcdFile = pFile;
+}
+
+/*********************************************************************
+ * @fn      halHostLcdLine
+ *
+ * @brief   Get what an LCD line shows.
+ *
+ * @param   line - HAL_LCD_LINE_1 ... HAL_LCD_LINE_8
+ *
+ * @return  the text, empty for a line out of range
+ */
+const char *halHostLcdLine( uint8 line )
+{
+    if ( line < HAL_LCD_LINE_1 || line > HAL_LCD_MAX_LINES )
+    {
+        return ( "" );
+    }
+
+    return ( lcdLines[line - HAL_LCD_LINE_1] );
+}
+
+/*********************************************************************
+ * REGISTER ACCESS
+ */
+
+volatile uint8 *halHostTimer1Count( void )
+{
+    t1Restart = TRUE;
+
+    return ( &t1Count );
+}
+
+uint8 halHostSleepTimer( uint8 index )
+{
+    // Reading ST0 latches ST1 and ST2
+    if ( index == 0 )
+    {
+        sleepTimerLatch = (uint32)((osalHostSleepClock() * HAL_HOST_SLEEP_TIMER_HZ) / 1000000);
+    }
+
+    return ( (uint8)(sleepTimerLatch >> (8 * index)) );
+}
+
+/*********************************************************************
+ * @fn      timer1TickNs
+ *
+ * @brief   Get the Timer 1 tick for the prescaler in T1CTL.
+ *
+ * @param   none
+ *
+ * @return  nanoseconds per tick
+ */
+static uint32 timer1TickNs( void )
+{
+    static CONST uint8 divider[] = { 1, 8, 32, 128 };
+
+    return ( (uint32)divider[(T1CTL & T1CTL_DIV_MASK) >> T1CTL_DIV_SHIFT] * 1000 / HAL_HOST_TICK_MHZ );
+}
+
+/*********************************************************************
+ * LCD AND LED
+ */
+
+void HalLcdWriteString( char *str, uint8 option )
+{
+    if ( option < HAL_LCD_LINE_1 || option > HAL_LCD_MAX_LINES )
+    {
+        return;
+    }
+
+    snprintf( lcdLines[option - HAL_LCD_LINE_1], HAL_LCD_MAX_CHARS + 1, "%s", str );
+
+    if ( lcdFile != NULL )
+    {
+        fprintf( lcdFile, "%10llu LCD%u %s\n", (unsigned long long)osalHostNow(), option, str );
+    }
+}
+
+void HalLcdWriteValue( uint32 value, const uint8 radix, uint8 option )
+{
+    char buf[12];
+
+    snprintf( buf, sizeof( buf ), (radix == 16) ? "%X" : "%u", (unsigned)value );
+    HalLcdWriteString( buf, option );
+}
+
+void HalLcdWriteStringValue( char *title, uint16 value, uint8 format, uint8 line )
+{
+    char buf[HAL_LCD_MAX_CHARS * 2];
+
+    snprintf( buf, sizeof( buf ), (format == 16) ? "%s %X" : "%s %u", title, value );
+    HalLcdWriteString( buf, line );
+}
+
+void HalLcdWriteStringValueValue( char *title, uint16 value1, uint8 format1,
+                                  uint16 value2, uint8 format2, uint8 line )
+{
+    char buf[HAL_LCD_MAX_CHARS * 2];
+    char v1[8];
+    char v2[8];
+
+    snprintf( v1, sizeof( v1 ), (format1 == 16) ? "%X" : "%u", value1 );
+    snprintf( v2, sizeof( v2 ), (format2 == 16) ? "%X" : "%u", value2 );
+    snprintf( buf, sizeof( buf ), "%s %s, %s", title, v1, v2 );
+    HalLcdWriteString( buf, line );
+}
+
+uint8 HalLedSet( uint8 led, uint8 mode )
+{
+    VOID led;
+    VOID mode;
+
+    return ( 0 );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,85 @@
+/**************************************************************************************************
+  Filename:       host.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Interfaces between the host stand-ins. osal_host.c keeps the
+                  virtual clock and runs the task; hal_host.c and ble_host.c
+                  each say when they next need the CPU and do that work when
+                  polled at that time.
+**************************************************************************************************/
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// No work pending
+#define HOST_NEVER                          UINT64_MAX
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef uint16 (*hostEventHandler_t)( uint8 task_id, uint16 events );
+
+// Port 0 changed: the new level of every line and the lines that changed
+typedef void (*hostEdgeCB_t)( uint64_t timeUs, uint8 port, uint8 changed );
+
+// A notification went out on the link
+typedef void (*hostNotifyCB_t)( uint16 uuid, uint8 *pValue, uint8 len );
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * osal_host.c - virtual clock, task events, timers, SNV and power manager
+ */
+extern void osalHostReset( uint8 taskId, hostEventHandler_t pfnHandler );
+extern uint64_t osalHostNow( void );
+extern void osalHostRun( uint64_t untilUs );
+extern void osalHostSetLoad( uint32 periodUs, uint32 holdUs, uint32 seed );
+extern void osalHostSetWork( uint32 workUs );
+extern uint64_t osalHostSleepClock( void );
+extern uint32 osalHostSnvWrites( void );
+extern void osalHostSaveSnv( FILE *pFile );
+extern void osalHostLoadSnv( FILE *pFile );
+extern uint8 osalHostPowerHeld( void );
+extern uint64_t osalHostPowerHeldUs( void );
+extern uint32 osalHostWakes( void );
+
+/*
+ * hal_host.c - ports, Timer 1, sleep timer and LCD
+ */
+extern void halHostReset( void );
+extern uint64_t halHostNext( void );
+extern void halHostPoll( uint64_t nowUs );
+extern void halHostSample( void );
+extern void halHostSetEdgeCB( hostEdgeCB_t pfnEdge );
+extern void halHostSetLcd( FILE *pFile );
+extern const char *halHostLcdLine( uint8 line );
+
+/*
+ * ble_host.c - GATT server, peripheral role, the central and the radio
+ */
+extern void bleHostReset( void );
+extern uint64_t bleHostNext( void );
+extern void bleHostPoll( uint64_t nowUs );
+extern void bleHostConnect( uint16 interval );
+extern void bleHostDisconnect( void );
+extern uint8 bleHostConnected( void );
+extern bStatus_t bleHostWrite( uint16 uuid, uint8 *pValue, uint8 len, uint16 offset );
+extern bStatus_t bleHostRead( uint16 uuid, uint8 *pValue, uint8 *pLen, uint16 offset );
+extern bStatus_t bleHostSubscribe( uint16 uuid, uint8 enable );
+extern void bleHostSetNotifyCB( hostNotifyCB_t pfnNotify );
+extern uint32 bleHostAdvEvents( void );
+extern uint32 bleHostConnEvents( void );
+extern uint16 bleHostConnInterval( void );
+extern uint16 bleHostConnLatency( void );
+
+#endif /* HOST_H */
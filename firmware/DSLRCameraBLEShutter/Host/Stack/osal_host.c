@@ -0,0 +1,640 @@
+/**************************************************************************************************
+  Filename:       osal_host.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host OSAL. A virtual clock in microseconds replaces the sleep
+                  timer, and the run loop jumps from one due piece of work to
+                  the next, so hours of device time pass in milliseconds.
+                  The stack task's share of the CPU can be injected as load:
+                  while it holds the CPU the application task's events wait,
+                  interrupts don't. The application task's own work can be
+                  given a time too, for the active time it accounts.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_PwrMgr.h"
+#include "osal_snv.h"
+
+#include "host.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// One timer per event bit of the task
+#define OSAL_HOST_TIMERS                    16
+
+// A pass of the OSAL loop through the stack tasks, taken before an event
+// the task set again while handling it comes round
+#define OSAL_HOST_PASS_US                   50
+
+#define OSAL_HOST_SNV_ITEMS                 256
+#define OSAL_HOST_SNV_ITEM_LEN              255
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint64_t osalNow = 0;                // device time in us
+
+static uint8 osalTaskId = INVALID_TASK_ID;
+static hostEventHandler_t osalHandler = NULL;
+static uint16 osalEvents = 0;
+
+static uint16 osalTimerEvent[OSAL_HOST_TIMERS];
+static uint64_t osalTimerDue[OSAL_HOST_TIMERS];
+
+// Injected stack task load: once in every period the stack task holds the
+// CPU for up to holdUs, a different share at a different time each period
+static uint32 osalLoadPeriod = 0;
+static uint32 osalLoadHold = 0;
+static uint32 osalLoadSeed = 0;
+
+// Time each run of the task takes, and the sleep timer reads in the run
+// going on, 0 outside one
+static uint32 osalWorkUs = 0;
+static uint8 osalWorkReads = 0;
+static uint8 osalInTask = FALSE;
+
+static uint8 osalPowerHeld = 0;
+static uint64_t osalPowerHeldSince = 0;
+static uint64_t osalPowerHeldUs = 0;
+
+// Times the task ran after the device had been idle
+static uint32 osalWakes = 0;
+static uint64_t osalLastRun = HOST_NEVER;
+
+static uint8 osalSnv[OSAL_HOST_SNV_ITEMS][OSAL_HOST_SNV_ITEM_LEN];
+static uint8 osalSnvLen[OSAL_HOST_SNV_ITEMS];
+static uint32 osalSnvWrites = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint64_t osalHeldUntil( uint64_t now );
+static void osalExpireTimers( void );
+static uint64_t osalNextTimer( void );
+
+/*********************************************************************
+ * HOST FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      osalHostReset
+ *
+ * @brief   Start the clock over at 0 with no events, timers or load,
+ *          and run the given task from now on. SNV items are kept, as
+ *          across a device reset.
+ *
+ * @param   taskId - ID the task was initialized with
+ * @param   pfnHandler - the task's event processor
+ *
+ * @return  none
+ */
+void osalHostReset( uint8 taskId, hostEventHandler_t pfnHandler )
+{
+    osalNow = 0;
+    osalTaskId = taskId;
+    osalHandler = pfnHandler;
+    osalEvents = 0;
+    memset( osalTimerEvent, 0, sizeof( osalTimerEvent ) );
+    osalLoadPeriod = 0;
+    osalLoadHold = 0;
+    osalWorkUs = 0;
+    osalPowerHeld = 0;
+    osalPowerHeldUs = 0;
+    osalWakes = 0;
+    osalLastRun = HOST_NEVER;
+}
+
+/*********************************************************************
+ * @fn      osalHostNow
+ *
+ * @brief   Get the virtual clock.
+ *
+ * @param   none
+ *
+ * @return  device time in microseconds
+ */
+uint64_t osalHostNow( void )
+{
+    return ( osalNow );
+}
+
+/*********************************************************************
+ * @fn      osalHostSetLoad
+ *
+ * @brief   Inject stack task load. 0 for either time removes it.
+ *
+ * @param   periodUs - how often the stack task takes the CPU
+ * @param   holdUs - the longest it holds it for
+ * @param   seed - picks the share it takes in each period
+ *
+ * @return  none
+ */
+void osalHostSetLoad( uint32 periodUs, uint32 holdUs, uint32 seed )
+{
+    osalLoadPeriod = (holdUs != 0) ? periodUs : 0;
+    osalLoadHold = (holdUs < periodUs) ? holdUs : periodUs;
+    osalLoadSeed = seed;
+}
+
+/*********************************************************************
+ * @fn      osalHostSetWork
+ *
+ * @brief   Have each run of the task take a time. The clock moves on by
+ *          that much after the run, and the sleep timer reads its end
+ *          from the second read in the run on, so time the task takes
+ *          between two reads counts it. 0 makes work take no time.
+ *
+ * @param   workUs - time a run of the task takes
+ *
+ * @return  none
+ */
+void osalHostSetWork( uint32 workUs )
+{
+    osalWorkUs = workUs;
+}
+
+/*********************************************************************
+ * @fn      osalHostSleepClock
+ *
+ * @brief   Get the time the sleep timer reads, see osalHostSetWork.
+ *
+ * @param   none
+ *
+ * @return  device time in microseconds
+ */
+uint64_t osalHostSleepClock( void )
+{
+    if ( osalInTask && osalWorkReads++ > 0 )
+    {
+        return ( osalNow + osalWorkUs );
+    }
+
+    return ( osalNow );
+}
+
+/*********************************************************************
+ * @fn      osalHostRun
+ *
+ * @brief   Run the device up to the given time. Timers that come due
+ *          set their events, interrupts and the radio are serviced at
+ *          the moment they are due and the task handles its events as
+ *          soon as the stack task lets it. Work takes no time unless
+ *          osalHostSetWork gives it some.
+ *
+ * @param   untilUs - device time to stop at
+ *
+ * @return  none
+ */
+void osalHostRun( uint64_t untilUs )
+{
+    for ( ;; )
+    {
+        uint64_t next;
+        uint64_t held;
+
+        osalExpireTimers();
+        halHostPoll( osalNow );
+        bleHostPoll( osalNow );
+
+        held = osalHeldUntil( osalNow );
+        if ( osalEvents && held == osalNow && osalNow <= untilUs )
+        {
+            uint16 events = osalEvents;
+
+            if ( osalLastRun != osalNow )
+            {
+                osalWakes++;
+            }
+
+            osalEvents = 0;
+            osalInTask = TRUE;
+            osalWorkReads = 0;
+            osalEvents |= osalHandler( osalTaskId, events );
+            osalInTask = FALSE;
+            halHostSample();
+
+            // A Timer 1 pulse the work started counts from now, before
+            // any pass below
+            VOID halHostNext();
+            osalNow += osalWorkUs;
+
+            // Time passes before a task sees an event it set again while
+            // handling it, or one yielding to itself would run forever at
+            // one instant
+            if ( osalEvents & events )
+            {
+                osalNow += OSAL_HOST_PASS_US;
+            }
+            osalLastRun = osalNow;
+            continue;
+        }
+
+        next = osalNextTimer();
+        next = MIN( next, halHostNext() );
+        next = MIN( next, bleHostNext() );
+        if ( osalEvents )
+        {
+            next = MIN( next, held );
+        }
+
+        if ( next > untilUs )
+        {
+            osalNow = MAX( osalNow, untilUs );
+            return;
+        }
+
+        osalNow = next;
+    }
+}
+
+/*********************************************************************
+ * @fn      osalHostSnvWrites
+ *
+ * @brief   Get the number of SNV writes since the process started.
+ *
+ * @param   none
+ *
+ * @return  writes
+ */
+uint32 osalHostSnvWrites( void )
+{
+    return ( osalSnvWrites );
+}
+
+/*********************************************************************
+ * @fn      osalHostSaveSnv
+ *
+ * @brief   Write every SNV item to a file.
+ *
+ * @param   pFile - where to
+ *
+ * @return  none
+ */
+void osalHostSaveSnv( FILE *pFile )
+{
+    fwrite( osalSnvLen, sizeof( osalSnvLen ), 1, pFile );
+    fwrite( osalSnv, sizeof( osalSnv ), 1, pFile );
+}
+
+/*********************************************************************
+ * @fn      osalHostLoadSnv
+ *
+ * @brief   Replace the SNV items with those osalHostSaveSnv wrote. A
+ *          short file leaves no items.
+ *
+ * @param   pFile - where from
+ *
+ * @return  none
+ */
+void osalHostLoadSnv( FILE *pFile )
+{
+    if ( fread( osalSnvLen, sizeof( osalSnvLen ), 1, pFile ) != 1 ||
+         fread( osalSnv, sizeof( osalSnv ), 1, pFile ) != 1 )
+    {
+        memset( osalSnvLen, 0, sizeof( osalSnvLen ) );
+    }
+}
+
+/*********************************************************************
+ * @fn      osalHostPowerHeld
+ *
+ * @brief   Check whether a task keeps the device out of PM2/PM3.
+ *
+ * @param   none
+ *
+ * @return  TRUE while a task holds the power manager
+ */
+uint8 osalHostPowerHeld( void )
+{
+    return ( osalPowerHeld != 0 );
+}
+
+/*********************************************************************
+ * @fn      osalHostPowerHeldUs
+ *
+ * @brief   Get how long a task has kept the device out of PM2/PM3
+ *          since reset.
+ *
+ * @param   none
+ *
+ * @return  device time held, us
+ */
+uint64_t osalHostPowerHeldUs( void )
+{
+    return ( osalPowerHeldUs + (osalPowerHeld ? osalNow - osalPowerHeldSince : 0) );
+}
+
+/*********************************************************************
+ * @fn      osalHostWakes
+ *
+ * @brief   Get the number of times the task ran since reset, work at
+ *          the same moment counting once.
+ *
+ * @param   none
+ *
+ * @return  wakes
+ */
+uint32 osalHostWakes( void )
+{
+    return ( osalWakes );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      osalHeldUntil
+ *
+ * @brief   Find when the stack task gives the CPU back.
+ *
+ * @param   now - device time
+ *
+ * @return  now when the CPU is free, else the time it comes free
+ */
+static uint64_t osalHeldUntil( uint64_t now )
+{
+    uint64_t period;
+    uint64_t start;
+    uint32 hold;
+    uint32 x;
+
+    if ( osalLoadPeriod == 0 )
+    {
+        return ( now );
+    }
+
+    period = now / osalLoadPeriod;
+
+    // xorshift of the period number, the same window each time it is asked
+    x = (uint32)period ^ osalLoadSeed ^ 0x9E3779B9;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    // The window lands anywhere in the period, so frames on a period that
+    // divides the load period still meet it
+    hold = x % (osalLoadHold + 1);
+    start = period * osalLoadPeriod + (x >> 12) % (osalLoadPeriod - hold + 1);
+
+    return ( (now >= start && now < start + hold) ? start + hold : now );
+}
+
+/*********************************************************************
+ * @fn      osalExpireTimers
+ *
+ * @brief   Set the events of the timers that are due.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void osalExpireTimers( void )
+{
+    uint8 i;
+
+    for ( i = 0; i < OSAL_HOST_TIMERS; i++ )
+    {
+        if ( osalTimerEvent[i] && osalTimerDue[i] <= osalNow )
+        {
+            osalEvents |= osalTimerEvent[i];
+            osalTimerEvent[i] = 0;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      osalNextTimer
+ *
+ * @brief   Find the earliest running timer.
+ *
+ * @param   none
+ *
+ * @return  its due time, HOST_NEVER when none runs
+ */
+static uint64_t osalNextTimer( void )
+{
+    uint64_t next = HOST_NEVER;
+    uint8 i;
+
+    for ( i = 0; i < OSAL_HOST_TIMERS; i++ )
+    {
+        if ( osalTimerEvent[i] )
+        {
+            next = MIN( next, osalTimerDue[i] );
+        }
+    }
+
+    return ( next );
+}
+
+/*********************************************************************
+ * OSAL API
+ */
+
+uint8 *osal_msg_receive( uint8 task_id )
+{
+    VOID task_id;
+
+    return ( NULL );
+}
+
+uint8 osal_msg_deallocate( uint8 *msg_ptr )
+{
+    VOID msg_ptr;
+
+    return ( SUCCESS );
+}
+
+uint8 osal_set_event( uint8 task_id, uint16 event_flag )
+{
+    if ( task_id != osalTaskId )
+    {
+        return ( INVALID_TASK );
+    }
+
+    osalEvents |= event_flag;
+
+    return ( SUCCESS );
+}
+
+uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
+{
+    if ( task_id != osalTaskId )
+    {
+        return ( INVALID_TASK );
+    }
+
+    osalEvents &= ~event_flag;
+
+    return ( SUCCESS );
+}
+
+uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value )
+{
+    uint8 free = OSAL_HOST_TIMERS;
+    uint8 i;
+
+    if ( task_id != osalTaskId )
+    {
+        return ( INVALID_TASK );
+    }
+
+    // A running timer for the event is restarted, as OSAL does
+    for ( i = 0; i < OSAL_HOST_TIMERS; i++ )
+    {
+        if ( osalTimerEvent[i] == event_id )
+        {
+            break;
+        }
+
+        if ( osalTimerEvent[i] == 0 && free == OSAL_HOST_TIMERS )
+        {
+            free = i;
+        }
+    }
+
+    if ( i == OSAL_HOST_TIMERS )
+    {
+        if ( free == OSAL_HOST_TIMERS )
+        {
+            return ( NO_TIMER_AVAIL );
+        }
+        i = free;
+    }
+
+    // Timers count the same 1 ms ticks as the system clock
+    osalTimerEvent[i] = event_id;
+    osalTimerDue[i] = (osalNow / 1000 + timeout_value) * 1000;
+
+    return ( SUCCESS );
+}
+
+uint8 osal_stop_timerEx( uint8 task_id, uint16 event_id )
+{
+    uint8 i;
+
+    for ( i = 0; i < OSAL_HOST_TIMERS; i++ )
+    {
+        if ( task_id == osalTaskId && osalTimerEvent[i] == event_id )
+        {
+            osalTimerEvent[i] = 0;
+            return ( SUCCESS );
+        }
+    }
+
+    return ( INVALID_EVENT_ID );
+}
+
+uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
+{
+    uint8 i;
+
+    for ( i = 0; i < OSAL_HOST_TIMERS; i++ )
+    {
+        if ( task_id == osalTaskId && osalTimerEvent[i] == event_id )
+        {
+            return ( (uint32)((osalTimerDue[i] - osalNow + 999) / 1000) );
+        }
+    }
+
+    return ( 0 );
+}
+
+uint32 osal_GetSystemClock( void )
+{
+    return ( (uint32)(osalNow / 1000) );
+}
+
+void *osal_memcpy( void *dst, const void *src, unsigned int len )
+{
+    return ( memcpy( dst, src, len ) );
+}
+
+void *osal_memset( void *dest, uint8 value, int len )
+{
+    return ( memset( dest, value, len ) );
+}
+
+uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+    return ( memcmp( src1, src2, len ) == 0 );
+}
+
+void *osal_mem_alloc( uint16 size )
+{
+    return ( malloc( size ) );
+}
+
+void osal_mem_free( void *ptr )
+{
+    free( ptr );
+}
+
+uint8 osal_pwrmgr_task_state( uint8 task_id, uint8 state )
+{
+    if ( task_id != osalTaskId )
+    {
+        return ( INVALID_TASK );
+    }
+
+    if ( state == PWRMGR_HOLD && !osalPowerHeld )
+    {
+        osalPowerHeldSince = osalNow;
+    }
+    else if ( state != PWRMGR_HOLD && osalPowerHeld )
+    {
+        osalPowerHeldUs += osalNow - osalPowerHeldSince;
+    }
+
+    osalPowerHeld = (state == PWRMGR_HOLD);
+
+    return ( SUCCESS );
+}
+
+void osal_pwrmgr_device( uint8 pwrmgr_device )
+{
+    VOID pwrmgr_device;
+}
+
+uint8 osal_snv_init( void )
+{
+    return ( SUCCESS );
+}
+
+uint8 osal_snv_read( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+    if ( osalSnvLen[id] == 0 || len > osalSnvLen[id] )
+    {
+        return ( NV_OPER_FAILED );
+    }
+
+    memcpy( pBuf, osalSnv[id], len );
+
+    return ( SUCCESS );
+}
+
+uint8 osal_snv_write( osalSnvId_t id, osalSnvLen_t len, void *pBuf )
+{
+    if ( len == 0 )
+    {
+        return ( NV_OPER_FAILED );
+    }
+
+    memcpy( osalSnv[id], pBuf, len );
+    osalSnvLen[id] = len;
+    osalSnvWrites++;
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,100 @@
+/**************************************************************************************************
+  Filename:       host_test.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Checks for the host tests. The application keeps its state
+                  in statics, so every test runs in a child process on a
+                  device fresh from power on. A failed check prints where and
+                  what, and the test exits non-zero once all have run.
+**************************************************************************************************/
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "DSLRCameraBLEShutter_Host.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define CHECK( cond ) \
+    st( if ( !(cond) ) \
+        { \
+            hostTestFailures++; \
+            fprintf( stderr, "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #cond ); \
+        } )
+
+#define CHECK_EQ( a, b ) \
+    st( long long va_ = (long long)(a); \
+        long long vb_ = (long long)(b); \
+        if ( va_ != vb_ ) \
+        { \
+            hostTestFailures++; \
+            fprintf( stderr, "%s:%d: CHECK_EQ( %s, %s ) failed: %lld != %lld\n", \
+                     __FILE__, __LINE__, #a, #b, va_, vb_ ); \
+        } )
+
+#define RUN_TEST( fn )                      hostTestRun( #fn, fn )
+
+#define TEST_RESULT() \
+    ( fprintf( stderr, "%d tests, %d failed\n", hostTestRuns, hostTestFailed ), \
+      (hostTestFailed != 0) )
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+static int hostTestFailures = 0;
+
+static int hostTestRuns = 0;
+static int hostTestFailed = 0;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostTestRun
+ *
+ * @brief   Run a test on a freshly initialized device in a child
+ *          process.
+ *
+ * @param   pName - name to report
+ * @param   pfnTest - the test
+ *
+ * @return  none
+ */
+static void hostTestRun( const char *pName, void (*pfnTest)( void ) )
+{
+    pid_t pid;
+    int status = 0;
+
+    fflush( NULL );
+    hostTestRuns++;
+
+    pid = fork();
+    if ( pid == 0 )
+    {
+        DCBSHost_Init();
+        pfnTest();
+        fflush( NULL );
+        _exit( hostTestFailures != 0 );
+    }
+
+    if ( pid < 0 || waitpid( pid, &status, 0 ) != pid ||
+         !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+    {
+        hostTestFailed++;
+        fprintf( stderr, "FAIL %s\n", pName );
+    }
+    else
+    {
+        fprintf( stderr, "ok   %s\n", pName );
+    }
+}
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,361 @@
+/**************************************************************************************************
+  Filename:       test_program.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host tests of the shot sequence interpreter: what every
+                  opcode does, every program DCBSProgram_Load turns away,
+                  the step budget, MARK/WAIT_MARK on a late clock, and the
+                  edges a looping program makes on the shutter line.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "bcomdef.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Program.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+#include "host_test.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter line of channel 0, active low
+#define SHUTTER_0                           BV(1)
+
+#define MAX_LINES                           16
+#define MAX_EDGES                           16
+
+// Little endian imm32 operand
+#define IMM32( x ) \
+    (uint8)(x), (uint8)((x) >> 8), (uint8)((x) >> 16), (uint8)((x) >> 24)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Lines callbacks seen, lines in the low nibble and active in bit 4
+static uint8 lineCalls[MAX_LINES];
+static uint8 lineCount = 0;
+
+static uint32 progressCount = 0;
+
+static dcbsProgramCBs_t testProgramCBs;
+
+// Shutter 0 edges seen: device time and TRUE when pressed
+static uint64_t edgeTime[MAX_EDGES];
+static uint8 edgeActive[MAX_EDGES];
+static uint32 edgeCount = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static void recordLines( uint8 lines, uint8 active )
+{
+    if ( lineCount < MAX_LINES )
+    {
+        lineCalls[lineCount++] = lines | (active ? 0x10 : 0x00);
+    }
+}
+
+static void recordProgress( void )
+{
+    progressCount++;
+}
+
+static void recordEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( (changed & SHUTTER_0) && edgeCount < MAX_EDGES )
+    {
+        edgeTime[edgeCount] = timeUs;
+        edgeActive[edgeCount] = !(port & SHUTTER_0);
+        edgeCount++;
+    }
+}
+
+// Take the interpreter over from the application
+static void useTestCBs( void )
+{
+    testProgramCBs.pfnLines = recordLines;
+    testProgramCBs.pfnProgress = recordProgress;
+    DCBSProgram_RegisterCBs( &testProgramCBs );
+}
+
+// Load must turn the program away as malformed
+static uint8 rejected( uint8 *pCode, uint8 len )
+{
+    return ( DCBSProgram_Load( pCode, len ) == INVALIDPARAMETER );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+// Every opcode, run on an explicit clock
+static void testEveryOp( void )
+{
+    uint8 program[] =
+    {
+        DCBS_OP_FOCUS_ON,                               // 0
+        DCBS_OP_SHUTTER_ON,                             // 1
+        DCBS_OP_WAIT, IMM32( 250 ),                     // 2
+        DCBS_OP_SHUTTER_OFF,                            // 7
+        DCBS_OP_FOCUS_OFF,                              // 8
+        DCBS_OP_SET_VAR, 1, IMM32( 3 ),                 // 9
+        DCBS_OP_ADD_VAR, 1, IMM32( 0xFFFFFFFFUL ),      // 15: 2
+        DCBS_OP_SHL_VAR, 1, 4,                          // 21: 32
+        DCBS_OP_SHR_VAR, 1, 1,                          // 24: 16
+        DCBS_OP_WAIT_VAR, 1,                            // 27
+        DCBS_OP_PROGRESS,                               // 29
+        DCBS_OP_MARK,                                   // 30
+        DCBS_OP_WAIT_MARK, IMM32( 40 ),                 // 31
+        DCBS_OP_JUMP, 39,                               // 36
+        DCBS_OP_PROGRESS,                               // 38: jumped over
+        DCBS_OP_SET_VAR, 2, IMM32( 2 ),                 // 39
+        DCBS_OP_PROGRESS,                               // 45
+        DCBS_OP_LOOP, 2, 45,                            // 46
+        DCBS_OP_END,                                    // 49
+        DCBS_OP_PROGRESS,                               // 50: never reached
+    };
+    dcbsProgramState_t state;
+    uint32 wait = 0;
+
+    useTestCBs();
+    CHECK_EQ( DCBSProgram_Load( program, sizeof( program ) ), SUCCESS );
+    CHECK( DCBSProgram_Running() );
+
+    CHECK_EQ( DCBSProgram_Run( 1000, &wait ), DCBS_PROGRAM_WAIT );
+    CHECK_EQ( wait, 250 );
+    CHECK_EQ( lineCount, 2 );
+    CHECK_EQ( lineCalls[0], DCBS_PROGRAM_LINE_FOCUS | 0x10 );
+    CHECK_EQ( lineCalls[1], DCBS_PROGRAM_LINE_SHUTTER | 0x10 );
+
+    CHECK_EQ( DCBSProgram_Run( 1250, &wait ), DCBS_PROGRAM_WAIT );
+    CHECK_EQ( wait, 16 );
+    CHECK_EQ( lineCount, 4 );
+    CHECK_EQ( lineCalls[2], DCBS_PROGRAM_LINE_SHUTTER );
+    CHECK_EQ( lineCalls[3], DCBS_PROGRAM_LINE_FOCUS );
+    DCBSProgram_SaveState( 1250, &state );
+    CHECK_EQ( state.vars[1], 16 );
+    CHECK_EQ( state.pc, 29 );
+
+    CHECK_EQ( DCBSProgram_Run( 1266, &wait ), DCBS_PROGRAM_WAIT );
+    CHECK_EQ( wait, 40 );
+    CHECK_EQ( progressCount, 1 );
+    DCBSProgram_SaveState( 1266, &state );
+    CHECK_EQ( state.anchorOffset, 40 );
+
+    CHECK_EQ( DCBSProgram_Run( 1306, &wait ), DCBS_PROGRAM_DONE );
+    CHECK_EQ( progressCount, 3 );
+    CHECK( !DCBSProgram_Running() );
+    CHECK_EQ( DCBSProgram_Run( 1306, &wait ), DCBS_PROGRAM_DONE );
+    CHECK_EQ( progressCount, 3 );
+}
+
+// Every malformed program is turned away, and the one loaded before keeps
+// running
+static void testLoadRejects( void )
+{
+    uint8 good[] = { DCBS_OP_PROGRESS, DCBS_OP_END };
+    uint8 program[DCBS_PROGRAM_MAX_LEN + 1];
+    uint8 ops[] = { DCBS_OP_WAIT_VAR, DCBS_OP_SET_VAR, DCBS_OP_ADD_VAR,
+                    DCBS_OP_SHL_VAR, DCBS_OP_SHR_VAR, DCBS_OP_LOOP };
+    uint32 wait = 0;
+    uint8 i;
+
+    useTestCBs();
+    CHECK_EQ( DCBSProgram_Load( good, sizeof( good ) ), SUCCESS );
+
+    // Lengths
+    memset( program, DCBS_OP_PROGRESS, sizeof( program ) );
+    CHECK_EQ( DCBSProgram_Load( program, 0 ), bleInvalidRange );
+    CHECK_EQ( DCBSProgram_Load( program, DCBS_PROGRAM_MAX_LEN + 1 ), bleInvalidRange );
+
+    // Unknown ops
+    program[0] = 0x10;
+    CHECK( rejected( program, 1 ) );
+    program[0] = 0xFF;
+    CHECK( rejected( program, 1 ) );
+
+    // Truncated instructions
+    program[0] = DCBS_OP_WAIT;
+    CHECK( rejected( program, 4 ) );
+    program[0] = DCBS_OP_SET_VAR;
+    program[1] = 0;
+    CHECK( rejected( program, 5 ) );
+    program[0] = DCBS_OP_LOOP;
+    CHECK( rejected( program, 2 ) );
+    program[0] = DCBS_OP_JUMP;
+    CHECK( rejected( program, 1 ) );
+
+    // Variable index out of range, for every op that names one
+    for ( i = 0; i < sizeof( ops ); i++ )
+    {
+        memset( program, 0, sizeof( program ) );
+        program[0] = ops[i];
+        program[1] = DCBS_PROGRAM_NUM_VARS;
+        CHECK( rejected( program, 6 ) );
+    }
+
+    // Shifts as wide as the variable or wider
+    memset( program, 0, sizeof( program ) );
+    program[0] = DCBS_OP_SHL_VAR;
+    program[2] = 32;
+    CHECK( rejected( program, 3 ) );
+    program[2] = 255;
+    CHECK( rejected( program, 3 ) );
+    program[0] = DCBS_OP_SHR_VAR;
+    CHECK( rejected( program, 3 ) );
+    program[2] = 32;
+    CHECK( rejected( program, 3 ) );
+
+    // Jump targets past the end or inside an instruction
+    memset( program, 0, sizeof( program ) );
+    program[0] = DCBS_OP_JUMP;
+    program[1] = 2;
+    CHECK( rejected( program, 2 ) );
+    program[1] = 1;
+    CHECK( rejected( program, 3 ) );
+    program[0] = DCBS_OP_WAIT;
+    program[5] = DCBS_OP_LOOP;
+    program[6] = 0;
+    program[7] = 3;
+    CHECK( rejected( program, 8 ) );
+    program[7] = 8;
+    CHECK( rejected( program, 8 ) );
+
+    // The widest shift and a loop back to the start are fine
+    memset( program, 0, sizeof( program ) );
+    program[0] = DCBS_OP_SHR_VAR;
+    program[2] = 31;
+    program[3] = DCBS_OP_LOOP;
+    program[5] = 0;
+    CHECK_EQ( DCBSProgram_Load( program, 6 ), SUCCESS );
+
+    // None of the rejects replaced the program that was running
+    CHECK_EQ( DCBSProgram_Load( good, sizeof( good ) ), SUCCESS );
+    CHECK( rejected( program, 5 ) );
+    CHECK( DCBSProgram_Running() );
+    CHECK_EQ( DCBSProgram_Run( 0, &wait ), DCBS_PROGRAM_DONE );
+    CHECK_EQ( progressCount, 1 );
+}
+
+// A program that never waits gets DCBS_PROGRAM_STEP_BUDGET instructions a
+// call, no more
+static void testYieldBudget( void )
+{
+    uint8 spin[] = { DCBS_OP_PROGRESS, DCBS_OP_JUMP, 0 };
+    uint8 straight[DCBS_PROGRAM_STEP_BUDGET + 2];
+    uint32 wait = 0;
+
+    useTestCBs();
+
+    CHECK_EQ( DCBSProgram_Load( spin, sizeof( spin ) ), SUCCESS );
+    CHECK_EQ( DCBSProgram_Run( 0, &wait ), DCBS_PROGRAM_YIELD );
+    CHECK_EQ( progressCount, DCBS_PROGRAM_STEP_BUDGET / 2 );
+    CHECK_EQ( DCBSProgram_Run( 0, &wait ), DCBS_PROGRAM_YIELD );
+    CHECK_EQ( progressCount, DCBS_PROGRAM_STEP_BUDGET );
+    DCBSProgram_Stop();
+    CHECK_EQ( DCBSProgram_Run( 0, &wait ), DCBS_PROGRAM_DONE );
+
+    // One instruction over the budget runs on the next call
+    memset( straight, DCBS_OP_PROGRESS, sizeof( straight ) );
+    straight[sizeof( straight ) - 1] = DCBS_OP_END;
+    progressCount = 0;
+    CHECK_EQ( DCBSProgram_Load( straight, sizeof( straight ) ), SUCCESS );
+    CHECK_EQ( DCBSProgram_Run( 0, &wait ), DCBS_PROGRAM_YIELD );
+    CHECK_EQ( progressCount, DCBS_PROGRAM_STEP_BUDGET );
+    CHECK_EQ( DCBSProgram_Run( 0, &wait ), DCBS_PROGRAM_DONE );
+    CHECK_EQ( progressCount, DCBS_PROGRAM_STEP_BUDGET + 1 );
+}
+
+// WAIT_MARK reached late carries on without waiting and the next one
+// is still on the grid
+static void testLateMark( void )
+{
+    uint8 program[] =
+    {
+        DCBS_OP_MARK,
+        DCBS_OP_WAIT, IMM32( 1500 ),
+        DCBS_OP_WAIT_MARK, IMM32( 1000 ),
+        DCBS_OP_PROGRESS,
+        DCBS_OP_WAIT_MARK, IMM32( 1000 ),
+        DCBS_OP_PROGRESS,
+    };
+    uint32 wait = 0;
+
+    useTestCBs();
+    CHECK_EQ( DCBSProgram_Load( program, sizeof( program ) ), SUCCESS );
+
+    CHECK_EQ( DCBSProgram_Run( 5000, &wait ), DCBS_PROGRAM_WAIT );
+    CHECK_EQ( wait, 1500 );
+    CHECK_EQ( DCBSProgram_Run( 6500, &wait ), DCBS_PROGRAM_WAIT );
+    CHECK_EQ( wait, 500 );
+    CHECK_EQ( progressCount, 1 );
+
+    // Running off the end is the same as END
+    CHECK_EQ( DCBSProgram_Run( 7000, &wait ), DCBS_PROGRAM_DONE );
+    CHECK_EQ( progressCount, 2 );
+}
+
+// A looping program on the device presses the shutter on a 1 s grid from
+// its MARK, LOOP counts the frames and JUMP skips the extra press
+static void testLoopTiming( void )
+{
+    uint8 program[] =
+    {
+        DCBS_OP_MARK,                                   // 0
+        DCBS_OP_SET_VAR, 0, IMM32( 5 ),                 // 1
+        DCBS_OP_SHUTTER_ON,                             // 7
+        DCBS_OP_WAIT, IMM32( 100 ),                     // 8
+        DCBS_OP_SHUTTER_OFF,                            // 13
+        DCBS_OP_PROGRESS,                               // 14
+        DCBS_OP_WAIT_MARK, IMM32( 1000 ),               // 15
+        DCBS_OP_LOOP, 0, 7,                             // 20
+        DCBS_OP_JUMP, 26,                               // 23
+        DCBS_OP_SHUTTER_ON,                             // 25: jumped over
+        DCBS_OP_END,                                    // 26
+    };
+    uint8 status[BLESHUTTER_STATUS_LEN];
+    uint32 i;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+    CHECK_EQ( DCBSHost_Upload( BLESHUTTER_UPLOAD_TYPE_PROGRAM, program, sizeof( program ) ), SUCCESS );
+    DCBSHost_Run( 10000 );
+
+    CHECK_EQ( edgeCount, 10 );
+    for ( i = 0; i + 1 < edgeCount; i += 2 )
+    {
+        CHECK( edgeActive[i] && !edgeActive[i + 1] );
+        CHECK_EQ( edgeTime[i] - edgeTime[0], (i / 2) * 1000000ULL );
+        CHECK_EQ( edgeTime[i + 1] - edgeTime[i], 100000 );
+    }
+
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_DONE );
+    CHECK( DCBSHost_Port() & SHUTTER_0 );
+}
+
+/*********************************************************************
+ * MAIN
+ */
+
+int main( void )
+{
+    RUN_TEST( testEveryOp );
+    RUN_TEST( testLoadRejects );
+    RUN_TEST( testYieldBudget );
+    RUN_TEST( testLateMark );
+    RUN_TEST( testLoopTiming );
+
+    return ( TEST_RESULT() );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,218 @@
+/**************************************************************************************************
+  Filename:       test_queue.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host tests of the Shooting queue: a queued value taking
+                  over from the run before it, and the pool blocks queued
+                  values are held in, run out and counted in Stats.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "bcomdef.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Pool.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+#include "host_test.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter line of channel 0, active low
+#define SHUTTER_0                           BV(1)
+
+#define MAX_EDGES                           32
+
+// Stats fields, 4 bytes each
+#define STATS_POOL_IN_USE                   7
+#define STATS_POOL_HIGH_WATER               8
+#define STATS_POOL_BLOCKS                   9
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Shutter 0 edges seen: device time and TRUE when pressed
+static uint64_t edgeTime[MAX_EDGES];
+static uint8 edgeActive[MAX_EDGES];
+static uint32 edgeCount = 0;
+
+static uint32 ackCount = 0;
+static uint8 lastAck[BLESHUTTER_COMMAND_ACK_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static void recordEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( (changed & SHUTTER_0) && edgeCount < MAX_EDGES )
+    {
+        edgeTime[edgeCount] = timeUs;
+        edgeActive[edgeCount] = !(port & SHUTTER_0);
+        edgeCount++;
+    }
+}
+
+static void recordAck( uint16 uuid, uint8 *pValue, uint8 len )
+{
+    if ( uuid == BLESHUTTER_COMMAND_UUID && len == BLESHUTTER_COMMAND_ACK_LEN )
+    {
+        memcpy( lastAck, pValue, len );
+        ackCount++;
+    }
+}
+
+// SHOOT command of one 100 ms frame after 1 s on channel 0, its result
+static uint8 shootCommand( uint8 seq, uint8 options )
+{
+    uint8 command[BLESHUTTER_COMMAND_HDR_LEN + BLESHUTTER_SHOOTING_BASE_LEN + 2];
+
+    memset( command, 0, sizeof( command ) );
+    command[0] = seq;
+    command[1] = BLESHUTTER_COMMAND_SHOOT;
+    command[BLESHUTTER_COMMAND_HDR_LEN + 0] = 1;
+    command[BLESHUTTER_COMMAND_HDR_LEN + 2] = LO_UINT16( 1000 );
+    command[BLESHUTTER_COMMAND_HDR_LEN + 3] = HI_UINT16( 1000 );
+    command[BLESHUTTER_COMMAND_HDR_LEN + 6] = 100;
+    command[BLESHUTTER_COMMAND_HDR_LEN + 14] = options;
+    command[BLESHUTTER_COMMAND_HDR_LEN + 15] = BV(0);
+
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_COMMAND_UUID, command, sizeof( command ), 0 ), SUCCESS );
+    CHECK_EQ( lastAck[0], seq );
+
+    return ( lastAck[2] );
+}
+
+// One field of the Stats value
+static uint32 statsField( uint8 field )
+{
+    uint8 stats[BLESHUTTER_STATS_LEN];
+
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATS_UUID, stats, sizeof( stats ) ), sizeof( stats ) );
+
+    return ( BUILD_UINT32( stats[field * 4], stats[field * 4 + 1],
+                           stats[field * 4 + 2], stats[field * 4 + 3] ) );
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+// A value queued behind a 3 frame run presses the moment the last frame
+// is released and keeps its own period from there
+static void testQueuedStart( void )
+{
+    uint8 i;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+
+    CHECK_EQ( DCBSHost_Shoot( 3, 100, 100, 900, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    CHECK_EQ( DCBSHost_Shoot( 2, 0, 100, 400, BLESHUTTER_SHOOTING_OPT_ANCHORED |
+                              BLESHUTTER_SHOOTING_OPT_QUEUED, BV(0) ), SUCCESS );
+    CHECK_EQ( statsField( STATS_POOL_IN_USE ), 1 );
+    DCBSHost_Run( 6000 );
+
+    CHECK_EQ( edgeCount, 5 * 2 );
+    for ( i = 0; i < 5 && i * 2U + 1 < edgeCount; i++ )
+    {
+        CHECK( edgeActive[i * 2] && !edgeActive[i * 2 + 1] );
+        CHECK_EQ( edgeTime[i * 2 + 1] - edgeTime[i * 2], 100000 );
+    }
+    if ( edgeCount == 5 * 2 )
+    {
+        CHECK_EQ( edgeTime[2] - edgeTime[0], 1000000 );
+        CHECK_EQ( edgeTime[4] - edgeTime[0], 2000000 );
+        CHECK_EQ( edgeTime[6] - edgeTime[5], 0 );
+        CHECK_EQ( edgeTime[8] - edgeTime[6], 500000 );
+    }
+    CHECK_EQ( statsField( STATS_POOL_IN_USE ), 0 );
+}
+
+// A value that replaces the run drops what was queued behind it, and the
+// block it was held in goes back to the pool
+static void testQueueDrop( void )
+{
+    DCBSHost_SetEdgeCB( recordEdge );
+
+    CHECK_EQ( DCBSHost_Shoot( 3, 100, 100, 900, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    CHECK_EQ( DCBSHost_Shoot( 2, 0, 100, 400, BLESHUTTER_SHOOTING_OPT_ANCHORED |
+                              BLESHUTTER_SHOOTING_OPT_QUEUED, BV(0) ), SUCCESS );
+    CHECK_EQ( DCBSPool_InUse(), 1 );
+
+    CHECK_EQ( DCBSHost_Shoot( 1, 100, 100, 0, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    CHECK_EQ( DCBSPool_InUse(), 0 );
+    CHECK_EQ( statsField( STATS_POOL_IN_USE ), 0 );
+
+    DCBSHost_Run( 6000 );
+    CHECK_EQ( edgeCount, 1 * 2 );
+}
+
+// With every block taken a queued SHOOT is refused and the run goes on;
+// the most blocks ever taken is what Stats reports
+static void testPoolFull( void )
+{
+    uint8 *pBlocks[DCBS_POOL_BLOCKS];
+    uint8 seq = 0;
+    uint8 i;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+    DCBSHost_SetNotifyCB( recordAck );
+    DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+    CHECK_EQ( DCBSHost_Subscribe( BLESHUTTER_COMMAND_UUID, TRUE ), SUCCESS );
+    CHECK_EQ( statsField( STATS_POOL_BLOCKS ), DCBS_POOL_BLOCKS );
+
+    CHECK_EQ( shootCommand( ++seq, BLESHUTTER_SHOOTING_OPT_ANCHORED ), BLESHUTTER_COMMAND_OK );
+
+    // The pool runs out before the queue does
+    for ( i = 0; i < DCBS_POOL_BLOCKS; i++ )
+    {
+        pBlocks[i] = DCBSPool_Alloc();
+        CHECK( pBlocks[i] != NULL );
+    }
+    CHECK( DCBSPool_Alloc() == NULL );
+    CHECK_EQ( shootCommand( ++seq, BLESHUTTER_SHOOTING_OPT_QUEUED ), BLESHUTTER_COMMAND_QUEUE_FULL );
+    CHECK_EQ( DCBSPool_InUse(), DCBS_POOL_BLOCKS );
+    for ( i = 0; i < DCBS_POOL_BLOCKS; i++ )
+    {
+        DCBSPool_Free( pBlocks[i] );
+    }
+
+    // And the queue runs out with the pool
+    for ( i = 0; i < DCBS_POOL_BLOCKS; i++ )
+    {
+        CHECK_EQ( shootCommand( ++seq, BLESHUTTER_SHOOTING_OPT_QUEUED ), BLESHUTTER_COMMAND_OK );
+    }
+    CHECK_EQ( shootCommand( ++seq, BLESHUTTER_SHOOTING_OPT_QUEUED ), BLESHUTTER_COMMAND_QUEUE_FULL );
+    CHECK_EQ( ackCount, seq );
+    CHECK_EQ( statsField( STATS_POOL_IN_USE ), DCBS_POOL_BLOCKS );
+
+    // The run and everything queued behind it are still taken
+    DCBSHost_Run( 10000 );
+    CHECK_EQ( edgeCount, (1 + DCBS_POOL_BLOCKS) * 2 );
+    CHECK_EQ( statsField( STATS_POOL_IN_USE ), 0 );
+    CHECK_EQ( DCBSPool_HighWater(), DCBS_POOL_BLOCKS );
+    CHECK_EQ( statsField( STATS_POOL_HIGH_WATER ), DCBSPool_HighWater() );
+}
+
+/*********************************************************************
+ * MAIN
+ */
+
+int main( void )
+{
+    RUN_TEST( testQueuedStart );
+    RUN_TEST( testQueueDrop );
+    RUN_TEST( testPoolFull );
+
+    return ( TEST_RESULT() );
+}
+
+/*********************************************************************
+ *********************************************************************/
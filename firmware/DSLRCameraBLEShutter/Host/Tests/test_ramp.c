@@ -0,0 +1,375 @@
+/**************************************************************************************************
+  Filename:       test_ramp.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host tests of the exposure ramp: the fixed-point series the
+                  curve walker gives, stepped and sought, against a double
+                  precision reference of the same curve, and the exposures a
+                  ramped run really makes on the shutter line.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <math.h>
+#include <string.h>
+
+#include "bcomdef.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Ramp.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+#include "host_test.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter line of channel 0, active low
+#define SHUTTER_0                           BV(1)
+
+// The walker keeps 16 bits of position and truncates it, and truncates the
+// value: up to 2 parts in 65536 of the segment's change plus 1 linear. The
+// smoothstep truncates its square and drops 2 bits of its second factor,
+// up to 6 parts more
+#define RAMP_TOLERANCE( shape, from, to ) \
+    ( fabs( (double)(to) - (double)(from) ) * \
+      (((shape) == DCBS_RAMP_SHAPE_EASED) ? 8 : 2) / 65536 + 1 )
+
+#define MAX_FRAMES                          64
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    uint16 frames;
+    uint8 shape;
+    uint32 exposure;
+    uint32 interval;
+} rampPoint_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint8 curve[DCBS_RAMP_MAX_LEN];
+static uint8 curveLen;
+
+static uint32 rand32 = 0x12345678;
+
+static uint64_t pressTime = 0;
+static uint32 exposureUs[MAX_FRAMES];
+static uint32 exposures = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static uint32 nextRand( void )
+{
+    rand32 ^= rand32 << 13;
+    rand32 ^= rand32 >> 17;
+    rand32 ^= rand32 << 5;
+
+    return ( rand32 );
+}
+
+// Build curve[] from points
+static void buildCurve( uint8 flags, CONST rampPoint_t *pPoints, uint8 points )
+{
+    uint8 n;
+
+    curve[0] = flags;
+    for ( n = 0; n < points; n++ )
+    {
+        uint8 *p = curve + DCBS_RAMP_HDR_LEN + n * DCBS_RAMP_POINT_LEN;
+        uint8 i;
+
+        p[0] = LO_UINT16( pPoints[n].frames );
+        p[1] = HI_UINT16( pPoints[n].frames );
+        p[2] = pPoints[n].shape;
+        for ( i = 0; i < 4; i++ )
+        {
+            p[3 + i] = BREAK_UINT32( pPoints[n].exposure, i );
+            p[7 + i] = BREAK_UINT32( pPoints[n].interval, i );
+        }
+    }
+    curveLen = DCBS_RAMP_HDR_LEN + points * DCBS_RAMP_POINT_LEN;
+}
+
+// Double precision reference: the value of a frame of the curve, the two
+// points it lies between and the shape of the segment
+static double refValue( CONST rampPoint_t *pPoints, uint8 points, uint32 frame, uint8 interval,
+                        double *pFrom, double *pTo, uint8 *pShape )
+{
+    uint8 n;
+
+    for ( n = 1; n < points; n++ )
+    {
+        if ( frame < pPoints[n].frames )
+        {
+            double t = (double)frame / pPoints[n].frames;
+            double from = interval ? pPoints[n - 1].interval : pPoints[n - 1].exposure;
+            double to = interval ? pPoints[n].interval : pPoints[n].exposure;
+
+            if ( pPoints[n].shape == DCBS_RAMP_SHAPE_EASED )
+            {
+                t = t * t * (3 - 2 * t);
+            }
+
+            *pFrom = from;
+            *pTo = to;
+            *pShape = pPoints[n].shape;
+            return ( from + (to - from) * t );
+        }
+        frame -= pPoints[n].frames;
+    }
+
+    *pFrom = *pTo = interval ? pPoints[points - 1].interval : pPoints[points - 1].exposure;
+    *pShape = DCBS_RAMP_SHAPE_LINEAR;
+
+    return ( *pFrom );
+}
+
+// Walk a curve frame by frame and check every frame against the
+// reference, stepped and sought
+static void checkCurve( uint8 flags, CONST rampPoint_t *pPoints, uint8 points )
+{
+    dcbsRampState_t step;
+    uint32 total = 0;
+    uint32 frame;
+    uint8 n;
+
+    buildCurve( flags, pPoints, points );
+    CHECK_EQ( DCBSRamp_Load( curve, curveLen ), SUCCESS );
+
+    for ( n = 1; n < points; n++ )
+    {
+        total += pPoints[n].frames;
+    }
+
+    DCBSRamp_Seek( &step, 0 );
+    for ( frame = 0; frame <= total + 2 && frame <= 0xFFFF; frame++ )
+    {
+        dcbsRampState_t seek;
+        uint32 exposure = 0;
+        uint32 interval = 0xA5A5A5A5;
+        uint32 seekExposure = 0;
+        uint32 seekInterval = 0xA5A5A5A5;
+        double from, to;
+        double ref;
+        double err;
+        uint8 shape;
+
+        DCBSRamp_Value( &step, &exposure, &interval );
+
+        DCBSRamp_Seek( &seek, (uint16)frame );
+        DCBSRamp_Value( &seek, &seekExposure, &seekInterval );
+        CHECK_EQ( seekExposure, exposure );
+        CHECK_EQ( seekInterval, interval );
+
+        ref = refValue( pPoints, points, frame, FALSE, &from, &to, &shape );
+        err = fabs( exposure - ref ) / RAMP_TOLERANCE( shape, from, to );
+        if ( err > 1 )
+        {
+            fprintf( stderr, "frame %u: exposure %u, reference %.3f\n", frame, exposure, ref );
+        }
+        CHECK( err <= 1 );
+        CHECK( exposure >= MIN( from, to ) && exposure <= MAX( from, to ) );
+
+        if ( flags & DCBS_RAMP_FLAG_INTERVAL )
+        {
+            ref = refValue( pPoints, points, frame, TRUE, &from, &to, &shape );
+            err = fabs( interval - ref ) / RAMP_TOLERANCE( shape, from, to );
+            CHECK( err <= 1 );
+        }
+        else
+        {
+            CHECK_EQ( interval, 0xA5A5A5A5 );
+        }
+
+        DCBSRamp_Advance( &step );
+    }
+}
+
+static void recordEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( !(changed & SHUTTER_0) )
+    {
+        return;
+    }
+
+    if ( !(port & SHUTTER_0) )
+    {
+        pressTime = timeUs;
+    }
+    else if ( exposures < MAX_FRAMES )
+    {
+        exposureUs[exposures++] = (uint32)(timeUs - pressTime);
+    }
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+// A linear ramp of exposure alone
+static void testLinear( void )
+{
+    static CONST rampPoint_t points[] =
+    {
+        { 0,  DCBS_RAMP_SHAPE_LINEAR, 100,  1000 },
+        { 30, DCBS_RAMP_SHAPE_LINEAR, 3200, 1000 },
+    };
+
+    checkCurve( 0, points, 2 );
+}
+
+// Day to night in microseconds: eased into a 30 s exposure, then a long
+// linear segment back with the interval following
+static void testDayToNight( void )
+{
+    static CONST rampPoint_t points[] =
+    {
+        { 0,      DCBS_RAMP_SHAPE_LINEAR, 1000,     5000  },
+        { 600,    DCBS_RAMP_SHAPE_EASED,  30000000, 35000 },
+        { 0xFFFF, DCBS_RAMP_SHAPE_LINEAR, 20000000, 30000 },
+    };
+
+    checkCurve( DCBS_RAMP_FLAG_INTERVAL, points, 3 );
+}
+
+// The whole range of a value, up and down, over short segments, and
+// segments one frame long
+static void testExtremes( void )
+{
+    static CONST rampPoint_t points[] =
+    {
+        { 0, DCBS_RAMP_SHAPE_LINEAR, 1,          1          },
+        { 7, DCBS_RAMP_SHAPE_EASED,  0xFFFFFFFE, 0xFFFFFFFE },
+        { 1, DCBS_RAMP_SHAPE_LINEAR, 1,          0xFFFFFFFE },
+        { 1, DCBS_RAMP_SHAPE_EASED,  0xFFFFFFFE, 1          },
+        { 3, DCBS_RAMP_SHAPE_LINEAR, 1,          1          },
+    };
+
+    checkCurve( DCBS_RAMP_FLAG_INTERVAL, points, 5 );
+}
+
+// A single point holds its values
+static void testSinglePoint( void )
+{
+    static CONST rampPoint_t points[] =
+    {
+        { 0, DCBS_RAMP_SHAPE_LINEAR, 250, 2000 },
+    };
+
+    checkCurve( DCBS_RAMP_FLAG_INTERVAL, points, 1 );
+}
+
+// Random curves of every size and shape
+static void testRandomCurves( void )
+{
+    rampPoint_t points[DCBS_RAMP_MAX_POINTS];
+    uint16 c;
+    uint8 n;
+
+    for ( c = 0; c < 100; c++ )
+    {
+        uint8 count = 1 + nextRand() % DCBS_RAMP_MAX_POINTS;
+
+        for ( n = 0; n < count; n++ )
+        {
+            // Spread values over every magnitude
+            uint8 bits = 1 + nextRand() % 32;
+
+            points[n].frames = (n == 0) ? 0 : 1 + nextRand() % 1500;
+            points[n].shape = nextRand() & 1;
+            points[n].exposure = 1 + nextRand() % (uint32)MIN( (1ULL << bits) - 1, 0xFFFFFFFDULL );
+            points[n].interval = nextRand();
+        }
+
+        checkCurve( (uint8)(nextRand() & DCBS_RAMP_FLAG_INTERVAL), points, count );
+    }
+}
+
+// Malformed curves are refused
+static void testRefused( void )
+{
+    static CONST rampPoint_t zeroFrames[] =
+    {
+        { 0, DCBS_RAMP_SHAPE_LINEAR, 100, 0 },
+        { 0, DCBS_RAMP_SHAPE_LINEAR, 200, 0 },
+    };
+    static CONST rampPoint_t bulb[] =
+    {
+        { 0, DCBS_RAMP_SHAPE_LINEAR, 0xFFFFFFFF, 0 },
+    };
+    static CONST rampPoint_t shape[] =
+    {
+        { 0, DCBS_RAMP_SHAPE_LINEAR,    100, 0 },
+        { 5, DCBS_RAMP_SHAPE_EASED + 1, 200, 0 },
+    };
+
+    buildCurve( 0, zeroFrames, 2 );
+    CHECK_EQ( DCBSRamp_Load( curve, curveLen ), INVALIDPARAMETER );
+    buildCurve( 0, bulb, 1 );
+    CHECK_EQ( DCBSRamp_Load( curve, curveLen ), INVALIDPARAMETER );
+    buildCurve( 0, shape, 2 );
+    CHECK_EQ( DCBSRamp_Load( curve, curveLen ), INVALIDPARAMETER );
+    CHECK_EQ( DCBSRamp_Load( curve, curveLen - 1 ), bleInvalidRange );
+    CHECK( !DCBSRamp_Loaded() );
+}
+
+// A ramped run uploaded and shot through the service exposes each frame
+// for the curve's value, to the millisecond the Shooting unit allows
+static void testRampedRun( void )
+{
+    static CONST rampPoint_t points[] =
+    {
+        { 0, DCBS_RAMP_SHAPE_LINEAR, 10,  500 },
+        { 8, DCBS_RAMP_SHAPE_EASED,  200, 500 },
+        { 4, DCBS_RAMP_SHAPE_LINEAR, 120, 500 },
+    };
+    uint8 n;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+    buildCurve( 0, points, 3 );
+    CHECK_EQ( DCBSHost_Upload( BLESHUTTER_UPLOAD_TYPE_RAMP, curve, curveLen ), SUCCESS );
+    CHECK( DCBSRamp_Loaded() );
+
+    CHECK_EQ( DCBSHost_Shoot( 16, 100, 10, 500, BLESHUTTER_SHOOTING_OPT_ANCHORED |
+                              BLESHUTTER_SHOOTING_OPT_RAMP, BV(0) ), SUCCESS );
+    DCBSHost_Run( 20000 );
+
+    CHECK_EQ( exposures, 16 );
+    for ( n = 0; n < exposures; n++ )
+    {
+        double from, to;
+        uint8 shape;
+        double ref = refValue( points, 3, n, FALSE, &from, &to, &shape ) * 1000;
+
+        CHECK( fabs( exposureUs[n] - ref ) <= 1000 );
+    }
+}
+
+/*********************************************************************
+ * MAIN
+ */
+
+int main( void )
+{
+    RUN_TEST( testLinear );
+    RUN_TEST( testDayToNight );
+    RUN_TEST( testExtremes );
+    RUN_TEST( testSinglePoint );
+    RUN_TEST( testRandomCurves );
+    RUN_TEST( testRefused );
+    RUN_TEST( testRampedRun );
+
+    return ( TEST_RESULT() );
+}
+
+/*********************************************************************
+ *********************************************************************/
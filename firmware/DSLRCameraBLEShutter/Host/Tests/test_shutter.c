@@ -0,0 +1,702 @@
+/**************************************************************************************************
+  Filename:       test_shutter.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host tests of the shutter lines: frames seen on port 0 at
+                  the times the Shooting value asks for, the phase of 10000
+                  frames under load, the Timer 1 pulse, brackets, channels
+                  run apart, wall clock starts, long runs on the virtual
+                  clock, paused and resumed runs, a run cut by a reset, a
+                  program that never waits, the edge trace, Status
+                  notifications, the Stats counts and the display.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "bcomdef.h"
+#include "hal_lcd.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Program.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+#include "host_test.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Shutter lines of channels 0 and 1, active low
+#define SHUTTER_0                           BV(1)
+#define SHUTTER_1                           BV(2)
+
+#define MAX_EDGES                           64
+#define MAX_STATUS                          32
+
+// Status updates a second until Rate is written, DCBS_DEFAULT_STATUS_RATE
+#define STATUS_RATE                         4
+
+// Shortest gap between bracket frames, DCBS_BRACKET_MIN_GAP
+#define BRACKET_GAP_MS                      250
+
+// Stats fields, 4 bytes each
+#define STATS_UPTIME                        0
+#define STATS_ACTIVE                        1
+#define STATS_EVENTS                        2
+#define STATS_CONN_EVENTS                   3
+#define STATS_ADV_EVENTS                    4
+#define STATS_NOTIFICATIONS                 5
+#define STATS_PRESSES                       6
+
+// Time each application event takes in the Stats run, and the sleep timer
+// ticks it comes to, 32.768 at 32768 Hz
+#define STATS_WORK_US                       1000
+#define STATS_WORK_TICKS                    32
+
+// Wall clock the Time value is set to, utc (s since 2000) and ms
+#define WALL_UTC                            800000000UL
+#define WALL_MS                             500
+
+// Phase run: 10000 anchored frames of 100 ms every 200 ms under stack task
+// load of up to 2.5 ms every 7.5 ms. A press may land up to 1 ms past the
+// load it waited for and the windows of two periods may meet
+#define PHASE_FRAMES                        10000
+#define PHASE_PERIOD_MS                     200
+#define PHASE_LOAD_PERIOD_US                7500
+#define PHASE_LOAD_HOLD_US                  2500
+#define PHASE_LIMIT_US                      (2 * PHASE_LOAD_HOLD_US + 1000)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Shutter 0 edges seen: device time and TRUE when pressed
+static uint64_t edgeTime[MAX_EDGES];
+static uint8 edgeActive[MAX_EDGES];
+static uint32 edgeCount = 0;
+
+// Shutter 1 edges seen, as above
+static uint64_t edge1Time[MAX_EDGES];
+static uint8 edge1Active[MAX_EDGES];
+static uint32 edge1Count = 0;
+
+// Phase run: first press, presses seen and the worst |press - k * period|
+static uint64_t phaseStart = 0;
+static uint32 phasePresses = 0;
+static int64_t phaseMaxError = 0;
+
+// Status notifications seen: device time, state and frame count
+static uint64_t statusTime[MAX_STATUS];
+static uint8 statusState[MAX_STATUS];
+static uint16 statusFrames[MAX_STATUS];
+static uint32 statusCount = 0;
+static uint8 lastStatus[BLESHUTTER_STATUS_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static void recordEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    if ( (changed & SHUTTER_0) && edgeCount < MAX_EDGES )
+    {
+        edgeTime[edgeCount] = timeUs;
+        edgeActive[edgeCount] = !(port & SHUTTER_0);
+        edgeCount++;
+    }
+}
+
+static void recordChannels( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    recordEdge( timeUs, port, changed );
+
+    if ( (changed & SHUTTER_1) && edge1Count < MAX_EDGES )
+    {
+        edge1Time[edge1Count] = timeUs;
+        edge1Active[edge1Count] = !(port & SHUTTER_1);
+        edge1Count++;
+    }
+}
+
+static void recordPhase( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    int64_t error;
+
+    if ( !(changed & SHUTTER_0) || (port & SHUTTER_0) )
+    {
+        return;
+    }
+
+    if ( phasePresses == 0 )
+    {
+        phaseStart = timeUs;
+    }
+    error = (int64_t)(timeUs - phaseStart) - (int64_t)phasePresses * PHASE_PERIOD_MS * 1000;
+    error = (error < 0) ? -error : error;
+    phaseMaxError = MAX( phaseMaxError, error );
+    phasePresses++;
+}
+
+static void recordNotify( uint16 uuid, uint8 *pValue, uint8 len )
+{
+    if ( uuid == BLESHUTTER_STATUS_UUID && len == BLESHUTTER_STATUS_LEN )
+    {
+        memcpy( lastStatus, pValue, len );
+        if ( statusCount < MAX_STATUS )
+        {
+            statusTime[statusCount] = DCBSHost_Now();
+            statusState[statusCount] = pValue[0];
+            statusFrames[statusCount] = BUILD_UINT16( pValue[1], pValue[2] );
+        }
+        statusCount++;
+    }
+}
+
+// Write a Shooting value of one 100 ms frame on channel 0 at a wall clock
+// time, and read back the Status state it leaves
+static uint8 wallShoot( uint32 utc, uint16 ms )
+{
+    uint8 shooting[BLESHUTTER_SHOOTING_LEN];
+    uint8 status[BLESHUTTER_STATUS_LEN];
+    uint8 len = 0;
+
+    memset( shooting, 0, sizeof( shooting ) );
+    shooting[0] = 1;
+    shooting[2] = BREAK_UINT32( utc, 0 );
+    shooting[3] = BREAK_UINT32( utc, 1 );
+    shooting[4] = BREAK_UINT32( utc, 2 );
+    shooting[5] = BREAK_UINT32( utc, 3 );
+    shooting[6] = 100;
+    shooting[14] = BLESHUTTER_SHOOTING_OPT_WALL;
+    shooting[15] = BV(0);
+    shooting[19] = LO_UINT16( ms );
+    shooting[20] = HI_UINT16( ms );
+
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, shooting, sizeof( shooting ), 0 ), SUCCESS );
+    CHECK_EQ( DCBSHost_Read( BLESHUTTER_STATUS_UUID, status, &len, 0 ), SUCCESS );
+    CHECK_EQ( len, sizeof( status ) );
+
+    return ( status[0] );
+}
+
+// One field of the Stats value
+static uint32 statsField( uint8 field )
+{
+    uint8 stats[BLESHUTTER_STATS_LEN];
+
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATS_UUID, stats, sizeof( stats ) ), sizeof( stats ) );
+
+    return ( BUILD_UINT32( stats[field * 4], stats[field * 4 + 1],
+                           stats[field * 4 + 2], stats[field * 4 + 3] ) );
+}
+
+// Run pfnBefore on a copy of the device in a child process, then start this
+// one again from power on with the SNV items the copy left, as a reset part
+// way through would
+static void resetDevice( void (*pfnBefore)( void ) )
+{
+    FILE *pSnv = tmpfile();
+    pid_t pid;
+    int status = 0;
+
+    if ( pSnv == NULL )
+    {
+        hostTestFailures++;
+        return;
+    }
+
+    fflush( NULL );
+    pid = fork();
+    if ( pid == 0 )
+    {
+        pfnBefore();
+        DCBSHost_SaveSnv( pSnv );
+        fflush( NULL );
+        _exit( hostTestFailures != 0 );
+    }
+
+    if ( pid < 0 || waitpid( pid, &status, 0 ) != pid ||
+         !WIFEXITED( status ) || WEXITSTATUS( status ) != 0 )
+    {
+        hostTestFailures++;
+    }
+
+    rewind( pSnv );
+    DCBSHost_LoadSnv( pSnv );
+    fclose( pSnv );
+    DCBSHost_Init();
+}
+
+/*********************************************************************
+ * TESTS
+ */
+
+// Three anchored frames of 100 ms every 1100 ms, the first after 200 ms
+static void testAnchoredFrames( void )
+{
+    uint64_t start;
+    uint8 i;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+    start = DCBSHost_Now();
+
+    CHECK_EQ( DCBSHost_Shoot( 3, 200, 100, 1000, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    DCBSHost_Run( 5000 );
+
+    CHECK_EQ( edgeCount, 6 );
+    for ( i = 0; i < 3 && i * 2U + 1 < edgeCount; i++ )
+    {
+        CHECK( edgeActive[i * 2] );
+        CHECK( !edgeActive[i * 2 + 1] );
+        CHECK_EQ( edgeTime[i * 2] - start, (200 + i * 1100ULL) * 1000 );
+        CHECK_EQ( edgeTime[i * 2 + 1] - edgeTime[i * 2], 100000 );
+    }
+    CHECK( DCBSHost_Port() & SHUTTER_0 );
+}
+
+// 10000 anchored frames under task load stay on k * interval from the
+// first, however late single presses are
+static void testPhaseError( void )
+{
+    DCBSHost_SetEdgeCB( recordPhase );
+    DCBSHost_SetLoad( PHASE_LOAD_PERIOD_US, PHASE_LOAD_HOLD_US, 1 );
+
+    CHECK_EQ( DCBSHost_Shoot( PHASE_FRAMES, 0, 100, PHASE_PERIOD_MS - 100,
+                              BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    DCBSHost_Run( (PHASE_FRAMES + 1) * PHASE_PERIOD_MS );
+
+    CHECK_EQ( phasePresses, PHASE_FRAMES );
+    CHECK( phaseMaxError <= PHASE_LIMIT_US );
+    if ( phaseMaxError > PHASE_LIMIT_US )
+    {
+        fprintf( stderr, "max phase error %lld us\n", (long long)phaseMaxError );
+    }
+    CHECK( DCBSHost_Port() & SHUTTER_0 );
+}
+
+// A 300 us exposure is released by the Timer 1 interrupt, not the task
+static void testMicrosecondPulse( void )
+{
+    DCBSHost_SetEdgeCB( recordEdge );
+
+    CHECK_EQ( DCBSHost_Shoot( 1, 0, 300, 0, BLESHUTTER_SHOOTING_OPT_EXPOSURE_US, BV(0) ), SUCCESS );
+    DCBSHost_Run( 100 );
+
+    CHECK_EQ( edgeCount, 2 );
+    CHECK( edgeActive[0] && !edgeActive[1] );
+    CHECK_EQ( edgeTime[1] - edgeTime[0], 300 );
+}
+
+// A bracket takes each frame at its own exposure, back to back with the
+// interval raised to the 250 ms minimum gap
+static void testBracket( void )
+{
+    // 5 frames a stop apart around 100 ms, then 3 a third of a stop apart
+    static CONST struct
+    {
+        uint16 count;
+        int8 step;
+        uint32 widthMs[5];
+    } brackets[] =
+    {
+        { 5, 3, { 25, 50, 100, 200, 400 } },
+        { 3, 1, { 79, 100, 126 } },
+    };
+    uint8 value[BLESHUTTER_SHOOTING_LEN];
+    uint8 b;
+    uint8 i;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+
+    for ( b = 0; b < sizeof( brackets ) / sizeof( brackets[0] ); b++ )
+    {
+        uint64_t press;
+
+        memset( value, 0, sizeof( value ) );
+        value[0] = LO_UINT16( brackets[b].count );
+        value[2] = 100;
+        value[6] = 100;
+        value[14] = BLESHUTTER_SHOOTING_OPT_ANCHORED;
+        value[15] = BV(0);
+        value[18] = (uint8)brackets[b].step;
+
+        edgeCount = 0;
+        CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, sizeof( value ), 0 ), SUCCESS );
+        DCBSHost_Run( 5000 );
+
+        CHECK_EQ( edgeCount, brackets[b].count * 2U );
+        press = edgeTime[0];
+        for ( i = 0; i < brackets[b].count && i * 2U + 1 < edgeCount; i++ )
+        {
+            CHECK( edgeActive[i * 2] && !edgeActive[i * 2 + 1] );
+            CHECK_EQ( edgeTime[i * 2], press );
+            CHECK_EQ( edgeTime[i * 2 + 1] - edgeTime[i * 2], brackets[b].widthMs[i] * 1000 );
+            press += (brackets[b].widthMs[i] + BRACKET_GAP_MS) * 1000ULL;
+        }
+    }
+}
+
+// Channels 0 and 1 run side by side on their own periods, set going and
+// stopped apart: writing or stopping one leaves the other alone
+static void testChannels( void )
+{
+    uint8 stop[BLESHUTTER_STOP_LEN] = { BV(1), BLESHUTTER_STOP_OP_STOP };
+    uint64_t start;
+    uint8 i;
+
+    DCBSHost_SetEdgeCB( recordChannels );
+    start = DCBSHost_Now();
+
+    CHECK_EQ( DCBSHost_Shoot( 3, 100, 100, 400, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    DCBSHost_Run( 250 );
+    CHECK_EQ( DCBSHost_Shoot( 3, 100, 200, 100, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(1) ), SUCCESS );
+    DCBSHost_Run( 650 );
+
+    // Between channel 1's second and third frames, channel 0 still has one to go
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, sizeof( stop ), 0 ), SUCCESS );
+    DCBSHost_Run( 2000 );
+
+    CHECK_EQ( edgeCount, 3 * 2 );
+    for ( i = 0; i < 3 && i * 2U + 1 < edgeCount; i++ )
+    {
+        CHECK( edgeActive[i * 2] && !edgeActive[i * 2 + 1] );
+        CHECK_EQ( edgeTime[i * 2] - start, (100 + i * 500ULL) * 1000 );
+        CHECK_EQ( edgeTime[i * 2 + 1] - edgeTime[i * 2], 100000 );
+    }
+
+    CHECK_EQ( edge1Count, 2 * 2 );
+    for ( i = 0; i < 2 && i * 2U + 1 < edge1Count; i++ )
+    {
+        CHECK( edge1Active[i * 2] && !edge1Active[i * 2 + 1] );
+        CHECK_EQ( edge1Time[i * 2] - start, (350 + i * 300ULL) * 1000 );
+        CHECK_EQ( edge1Time[i * 2 + 1] - edge1Time[i * 2], 200000 );
+    }
+    CHECK( (DCBSHost_Port() & (SHUTTER_0 | SHUTTER_1)) == (SHUTTER_0 | SHUTTER_1) );
+}
+
+// A wall clock start an hour off, with the adaptor left alone in power save
+// mode, fires on its ms; refused before Time is set and once it has passed
+static void testWallStart( void )
+{
+    uint8 time[BLESHUTTER_TIME_LEN];
+    uint8 state[BLESHUTTER_TIME_STATE_LEN];
+    uint8 power = BLESHUTTER_POWER_SAVE;
+    uint8 len = 0;
+    uint64_t set;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_POWER_UUID, &power, sizeof( power ), 0 ), SUCCESS );
+
+    CHECK_EQ( wallShoot( WALL_UTC + 10, 0 ), BLESHUTTER_STATUS_REJECTED );
+
+    time[0] = BREAK_UINT32( WALL_UTC, 0 );
+    time[1] = BREAK_UINT32( WALL_UTC, 1 );
+    time[2] = BREAK_UINT32( WALL_UTC, 2 );
+    time[3] = BREAK_UINT32( WALL_UTC, 3 );
+    time[4] = LO_UINT16( WALL_MS );
+    time[5] = HI_UINT16( WALL_MS );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_TIME_UUID, time, sizeof( time ), 0 ), SUCCESS );
+    set = DCBSHost_Now();
+
+    CHECK_EQ( wallShoot( WALL_UTC + 3600, 250 ), BLESHUTTER_STATUS_DELAY );
+    CHECK_EQ( DCBSHost_Read( BLESHUTTER_TIME_UUID, state, &len, 0 ), SUCCESS );
+    CHECK_EQ( len, sizeof( state ) );
+    CHECK( state[0] );
+    CHECK_EQ( BUILD_UINT32( state[1], state[2], state[3], state[4] ), WALL_UTC + 3600 );
+    CHECK_EQ( BUILD_UINT16( state[5], state[6] ), 250 );
+
+    DCBSHost_Run( 3601UL * 1000 );
+    CHECK_EQ( edgeCount, 2 );
+    CHECK( edgeActive[0] && !edgeActive[1] );
+    CHECK_EQ( edgeTime[0] - set, (3600ULL * 1000 - WALL_MS + 250) * 1000 );
+    CHECK_EQ( edgeTime[1] - edgeTime[0], 100000 );
+
+    // That second is gone now
+    CHECK_EQ( wallShoot( WALL_UTC + 3600, 999 ), BLESHUTTER_STATUS_REJECTED );
+    DCBSHost_Run( 2000 );
+    CHECK_EQ( edgeCount, 2 );
+}
+
+// A day of frames every 10 minutes runs in no time and ends on time
+static void testLongRun( void )
+{
+    uint64_t start;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+    start = DCBSHost_Now();
+
+    CHECK_EQ( DCBSHost_Shoot( 144, 0, 0, 600000 - DCBS_DEFAULT_ACTIVE_PERIOD,
+                              BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    DCBSHost_Run( 24UL * 60 * 60 * 1000 );
+
+    CHECK_EQ( edgeCount, MIN( 144 * 2, MAX_EDGES ) );
+    CHECK_EQ( edgeTime[MAX_EDGES - 2] - start, (MAX_EDGES / 2 - 1) * 600000000ULL );
+    CHECK( DCBSHost_Port() & SHUTTER_0 );
+}
+
+// Ten frames of 100 ms every 1000 ms paused 300 ms after the third for 2.2 s.
+// RESUME carries on at 5 s, the next time on the grid; RESUME_SHIFTED 700 ms
+// after the resume, what was left at the pause
+static void testPauseResume( void )
+{
+    static CONST struct
+    {
+        uint8 op;
+        uint32 firstMs;     // the fourth frame, from the first
+    } resumes[] =
+    {
+        { BLESHUTTER_STOP_OP_RESUME,            5000 },
+        { BLESHUTTER_STOP_OP_RESUME_SHIFTED,    5200 },
+    };
+    uint8 stop[BLESHUTTER_STOP_LEN] = { BV(0), BLESHUTTER_STOP_OP_PAUSE };
+    uint8 status[BLESHUTTER_STATUS_LEN];
+    uint8 r;
+    uint8 i;
+
+    DCBSHost_SetEdgeCB( recordEdge );
+
+    for ( r = 0; r < sizeof( resumes ) / sizeof( resumes[0] ); r++ )
+    {
+        edgeCount = 0;
+        CHECK_EQ( DCBSHost_Shoot( 10, 100, 100, 900, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+        DCBSHost_Run( 2400 );
+
+        stop[1] = BLESHUTTER_STOP_OP_PAUSE;
+        CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, sizeof( stop ), 0 ), SUCCESS );
+        DCBSHost_Run( 2200 );
+        CHECK_EQ( edgeCount, 3 * 2 );
+        CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+        CHECK_EQ( status[0], BLESHUTTER_STATUS_PAUSED );
+
+        stop[1] = resumes[r].op;
+        CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, sizeof( stop ), 0 ), SUCCESS );
+        DCBSHost_Run( 10000 );
+
+        // Every frame of the count, on the grid before the pause and a
+        // period apart from the resume on
+        CHECK_EQ( edgeCount, 10 * 2 );
+        for ( i = 1; i < 10 && i * 2U + 1 < edgeCount; i++ )
+        {
+            uint64_t due = (i < 3) ? i * 1000ULL : resumes[r].firstMs + (i - 3) * 1000ULL;
+
+            CHECK( edgeActive[i * 2] && !edgeActive[i * 2 + 1] );
+            CHECK_EQ( edgeTime[i * 2] - edgeTime[0], due * 1000 );
+            CHECK_EQ( edgeTime[i * 2 + 1] - edgeTime[i * 2], 100000 );
+        }
+    }
+}
+
+// Six frames of 100 ms every 1000 ms, then a reset half way to the seventh
+static void shootBeforeReset( void )
+{
+    DCBSHost_Shoot( 20, 0, 100, 900, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) );
+    DCBSHost_Run( 5500 );
+}
+
+// A reset between checkpoints takes the run up at the frame it had reached,
+// with its next press as far from boot as it was from the last release
+static void testResetMidRun( void )
+{
+    uint8 status[BLESHUTTER_STATUS_LEN];
+
+    resetDevice( shootBeforeReset );
+    DCBSHost_SetEdgeCB( recordEdge );
+
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_SHOOTING );
+    CHECK_EQ( BUILD_UINT16( status[1], status[2] ), 6 );
+
+    DCBSHost_Run( 20000 );
+
+    CHECK_EQ( edgeCount, 14 * 2 );
+    CHECK( edgeActive[0] );
+    CHECK_EQ( edgeTime[0], 900000 );
+    CHECK_EQ( edgeTime[2] - edgeTime[0], 1000000 );
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_DONE );
+    CHECK_EQ( BUILD_UINT16( status[1], status[2] ), 20 );
+}
+
+// A program that never waits only yields, the device carries on and a
+// Stop ends it
+static void testSpinningProgram( void )
+{
+    uint8 program[] = { DCBS_OP_JUMP, 0 };
+    uint8 stop = 0;
+    uint8 status[BLESHUTTER_STATUS_LEN];
+
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_PROGRAM_UUID, program, sizeof( program ), 0 ), SUCCESS );
+    DCBSHost_Run( 100 );
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_PROGRAM );
+
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, &stop, sizeof( stop ), 0 ), SUCCESS );
+    DCBSHost_Run( 100 );
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_STOPPED );
+}
+
+// The trace file has a header and a row for each edge
+static void testTrace( void )
+{
+    char line[64];
+    FILE *pFile = tmpfile();
+    uint32 rows = 0;
+
+    CHECK( pFile != NULL );
+    if ( pFile == NULL )
+    {
+        return;
+    }
+
+    DCBSHost_TraceEdges( pFile );
+    DCBSHost_Shoot( 2, 10, 50, 100, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) );
+    DCBSHost_Run( 1000 );
+    DCBSHost_TraceEdges( NULL );
+
+    rewind( pFile );
+    CHECK( fgets( line, sizeof( line ), pFile ) != NULL );
+    CHECK( strcmp( line, "time_us,line,level\n" ) == 0 );
+
+    CHECK( fgets( line, sizeof( line ), pFile ) != NULL );
+    CHECK( strcmp( line, "10000,P0.1,0\n" ) == 0 );
+    rows = 1;
+    while ( fgets( line, sizeof( line ), pFile ) != NULL )
+    {
+        rows++;
+    }
+    CHECK_EQ( rows, 4 );
+
+    fclose( pFile );
+}
+
+// A subscribed central hears the run start and finish. Of 40 frames 25 ms
+// apart it hears state changes at once and the count in between at most
+// 4 times a second; with Rate 0 the count is held back until a Rate write
+static void testStatusNotify( void )
+{
+    uint8 rate = 0;
+    uint32 i;
+
+    DCBSHost_SetNotifyCB( recordNotify );
+    DCBSHost_Run( 1000 );
+    DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+    CHECK( DCBSHost_ConnInterval() != 0 );
+    CHECK_EQ( DCBSHost_Subscribe( BLESHUTTER_STATUS_UUID, TRUE ), SUCCESS );
+
+    DCBSHost_Shoot( 2, 0, 100, 100, 0, BV(0) );
+    DCBSHost_Run( 2000 );
+
+    CHECK( statusCount >= 2 );
+    CHECK_EQ( lastStatus[0], BLESHUTTER_STATUS_DONE );
+    CHECK_EQ( BUILD_UINT16( lastStatus[1], lastStatus[2] ), 2 );
+    CHECK_EQ( BUILD_UINT16( lastStatus[3], lastStatus[4] ), 2 );
+
+    // Fast run at the default rate: DELAY, SHOOTING, three counts in the
+    // second it takes, DONE
+    statusCount = 0;
+    DCBSHost_Shoot( 40, 0, 10, 15, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) );
+    DCBSHost_Run( 2000 );
+
+    CHECK_EQ( statusCount, 6 );
+    CHECK_EQ( statusState[0], BLESHUTTER_STATUS_DELAY );
+    CHECK_EQ( statusState[1], BLESHUTTER_STATUS_SHOOTING );
+    for ( i = 2; i < statusCount - 1 && i < MAX_STATUS; i++ )
+    {
+        CHECK_EQ( statusState[i], BLESHUTTER_STATUS_SHOOTING );
+        CHECK( statusTime[i] - statusTime[i - 1] >= 1000000 / STATUS_RATE );
+        CHECK( statusFrames[i] > statusFrames[i - 1] );
+    }
+    CHECK_EQ( lastStatus[0], BLESHUTTER_STATUS_DONE );
+    CHECK_EQ( BUILD_UINT16( lastStatus[1], lastStatus[2] ), 40 );
+
+    // Rate 0 holds the counts back, a Rate write sends the latest at once
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_RATE_UUID, &rate, sizeof( rate ), 0 ), SUCCESS );
+    statusCount = 0;
+    DCBSHost_Shoot( 40, 0, 10, 15, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) );
+    DCBSHost_Run( 500 );
+    CHECK_EQ( statusCount, 2 );
+    CHECK_EQ( statusState[1], BLESHUTTER_STATUS_SHOOTING );
+
+    rate = STATUS_RATE;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_RATE_UUID, &rate, sizeof( rate ), 0 ), SUCCESS );
+    CHECK_EQ( statusCount, 3 );
+    CHECK_EQ( statusState[2], BLESHUTTER_STATUS_SHOOTING );
+    CHECK_EQ( statusFrames[2], 20 );
+}
+
+// Stats counts what the host saw: advertising events, connection events
+// at the interval the run was granted, the notifications a subscribed
+// client got and the presses, and active time is the work of each event
+static void testStats( void )
+{
+    uint32 events;
+    uint32 active;
+
+    DCBSHost_SetWork( STATS_WORK_US );
+    DCBSHost_SetNotifyCB( recordNotify );
+    DCBSHost_Run( 10000 );
+    CHECK( DCBSHost_AdvEvents() > 0 );
+    CHECK_EQ( statsField( STATS_ADV_EVENTS ), DCBSHost_AdvEvents() );
+    CHECK_EQ( statsField( STATS_CONN_EVENTS ), 0 );
+
+    DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+    CHECK_EQ( DCBSHost_Subscribe( BLESHUTTER_STATUS_UUID, TRUE ), SUCCESS );
+    CHECK_EQ( DCBSHost_Shoot( 5, 0, 100, 100, BLESHUTTER_SHOOTING_OPT_ANCHORED, BV(0) ), SUCCESS );
+    DCBSHost_Run( 10000 );
+
+    CHECK( DCBSHost_ConnInterval() != DCBS_HOST_CONN_INTERVAL );
+    CHECK_EQ( statsField( STATS_CONN_EVENTS ), DCBSHost_ConnEvents() );
+    CHECK( statusCount > 0 );
+    CHECK_EQ( statsField( STATS_NOTIFICATIONS ), statusCount );
+    CHECK_EQ( statsField( STATS_PRESSES ), 5 );
+    CHECK_EQ( statsField( STATS_UPTIME ), DCBSHost_Now() / 1000 );
+
+    // Each event is timed from one sleep timer tick to another
+    events = statsField( STATS_EVENTS );
+    active = statsField( STATS_ACTIVE );
+    CHECK( events > 0 );
+    CHECK( active >= events * STATS_WORK_TICKS );
+    CHECK( active <= events * (STATS_WORK_TICKS + 1) );
+}
+
+// The display shows the application and its state
+static void testDisplay( void )
+{
+    CHECK( strcmp( DCBSHost_Lcd( HAL_LCD_LINE_1 ), "BLE Shutter" ) == 0 );
+    DCBSHost_Run( 100 );
+    CHECK( strcmp( DCBSHost_Lcd( HAL_LCD_LINE_3 ), "Advertising" ) == 0 );
+    DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+    CHECK( strcmp( DCBSHost_Lcd( HAL_LCD_LINE_3 ), "Connected" ) == 0 );
+}
+
+/*********************************************************************
+ * MAIN
+ */
+
+int main( void )
+{
+    RUN_TEST( testAnchoredFrames );
+    RUN_TEST( testPhaseError );
+    RUN_TEST( testMicrosecondPulse );
+    RUN_TEST( testBracket );
+    RUN_TEST( testChannels );
+    RUN_TEST( testWallStart );
+    RUN_TEST( testLongRun );
+    RUN_TEST( testPauseResume );
+    RUN_TEST( testResetMidRun );
+    RUN_TEST( testSpinningProgram );
+    RUN_TEST( testTrace );
+    RUN_TEST( testStatusNotify );
+    RUN_TEST( testStats );
+    RUN_TEST( testDisplay );
+
+    return ( TEST_RESULT() );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,317 @@
+/**************************************************************************************************
+  Filename:       test_writes.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Host tests of malformed writes: every value the service
+                  refuses gets its ATT error, changes nothing on the lines
+                  or in what is read back, and Command parameters are held
+                  to the same rules. A Power write of the mode already set
+                  doesn't reach SNV either.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "bcomdef.h"
+#include "att.h"
+
+#include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutterService.h"
+#include "DSLRCameraBLEShutter_Host.h"
+
+#include "host_test.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// First mask bit past the channels
+#define BAD_CHANNEL                         BV(DCBS_NUM_CHANNELS)
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint32 edgeCount = 0;
+
+static uint32 ackCount = 0;
+static uint8 lastAck[BLESHUTTER_COMMAND_ACK_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static void countEdge( uint64_t timeUs, uint8 port, uint8 changed )
+{
+    edgeCount++;
+}
+
+static void recordAck( uint16 uuid, uint8 *pValue, uint8 len )
+{
+    if ( uuid == BLESHUTTER_COMMAND_UUID && len == BLESHUTTER_COMMAND_ACK_LEN )
+    {
+        memcpy( lastAck, pValue, len );
+        ackCount++;
+    }
+}
+
+// A Shooting value of one 100 ms frame after 100 ms, up to the channel mask
+static void shootingBase( uint8 *pValue, uint8 options, uint8 mask )
+{
+    memset( pValue, 0, BLESHUTTER_SHOOTING_BASE_LEN );
+    pValue[0] = 1;
+    pValue[2] = 100;
+    pValue[6] = 100;
+    pValue[14] = options;
+    pValue[15] = mask;
+}
+
+// The same with every field
+static uint8 shootingValue( uint8 *pValue, uint8 options, uint8 mask )
+{
+    memset( pValue, 0, BLESHUTTER_SHOOTING_LEN );
+    pValue[0] = 1;
+    pValue[2] = 100;
+    pValue[6] = 100;
+    pValue[14] = options;
+    pValue[15] = mask;
+
+    return ( BLESHUTTER_SHOOTING_LEN );
+}
+
+static void testFocusMask( void )
+{
+    uint8 mask;
+
+    DCBSHost_SetEdgeCB( countEdge );
+
+    mask = BAD_CHANNEL;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_FOCUS_UUID, &mask, 1, 0 ), ATT_ERR_INVALID_VALUE );
+    mask = 0x80 | BV(0);
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_FOCUS_UUID, &mask, 1, 0 ), ATT_ERR_INVALID_VALUE );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_FOCUS_UUID, &mask, 2, 0 ), ATT_ERR_INVALID_VALUE_SIZE );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_FOCUS_UUID, &mask, 0, 0 ), ATT_ERR_INVALID_VALUE_SIZE );
+    DCBSHost_Run( 1000 );
+    CHECK_EQ( edgeCount, 0 );
+
+    // Every channel there is
+    mask = BAD_CHANNEL - 1;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_FOCUS_UUID, &mask, 1, 0 ), SUCCESS );
+    DCBSHost_Run( 1000 );
+    CHECK( edgeCount > 0 );
+}
+
+static void testShootingFields( void )
+{
+    uint8 value[BLESHUTTER_SHOOTING_LEN + 1];
+    uint8 status[BLESHUTTER_STATUS_LEN];
+    uint8 len;
+    uint8 bit;
+
+    DCBSHost_SetEdgeCB( countEdge );
+
+    // Every option bit past the ones defined
+    for ( bit = 0; bit < 8; bit++ )
+    {
+        if ( !(BV(bit) & BLESHUTTER_SHOOTING_OPTS) )
+        {
+            len = shootingValue( value, BV(bit), BV(0) );
+            CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, len, 0 ), ATT_ERR_INVALID_VALUE );
+        }
+    }
+
+    len = shootingValue( value, 0, BAD_CHANNEL );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, len, 0 ), ATT_ERR_INVALID_VALUE );
+    len = shootingValue( value, 0, 0xFF );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, 16, 0 ), ATT_ERR_INVALID_VALUE );
+
+    // Start ms of a second or more
+    len = shootingValue( value, 0, BV(0) );
+    value[19] = LO_UINT16( 1000 );
+    value[20] = HI_UINT16( 1000 );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, len, 0 ), ATT_ERR_INVALID_VALUE );
+
+    // Short of the base fields, and past the last one
+    len = shootingValue( value, 0, BV(0) );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, BLESHUTTER_SHOOTING_BASE_LEN - 1, 0 ),
+              ATT_ERR_INVALID_VALUE_SIZE );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, BLESHUTTER_SHOOTING_LEN + 1, 0 ),
+              ATT_ERR_INVALID_VALUE_SIZE );
+
+    // Not a long value
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, len, 4 ), ATT_ERR_ATTR_NOT_LONG );
+
+    DCBSHost_Run( 2000 );
+    CHECK_EQ( edgeCount, 0 );
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_IDLE );
+
+    // The same value with every defined field in range is taken
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SHOOTING_UUID, value, len, 0 ), SUCCESS );
+    DCBSHost_Run( 2000 );
+    CHECK_EQ( edgeCount, 2 );
+}
+
+static void testStopFields( void )
+{
+    uint8 stop[BLESHUTTER_STOP_LEN];
+    uint8 status[BLESHUTTER_STATUS_LEN];
+
+    DCBSHost_Shoot( 10, 0, 100, 1000, 0, BV(0) );
+    DCBSHost_Run( 500 );
+
+    stop[0] = BV(0);
+    stop[1] = BLESHUTTER_STOP_OP_RESUME_SHIFTED + 1;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, 2, 0 ), ATT_ERR_INVALID_VALUE );
+    stop[1] = 0xFF;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, 2, 0 ), ATT_ERR_INVALID_VALUE );
+
+    stop[0] = BV(0) | BAD_CHANNEL;
+    stop[1] = BLESHUTTER_STOP_OP_STOP;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, 2, 0 ), ATT_ERR_INVALID_VALUE );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, 1, 0 ), ATT_ERR_INVALID_VALUE );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, 0, 0 ), ATT_ERR_INVALID_VALUE_SIZE );
+
+    // Still running
+    DCBSHost_Run( 1000 );
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_SHOOTING );
+
+    stop[0] = BV(0);
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STOP_UUID, stop, 2, 0 ), SUCCESS );
+    CHECK_EQ( DCBSHost_ReadLong( BLESHUTTER_STATUS_UUID, status, sizeof( status ) ), sizeof( status ) );
+    CHECK_EQ( status[0], BLESHUTTER_STATUS_STOPPED );
+}
+
+static void testRateRange( void )
+{
+    uint8 rate;
+    uint8 value[ATT_MTU_SIZE];
+    uint8 len = 0;
+
+    rate = BLESHUTTER_RATE_MAX;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_RATE_UUID, &rate, 1, 0 ), SUCCESS );
+
+    rate = BLESHUTTER_RATE_MAX + 1;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_RATE_UUID, &rate, 1, 0 ), ATT_ERR_INVALID_VALUE );
+    rate = 0xFF;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_RATE_UUID, &rate, 1, 0 ), ATT_ERR_INVALID_VALUE );
+
+    CHECK_EQ( DCBSHost_Read( BLESHUTTER_RATE_UUID, value, &len, 0 ), SUCCESS );
+    CHECK_EQ( len, BLESHUTTER_RATE_LEN );
+    CHECK_EQ( value[0], BLESHUTTER_RATE_MAX );
+
+    rate = 0;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_RATE_UUID, &rate, 1, 0 ), SUCCESS );
+}
+
+static void testOtherValues( void )
+{
+    uint8 value[BLESHUTTER_SYNC_LEN];
+
+    memset( value, 0, sizeof( value ) );
+
+    // Unknown commands
+    value[0] = BLESHUTTER_SYNC_FOLLOW_UP + 1;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SYNC_UUID, value, 2, 0 ), ATT_ERR_INVALID_VALUE );
+    value[0] = BLESHUTTER_SYNC_FOLLOW_UP;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_SYNC_UUID, value, 2, 0 ), ATT_ERR_INVALID_VALUE_SIZE );
+
+    // Time ms of a second or more
+    memset( value, 0, sizeof( value ) );
+    value[4] = LO_UINT16( 1000 );
+    value[5] = HI_UINT16( 1000 );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_TIME_UUID, value, BLESHUTTER_TIME_LEN, 0 ), ATT_ERR_INVALID_VALUE );
+
+    value[0] = BLESHUTTER_POWER_SAVE + 1;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_POWER_UUID, value, 1, 0 ), ATT_ERR_INVALID_VALUE );
+
+    // Read only values
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STATUS_UUID, value, 1, 0 ), ATT_ERR_WRITE_NOT_PERMITTED );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_STATS_UUID, value, 1, 0 ), ATT_ERR_WRITE_NOT_PERMITTED );
+}
+
+static void testPowerWrites( void )
+{
+    uint8 power = BLESHUTTER_POWER_NORMAL;
+    uint32 writes = DCBSHost_SnvWrites();
+
+    // Normal is what an empty SNV reads as
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_POWER_UUID, &power, sizeof( power ), 0 ), SUCCESS );
+    CHECK_EQ( DCBSHost_SnvWrites(), writes );
+
+    power = BLESHUTTER_POWER_SAVE;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_POWER_UUID, &power, sizeof( power ), 0 ), SUCCESS );
+    CHECK_EQ( DCBSHost_SnvWrites(), writes + 1 );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_POWER_UUID, &power, sizeof( power ), 0 ), SUCCESS );
+    CHECK_EQ( DCBSHost_SnvWrites(), writes + 1 );
+
+    power = BLESHUTTER_POWER_NORMAL;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_POWER_UUID, &power, sizeof( power ), 0 ), SUCCESS );
+    CHECK_EQ( DCBSHost_SnvWrites(), writes + 2 );
+}
+
+static void testCommandParams( void )
+{
+    uint8 command[BLESHUTTER_COMMAND_LEN];
+
+    DCBSHost_SetEdgeCB( countEdge );
+    DCBSHost_SetNotifyCB( recordAck );
+    DCBSHost_Connect( DCBS_HOST_CONN_INTERVAL );
+    CHECK_EQ( DCBSHost_Subscribe( BLESHUTTER_COMMAND_UUID, TRUE ), SUCCESS );
+
+    command[0] = 1;
+    command[1] = BLESHUTTER_COMMAND_FOCUS;
+    command[2] = BAD_CHANNEL;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_COMMAND_UUID, command, 3, 0 ), SUCCESS );
+    CHECK_EQ( ackCount, 1 );
+    CHECK_EQ( lastAck[2], BLESHUTTER_COMMAND_BAD_VALUE );
+
+    command[0] = 2;
+    command[1] = BLESHUTTER_COMMAND_STOP;
+    command[2] = BV(0);
+    command[3] = BLESHUTTER_STOP_OP_RESUME_SHIFTED + 1;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_COMMAND_UUID, command, 4, 0 ), SUCCESS );
+    CHECK_EQ( ackCount, 2 );
+    CHECK_EQ( lastAck[2], BLESHUTTER_COMMAND_BAD_VALUE );
+
+    command[0] = 3;
+    command[1] = BLESHUTTER_COMMAND_SHOOT;
+    shootingBase( command + BLESHUTTER_COMMAND_HDR_LEN, 0x80, BV(0) );
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_COMMAND_UUID, command, BLESHUTTER_COMMAND_HDR_LEN + 16, 0 ),
+              SUCCESS );
+    CHECK_EQ( ackCount, 3 );
+    CHECK_EQ( lastAck[2], BLESHUTTER_COMMAND_BAD_VALUE );
+
+    command[0] = 4;
+    command[BLESHUTTER_COMMAND_HDR_LEN + 14] = 0;
+    command[BLESHUTTER_COMMAND_HDR_LEN + 15] = BAD_CHANNEL;
+    CHECK_EQ( DCBSHost_Write( BLESHUTTER_COMMAND_UUID, command, BLESHUTTER_COMMAND_HDR_LEN + 16, 0 ),
+              SUCCESS );
+    CHECK_EQ( ackCount, 4 );
+    CHECK_EQ( lastAck[2], BLESHUTTER_COMMAND_BAD_VALUE );
+
+    DCBSHost_Run( 2000 );
+    CHECK_EQ( edgeCount, 0 );
+}
+
+/*********************************************************************
+ * MAIN
+ */
+
+int main( void )
+{
+    RUN_TEST( testFocusMask );
+    RUN_TEST( testShootingFields );
+    RUN_TEST( testStopFields );
+    RUN_TEST( testRateRange );
+    RUN_TEST( testOtherValues );
+    RUN_TEST( testPowerWrites );
+    RUN_TEST( testCommandParams );
+
+    return ( TEST_RESULT() );
+}
+
+/*********************************************************************
+ *********************************************************************/
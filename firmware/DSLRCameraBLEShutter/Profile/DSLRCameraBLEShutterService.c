@@ -23,6 +23,9 @@
  * MACROS
  */
 
+// Continuation offset marking no long DATA write in progress
+#define UPLOAD_NO_LONG_WRITE                0xFFFF
+
 /*********************************************************************
  * CONSTANTS
  */
@@ -31,34 +34,26 @@
  * TYPEDEFS
  */
 
-// DSLR Camera BLE Shutter Service UUID
-CONST uint8 bleShutterServUUID[ATT_BT_UUID_SIZE] = 
-{
-    LO_UINT16(BLESHUTTER_SERV_UUID), HI_UINT16(BLESHUTTER_SERV_UUID)
-};
+// Checks the fields of a write whose length is in range
+typedef bStatus_t (*bleShutterCheck_t)( uint8 *pValue, uint8 len );
 
-// Characteristic Focus UUID
-CONST uint8 bleShutterFocusUUID[ATT_BT_UUID_SIZE] = 
+typedef struct
 {
-    LO_UINT16(BLESHUTTER_FOCUS_UUID), HI_UINT16(BLESHUTTER_FOCUS_UUID)
-};
+    uint8   kind;               // BLESHUTTER_ATTR_SERVICE ...
+    uint8   param;              // parameter ID of its characteristic
+    uint8   *pValue;            // value: where it is kept, NULL if built on each read
+    uint8   *pLen;              // value: length of the last write if that varies
+    uint8   *pRead;             // value: what a read returns, NULL if nothing or built on each read
+    uint8   readLen;
+    uint8   minLen;             // value: lengths a write may have, maxLen 0 if never written
+    uint8   maxLen;
+    bleShutterCheck_t pfnCheck; // value: checks the fields of a write, NULL if any will do
+} bleShutterAttrInfo_t;
 
-// Characteristic Shooting UUID
-CONST uint8 bleShutterShootingUUID[ATT_BT_UUID_SIZE] = 
-{
-    LO_UINT16(BLESHUTTER_SHOOTING_UUID), HI_UINT16(BLESHUTTER_SHOOTING_UUID)
-};
-
-// Characteristic Stop UUID
-CONST uint8 bleShutterStopUUID[ATT_BT_UUID_SIZE] = 
-{
-    LO_UINT16(BLESHUTTER_STOP_UUID), HI_UINT16(BLESHUTTER_STOP_UUID)
-};
-
-// Characteristic Progress UUID
-CONST uint8 bleShutterProgressUUID[ATT_BT_UUID_SIZE] = 
+// DSLR Camera BLE Shutter Service UUID
+CONST uint8 bleShutterServUUID[ATT_BT_UUID_SIZE] = 
 {
-    LO_UINT16(BLESHUTTER_PROGRESS_UUID), HI_UINT16(BLESHUTTER_PROGRESS_UUID)
+    LO_UINT16(BLESHUTTER_SERV_UUID), HI_UINT16(BLESHUTTER_SERV_UUID)
 };
 
 /*********************************************************************
@@ -82,44 +77,209 @@ static bleShutterCBs_t *bleShutter_AppCBs = NULL;
 // DSLR Camera BLE Shutter Service attribute
 static CONST gattAttrType_t bleShutterService = { ATT_BT_UUID_SIZE, bleShutterServUUID };
 
-
-// Characteristic Focus Properties
-static uint8 bleShutterFocusProps = GATT_PROP_WRITE;
 // Characteristic Focus Value
 static uint8 bleShutterFocus = 0;
-// Characteristic Focus Description
-static uint8 bleShutterFocusUserDesp[] = "Focus\0";
 
-// Characteristic Shooting Properties
-static uint8 bleShutterShootingProps = GATT_PROP_WRITE;
 // Characteristic Shooting Value
 static uint8 bleShutterShooting[BLESHUTTER_SHOOTING_LEN] = { 0 };
-// Characteristic Shooting Description
-static uint8 bleShutterShootingUserDesp[] = "Shooting\0";
 
-// Characteristic Stop Properties
-static uint8 bleShutterStopProps = GATT_PROP_WRITE;
 // Characteristic Stop Value
-static uint8 bleShutterStop = 0;
-// Characteristic Stop Description
-static uint8 bleShutterStopUserDesp[] = "Stop\0";
+static uint8 bleShutterStop[BLESHUTTER_STOP_LEN] = { 0 };
 
-// Characteristic Progress Properties
-static uint8 bleShutterProgressProps = GATT_PROP_NOTIFY;
 // Characteristic Progress Value
 static uint8 bleShutterProgress[BLESHUTTER_PROGRESS_LEN] = { 0 };
-// Characteristic Progress Configuration Each client has its own
-// instantiation of the Client Characteristic Configuration. Reads of the
-// Client Characteristic Configuration only shows the configuration for
-// that client and writes only affect the configuration of that client.
-static gattCharCfg_t bleShutterProgressConfig[GATT_MAX_NUM_CONN];
-// Characteristic Progress Description
-static uint8 bleShutterProgressUserDesp[] = "Progress\0";
+
+// Characteristic Program Value
+static uint8 bleShutterProgram[BLESHUTTER_PROGRAM_LEN] = { 0 };
+// Characteristic Program Length of the last write
+static uint8 bleShutterProgramLen = 0;
+
+// Characteristic Upload staging buffer
+static uint8 bleShutterUpload[BLESHUTTER_UPLOAD_MAX_LEN];
+// Characteristic Upload state
+static uint8 bleShutterUploadState = BLESHUTTER_UPLOAD_IDLE;
+static uint8 bleShutterUploadType = 0;
+static uint8 bleShutterUploadLen = 0;
+static uint8 bleShutterUploadReceived = 0;
+static uint16 bleShutterUploadCRC = 0;
+// Blob offset of the DATA record a long write continues
+static uint16 bleShutterUploadLongBase = UPLOAD_NO_LONG_WRITE;
+
+// Characteristic Status Value
+static uint8 bleShutterStatus[BLESHUTTER_STATUS_LEN] = { 0 };
+
+// Characteristic Rate Value
+static uint8 bleShutterRate = 0;
+
+// Characteristic Timing Value
+static uint8 bleShutterTiming[BLESHUTTER_TIMING_LEN] = { 0 };
+
+// Characteristic Sync last command
+static uint8 bleShutterSync[BLESHUTTER_SYNC_LEN] = { 0 };
+static uint8 bleShutterSyncLen = 0;
+// Characteristic Sync state, what a read returns
+static uint8 bleShutterSyncState[BLESHUTTER_SYNC_STATE_LEN] = { 0 };
+
+// Characteristic Time Value, the last time written
+static uint8 bleShutterTime[BLESHUTTER_TIME_LEN] = { 0 };
+// Characteristic Time state, what a read returns
+static uint8 bleShutterTimeState[BLESHUTTER_TIME_STATE_LEN] = { 0 };
+
+// Characteristic Power Value
+static uint8 bleShutterPower = BLESHUTTER_POWER_NORMAL;
+
+// Characteristic Command last command
+static uint8 bleShutterCommand[BLESHUTTER_COMMAND_LEN] = { 0 };
+static uint8 bleShutterCommandLen = 0;
+// Characteristic Command ack, what a notification carries
+static uint8 bleShutterCommandAck[BLESHUTTER_COMMAND_ACK_LEN] = { 0 };
+
+/*********************************************************************
+ * Profile Attributes - Description
+ *
+ * The service, one entry per characteristic in attribute table order.
+ * The characteristic UUIDs, properties, descriptions and configurations,
+ * the attribute table and the attribute info that reads, writes and the
+ * parameter calls look values up in are all generated from it.
+ *
+ *   CHAR( name, param, props, permit,
+ *         pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck )
+ *   CHAR_CFG( ... ), the same for a characteristic that notifies
+ *
+ *   name - bleShutter<name>UUID, Props, UserDesp and Config are generated
+ *   param - parameter ID, with the UUID in <param>_UUID
+ *   props, permit - properties, permissions of the value
+ *   pValue - value, NULL if the application builds it on each read
+ *   pLen - length of the last write of a value whose length varies,
+ *          NULL for one kept at maxLen with missing trailing bytes 0
+ *   pRead, readLen - what a read of the value returns and what the
+ *                    application sets, NULL if nothing or built on each
+ *                    read; without it the application sets pValue
+ *   minLen, maxLen - lengths a write may have, maxLen 0 if never written
+ *   pfnCheck - checks the fields of a write, NULL if any will do
+ */
+#define BLESHUTTER_CHARS( CHAR, CHAR_CFG ) \
+    CHAR(     Focus,    BLESHUTTER_FOCUS,    GATT_PROP_WRITE,                                           GATT_PERMIT_WRITE, \
+            &bleShutterFocus,   NULL,                  NULL,                 0,                          1,                            1,                         bleShutter_CheckMask ) \
+    CHAR(     Shooting, BLESHUTTER_SHOOTING, GATT_PROP_WRITE,                                           GATT_PERMIT_WRITE, \
+            bleShutterShooting, NULL,                  NULL,                 0,                          BLESHUTTER_SHOOTING_BASE_LEN, BLESHUTTER_SHOOTING_LEN,   bleShutter_CheckShooting ) \
+    CHAR(     Stop,     BLESHUTTER_STOP,     GATT_PROP_WRITE,                                           GATT_PERMIT_WRITE, \
+            bleShutterStop,     NULL,                  NULL,                 0,                          1,                            BLESHUTTER_STOP_LEN,       bleShutter_CheckStop ) \
+    CHAR_CFG( Progress, BLESHUTTER_PROGRESS, GATT_PROP_NOTIFY,                                          0, \
+            bleShutterProgress, NULL,                  bleShutterProgress,   BLESHUTTER_PROGRESS_LEN,    0,                            0,                         NULL ) \
+    CHAR(     Program,  BLESHUTTER_PROGRAM,  GATT_PROP_WRITE,                                           GATT_PERMIT_WRITE, \
+            bleShutterProgram,  &bleShutterProgramLen, NULL,                 0,                          1,                            BLESHUTTER_PROGRAM_LEN,    NULL ) \
+    CHAR(     Upload,   BLESHUTTER_UPLOAD,   GATT_PROP_READ | GATT_PROP_WRITE | GATT_PROP_WRITE_NO_RSP, GATT_PERMIT_READ | GATT_PERMIT_WRITE, \
+            bleShutterUpload,   NULL,                  NULL,                 0,                          1,                            BLESHUTTER_UPLOAD_MAX_LEN, NULL ) \
+    CHAR_CFG( Status,   BLESHUTTER_STATUS,   GATT_PROP_READ | GATT_PROP_NOTIFY,                         GATT_PERMIT_READ, \
+            bleShutterStatus,   NULL,                  bleShutterStatus,     BLESHUTTER_STATUS_LEN,      0,                            0,                         NULL ) \
+    CHAR(     Rate,     BLESHUTTER_RATE,     GATT_PROP_READ | GATT_PROP_WRITE,                          GATT_PERMIT_READ | GATT_PERMIT_WRITE, \
+            &bleShutterRate,    NULL,                  &bleShutterRate,      BLESHUTTER_RATE_LEN,        BLESHUTTER_RATE_LEN,          BLESHUTTER_RATE_LEN,       bleShutter_CheckRate ) \
+    CHAR(     Timing,   BLESHUTTER_TIMING,   GATT_PROP_READ,                                            GATT_PERMIT_READ, \
+            bleShutterTiming,   NULL,                  bleShutterTiming,     BLESHUTTER_TIMING_LEN,      0,                            0,                         NULL ) \
+    CHAR(     Sync,     BLESHUTTER_SYNC,     GATT_PROP_READ | GATT_PROP_WRITE,                          GATT_PERMIT_READ | GATT_PERMIT_WRITE, \
+            bleShutterSync,     &bleShutterSyncLen,    bleShutterSyncState,  BLESHUTTER_SYNC_STATE_LEN,  2,                            BLESHUTTER_SYNC_LEN,       bleShutter_CheckSync ) \
+    CHAR(     Time,     BLESHUTTER_TIME,     GATT_PROP_READ | GATT_PROP_WRITE,                          GATT_PERMIT_READ | GATT_PERMIT_WRITE, \
+            bleShutterTime,     NULL,                  bleShutterTimeState,  BLESHUTTER_TIME_STATE_LEN,  BLESHUTTER_TIME_LEN,          BLESHUTTER_TIME_LEN,       bleShutter_CheckTime ) \
+    CHAR(     Power,    BLESHUTTER_POWER,    GATT_PROP_READ | GATT_PROP_WRITE,                          GATT_PERMIT_READ | GATT_PERMIT_WRITE, \
+            &bleShutterPower,   NULL,                  &bleShutterPower,     BLESHUTTER_POWER_LEN,       BLESHUTTER_POWER_LEN,         BLESHUTTER_POWER_LEN,      bleShutter_CheckPower ) \
+    CHAR(     Stats,    BLESHUTTER_STATS,    GATT_PROP_READ,                                            GATT_PERMIT_READ, \
+            NULL,               NULL,                  NULL,                 0,                          0,                            0,                         NULL ) \
+    CHAR(     Trace,    BLESHUTTER_TRACE,    GATT_PROP_READ,                                            GATT_PERMIT_READ, \
+            NULL,               NULL,                  NULL,                 0,                          0,                            0,                         NULL ) \
+    CHAR_CFG( Command,  BLESHUTTER_COMMAND,  GATT_PROP_WRITE_NO_RSP | GATT_PROP_NOTIFY,                 GATT_PERMIT_WRITE, \
+            bleShutterCommand,  &bleShutterCommandLen, bleShutterCommandAck, BLESHUTTER_COMMAND_ACK_LEN, BLESHUTTER_COMMAND_HDR_LEN,   BLESHUTTER_COMMAND_LEN,    NULL )
+
+// Kinds of attribute
+#define BLESHUTTER_ATTR_SERVICE             0
+#define BLESHUTTER_ATTR_DECLARATION         1
+#define BLESHUTTER_ATTR_VALUE               2
+#define BLESHUTTER_ATTR_CONFIG              3
+#define BLESHUTTER_ATTR_DESCRIPTION         4
+
+// Characteristic UUID, properties and description
+#define BLESHUTTER_CHAR_VARS( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    CONST uint8 bleShutter##name##UUID[ATT_BT_UUID_SIZE] = \
+    { \
+        LO_UINT16(param##_UUID), HI_UINT16(param##_UUID) \
+    }; \
+    static uint8 bleShutter##name##Props = props; \
+    static uint8 bleShutter##name##UserDesp[] = #name "\0";
+
+// The same and a Client Characteristic Configuration. Each client has its
+// own instantiation of it: reads only show the configuration for that
+// client and writes only affect the configuration of that client.
+#define BLESHUTTER_CHAR_CFG_VARS( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    CONST uint8 bleShutter##name##UUID[ATT_BT_UUID_SIZE] = \
+    { \
+        LO_UINT16(param##_UUID), HI_UINT16(param##_UUID) \
+    }; \
+    static uint8 bleShutter##name##Props = props; \
+    static uint8 bleShutter##name##UserDesp[] = #name "\0"; \
+    static gattCharCfg_t bleShutter##name##Config[GATT_MAX_NUM_CONN];
+
+// Declaration, value and user description attributes
+#define BLESHUTTER_CHAR_ATTRS( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    { { ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &bleShutter##name##Props }, \
+    { { ATT_BT_UUID_SIZE, bleShutter##name##UUID }, permit, 0, (uint8 *)(pValue) }, \
+    { { ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, bleShutter##name##UserDesp },
+
+// Declaration, value, configuration and user description attributes
+#define BLESHUTTER_CHAR_CFG_ATTRS( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    { { ATT_BT_UUID_SIZE, characterUUID }, GATT_PERMIT_READ, 0, &bleShutter##name##Props }, \
+    { { ATT_BT_UUID_SIZE, bleShutter##name##UUID }, permit, 0, (uint8 *)(pValue) }, \
+    { { ATT_BT_UUID_SIZE, clientCharCfgUUID }, GATT_PERMIT_READ | GATT_PERMIT_WRITE, 0, (uint8 *)bleShutter##name##Config }, \
+    { { ATT_BT_UUID_SIZE, charUserDescUUID }, GATT_PERMIT_READ, 0, bleShutter##name##UserDesp },
+
+// Attribute info, one for each of the attributes above
+#define BLESHUTTER_CHAR_INFO( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    { BLESHUTTER_ATTR_DECLARATION, param, NULL, NULL, NULL, 0, 0, 0, NULL }, \
+    { BLESHUTTER_ATTR_VALUE, param, (uint8 *)(pValue), pLen, (uint8 *)(pRead), readLen, minLen, maxLen, pfnCheck }, \
+    { BLESHUTTER_ATTR_DESCRIPTION, param, NULL, NULL, NULL, 0, 0, 0, NULL },
+
+#define BLESHUTTER_CHAR_CFG_INFO( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    { BLESHUTTER_ATTR_DECLARATION, param, NULL, NULL, NULL, 0, 0, 0, NULL }, \
+    { BLESHUTTER_ATTR_VALUE, param, (uint8 *)(pValue), pLen, (uint8 *)(pRead), readLen, minLen, maxLen, pfnCheck }, \
+    { BLESHUTTER_ATTR_CONFIG, param, NULL, NULL, NULL, 0, 0, 0, NULL }, \
+    { BLESHUTTER_ATTR_DESCRIPTION, param, NULL, NULL, NULL, 0, 0, 0, NULL },
+
+// Client Characteristic Configurations reset for a connection
+#define BLESHUTTER_CHAR_NO_CFG( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck )
+#define BLESHUTTER_CHAR_CFG_INIT( name, param, props, permit, pValue, pLen, pRead, readLen, minLen, maxLen, pfnCheck ) \
+    GATTServApp_InitCharCfg( connHandle, bleShutter##name##Config );
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 bleShutter_ReadAttrCB( uint16 connHandle, gattAttribute_t *pAttr, 
+        uint8 *pValue, uint8 *pLen, uint16 offset, uint8 maxLen );
+static bStatus_t bleShutter_WriteAttrCB( uint16 connHandle, gattAttribute_t *pAttr,
+        uint8 *pValue, uint8 len, uint16 offset );
+
+static void bleShutter_HandleConnStatusCB( uint16 connHandle, uint8 changeType );
+static uint8 bleShutter_FindAttr( uint8 param, uint8 kind );
+static CONST bleShutterAttrInfo_t *bleShutter_AttrInfo( gattAttribute_t *pAttr );
+static bStatus_t bleShutter_CheckWrite( CONST bleShutterAttrInfo_t *pInfo,
+        uint8 *pValue, uint8 len, uint16 offset );
+
+static bStatus_t bleShutter_UploadWrite( uint8 *pValue, uint8 len, uint16 offset, uint8 *pCommitted );
+static bStatus_t bleShutter_UploadData( uint16 offset, uint8 *pData, uint8 len );
+static uint16 bleShutter_CRC16( uint8 *pData, uint8 len );
+
+static bStatus_t bleShutter_CheckMask( uint8 *pValue, uint8 len );
+static bStatus_t bleShutter_CheckShooting( uint8 *pValue, uint8 len );
+static bStatus_t bleShutter_CheckStop( uint8 *pValue, uint8 len );
+static bStatus_t bleShutter_CheckRate( uint8 *pValue, uint8 len );
+static bStatus_t bleShutter_CheckSync( uint8 *pValue, uint8 len );
+static bStatus_t bleShutter_CheckTime( uint8 *pValue, uint8 len );
+static bStatus_t bleShutter_CheckPower( uint8 *pValue, uint8 len );
 
 /*********************************************************************
  * Profile Attributes - Table
  */
 
+BLESHUTTER_CHARS( BLESHUTTER_CHAR_VARS, BLESHUTTER_CHAR_CFG_VARS )
+
 static gattAttribute_t bleShutterAttrTbl[] =
 {
     // BLE Shutter Service
@@ -130,122 +290,17 @@ static gattAttribute_t bleShutterAttrTbl[] =
         (uint8 *)&bleShutterService               /* pValue */
     },
 
-    // Characteristic Focus Declaration
-    { 
-        { ATT_BT_UUID_SIZE, characterUUID },
-        GATT_PERMIT_READ, 
-        0,
-        &bleShutterFocusProps 
-    },
-
-    // Characteristic Focus Value 
-    { 
-        { ATT_BT_UUID_SIZE, bleShutterFocusUUID },
-        GATT_PERMIT_WRITE,
-        0, 
-        &bleShutterFocus 
-    },
-
-    // Characteristic Focus User Description
-    { 
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ, 
-        0, 
-        bleShutterFocusUserDesp 
-    },      
-
-    // Characteristic Shooting Declaration
-    { 
-        { ATT_BT_UUID_SIZE, characterUUID },
-        GATT_PERMIT_READ, 
-        0,
-        &bleShutterShootingProps 
-    },
-
-    // Characteristic Value Shooting
-    { 
-        { ATT_BT_UUID_SIZE, bleShutterShootingUUID },
-        GATT_PERMIT_WRITE,
-        0, 
-        bleShutterShooting 
-    },
-
-    // Characteristic Shooting User Description
-    { 
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ, 
-        0, 
-        bleShutterShootingUserDesp 
-    },           
-
-    // Characteristic Stop Declaration
-    { 
-        { ATT_BT_UUID_SIZE, characterUUID },
-        GATT_PERMIT_READ, 
-        0,
-        &bleShutterStopProps 
-    },
-
-    // Characteristic Stop Value 
-    { 
-        { ATT_BT_UUID_SIZE, bleShutterStopUUID },
-        GATT_PERMIT_WRITE, 
-        0, 
-        &bleShutterStop 
-    },
-
-    // Characteristic Stop User Description
-    { 
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ, 
-        0, 
-        bleShutterStopUserDesp 
-    },
-
-    // Characteristic Progress Declaration
-    { 
-        { ATT_BT_UUID_SIZE, characterUUID },
-        GATT_PERMIT_READ, 
-        0,
-        &bleShutterProgressProps 
-    },
-
-    // Characteristic Progress Value 
-    { 
-        { ATT_BT_UUID_SIZE, bleShutterProgressUUID },
-        0, 
-        0, 
-        bleShutterProgress 
-    },
-
-    // Characteristic Progress configuration
-    { 
-        { ATT_BT_UUID_SIZE, clientCharCfgUUID },
-        GATT_PERMIT_READ | GATT_PERMIT_WRITE, 
-        0, 
-        (uint8 *)bleShutterProgressConfig 
-    },
-
-    // Characteristic Progress User Description
-    { 
-        { ATT_BT_UUID_SIZE, charUserDescUUID },
-        GATT_PERMIT_READ, 
-        0, 
-        bleShutterProgressUserDesp 
-    }
-
+    BLESHUTTER_CHARS( BLESHUTTER_CHAR_ATTRS, BLESHUTTER_CHAR_CFG_ATTRS )
 };
 
+// Indexed like bleShutterAttrTbl, so an attribute is found from its place
+// in the table
+static CONST bleShutterAttrInfo_t bleShutterAttrInfo[] =
+{
+    { BLESHUTTER_ATTR_SERVICE, 0, NULL, NULL, NULL, 0, 0, 0, NULL },
 
-/*********************************************************************
- * LOCAL FUNCTIONS
- */
-static uint8 bleShutter_ReadAttrCB( uint16 connHandle, gattAttribute_t *pAttr, 
-        uint8 *pValue, uint8 *pLen, uint16 offset, uint8 maxLen );
-static bStatus_t bleShutter_WriteAttrCB( uint16 connHandle, gattAttribute_t *pAttr,
-        uint8 *pValue, uint8 len, uint16 offset );
-
-static void bleShutter_HandleConnStatusCB( uint16 connHandle, uint8 changeType );
+    BLESHUTTER_CHARS( BLESHUTTER_CHAR_INFO, BLESHUTTER_CHAR_CFG_INFO )
+};
 
 
 /*********************************************************************
@@ -277,9 +332,10 @@ CONST gattServiceCBs_t bleShutterCBs =
 bStatus_t BLEShutter_AddService( uint32 services )
 {
     uint8 status = SUCCESS;
+    uint16 connHandle = INVALID_CONNHANDLE;
 
     // Initialize Client Characteristic Configuration attributes
-    GATTServApp_InitCharCfg( INVALID_CONNHANDLE, bleShutterProgressConfig );
+    BLESHUTTER_CHARS( BLESHUTTER_CHAR_NO_CFG, BLESHUTTER_CHAR_CFG_INIT )
 
     // Register with Link DB to receive link status change callback
     VOID linkDB_Register( bleShutter_HandleConnStatusCB );  
@@ -337,64 +393,124 @@ bStatus_t BLEShutter_RegisterAppCBs( bleShutterCBs_t *appCallbacks )
  */
 bStatus_t BLEShutter_SetParameter( uint8 param, uint8 len, void *value )
 {
-    bStatus_t ret = SUCCESS;
-    switch ( param )
+    CONST bleShutterAttrInfo_t *pInfo;
+    uint8 i;
+    uint8 cfg;
+
+    i = bleShutter_FindAttr( param, BLESHUTTER_ATTR_VALUE );
+    if ( i == GATT_NUM_ATTRS( bleShutterAttrTbl ) )
     {
-        case BLESHUTTER_FOCUS:
-            if ( len == sizeof ( uint8 ) ) 
-            {
-                bleShutterFocus = *((uint8*)value);
-            }
-            else
-            {
-                ret = bleInvalidRange;
-            }
-            break;
+        return ( INVALIDPARAMETER );
+    }
+    pInfo = &bleShutterAttrInfo[i];
 
-        case BLESHUTTER_SHOOTING:
-            if ( len == BLESHUTTER_SHOOTING_LEN )
-            {
-                VOID osal_memcpy( bleShutterShooting, value, BLESHUTTER_SHOOTING_LEN );
-            }
-            else
-            {
-                ret = bleInvalidRange;
-            }
-            break;
+    if ( param == BLESHUTTER_UPLOAD )
+    {
+        // Application marks a committed blob it couldn't use
+        if ( len != sizeof ( uint8 ) )
+        {
+            return ( bleInvalidRange );
+        }
 
-        case BLESHUTTER_STOP:
-            if ( len == sizeof ( uint8 ) ) 
-            {
-                bleShutterStop = *((uint8*)value);
-            }
-            else
-            {
-                ret = bleInvalidRange;
-            }
-            break;
+        bleShutterUploadState = *((uint8*)value);
+        return ( SUCCESS );
+    }
 
-        case BLESHUTTER_PROGRESS:
-            if ( len == BLESHUTTER_PROGRESS_LEN ) 
-            {
-                VOID osal_memcpy( bleShutterProgress, value, BLESHUTTER_PROGRESS_LEN);
+    // The application sets what a read returns, or a value a client only
+    // writes; one whose length varies is only ever written
+    if ( pInfo->pRead != NULL )
+    {
+        if ( len != pInfo->readLen )
+        {
+            return ( bleInvalidRange );
+        }
+        VOID osal_memcpy( pInfo->pRead, value, len );
+    }
+    else if ( pInfo->pValue != NULL && pInfo->pLen == NULL )
+    {
+        if ( len != pInfo->maxLen )
+        {
+            return ( bleInvalidRange );
+        }
+        VOID osal_memcpy( pInfo->pValue, value, len );
+    }
+    else
+    {
+        return ( INVALIDPARAMETER );
+    }
 
-                // See if Notification has been enabled
-                GATTServApp_ProcessCharCfg( bleShutterProgressConfig, bleShutterProgress, FALSE,
-                        bleShutterAttrTbl, GATT_NUM_ATTRS( bleShutterAttrTbl ),
-                        INVALID_TASK_ID );
-            }
-            else
-            {
-                ret = bleInvalidRange;
-            }
-            break;
+    // See if Notification has been enabled
+    cfg = bleShutter_FindAttr( param, BLESHUTTER_ATTR_CONFIG );
+    if ( cfg != GATT_NUM_ATTRS( bleShutterAttrTbl ) )
+    {
+        GATTServApp_ProcessCharCfg( (gattCharCfg_t *)bleShutterAttrTbl[cfg].pValue,
+                bleShutterAttrTbl[i].pValue, FALSE,
+                bleShutterAttrTbl, GATT_NUM_ATTRS( bleShutterAttrTbl ),
+                INVALID_TASK_ID );
+    }
 
-        default:
-            ret = INVALIDPARAMETER;
-            break;
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      BLEShutter_CheckParameter
+ *
+ * @brief   Check a value as a write of it would be checked, without
+ *          storing it. Values that arrive another way, as the
+ *          parameters of a command, are held to the same rules.
+ *
+ * @param   param - Profile parameter ID
+ * @param   len - length of the value
+ * @param   value - pointer to the value
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or the ATT error the write would get
+ */
+bStatus_t BLEShutter_CheckParameter( uint8 param, uint8 len, void *value )
+{
+    uint8 i = bleShutter_FindAttr( param, BLESHUTTER_ATTR_VALUE );
+
+    if ( i == GATT_NUM_ATTRS( bleShutterAttrTbl ) )
+    {
+        return ( INVALIDPARAMETER );
     }
 
-    return ( ret );
+    return ( bleShutter_CheckWrite( &bleShutterAttrInfo[i], value, len, 0 ) );
+}
+
+/*********************************************************************
+ * @fn      BLEShutter_Notifying
+ *
+ * @brief   Count the clients a new value of a characteristic is
+ *          notified to, those with its notifications turned on.
+ *
+ * @param   param - Profile parameter ID
+ *
+ * @return  number of clients, 0 for a parameter without notifications
+ */
+uint8 BLEShutter_Notifying( uint8 param )
+{
+    gattCharCfg_t *pCfg;
+    uint8 clients = 0;
+    uint8 i;
+    uint8 c;
+
+    i = bleShutter_FindAttr( param, BLESHUTTER_ATTR_CONFIG );
+    if ( i == GATT_NUM_ATTRS( bleShutterAttrTbl ) )
+    {
+        return ( 0 );
+    }
+
+    pCfg = (gattCharCfg_t *)bleShutterAttrTbl[i].pValue;
+    for ( c = 0; c < GATT_MAX_NUM_CONN; c++ )
+    {
+        if ( pCfg[c].connHandle != INVALID_CONNHANDLE &&
+             (pCfg[c].value & GATT_CLIENT_CFG_NOTIFY) )
+        {
+            clients++;
+        }
+    }
+
+    return ( clients );
 }
 
 /*********************************************************************
@@ -412,31 +528,38 @@ bStatus_t BLEShutter_SetParameter( uint8 param, uint8 len, void *value )
  */
 bStatus_t BLEShutter_GetParameter( uint8 param, void *value )
 {
-    bStatus_t ret = SUCCESS;
-    switch ( param )
-    {
-        case BLESHUTTER_FOCUS:
-            *((uint8*)value) = bleShutterFocus;
-            break;
-
-        case BLESHUTTER_SHOOTING:
-            VOID osal_memcpy( value, bleShutterShooting, BLESHUTTER_SHOOTING_LEN );
-            break;      
+    CONST bleShutterAttrInfo_t *pInfo;
+    uint8 i;
 
-        case BLESHUTTER_STOP:
-            *((uint8*)value) = bleShutterStop;
-            break;  
-
-        case BLESHUTTER_PROGRESS:
-            VOID osal_memcpy( value, bleShutterProgress, BLESHUTTER_PROGRESS_LEN );
-            break;      
+    i = bleShutter_FindAttr( param, BLESHUTTER_ATTR_VALUE );
+    if ( i == GATT_NUM_ATTRS( bleShutterAttrTbl ) || bleShutterAttrInfo[i].pValue == NULL )
+    {
+        return ( INVALIDPARAMETER );
+    }
+    pInfo = &bleShutterAttrInfo[i];
 
-        default:
-            ret = INVALIDPARAMETER;
-            break;
+    if ( param == BLESHUTTER_UPLOAD )
+    {
+        ((bleShutterUpload_t*)value)->type = bleShutterUploadType;
+        ((bleShutterUpload_t*)value)->len = bleShutterUploadLen;
+        ((bleShutterUpload_t*)value)->pData = bleShutterUpload;
+    }
+    else if ( pInfo->pLen != NULL )
+    {
+        // Length of the last write, then what was written
+        *((uint8*)value) = *pInfo->pLen;
+        VOID osal_memcpy( (uint8*)value + 1, pInfo->pValue, *pInfo->pLen );
+    }
+    else if ( pInfo->maxLen != 0 )
+    {
+        VOID osal_memcpy( value, pInfo->pValue, pInfo->maxLen );
+    }
+    else
+    {
+        VOID osal_memcpy( value, pInfo->pValue, pInfo->readLen );
     }
 
-    return ( ret );
+    return ( SUCCESS );
 }
 
 /*********************************************************************
@@ -456,6 +579,7 @@ bStatus_t BLEShutter_GetParameter( uint8 param, void *value )
 static uint8 bleShutter_ReadAttrCB( uint16 connHandle, gattAttribute_t *pAttr, 
         uint8 *pValue, uint8 *pLen, uint16 offset, uint8 maxLen )
 {
+    CONST bleShutterAttrInfo_t *pInfo;
     bStatus_t status = SUCCESS;
 
     // If attribute permissions require authorization to read, return error
@@ -465,36 +589,63 @@ static uint8 bleShutter_ReadAttrCB( uint16 connHandle, gattAttribute_t *pAttr,
         return ( ATT_ERR_INSUFFICIENT_AUTHOR );
     }
 
-    // Make sure it's not a blob operation (no attributes in the profile are long)
-    if ( offset > 0 )
+    pInfo = bleShutter_AttrInfo( pAttr );
+    if ( pInfo == NULL )
+    {
+        *pLen = 0;
+        return ( ATT_ERR_INVALID_HANDLE );
+    }
+
+    // No need for the service or configuration attributes; gattserverapp
+    // handles those reads
+    if ( pInfo->kind != BLESHUTTER_ATTR_VALUE )
+    {
+        *pLen = 0;
+        return ( ATT_ERR_ATTR_NOT_FOUND );
+    }
+
+    // Make sure it's not a blob operation (only values the application keeps are long)
+    if ( offset > 0 && pAttr->pValue != NULL )
     {
         return ( ATT_ERR_ATTR_NOT_LONG );
     }
 
-    if ( pAttr->type.len == ATT_BT_UUID_SIZE )
+    switch ( pInfo->param )
     {
-        // 16-bit UUID
-        uint16 uuid = BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1]);
-        switch ( uuid )
-        {
-            // No need for "GATT_SERVICE_UUID" or "GATT_CLIENT_CHAR_CFG_UUID" cases;
-            // gattserverapp handles those reads
-            case BLESHUTTER_PROGRESS_UUID:
-                *pLen = BLESHUTTER_PROGRESS_LEN;
-                VOID osal_memcpy( pValue, pAttr->pValue, BLESHUTTER_PROGRESS_LEN );
-                break;
+        case BLESHUTTER_STATS:
+        case BLESHUTTER_TRACE:
+            if ( bleShutter_AppCBs && bleShutter_AppCBs->pfnBLEShutterRead )
+            {
+                status = bleShutter_AppCBs->pfnBLEShutterRead( pInfo->param,
+                        offset, pValue, pLen, maxLen );
+            }
+            else
+            {
+                *pLen = 0;
+            }
+            break;
+
+        case BLESHUTTER_UPLOAD:
+            *pLen = BLESHUTTER_UPLOAD_STATUS_LEN;
+            pValue[0] = bleShutterUploadState;
+            pValue[1] = bleShutterUploadType;
+            pValue[2] = bleShutterUploadLen;
+            pValue[3] = 0;
+            pValue[4] = bleShutterUploadReceived;
+            pValue[5] = 0;
+            break;
 
-            default:
+        default:
+            if ( pInfo->pRead == NULL )
+            {
                 *pLen = 0;
                 status = ATT_ERR_ATTR_NOT_FOUND;
                 break;
-        }
-    }
-    else
-    {
-        // 128-bit UUID
-        *pLen = 0;
-        status = ATT_ERR_INVALID_HANDLE;
+            }
+
+            *pLen = pInfo->readLen;
+            VOID osal_memcpy( pValue, pInfo->pRead, pInfo->readLen );
+            break;
     }
 
     return ( status );
@@ -516,6 +667,7 @@ static uint8 bleShutter_ReadAttrCB( uint16 connHandle, gattAttribute_t *pAttr,
 static bStatus_t bleShutter_WriteAttrCB( uint16 connHandle, gattAttribute_t *pAttr,
         uint8 *pValue, uint8 len, uint16 offset )
 {
+    CONST bleShutterAttrInfo_t *pInfo;
     bStatus_t status = SUCCESS;
     uint8 notifyApp = 0xFF;
 
@@ -526,35 +678,53 @@ static bStatus_t bleShutter_WriteAttrCB( uint16 connHandle, gattAttribute_t *pAt
         return ( ATT_ERR_INSUFFICIENT_AUTHOR );
     }
 
-    if ( pAttr->type.len == ATT_BT_UUID_SIZE )
+    pInfo = bleShutter_AttrInfo( pAttr );
+    if ( pInfo == NULL )
     {
-        // 16-bit UUID
-        uint16 uuid = BUILD_UINT16( pAttr->type.uuid[0], pAttr->type.uuid[1]);
-        switch ( uuid )
-        {
-            case BLESHUTTER_FOCUS_UUID:
-            case BLESHUTTER_SHOOTING_UUID:
-            case BLESHUTTER_STOP_UUID:
-            case BLESHUTTER_PROGRESS_UUID:
-                VOID osal_memcpy( pAttr->pValue, pValue, len );
-                notifyApp = uuid - BLESHUTTER_SERV_UUID;
+        return ( ATT_ERR_INVALID_HANDLE );
+    }
 
-                break;
+    if ( pInfo->kind == BLESHUTTER_ATTR_CONFIG )
+    {
+        return ( GATTServApp_ProcessCCCWriteReq( connHandle, pAttr, pValue, len,
+                    offset, GATT_CLIENT_CFG_NOTIFY ) );
+    }
 
-            case GATT_CLIENT_CHAR_CFG_UUID:
-                status = GATTServApp_ProcessCCCWriteReq( connHandle, pAttr, pValue, len,
-                        offset, GATT_CLIENT_CFG_NOTIFY );
-                break;
+    if ( pInfo->kind != BLESHUTTER_ATTR_VALUE )
+    {
+        return ( ATT_ERR_WRITE_NOT_PERMITTED );
+    }
 
-            default:
-                status = ATT_ERR_ATTR_NOT_FOUND;
-                break;
+    // Nothing is copied or passed on before the whole write checks out
+    status = bleShutter_CheckWrite( pInfo, pValue, len, offset );
+    if ( status != SUCCESS )
+    {
+        return ( status );
+    }
+
+    if ( pInfo->param == BLESHUTTER_UPLOAD )
+    {
+        uint8 committed = FALSE;
+
+        status = bleShutter_UploadWrite( pValue, len, offset, &committed );
+        if ( committed )
+        {
+            notifyApp = BLESHUTTER_UPLOAD;
         }
     }
     else
     {
-        // 128-bit UUID
-        status = ATT_ERR_INVALID_HANDLE;
+        // Trailing fields are optional, older clients leave them out and
+        // they read as 0; a value whose length varies keeps its length.
+        // A Command gets no response, the application acks anything with
+        // a seq
+        VOID osal_memset( pInfo->pValue, 0, pInfo->maxLen );
+        VOID osal_memcpy( pInfo->pValue, pValue, len );
+        if ( pInfo->pLen != NULL )
+        {
+            *pInfo->pLen = len;
+        }
+        notifyApp = pInfo->param;
     }
 
     // If a charactersitic value changed then callback function to notify application of change
@@ -566,6 +736,406 @@ static bStatus_t bleShutter_WriteAttrCB( uint16 connHandle, gattAttribute_t *pAt
     return ( status );
 }
 
+/*********************************************************************
+ * @fn      bleShutter_UploadWrite
+ *
+ * @brief   Handle one write to the Upload characteristic. Records
+ *          arrive at offset 0; a long write of a DATA record arrives
+ *          as further chunks at increasing attribute offsets, which
+ *          continue that record.
+ *
+ * @param   pValue - pointer to data written
+ * @param   len - length of data
+ * @param   offset - attribute offset of the data
+ * @param   pCommitted - set TRUE when a blob was committed
+ *
+ * @return  Success or an ATT error
+ */
+static bStatus_t bleShutter_UploadWrite( uint8 *pValue, uint8 len, uint16 offset, uint8 *pCommitted )
+{
+    if ( offset > 0 )
+    {
+        if ( bleShutterUploadLongBase == UPLOAD_NO_LONG_WRITE ||
+             offset < BLESHUTTER_UPLOAD_DATA_HDR_LEN )
+        {
+            return ( ATT_ERR_INVALID_OFFSET );
+        }
+
+        return ( bleShutter_UploadData( bleShutterUploadLongBase + offset - BLESHUTTER_UPLOAD_DATA_HDR_LEN,
+                    pValue, len ) );
+    }
+
+    bleShutterUploadLongBase = UPLOAD_NO_LONG_WRITE;
+
+    if ( len == 0 )
+    {
+        return ( ATT_ERR_INVALID_VALUE_SIZE );
+    }
+
+    switch ( pValue[0] )
+    {
+        case BLESHUTTER_UPLOAD_BEGIN:
+            if ( len != BLESHUTTER_UPLOAD_BEGIN_LEN )
+            {
+                return ( ATT_ERR_INVALID_VALUE_SIZE );
+            }
+
+            if ( BUILD_UINT16( pValue[2], pValue[3] ) > BLESHUTTER_UPLOAD_MAX_LEN )
+            {
+                return ( ATT_ERR_INSUFFICIENT_RESOURCES );
+            }
+
+            // Unwritten bytes read as zero so a short upload fails the CRC
+            VOID osal_memset( bleShutterUpload, 0, BLESHUTTER_UPLOAD_MAX_LEN );
+            bleShutterUploadType = pValue[1];
+            bleShutterUploadLen = pValue[2];
+            bleShutterUploadCRC = BUILD_UINT16( pValue[4], pValue[5] );
+            bleShutterUploadReceived = 0;
+            bleShutterUploadState = BLESHUTTER_UPLOAD_RECEIVING;
+            break;
+
+        case BLESHUTTER_UPLOAD_DATA:
+            if ( len < BLESHUTTER_UPLOAD_DATA_HDR_LEN )
+            {
+                return ( ATT_ERR_INVALID_VALUE_SIZE );
+            }
+
+            bleShutterUploadLongBase = BUILD_UINT16( pValue[1], pValue[2] );
+
+            return ( bleShutter_UploadData( bleShutterUploadLongBase,
+                        pValue + BLESHUTTER_UPLOAD_DATA_HDR_LEN, len - BLESHUTTER_UPLOAD_DATA_HDR_LEN ) );
+
+        case BLESHUTTER_UPLOAD_COMMIT:
+            if ( bleShutterUploadState != BLESHUTTER_UPLOAD_RECEIVING )
+            {
+                return ( ATT_ERR_WRITE_NOT_PERMITTED );
+            }
+
+            if ( bleShutter_CRC16( bleShutterUpload, bleShutterUploadLen ) != bleShutterUploadCRC )
+            {
+                bleShutterUploadState = BLESHUTTER_UPLOAD_FAILED;
+                return ( ATT_ERR_INVALID_VALUE );
+            }
+
+            bleShutterUploadState = BLESHUTTER_UPLOAD_COMMITTED;
+            *pCommitted = TRUE;
+            break;
+
+        case BLESHUTTER_UPLOAD_ABORT:
+            bleShutterUploadState = BLESHUTTER_UPLOAD_IDLE;
+            break;
+
+        default:
+            return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_UploadData
+ *
+ * @brief   Copy a chunk into the staging buffer, bounded by the length
+ *          announced in BEGIN.
+ *
+ * @param   offset - blob offset of the chunk
+ * @param   pData - chunk data
+ * @param   len - chunk length
+ *
+ * @return  Success or an ATT error
+ */
+static bStatus_t bleShutter_UploadData( uint16 offset, uint8 *pData, uint8 len )
+{
+    if ( bleShutterUploadState != BLESHUTTER_UPLOAD_RECEIVING )
+    {
+        return ( ATT_ERR_WRITE_NOT_PERMITTED );
+    }
+
+    if ( (uint32)offset + len > bleShutterUploadLen )
+    {
+        return ( ATT_ERR_INVALID_OFFSET );
+    }
+
+    VOID osal_memcpy( bleShutterUpload + offset, pData, len );
+
+    if ( offset + len > bleShutterUploadReceived )
+    {
+        bleShutterUploadReceived = offset + len;
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CRC16
+ *
+ * @brief   CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF).
+ *
+ * @param   pData - data to check
+ * @param   len - data length
+ *
+ * @return  CRC value
+ */
+static uint16 bleShutter_CRC16( uint8 *pData, uint8 len )
+{
+    uint16 crc = 0xFFFF;
+    uint8 i;
+
+    while ( len-- )
+    {
+        crc ^= (uint16)(*pData++) << 8;
+        for ( i = 0; i < 8; i++ )
+        {
+            crc = ( crc & 0x8000 ) ? ( (crc << 1) ^ 0x1021 ) : ( crc << 1 );
+        }
+    }
+
+    return ( crc );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_AttrInfo
+ *
+ * @brief   Find what an attribute is from its place in the table.
+ *
+ * @param   pAttr - pointer to attribute
+ *
+ * @return  its info, NULL if it is not one of the service's
+ */
+static CONST bleShutterAttrInfo_t *bleShutter_AttrInfo( gattAttribute_t *pAttr )
+{
+    if ( pAttr < bleShutterAttrTbl ||
+         pAttr >= bleShutterAttrTbl + GATT_NUM_ATTRS( bleShutterAttrTbl ) )
+    {
+        return ( NULL );
+    }
+
+    return ( &bleShutterAttrInfo[pAttr - bleShutterAttrTbl] );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckWrite
+ *
+ * @brief   Check a write against the value it is for: its length,
+ *          its offset and the range of each field, so a write is either
+ *          taken whole or refused with nothing changed.
+ *
+ * @param   pInfo - info of the value attribute
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ * @param   offset - offset of the first octet to be written
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckWrite( CONST bleShutterAttrInfo_t *pInfo,
+        uint8 *pValue, uint8 len, uint16 offset )
+{
+    if ( pInfo->maxLen == 0 )
+    {
+        return ( ATT_ERR_WRITE_NOT_PERMITTED );
+    }
+
+    if ( len < pInfo->minLen || len > pInfo->maxLen )
+    {
+        return ( ATT_ERR_INVALID_VALUE_SIZE );
+    }
+
+    // Only Upload takes long writes, it checks their offsets itself
+    if ( offset > 0 )
+    {
+        return ( (pInfo->param == BLESHUTTER_UPLOAD) ? SUCCESS : ATT_ERR_ATTR_NOT_LONG );
+    }
+
+    if ( pInfo->pfnCheck != NULL )
+    {
+        return ( pInfo->pfnCheck( pValue, len ) );
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_FindAttr
+ *
+ * @brief   Find an attribute of a characteristic.
+ *
+ * @param   param - Profile parameter ID
+ * @param   kind - BLESHUTTER_ATTR_VALUE or BLESHUTTER_ATTR_CONFIG
+ *
+ * @return  its place in the table, the table's length if it has none
+ */
+static uint8 bleShutter_FindAttr( uint8 param, uint8 kind )
+{
+    uint8 i;
+
+    // The info table is indexed like the attribute table, which sets its length
+    for ( i = 0; i < GATT_NUM_ATTRS( bleShutterAttrTbl ); i++ )
+    {
+        if ( bleShutterAttrInfo[i].kind == kind && bleShutterAttrInfo[i].param == param )
+        {
+            break;
+        }
+    }
+
+    return ( i );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckMask
+ *
+ * @brief   Check a Focus write: a mask of the channels there are.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckMask( uint8 *pValue, uint8 len )
+{
+    VOID len;  // Intentionally unreferenced parameter
+
+    if ( pValue[0] & ~BLESHUTTER_CHANNELS )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckShooting
+ *
+ * @brief   Check a Shooting write: the options, the channel mask and
+ *          the start ms, of those it has.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckShooting( uint8 *pValue, uint8 len )
+{
+    if ( len > 14 && (pValue[14] & ~BLESHUTTER_SHOOTING_OPTS) )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    // Channel mask
+    if ( len > 15 && (pValue[15] & ~BLESHUTTER_CHANNELS) )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    // Start ms
+    if ( len > 20 && BUILD_UINT16( pValue[19], pValue[20] ) >= 1000 )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckStop
+ *
+ * @brief   Check a Stop write: the channel mask and the op, if it has one.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckStop( uint8 *pValue, uint8 len )
+{
+    if ( bleShutter_CheckMask( pValue, len ) != SUCCESS )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    if ( len > 1 && pValue[1] > BLESHUTTER_STOP_OP_RESUME_SHIFTED )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckRate
+ *
+ * @brief   Check a Rate write.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckRate( uint8 *pValue, uint8 len )
+{
+    VOID len;  // Intentionally unreferenced parameter
+
+    return ( (pValue[0] > BLESHUTTER_RATE_MAX) ? ATT_ERR_INVALID_VALUE : SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckSync
+ *
+ * @brief   Check a Sync write: the command and the length it takes.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckSync( uint8 *pValue, uint8 len )
+{
+    if ( len != ((pValue[0] == BLESHUTTER_SYNC_FOLLOW_UP) ? BLESHUTTER_SYNC_LEN : 2) )
+    {
+        return ( ATT_ERR_INVALID_VALUE_SIZE );
+    }
+
+    if ( pValue[0] < BLESHUTTER_SYNC_SYNC || pValue[0] > BLESHUTTER_SYNC_FOLLOW_UP )
+    {
+        return ( ATT_ERR_INVALID_VALUE );
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckTime
+ *
+ * @brief   Check a Time write: the ms of the second.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckTime( uint8 *pValue, uint8 len )
+{
+    VOID len;  // Intentionally unreferenced parameter
+
+    return ( (BUILD_UINT16( pValue[4], pValue[5] ) >= 1000) ? ATT_ERR_INVALID_VALUE : SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      bleShutter_CheckPower
+ *
+ * @brief   Check a Power write.
+ *
+ * @param   pValue - pointer to data to be written
+ * @param   len - length of data
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutter_CheckPower( uint8 *pValue, uint8 len )
+{
+    VOID len;  // Intentionally unreferenced parameter
+
+    return ( (pValue[0] > BLESHUTTER_POWER_SAVE) ? ATT_ERR_INVALID_VALUE : SUCCESS );
+}
+
 /*********************************************************************
  * @fn          bleShutter_HandleConnStatusCB
  *
@@ -586,7 +1156,7 @@ static void bleShutter_HandleConnStatusCB( uint16 connHandle, uint8 changeType )
                 ( ( changeType == LINKDB_STATUS_UPDATE_STATEFLAGS ) && 
                   ( !linkDB_Up( connHandle ) ) ) )
         { 
-            GATTServApp_InitCharCfg( connHandle, bleShutterProgressConfig );
+            BLESHUTTER_CHARS( BLESHUTTER_CHAR_NO_CFG, BLESHUTTER_CHAR_CFG_INIT )
         }
     }
 }
@@ -25,6 +25,17 @@ extern "C"
 #define BLESHUTTER_SHOOTING                 2
 #define BLESHUTTER_STOP                     3
 #define BLESHUTTER_PROGRESS                 4
+#define BLESHUTTER_PROGRAM                  5
+#define BLESHUTTER_UPLOAD                   6
+#define BLESHUTTER_STATUS                   7
+#define BLESHUTTER_RATE                     8
+#define BLESHUTTER_TIMING                   9
+#define BLESHUTTER_SYNC                     11
+#define BLESHUTTER_TIME                     12
+#define BLESHUTTER_POWER                    13
+#define BLESHUTTER_STATS                    14
+#define BLESHUTTER_TRACE                    15
+#define BLESHUTTER_COMMAND                  16
 
 // DSLR Camera BLE Shutter Service UUID
 #define BLESHUTTER_SERV_UUID                0xFFF0
@@ -34,17 +45,231 @@ extern "C"
 #define BLESHUTTER_SHOOTING_UUID            BLESHUTTER_SERV_UUID + BLESHUTTER_SHOOTING
 #define BLESHUTTER_STOP_UUID                BLESHUTTER_SERV_UUID + BLESHUTTER_STOP
 #define BLESHUTTER_PROGRESS_UUID            BLESHUTTER_SERV_UUID + BLESHUTTER_PROGRESS
+#define BLESHUTTER_PROGRAM_UUID             BLESHUTTER_SERV_UUID + BLESHUTTER_PROGRAM
+#define BLESHUTTER_UPLOAD_UUID              BLESHUTTER_SERV_UUID + BLESHUTTER_UPLOAD
+#define BLESHUTTER_STATUS_UUID              BLESHUTTER_SERV_UUID + BLESHUTTER_STATUS
+#define BLESHUTTER_RATE_UUID                BLESHUTTER_SERV_UUID + BLESHUTTER_RATE
+#define BLESHUTTER_TIMING_UUID              BLESHUTTER_SERV_UUID + BLESHUTTER_TIMING
+#define BLESHUTTER_SYNC_UUID                BLESHUTTER_SERV_UUID + BLESHUTTER_SYNC
+#define BLESHUTTER_TIME_UUID                BLESHUTTER_SERV_UUID + BLESHUTTER_TIME
+#define BLESHUTTER_POWER_UUID               BLESHUTTER_SERV_UUID + BLESHUTTER_POWER
+#define BLESHUTTER_STATS_UUID               BLESHUTTER_SERV_UUID + BLESHUTTER_STATS
+#define BLESHUTTER_TRACE_UUID               BLESHUTTER_SERV_UUID + BLESHUTTER_TRACE
+
+// Command sits just below the service
+#define BLESHUTTER_COMMAND_UUID             0xFFEF
   
 // Simple Keys Profile Services bit fields
 #define BLESHUTTER_SERVICE                  0x00000001
 
-#define BLESHUTTER_SHOOTING_LEN             14
+// Shooting value is count(2) + delay(4) + exposure(4) + interval(4), optionally
+// followed by options(1), channel mask(1), stagger(2, ms between the start of
+// consecutive channels in the mask), bracket step(1, signed, 1/3 stops between
+// frames) and start ms(2, see BLESHUTTER_SHOOTING_OPT_WALL). Missing trailing
+// fields read as 0; channel mask 0 is channel 0.
+// A non-zero bracket step shoots count frames centred on the exposure, back to
+// back: the interval is the gap after each frame and is raised to at least 250 ms.
+// A value without BLESHUTTER_SHOOTING_OPT_QUEUED replaces the runs on its channels
+// and whatever was queued for them.
+#define BLESHUTTER_SHOOTING_LEN             21
+#define BLESHUTTER_SHOOTING_BASE_LEN        14
+
+// Focus and Stop values are channel masks, bit n for channel n. Focus 0 is
+// channel 0, Stop 0 is every channel. Programs always run on channel 0.
+// Stop may be followed by an op(1), left out it is STOP. PAUSE holds a shooting
+// run where it is, frame count and time to the next frame kept; a frame being
+// exposed is finished first, bulb frames and programs are only stopped. RESUME
+// goes on at the first time still to come on the original start + n * period
+// grid, the times that went by while paused are passed over; RESUME_SHIFTED
+// goes on with the time that was left, the grid moved on by the length of the
+// pause. Either way every frame of the count is still taken.
+#define BLESHUTTER_STOP_LEN                 2
+
+// Channels a mask can name, the application's DCBS_NUM_CHANNELS; a mask with
+// any other bit is refused. The keyfob has three.
+#if defined( CC2540_MINIDK )
+#define BLESHUTTER_NUM_CHANNELS             3
+#else
+#define BLESHUTTER_NUM_CHANNELS             4
+#endif // CC2540_MINIDK
+
+#define BLESHUTTER_CHANNELS                 ( BV(BLESHUTTER_NUM_CHANNELS) - 1 )
+
+#define BLESHUTTER_STOP_OP_STOP             0x00
+#define BLESHUTTER_STOP_OP_PAUSE            0x01
+#define BLESHUTTER_STOP_OP_RESUME           0x02
+#define BLESHUTTER_STOP_OP_RESUME_SHIFTED   0x03
+
 #define BLESHUTTER_PROGRESS_LEN             2
 
+// Program value is a shot sequence program of 1 to BLESHUTTER_PROGRAM_LEN bytes.
+// BLEShutter_GetParameter returns it prefixed with its length byte.
+#define BLESHUTTER_PROGRAM_LEN              20
+
+// Upload stages a blob of up to BLESHUTTER_UPLOAD_MAX_LEN bytes through a
+// series of records, each written at attribute offset 0:
+//   BEGIN  type(1) len(2) crc(2)  start a new blob, CRC-16/CCITT over len bytes
+//   DATA   offset(2) data(n)      store data at offset; may be a long write
+//                                 (Prepare/Execute), or Write Without Response
+//   COMMIT                        check the CRC and hand the blob to the app
+//   ABORT                         drop the staged blob
+// Reading the value returns state(1) type(1) len(2) received(2).
+#define BLESHUTTER_UPLOAD_MAX_LEN           240
+#define BLESHUTTER_UPLOAD_STATUS_LEN        6
+
+#define BLESHUTTER_UPLOAD_BEGIN             0x01
+#define BLESHUTTER_UPLOAD_DATA              0x02
+#define BLESHUTTER_UPLOAD_COMMIT            0x03
+#define BLESHUTTER_UPLOAD_ABORT             0x04
+
+#define BLESHUTTER_UPLOAD_BEGIN_LEN         6
+#define BLESHUTTER_UPLOAD_DATA_HDR_LEN      3
+
+// Upload blob types
+#define BLESHUTTER_UPLOAD_TYPE_PROGRAM      0x01
+#define BLESHUTTER_UPLOAD_TYPE_RAMP         0x02    // exposure ramp curve, see DSLRCameraBLEShutter_Ramp.h
+
+// Upload states
+#define BLESHUTTER_UPLOAD_IDLE              0x00
+#define BLESHUTTER_UPLOAD_RECEIVING         0x01
+#define BLESHUTTER_UPLOAD_COMMITTED         0x02
+#define BLESHUTTER_UPLOAD_FAILED            0x03    // CRC mismatch or rejected by the app
+
+// Status value is state(1) count(2) target(2) last shot(4) drift(4), little endian.
+// Last shot is the device clock (ms) of the last frame, drift how late (ms, signed)
+// it was against start + n * (exposure + interval).
+#define BLESHUTTER_STATUS_LEN               13
+
+// Status states
+#define BLESHUTTER_STATUS_IDLE              0x00
+#define BLESHUTTER_STATUS_DELAY             0x01    // waiting for the first frame
+#define BLESHUTTER_STATUS_SHOOTING          0x02
+#define BLESHUTTER_STATUS_PROGRAM           0x03
+#define BLESHUTTER_STATUS_DONE              0x04
+#define BLESHUTTER_STATUS_STOPPED           0x05
+#define BLESHUTTER_STATUS_PAUSED            0x06
+#define BLESHUTTER_STATUS_REJECTED          0x07    // a Shooting value was dropped: it can't be scheduled
+                                                    // or the queue is full; runs already going carry on
+
+// Rate value is the most Status/Progress notifications per second, state changes
+// are always sent; 0 sends on state changes only. Above BLESHUTTER_RATE_MAX is
+// refused, more than one per 10 ms connection event.
+#define BLESHUTTER_RATE_LEN                 1
+#define BLESHUTTER_RATE_MAX                 100
+
+// Timing value is a histogram of how late each frame of the current run fired
+// against its own due time: count(2) per bin for < 0, 0, 1, 2-3, 4-7, 8-15, 16-31
+// and >= 32 ms, then the worst lateness (2, ms) and the drift of the last frame
+// from the start + n * period grid (4, ms signed). Fits one read at the default MTU.
+#define BLESHUTTER_TIMING_BINS              8
+#define BLESHUTTER_TIMING_LEN               22
+
+// Sync value is a command(1) followed by its argument, building a timebase shared
+// with the master (the phone) so several adaptors can shoot on the same clock:
+//   SYNC       seq(1)                   write with response; the adaptor stamps
+//                                       its arrival
+//   FOLLOW_UP  seq(1) time(4) rtt(2)    master clock (ms) halfway between sending
+//                                       that SYNC and getting its response, and
+//                                       that round trip (ms)
+// A SYNC every few seconds keeps offset and skew disciplined, see
+// DSLRCameraBLEShutter_Sync.h. BLEShutter_GetParameter returns the last command
+// prefixed with its length byte. Reading the value returns synced(1), skew(2,
+// signed, 2^-20 units, master ms per adaptor ms minus one) and the phase error
+// (2, ms signed) of the last sample.
+#define BLESHUTTER_SYNC_LEN                 8
+#define BLESHUTTER_SYNC_STATE_LEN           5
+
+#define BLESHUTTER_SYNC_SYNC                0x01
+#define BLESHUTTER_SYNC_FOLLOW_UP           0x02
+
+// Time value is the wall clock, utc(4, seconds since 2000-01-01 00:00 UTC) and
+// ms(2) within that second, little endian. It keeps running through sleep, with
+// the Sync skew applied once there is a timebase, and is lost on reset. Reading
+// the value returns set(1) and the utc(4) ms(2) of the last wall clock start
+// accepted, zeros when there is none.
+#define BLESHUTTER_TIME_LEN                 6
+#define BLESHUTTER_TIME_STATE_LEN           7
+
+// Power value is the power mode, kept across resets. In power save mode a long run
+// (every running channel at least 10 s apart, or a program) left alone asks for a
+// 2 s connection interval with slave latency 4, and advertises every 5 s when the
+// phone is gone, so the adaptor sleeps between frames.
+#define BLESHUTTER_POWER_LEN                1
+
+#define BLESHUTTER_POWER_NORMAL             0x00
+#define BLESHUTTER_POWER_SAVE               0x01
+
+// Stats value is read only and counts from reset, each field 4 bytes little endian:
+// uptime (ms), active (sleep timer ticks, 1/32768 s, spent in the application task),
+// application events, connection events (from the interval and time connected, so
+// events skipped under slave latency are included), advertising events,
+// notifications sent to subscribed clients, shutter/focus line presses, pool blocks in use, the most pool
+// blocks ever in use, pool blocks in all and the bytes of static RAM set aside for
+// the pool, programs, the ramp, uploads and the trace together. Sleep and stack time
+// is uptime less active; the event counts give the radio share. Longer than a
+// default ATT_MTU, the value is taken from one snapshot at offset 0 and read with
+// Read Blob after that.
+#define BLESHUTTER_STATS_LEN                44
+
+// Trace value is read only, a dump of the event trace ring, see
+// DSLRCameraBLEShutter_Trace.h for the layout. Reading it from offset 0 holds the
+// trace until the Read Blobs reach the end.
+
+// Command value is seq(1) op(1) and the op's parameters, written without response
+// so a client can put several in one connection event:
+//   FOCUS      mask(1)                 as the Focus value
+//   SHOOT      14 to 18 bytes          the Shooting value up to stagger, the rest 0;
+//                                      also becomes the Shooting value
+//   STOP       mask(1) [op(1)]         as the Stop value
+// Parameters are held to the rules of the value they stand for.
+// Each command is acked with a notification of seq(1) op(1) result(1). A command
+// with the seq of the one before is not run again, its ack is repeated with
+// BLESHUTTER_COMMAND_REPEAT set, so a client unsure of a command can send it again.
+// The seq is forgotten on disconnect.
+#define BLESHUTTER_COMMAND_LEN              20
+#define BLESHUTTER_COMMAND_HDR_LEN          2
+#define BLESHUTTER_COMMAND_ACK_LEN          3
+
+#define BLESHUTTER_COMMAND_FOCUS            0x01
+#define BLESHUTTER_COMMAND_SHOOT            0x02
+#define BLESHUTTER_COMMAND_STOP             0x03
+
+// Command results
+#define BLESHUTTER_COMMAND_OK               0x00
+#define BLESHUTTER_COMMAND_BAD_OP           0x01
+#define BLESHUTTER_COMMAND_BAD_LEN          0x02
+#define BLESHUTTER_COMMAND_BAD_VALUE        0x03    // parameters out of range
+#define BLESHUTTER_COMMAND_QUEUE_FULL       0x04    // SHOOT queued with the queue full, dropped
+#define BLESHUTTER_COMMAND_REJECTED         0x05    // SHOOT that can't be scheduled, dropped; see the
+                                                    // SYNCED and WALL options
+#define BLESHUTTER_COMMAND_REPEAT           0x80    // flag, the command was not run again
+
+// Shooting options bit fields
+#define BLESHUTTER_SHOOTING_OPT_ANCHORED    0x01    // frames anchored to start + n * (exposure + interval)
+#define BLESHUTTER_SHOOTING_OPT_EXPOSURE_US 0x02    // exposure is given in microseconds
+#define BLESHUTTER_SHOOTING_OPT_RAMP        0x04    // exposure follows the uploaded ramp curve frame by frame
+#define BLESHUTTER_SHOOTING_OPT_SYNCED      0x08    // delay is the master clock (ms) of the first frame and
+                                                    // frames follow the master grid; rejected until synced
+#define BLESHUTTER_SHOOTING_OPT_WALL        0x10    // delay is the wall clock utc (s) of the first frame, plus
+                                                    // start ms (< 1000); rejected until Time is set and
+                                                    // once that time has passed
+#define BLESHUTTER_SHOOTING_OPT_QUEUED      0x20    // wait for the runs on its channels to finish, then
+                                                    // start with delay counted from the last frame's end;
+                                                    // a few can wait, they are lost on reset
+#define BLESHUTTER_SHOOTING_OPTS            0x3F    // every option, a value with others is refused
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// Committed upload as returned by BLEShutter_GetParameter( BLESHUTTER_UPLOAD ).
+// pData stays valid until the next BEGIN record.
+typedef struct
+{
+  uint8   type;
+  uint8   len;
+  uint8   *pData;
+} bleShutterUpload_t;
   
 /*********************************************************************
  * MACROS
@@ -57,9 +282,15 @@ extern "C"
 // Callback when a characteristic value has changed
 typedef void (*bleShutterChange_t)( uint8 paramID );
 
+// Callback to read part of a value the application keeps itself, returns
+// SUCCESS or an ATT error
+typedef bStatus_t (*bleShutterRead_t)( uint8 paramID, uint16 offset,
+        uint8 *pValue, uint8 *pLen, uint8 maxLen );
+
 typedef struct
 {
   bleShutterChange_t        pfnBLEShutterChange;  // Called when characteristic value changes
+  bleShutterRead_t          pfnBLEShutterRead;    // Called when Stats or Trace is read
 } bleShutterCBs_t;
 
 /*********************************************************************
@@ -107,6 +338,28 @@ extern bStatus_t BLEShutter_SetParameter( uint8 param, uint8 len, void *value );
  */
 extern bStatus_t BLEShutter_GetParameter( uint8 param, void *value );
 
+/*
+ * BLEShutter_CheckParameter - Check a value as a write of it would be
+ *          checked, without storing it.
+ *
+ *    param - Profile parameter ID
+ *    len - length of the value
+ *    value - pointer to the value
+ *
+ *    returns SUCCESS or the ATT error the write would get
+ */
+extern bStatus_t BLEShutter_CheckParameter( uint8 param, uint8 len, void *value );
+
+/*
+ * BLEShutter_Notifying - Count the clients a new value of a characteristic
+ *          is notified to.
+ *
+ *    param - Profile parameter ID
+ *
+ *    returns the number of clients with its notifications turned on
+ */
+extern uint8 BLEShutter_Notifying( uint8 param );
+
 
 /*********************************************************************
 *********************************************************************/
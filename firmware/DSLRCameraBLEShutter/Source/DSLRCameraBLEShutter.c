@@ -12,6 +12,7 @@ for use with the CC2540 Bluetooth Low Energy Protocol Stack.
 #include "bcomdef.h"
 #include "OSAL.h"
 #include "OSAL_PwrMgr.h"
+#include "osal_snv.h"
 
 #include "OnBoard.h"
 #include "hal_adc.h"
@@ -37,6 +38,14 @@ for use with the CC2540 Bluetooth Low Energy Protocol Stack.
 #include "gapbondmgr.h"
 
 #include "DSLRCameraBLEShutter.h"
+#include "DSLRCameraBLEShutter_Pulse.h"
+#include "DSLRCameraBLEShutter_Program.h"
+#include "DSLRCameraBLEShutter_Ramp.h"
+#include "DSLRCameraBLEShutter_Sync.h"
+#include "DSLRCameraBLEShutter_Stats.h"
+#include "DSLRCameraBLEShutter_Trace.h"
+#include "DSLRCameraBLEShutter_Log.h"
+#include "DSLRCameraBLEShutter_Pool.h"
 
 #if defined FEATURE_OAD
 #include "oad.h"
@@ -81,6 +90,92 @@ for use with the CC2540 Bluetooth Low Energy Protocol Stack.
 // Connection Pause Peripheral time value (in seconds)
 #define DEFAULT_CONN_PAUSE_PERIPHERAL         6
 
+// Connection interval range while the user is framing or triggering (units of 1.25ms, 6=7.5ms, 12=15ms)
+#define DCBS_ACTIVE_MIN_CONN_INTERVAL         6
+#define DCBS_ACTIVE_MAX_CONN_INTERVAL         12
+#define DCBS_ACTIVE_SLAVE_LATENCY             0
+
+// Connection interval range during long autonomous runs (units of 1.25ms, 640=800ms, 800=1s),
+// slave latency keeps (1 + 3) * 1s well inside the 10s supervision timeout
+#define DCBS_LONGRUN_MIN_CONN_INTERVAL        640
+#define DCBS_LONGRUN_MAX_CONN_INTERVAL        800
+#define DCBS_LONGRUN_SLAVE_LATENCY            3
+
+// Power save (BLESHUTTER_POWER_SAVE) long runs: a 2s interval skipping up to 4 events
+// (units of 1.25ms, 1600=2s), timeout (units of 10ms, 3200=32s) above the 20s the
+// spec asks for at that latency, and 5s advertising (units of 625us) when not connected.
+// A relaxed link costs less than advertising for the phone to come back, see
+// Host/Bench/README.md for the charge of each setting.
+// Between events OSAL sleeps in PM2 and wakes ahead of each timer for the
+// crystal to settle, so frames keep their timing however long the sleep.
+#define DCBS_SAVE_MIN_CONN_INTERVAL           1600
+#define DCBS_SAVE_MAX_CONN_INTERVAL           1600
+#define DCBS_SAVE_SLAVE_LATENCY               4
+#define DCBS_SAVE_CONN_TIMEOUT                3200
+#define DCBS_SAVE_ADVERTISING_INTERVAL        8000
+
+// How long the link stays fast after the last command (ms)
+#define DCBS_ACTIVE_LINK_TIMEOUT              30000
+
+// Shooting intervals at least this long let the link relax while running (ms)
+#define DCBS_LONGRUN_MIN_INTERVAL             10000
+
+// Link modes
+#define DCBS_LINK_IDLE                        0
+#define DCBS_LINK_ACTIVE                      1
+#define DCBS_LINK_LONGRUN                     2
+#define DCBS_LINK_SAVE                        3
+
+// SNV items holding the sequence checkpoint and the program it runs
+#define DCBS_NVID_CHECKPOINT                  BLE_NVID_CUST_START
+#define DCBS_NVID_PROGRAM                     ( BLE_NVID_CUST_START + 1 )
+#define DCBS_NVID_RAMP                        ( BLE_NVID_CUST_START + 2 )
+#define DCBS_NVID_FRAMES                      ( BLE_NVID_CUST_START + 3 )
+#define DCBS_NVID_POWER                       ( BLE_NVID_CUST_START + 5 )
+
+// Bump whenever dcbsCheckpoint_t changes so stale records are ignored
+#define DCBS_CHECKPOINT_VERSION               6
+
+// Shortest time between two checkpoints of the same run (ms). In between,
+// every frame writes only the frame counts (DCBS_NVID_FRAMES), so a reset
+// takes no frame twice. At one ~60 byte record per frame every 10 s, each
+// 2KB SNV page fills in about 6 minutes and, with the 20000 erase cycles
+// of the CC254x flash, lasts over five months of continuous runs.
+#define DCBS_CHECKPOINT_PERIOD                60000
+
+// Status/Progress notifications per second unless the client writes Rate
+#define DCBS_DEFAULT_STATUS_RATE              4
+
+// What a checkpoint resumes, bit fields
+#define DCBS_RUN_NONE                         0x00
+#define DCBS_RUN_SHOOTING                     0x01
+#define DCBS_RUN_PROGRAM                      0x02
+
+// Channel states
+#define DCBS_CHANNEL_IDLE                     0
+#define DCBS_CHANNEL_WAIT                     1     // shutter released, next press at due
+#define DCBS_CHANNEL_EXPOSE                   2     // shutter pressed, release at due
+#define DCBS_CHANNEL_PULSE                    3     // shutter pressed, Timer 1 releases it
+#define DCBS_CHANNEL_BULB                     4     // shutter held until Stop
+#define DCBS_CHANNEL_PAUSED                   5     // shutter released, held by a pause since pausedAt
+
+#define DCBS_ALL_CHANNELS                     ( BV(DCBS_NUM_CHANNELS) - 1 )
+
+// The service refuses masks naming a channel past its own count
+#if DCBS_NUM_CHANNELS != BLESHUTTER_NUM_CHANNELS
+#error "BLESHUTTER_NUM_CHANNELS must match DCBS_NUM_CHANNELS"
+#endif
+
+// Exposure value that holds the shutter open until Stop
+#define DCBS_BULB_EXPOSURE                    0xFFFFFFFF
+
+// Shortest gap (ms) between bracket frames, enough for the camera to close the
+// shutter and take the next press; a smaller interval is raised to it
+#define DCBS_BRACKET_MIN_GAP                  250
+
+// Queued Shooting values waiting for their channels, each held in a pool block
+#define DCBS_QUEUE_LEN                        DCBS_POOL_BLOCKS
+
 // Company Identifier: Texas Instruments Inc. (13)
 #define TI_COMPANY_ID                         0x000D
 
@@ -89,21 +184,74 @@ for use with the CC2540 Bluetooth Low Energy Protocol Stack.
 // Length of bd addr as a string
 #define B_ADDR_STR_LEN                        15
 
-#define SHUTTER_SBIT                          P0_1
-#define SHUTTER_BV                            BV(1)
-#define SHUTTER_DIR                           P0DIR
-#define SHUTTER_ACTIVE                        0
-#define SHUTTER_RELEASE                       1
-#define FOCUS_SBIT                            P0_7
-#define FOCUS_DIR                             P0DIR
-#define FOCUS_BV                              BV(7)
-#define FOCUS_ACTIVE                          0
-#define FOCUS_RELEASE                         1
+// Prepare Write queue depth, enough for a ~140 byte long write at the default MTU
+#define DCBS_NUM_PREPARE_WRITES               8
+
 
 /*********************************************************************
  * TYPEDEFS
  */
 
+// Sequence state of one shutter/focus channel
+typedef struct
+{
+    uint8   state;              // DCBS_CHANNEL_*
+    uint8   options;            // BLESHUTTER_SHOOTING_OPT_*
+    uint16  progressCount;
+    uint16  targetCount;
+    int8    bracketStep;        // 1/3 stops between frames, 0 when not bracketing
+    uint32  baseExposure;       // as written, ms or us (BLESHUTTER_SHOOTING_OPT_EXPOSURE_US)
+    uint32  exposure;           // ms of the current frame, DCBS_BULB_EXPOSURE holds until Stop
+    uint32  interval;           // ms
+    uint32  pulseWidthUs;       // exposure for the Timer 1 pulse engine, 0 when the dispatcher times it
+    uint32  frameDeadline;      // clock time (ms) of the current frame on the start + n * period grid
+    uint32  syncDeadline;       // the same on the master clock (BLESHUTTER_SHOOTING_OPT_SYNCED)
+    uint32  due;                // clock time (ms) of the next press (WAIT) or release (EXPOSE)
+    uint32  pausedAt;           // clock time (ms) of the pause (PAUSED)
+    dcbsRampState_t ramp;       // position on the ramp curve (BLESHUTTER_SHOOTING_OPT_RAMP)
+} dcbsChannel_t;
+
+// Channel as kept in a checkpoint
+typedef struct
+{
+    uint8   running;
+    uint8   paused;
+    uint8   options;
+    uint16  progressCount;
+    uint16  targetCount;
+    int8    bracketStep;
+    uint32  baseExposure;
+    uint32  interval;
+    uint32  untilNext;          // ms from the save to the next frame
+} dcbsChannelSave_t;
+
+// Sequence state kept in SNV so a run survives a brown-out or reset
+typedef struct
+{
+    uint8   version;            // DCBS_CHECKPOINT_VERSION
+    uint16  seq;                // told apart from the one before, see dcbsFrames_t
+    uint8   run;                // DCBS_RUN_* bits
+    uint8   statusChannel;
+    dcbsChannelSave_t channels[DCBS_NUM_CHANNELS];
+    uint8   programLen;         // length of the DCBS_NVID_PROGRAM item
+    uint8   rampLen;            // length of the DCBS_NVID_RAMP item
+    uint16  programProgress;
+    uint32  programUntilNext;   // ms from the save to the next program step
+    dcbsProgramState_t program;
+} dcbsCheckpoint_t;
+
+// Frame counts and the time to the next step written after every frame
+// between checkpoints, newer than the checkpoint with the same seq
+typedef struct
+{
+    uint16  seq;
+    uint16  progressCount[DCBS_NUM_CHANNELS];
+    uint32  untilNext[DCBS_NUM_CHANNELS];
+    uint16  programProgress;
+    uint32  programUntilNext;
+    dcbsProgramState_t program;
+} dcbsFrames_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -186,23 +334,151 @@ static uint8 advertData[] =
 // GAP GATT Attributes
 static uint8 attDeviceName[GAP_DEVICE_NAME_LEN] = "DSLR BLE Shutter";
 
-static uint16 progressCount     = 0;
-static uint16 targetCount       = 1;
-static uint32 delayBeforeStart  = 0;
-static uint32 shutterExposure   = 0;
-static uint32 repeatInterval    = 0;
+// Connection parameter set last requested from the central
+static uint8 linkMode = DCBS_LINK_IDLE;
+
+// BLESHUTTER_POWER_*, and whether advertising is slowed down for it
+static uint8 powerMode = BLESHUTTER_POWER_NORMAL;
+static uint8 advertSlow = FALSE;
+
+// Shutter and focus outputs of each channel, all active low on port 0.
+// Channel 0 keeps the original P0.1/P0.7 wiring. Only these lines are
+// made outputs, the keyfob leaves P0.0 to its button.
+#if defined( CC2540_MINIDK )
+static CONST uint8 channelShutterBV[DCBS_NUM_CHANNELS] = { BV(1), BV(2), BV(4) };
+static CONST uint8 channelFocusBV[DCBS_NUM_CHANNELS]   = { BV(7), BV(3), BV(5) };
+#else
+static CONST uint8 channelShutterBV[DCBS_NUM_CHANNELS] = { BV(1), BV(2), BV(4), BV(6) };
+static CONST uint8 channelFocusBV[DCBS_NUM_CHANNELS]   = { BV(7), BV(3), BV(5), BV(0) };
+#endif // CC2540_MINIDK
+
+// Independent sequences multiplexed on DCBS_SHOOTING_EVT
+static dcbsChannel_t channels[DCBS_NUM_CHANNELS];
+
+// Queued Shooting values, oldest first, each started on DCBS_QUEUE_EVT once
+// its channels come free
+static uint8  *shootingQueue[DCBS_QUEUE_LEN];
+static uint8  queueHead         = 0;
+static uint8  queueCount        = 0;
+static uint32 queueFrom         = 0;    // clock time (ms) channels last came free
+
+// Channel reported on Status, Progress and Timing
+static uint8  statusChannel     = 0;
+
+// Channels whose shutter the running Timer 1 pulse holds
+static uint8  pulseChannels     = 0;
+
+// Channels to pause once the frame they are exposing ends
+static uint8  pausePending      = 0;
+
+// Port 0 focus lines held until DCBS_FOCUS_RELEASE_EVT
+static uint8  focusHeld         = 0;
+
+// Clock time (ms) DCBS_PROGRAM_EVT is armed for
+static uint32 programDue        = 0;
+
+// Kept off the stack, it's larger than the 8051 likes there
+static dcbsCheckpoint_t checkpointBuf;
+static dcbsFrames_t framesBuf;
+
+// Last checkpoint written to SNV
+static uint8  checkpointRun     = DCBS_RUN_NONE;
+static uint32 checkpointTime    = 0;
+static uint16 checkpointSeq     = 0;
+
+// Set when a new run starts so its first checkpoint isn't throttled
+static uint8  checkpointDirty   = FALSE;
+
+// Length of the program last stored in SNV
+static uint8  programLen        = 0;
+
+// Length of the ramp curve kept in SNV, 0 when it couldn't be stored
+static uint8  rampLen           = 0;
+
+// Coalesced status reporting, see reportStatus()
+static uint8  statusState       = BLESHUTTER_STATUS_IDLE;
+static uint8  statusRate        = DCBS_DEFAULT_STATUS_RATE;
+static uint8  statusPending     = FALSE;
+static uint32 statusSentTime    = 0;
+static uint32 lastShotTime      = 0;
+static int32  lastShotDrift     = 0;
+
+// Frame lateness histogram of the current run, see BLESHUTTER_TIMING
+static uint16 timingBins[BLESHUTTER_TIMING_BINS];
+static uint16 timingMaxLate     = 0;
+
+// Last command run from the Command characteristic and its result, so a
+// repeat of it is only acked again
+static uint8  commandSeq        = 0;
+static uint8  commandResult     = BLESHUTTER_COMMAND_OK;
+static uint8  commandSeen       = FALSE;
 
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
+static uint16 DSLRCameraBLEShutter_HandleEvent( uint16 events );
 static void DSLRCameraBLEShutter_ProcessOSALMsg( osal_event_hdr_t *pMsg );
 static void peripheralStateNotificationCB( gaprole_States_t newState );
 static void bleShutterChangeCB( uint8 paramID );
-
-static void activeShutter();
-static void releaseShutter();
-static void activeFocus();
+static bStatus_t bleShutterReadCB( uint8 paramID, uint16 offset,
+        uint8 *pValue, uint8 *pLen, uint8 maxLen );
+
+static uint8 shootingCommand( uint8 *pShooting );
+static uint8 shootingCheck( uint8 *pShooting );
+static uint8 startShooting( uint8 *pShooting, uint32 now );
+static uint8 shootingMask( uint8 *pShooting );
+static uint8 busyChannels();
+static void queueNext();
+static void queueDrop( uint8 mask );
+static void stopShooting( uint8 mask );
+static void stopChannels( uint8 mask );
+static void stopCommand( uint8 *pStop );
+static void pauseShooting( uint8 mask );
+static void pauseChannel( uint8 ch, uint32 now );
+static void resumeShooting( uint8 mask, uint8 shifted );
+static void dispatchChannels();
+static void pressChannels( uint8 mask, uint32 now );
+static void pulseDone();
+static void finishFrame( uint8 ch, uint32 now );
+static void frameExposure( dcbsChannel_t *pChannel );
+static uint32 bracketExposure( uint32 base, int32 thirds );
+static void armChannels();
+static uint8 runningChannels();
+static uint8 channelLines( uint8 mask, CONST uint8 *pLines );
+static void activeFocus( uint8 mask );
 static void releaseFocus();
+static void startTimerAt( uint16 event, uint32 deadline );
+static void linkActivity();
+static void linkIdle();
+static void setLinkMode( uint8 mode );
+static void statsLink();
+static void linkRunDone();
+static void slowAdvertising( uint8 slow );
+static void restorePower();
+static void loadProgram( uint8 *pCode, uint8 len );
+static void runProgram();
+static void stopProgram();
+static void programLinesCB( uint8 lines, uint8 active );
+static void driveLines( uint8 lines, uint8 active );
+static void linesChanged( uint8 lines, uint8 active );
+static void programProgressCB( void );
+static void loadRamp( uint8 *pCurve, uint8 len );
+static void saveCheckpoint();
+static void saveFrames( dcbsCheckpoint_t *pCheckpoint );
+static void resetFrames( dcbsCheckpoint_t *pCheckpoint );
+static void restoreCheckpoint();
+static void reportStatus( uint8 state );
+static void sendStatus();
+static void resetTiming();
+static void recordTiming( int32 late );
+static void publishTiming();
+static void syncCommand( uint32 arrival );
+static void syncState();
+static void timeCommand( uint32 arrival );
+static void timeState( uint32 utc, uint16 ms );
+static void commandReceived();
+static uint8 commandCheck( uint8 param, uint8 *pParams, uint8 len );
+static void commandAck( uint8 seq, uint8 op, uint8 result );
 
 #if defined( CC2540_MINIDK )
 static void DSLRCameraBLEShutter_HandleKeys( uint8 shift, uint8 keys );
@@ -235,7 +511,15 @@ static gapBondCBs_t DSLRCameraBLEShutter_BondMgrCBs =
 // BLE Shutter GATT Profile Callbacks
 static bleShutterCBs_t DSLRCameraBLEShutter_BLEShutterCBs =
 {
-    bleShutterChangeCB    // Charactersitic value change callback
+    bleShutterChangeCB,   // Charactersitic value change callback
+    bleShutterReadCB      // Characteristic value refresh callback
+};
+
+// Shot Sequence Program Callbacks
+static dcbsProgramCBs_t DSLRCameraBLEShutter_ProgramCBs =
+{
+    programLinesCB,       // Shutter/focus line change callback
+    programProgressCB     // Frame completed callback
 };
 /*********************************************************************
  * PUBLIC FUNCTIONS
@@ -333,16 +617,25 @@ void DSLRCameraBLEShutter_Init( uint8 task_id )
     VOID OADTarget_AddService();                    // OAD Profile
 #endif
 
+    // Let a whole program go out as one long write
+    {
+        uint8 numPrepareWrites = DCBS_NUM_PREPARE_WRITES;
+
+        GATTServApp_SetParameter( GATT_PARAM_NUM_PREPARE_WRITES, sizeof ( uint8 ), &numPrepareWrites );
+    }
+
     // Setup the BLEShutter Characteristic Values
     {
         uint8 focus = 0;
-        uint8 stop = 0;
+        uint8 stop[BLESHUTTER_STOP_LEN] = { 0 };
         uint8 shooting[BLESHUTTER_SHOOTING_LEN] = { 1, 0 };
+        uint8 rate = DCBS_DEFAULT_STATUS_RATE;
 
         BLEShutter_SetParameter( BLESHUTTER_FOCUS, sizeof ( uint8 ), &focus);
-        BLEShutter_SetParameter( BLESHUTTER_STOP,  sizeof ( uint8 ), &stop);
-        BLEShutter_SetParameter( BLESHUTTER_PROGRESS, BLESHUTTER_PROGRESS_LEN, &progressCount);
+        BLEShutter_SetParameter( BLESHUTTER_STOP,  BLESHUTTER_STOP_LEN, stop);
+        BLEShutter_SetParameter( BLESHUTTER_PROGRESS, BLESHUTTER_PROGRESS_LEN, &channels[0].progressCount);
         BLEShutter_SetParameter( BLESHUTTER_SHOOTING, BLESHUTTER_SHOOTING_LEN, shooting);
+        BLEShutter_SetParameter( BLESHUTTER_RATE, BLESHUTTER_RATE_LEN, &rate);
     }
 
 
@@ -375,12 +668,23 @@ void DSLRCameraBLEShutter_Init( uint8 task_id )
 
 #endif // #if defined( CC2540_MINIDK )
 
-    // Initialize Shutter and Focus related GPIO
-    SHUTTER_DIR |= SHUTTER_BV;
-    FOCUS_DIR |= FOCUS_BV;
+    // Initialize Shutter and Focus related GPIO of every channel
+    {
+        uint8 lines = channelLines( DCBS_ALL_CHANNELS, channelShutterBV ) |
+                      channelLines( DCBS_ALL_CHANNELS, channelFocusBV );
+
+        P0DIR |= lines;
+        driveLines( lines, FALSE );
+    }
+
+    // Short exposures are timed by Timer 1, which ends them with a done event
+    DCBSPulse_Init( dslrCameraBLEShutter_TaskID, DCBS_PULSE_DONE_EVT );
 
-    SHUTTER_SBIT = SHUTTER_RELEASE;
-    FOCUS_SBIT = SHUTTER_RELEASE;
+    // Queued Shooting values are kept in pool blocks, off the heap
+    DCBSPool_Init();
+
+    // Display lines are written after the work they describe
+    DCBS_LOG_INIT( dslrCameraBLEShutter_TaskID, DCBS_LOG_EVT );
 
 #if (defined HAL_LCD) && (HAL_LCD == TRUE)
 
@@ -399,11 +703,19 @@ void DSLRCameraBLEShutter_Init( uint8 task_id )
     // Register callback with BLE Shutter Service
     VOID BLEShutter_RegisterAppCBs( &DSLRCameraBLEShutter_BLEShutterCBs );
 
+    // Register callback with the shot sequence interpreter
+    DCBSProgram_RegisterCBs( &DSLRCameraBLEShutter_ProgramCBs );
+
     // Enable clock divide on halt
     // This reduces active current while radio is active and CC254x MCU
     // is halted
     HCI_EXT_ClkDivOnHaltCmd( HCI_EXT_ENABLE_CLK_DIVIDE_ON_HALT );
 
+    // Have the link layer tell the task about every advertising event, for
+    // the stats. Connection events are far more frequent and are worked out
+    // from the interval instead, see statsLink.
+    HCI_EXT_AdvEventNoticeCmd( dslrCameraBLEShutter_TaskID, DCBS_ADV_EVENT_EVT );
+
 #if defined ( DC_DC_P0_7 )
 
     // Enable stack to toggle bypass control on TPS62730 (DC/DC converter)
@@ -411,6 +723,12 @@ void DSLRCameraBLEShutter_Init( uint8 task_id )
 
 #endif // defined ( DC_DC_P0_7 )
 
+    restorePower();
+
+    // Pick up a sequence cut short by a reset, then advertise to suit it
+    restoreCheckpoint();
+    linkIdle();
+
     // Setup a delayed profile startup
     osal_set_event( dslrCameraBLEShutter_TaskID, DCBS_START_DEVICE_EVT );
 
@@ -422,6 +740,8 @@ void DSLRCameraBLEShutter_Init( uint8 task_id )
  * @brief   DSLR Camera BLE Shutter Application Task event processor.  This function
  *          is called to process all events for the task.  Events
  *          include timers, messages and any other user defined events.
+ *          The time spent handling each one goes into the stats,
+ *          and each one handled into the trace.
  *
  * @param   task_id  - The OSAL assigned task ID.
  * @param   events - events to process.  This is a bit map and can
@@ -431,9 +751,47 @@ void DSLRCameraBLEShutter_Init( uint8 task_id )
  */
 uint16 DSLRCameraBLEShutter_ProcessEvent( uint8 task_id, uint16 events )
 {
+    uint32 begin = DCBSStats_Begin();
+    uint8 traced = (events & ~DCBS_ADV_EVENT_EVT) != 0;
 
     VOID task_id; // OSAL required parameter that isn't used in this function
 
+    // Advertising notices alone would soon push everything else out of the trace
+    if ( traced )
+    {
+        DCBSTrace_Record( DCBS_TRACE_EVENT, 0, events );
+    }
+
+    events = DSLRCameraBLEShutter_HandleEvent( events );
+
+    if ( traced )
+    {
+        DCBSTrace_Record( DCBS_TRACE_EVENT_DONE, 0, events );
+    }
+
+    // An interval granted since is counted from here on
+    if ( gapProfileState == GAPROLE_CONNECTED || gapProfileState == GAPROLE_CONNECTED_ADV )
+    {
+        statsLink();
+    }
+
+    DCBSStats_Count( DCBS_STATS_EVENTS, 1 );
+    DCBSStats_End( begin );
+
+    return ( events );
+}
+
+/*********************************************************************
+ * @fn      DSLRCameraBLEShutter_HandleEvent
+ *
+ * @brief   Handle one event for the task, highest priority first.
+ *
+ * @param   events - events to process
+ *
+ * @return  events not processed
+ */
+static uint16 DSLRCameraBLEShutter_HandleEvent( uint16 events )
+{
     if ( events & SYS_EVENT_MSG )
     {
         uint8 *pMsg;
@@ -468,21 +826,69 @@ uint16 DSLRCameraBLEShutter_ProcessEvent( uint8 task_id, uint16 events )
         return ( events ^ DCBS_FOCUS_RELEASE_EVT );
     }
 
-    if ( events & DCBS_SHOOTING_ACTIVE_EVT )
+    if ( events & DCBS_SHOOTING_EVT )
+    {
+        DCBS_LOG_RECORD( DCBS_LOG_SHOOTING_EVENT, 0, 0 );
+        dispatchChannels();
+
+        return ( events ^ DCBS_SHOOTING_EVT );
+    }
+
+    if ( events & DCBS_PULSE_DONE_EVT )
+    {
+        DCBS_LOG_RECORD( DCBS_LOG_PULSE_DONE_EVENT, 0, 0 );
+        pulseDone();
+
+        return ( events ^ DCBS_PULSE_DONE_EVT );
+    }
+
+    if ( events & DCBS_PROGRAM_EVT )
+    {
+        runProgram();
+
+        return ( events ^ DCBS_PROGRAM_EVT );
+    }
+
+    if ( events & DCBS_QUEUE_EVT )
+    {
+        queueNext();
+
+        return ( events ^ DCBS_QUEUE_EVT );
+    }
+
+    if ( events & DCBS_LINK_IDLE_EVT )
+    {
+        linkIdle();
+
+        return ( events ^ DCBS_LINK_IDLE_EVT );
+    }
+
+    if ( events & DCBS_STATUS_EVT )
+    {
+        sendStatus();
+
+        return ( events ^ DCBS_STATUS_EVT );
+    }
+
+    if ( events & DCBS_ADV_EVENT_EVT )
     {
-        HalLcdWriteString( "Shooting Active Event",  HAL_LCD_LINE_8 );
-        activeShutter();
+        DCBSStats_Count( DCBS_STATS_ADV_EVENTS, 1 );
 
-        return ( events ^ DCBS_SHOOTING_ACTIVE_EVT );
+        return ( events ^ DCBS_ADV_EVENT_EVT );
     }
 
-    if ( events & DCBS_SHOOTING_RELEASE_EVT )
+#if (DCBS_LOG == TRUE)
+    // Last of all, the display only shows what already happened
+    if ( events & DCBS_LOG_EVT )
     {
-        HalLcdWriteString( "Shooting Release Event",  HAL_LCD_LINE_8 );
-        releaseShutter();
+        if ( DCBSLog_Show() )
+        {
+            return ( events );
+        }
 
-        return ( events ^ DCBS_SHOOTING_RELEASE_EVT );
+        return ( events ^ DCBS_LOG_EVT );
     }
+#endif // (DCBS_LOG == TRUE)
 
     // Discard unknown events
     return 0;
@@ -637,6 +1043,13 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
 
         case GAPROLE_CONNECTED:
             {        
+                // Peripheral role starts every link on the default parameters
+                if ( gapProfileState != GAPROLE_CONNECTED_ADV )
+                {
+                    linkMode = DCBS_LINK_IDLE;
+                }
+                statsLink();
+
 #if (defined HAL_LCD) && (HAL_LCD == TRUE)
                 HalLcdWriteString( "Connected",  HAL_LCD_LINE_3 );
 #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
@@ -664,6 +1077,19 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
             break;      
         case GAPROLE_WAITING:
             {
+                linkMode = DCBS_LINK_IDLE;
+                osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_LINK_IDLE_EVT );
+                DCBSStats_Link( 0 );
+
+                // Advertising restarts after this, slowly if a long run goes on alone
+                linkIdle();
+
+                // A trace dump cut short by the disconnect
+                DCBSTrace_Resume();
+
+                // The next client numbers its commands afresh
+                commandSeen = FALSE;
+
 #if (defined HAL_LCD) && (HAL_LCD == TRUE)
                 HalLcdWriteString( "Disconnected",  HAL_LCD_LINE_3 );
 #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
@@ -672,6 +1098,13 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
 
         case GAPROLE_WAITING_AFTER_TIMEOUT:
             {
+                linkMode = DCBS_LINK_IDLE;
+                osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_LINK_IDLE_EVT );
+                DCBSStats_Link( 0 );
+                linkIdle();
+                DCBSTrace_Resume();
+                commandSeen = FALSE;
+
 #if (defined HAL_LCD) && (HAL_LCD == TRUE)
                 HalLcdWriteString( "Timed Out",  HAL_LCD_LINE_3 );
 #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
@@ -722,6 +1155,19 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
  */
 static void bleShutterChangeCB( uint8 paramID )
 {
+    uint32 begin = DCBSStats_Begin();
+
+    DCBSTrace_Record( DCBS_TRACE_WRITE, paramID, 0 );
+
+    // User is framing or triggering, keep trigger latency down. Settings,
+    // sync, uploads and polling leave the link as it is, or a phone that
+    // keeps time sync going would never let it relax.
+    if ( paramID == BLESHUTTER_FOCUS || paramID == BLESHUTTER_SHOOTING ||
+         paramID == BLESHUTTER_STOP || paramID == BLESHUTTER_COMMAND )
+    {
+        linkActivity();
+    }
+
     switch( paramID )
     {
         case BLESHUTTER_FOCUS:
@@ -729,11 +1175,9 @@ static void bleShutterChangeCB( uint8 paramID )
                 uint8 focus;
                 BLEShutter_GetParameter( BLESHUTTER_FOCUS, &focus );
 
-                activeFocus();
-
-#if (defined HAL_LCD) && (HAL_LCD == TRUE)
-                HalLcdWriteStringValue( "Focus:", (uint16)(focus), 10,  HAL_LCD_LINE_3 );
-#endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
+                // Older clients write 1, which is channel 0 as well
+                activeFocus( focus ? focus : BV(0) );
+                DCBS_LOG_RECORD( DCBS_LOG_FOCUS, focus, 0 );
             }
             break;
 
@@ -742,55 +1186,89 @@ static void bleShutterChangeCB( uint8 paramID )
                 uint8 shooting[BLESHUTTER_SHOOTING_LEN];
                 BLEShutter_GetParameter( BLESHUTTER_SHOOTING, shooting );
 
-                uint8 index = 0;
-                VOID osal_memcpy( &targetCount, shooting + index, sizeof(uint16) );
-                index += sizeof(uint16);
-                VOID osal_memcpy( &delayBeforeStart, shooting + index, sizeof(uint32) );
-                index += sizeof(uint32);
-                VOID osal_memcpy( &shutterExposure, shooting + index, sizeof(uint32) );
-                index += sizeof(uint32);
-                VOID osal_memcpy( &repeatInterval, shooting + index, sizeof(uint32) );
-                progressCount = 0;
-
-#if (defined HAL_LCD) && (HAL_LCD == TRUE)
-                HalLcdWriteString( "Shooting:", HAL_LCD_LINE_3 );
-                HalLcdWriteStringValue( "- count:", targetCount, 10,  HAL_LCD_LINE_4 );
-                HalLcdWriteStringValueValue( "- delay:", (uint16)(delayBeforeStart >> 16), 10,
-                        (uint16)(delayBeforeStart), 10, HAL_LCD_LINE_5 );
-                HalLcdWriteStringValueValue( "- exposure:", (uint16)(shutterExposure >> 16), 10,
-                        (uint16)(shutterExposure), 10, HAL_LCD_LINE_6 );
-                HalLcdWriteStringValueValue( "- interval:", (uint16)(repeatInterval >> 16), 10,
-                        (uint16)(repeatInterval), 10, HAL_LCD_LINE_7 );
-#endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
-
-                if (delayBeforeStart)
-                {
-                    osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_SHOOTING_ACTIVE_EVT, delayBeforeStart );
-                    HalLcdWriteString( "Start Delay Timer",  HAL_LCD_LINE_8 );
-                }
-                else
+                // A plain write has no ack, Status tells the client instead
+                if ( shootingCommand( shooting ) != BLESHUTTER_COMMAND_OK )
                 {
-                    activeShutter();
+                    reportStatus( BLESHUTTER_STATUS_REJECTED );
                 }
-
             }
             break;
 
         case BLESHUTTER_STOP:
             {
-                uint8 stop;
-                BLEShutter_GetParameter( BLESHUTTER_STOP, &stop );
+                uint8 stop[BLESHUTTER_STOP_LEN];
+                BLEShutter_GetParameter( BLESHUTTER_STOP, stop );
 
-                osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_FOCUS_RELEASE_EVT );
-                osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_SHOOTING_ACTIVE_EVT );
-                osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_SHOOTING_RELEASE_EVT );
-                SHUTTER_SBIT = SHUTTER_RELEASE;
-                FOCUS_SBIT = FOCUS_RELEASE;
+                stopCommand( stop );
+            }
+            break;
 
-#if (defined HAL_LCD) && (HAL_LCD == TRUE)
-                HalLcdWriteStringValue( "Stop:", (uint16)(stop), 10,  HAL_LCD_LINE_3 );
-#endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
+        case BLESHUTTER_PROGRAM:
+            {
+                uint8 program[BLESHUTTER_PROGRAM_LEN + 1];
+                BLEShutter_GetParameter( BLESHUTTER_PROGRAM, program );
+
+                loadProgram( program + 1, program[0] );
+            }
+            break;
+
+        case BLESHUTTER_RATE:
+            BLEShutter_GetParameter( BLESHUTTER_RATE, &statusRate );
+
+            // An update held back under the old rate, for ever when it
+            // was 0, is rescheduled under the new one
+            if ( statusPending )
+            {
+                osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_STATUS_EVT );
+                statusPending = FALSE;
+                reportStatus( statusState );
+            }
+            break;
+
+        case BLESHUTTER_SYNC:
+            syncCommand( osal_GetSystemClock() );
+            break;
+
+        case BLESHUTTER_TIME:
+            timeCommand( osal_GetSystemClock() );
+            break;
+
+        case BLESHUTTER_POWER:
+            {
+                uint8 power;
+                BLEShutter_GetParameter( BLESHUTTER_POWER, &power );
+
+                // Every SNV write wears the flash, the mode already kept isn't written again
+                if ( power != powerMode )
+                {
+                    powerMode = power;
+                    VOID osal_snv_write( DCBS_NVID_POWER, sizeof ( uint8 ), &powerMode );
+                }
+            }
+            break;
+
+        case BLESHUTTER_COMMAND:
+            commandReceived();
+            break;
+
+        case BLESHUTTER_UPLOAD:
+            {
+                bleShutterUpload_t upload;
+                BLEShutter_GetParameter( BLESHUTTER_UPLOAD, &upload );
 
+                if ( upload.type == BLESHUTTER_UPLOAD_TYPE_PROGRAM )
+                {
+                    loadProgram( upload.pData, upload.len );
+                }
+                else if ( upload.type == BLESHUTTER_UPLOAD_TYPE_RAMP )
+                {
+                    loadRamp( upload.pData, upload.len );
+                }
+                else
+                {
+                    uint8 state = BLESHUTTER_UPLOAD_FAILED;
+                    BLEShutter_SetParameter( BLESHUTTER_UPLOAD, sizeof ( uint8 ), &state );
+                }
             }
             break;
 
@@ -798,46 +1276,2249 @@ static void bleShutterChangeCB( uint8 paramID )
             // should not reach here!
             break;
     }
+
+    DCBSTrace_Record( DCBS_TRACE_WRITE_DONE, paramID, 0 );
+    DCBSStats_End( begin );
+}
+
+/*********************************************************************
+ * @fn      bleShutterReadCB
+ *
+ * @brief   Callback from DSLR Camera BLE Shutter to read part of a value
+ *          the application keeps.
+ *
+ * @param   paramID - parameter ID of the value being read
+ * @param   offset - offset of the first byte
+ * @param   pValue - filled with the value
+ * @param   pLen - set to the number of bytes filled in
+ * @param   maxLen - room in pValue
+ *
+ * @return  SUCCESS or an ATT error
+ */
+static bStatus_t bleShutterReadCB( uint8 paramID, uint16 offset,
+        uint8 *pValue, uint8 *pLen, uint8 maxLen )
+{
+    switch ( paramID )
+    {
+        case BLESHUTTER_STATS:
+            if ( offset == 0 &&
+                 (gapProfileState == GAPROLE_CONNECTED || gapProfileState == GAPROLE_CONNECTED_ADV) )
+            {
+                // The snapshot counts connection events up to now
+                statsLink();
+            }
+            return ( DCBSStats_Read( offset, pValue, pLen, maxLen ) );
+
+        case BLESHUTTER_TRACE:
+            return ( DCBSTrace_Read( offset, pValue, pLen, maxLen ) );
+
+        default:
+            *pLen = 0;
+            return ( ATT_ERR_ATTR_NOT_FOUND );
+    }
 }
 
-static void activeShutter()
+/*********************************************************************
+ * @fn      shootingCommand
+ *
+ * @brief   Start a Shooting value, or queue it when it asks to wait
+ *          for the runs on its channels. Queued values start in the
+ *          order they came, each once all of its channels are free.
+ *
+ * @param   pShooting - Shooting value, BLESHUTTER_SHOOTING_LEN bytes
+ *
+ * @return  BLESHUTTER_COMMAND_OK, BLESHUTTER_COMMAND_REJECTED when it
+ *          can't be scheduled or BLESHUTTER_COMMAND_QUEUE_FULL when the
+ *          queue or the pool is full; either way nothing is changed
+ */
+static uint8 shootingCommand( uint8 *pShooting )
 {
-    SHUTTER_SBIT = SHUTTER_ACTIVE;
+    uint8 mask = shootingMask( pShooting );
+
+    // Checked before the queue is touched, a refused value leaves it be
+    if ( shootingCheck( pShooting ) != SUCCESS )
+    {
+        return ( BLESHUTTER_COMMAND_REJECTED );
+    }
 
-    if (shutterExposure != 0xFFFFFFFF)
+    if ( !(pShooting[14] & BLESHUTTER_SHOOTING_OPT_QUEUED) )
     {
-        if (shutterExposure == 0)
+        queueDrop( mask );
+    }
+    else if ( queueCount != 0 || (busyChannels() & mask) )
+    {
+        uint8 *pBlock;
+
+        if ( queueCount == DCBS_QUEUE_LEN || (pBlock = DCBSPool_Alloc()) == NULL )
         {
-            shutterExposure = DCBS_DEFAULT_ACTIVE_PERIOD;
+            return ( BLESHUTTER_COMMAND_QUEUE_FULL );
         }
-        HalLcdWriteString( "Start Exposure Timer",  HAL_LCD_LINE_8 );
-        osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_SHOOTING_RELEASE_EVT, shutterExposure );
+
+        VOID osal_memcpy( pBlock, pShooting, BLESHUTTER_SHOOTING_LEN );
+        shootingQueue[(queueHead + queueCount) % DCBS_QUEUE_LEN] = pBlock;
+        queueCount++;
+        return ( BLESHUTTER_COMMAND_OK );
     }
+
+    return ( (startShooting( pShooting, osal_GetSystemClock() ) == SUCCESS) ?
+            BLESHUTTER_COMMAND_OK : BLESHUTTER_COMMAND_REJECTED );
 }
 
-static void releaseShutter()
+/*********************************************************************
+ * @fn      shootingCheck
+ *
+ * @brief   Check that a Shooting value can be scheduled: a synced one
+ *          needs the master clock and a wall clock one a valid time,
+ *          with Time set, that hasn't passed yet. Starting a late wall
+ *          clock run at once would put it off its schedule for good.
+ *
+ * @param   pShooting - Shooting value, BLESHUTTER_SHOOTING_LEN bytes
+ *
+ * @return  SUCCESS or FAILURE
+ */
+static uint8 shootingCheck( uint8 *pShooting )
 {
-    SHUTTER_SBIT = SHUTTER_RELEASE;
-    
-    progressCount++;
-    BLEShutter_SetParameter( BLESHUTTER_PROGRESS, BLESHUTTER_PROGRESS_LEN, &progressCount);
-    if (progressCount < targetCount)
+    uint8 options = pShooting[14];
+
+    if ( options & BLESHUTTER_SHOOTING_OPT_SYNCED )
+    {
+        return ( DCBSSync_Synced() ? SUCCESS : FAILURE );
+    }
+
+    if ( options & BLESHUTTER_SHOOTING_OPT_WALL )
     {
-        HalLcdWriteString( "Start Interval Timer",  HAL_LCD_LINE_8 );
-        osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_SHOOTING_ACTIVE_EVT, repeatInterval );
+        uint32 utc = BUILD_UINT32( pShooting[2], pShooting[3], pShooting[4], pShooting[5] );
+        uint16 startMs = BUILD_UINT16( pShooting[19], pShooting[20] );
+        uint32 start;
+
+        if ( startMs >= 1000 || DCBSSync_WallToLocal( utc, startMs, &start ) != SUCCESS ||
+             (int32)(start - osal_GetSystemClock()) < 0 )
+        {
+            return ( FAILURE );
+        }
     }
+
+    return ( SUCCESS );
 }
 
-static void activeFocus()
+/*********************************************************************
+ * @fn      startShooting
+ *
+ * @brief   Start a Shooting command on every channel in its mask. The
+ *          whole run is anchored to the moment the command arrives and
+ *          channels start stagger ms apart in channel order, so one
+ *          command gives synchronized (stagger 0) or staggered frames.
+ *          A synced command is anchored to a master clock time instead,
+ *          so adaptors given the same command shoot together, and a wall
+ *          clock command to an absolute time, so it needn't stay
+ *          connected; a start already past is refused.
+ *          Nothing is changed for a value shootingCheck refuses.
+ *
+ * @param   pShooting - Shooting value, BLESHUTTER_SHOOTING_LEN bytes
+ * @param   now - clock time (ms) the run is anchored to, the time it
+ *                arrives or, queued, the time its channels came free
+ *
+ * @return  SUCCESS, or FAILURE when it can't be scheduled
+ */
+static uint8 startShooting( uint8 *pShooting, uint32 now )
 {
-    FOCUS_SBIT = FOCUS_ACTIVE;
+    uint16 count = BUILD_UINT16( pShooting[0], pShooting[1] );
+    uint32 delay = BUILD_UINT32( pShooting[2], pShooting[3], pShooting[4], pShooting[5] );
+    uint32 exposure = BUILD_UINT32( pShooting[6], pShooting[7], pShooting[8], pShooting[9] );
+    uint32 interval = BUILD_UINT32( pShooting[10], pShooting[11], pShooting[12], pShooting[13] );
+    uint8 options = pShooting[14];
+    uint8 mask = shootingMask( pShooting );
+    uint16 stagger = BUILD_UINT16( pShooting[16], pShooting[17] );
+    int8 bracketStep = (int8)pShooting[18];
+    uint16 startMs = BUILD_UINT16( pShooting[19], pShooting[20] );
+    uint8 ch;
+
+    if ( shootingCheck( pShooting ) != SUCCESS )
+    {
+        return ( FAILURE );
+    }
 
-    osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_FOCUS_RELEASE_EVT, DCBS_DEFAULT_ACTIVE_PERIOD );
+    if ( exposure == 0 )
+    {
+        exposure = DCBS_DEFAULT_ACTIVE_PERIOD;
+        options &= ~BLESHUTTER_SHOOTING_OPT_EXPOSURE_US;
+    }
+
+    if ( !DCBSRamp_Loaded() )
+    {
+        options &= ~BLESHUTTER_SHOOTING_OPT_RAMP;
+    }
+
+    // Delay is a master clock time, the grid is kept on the master clock
+    if ( options & BLESHUTTER_SHOOTING_OPT_SYNCED )
+    {
+        options |= BLESHUTTER_SHOOTING_OPT_ANCHORED;
+    }
+    else if ( options & BLESHUTTER_SHOOTING_OPT_WALL )
+    {
+        uint32 start;
+
+        // Delay is a wall clock time, worked out once on the local clock
+        VOID DCBSSync_WallToLocal( delay, startMs, &start );
+        timeState( delay, startMs );
+
+        // Not in the past, checked above, and now is no later than the clock
+        delay = start - now;
+        options |= BLESHUTTER_SHOOTING_OPT_ANCHORED;
+    }
+
+    // A bracket needs a fixed, timed base and goes back to back
+    if ( exposure == DCBS_BULB_EXPOSURE || (options & BLESHUTTER_SHOOTING_OPT_RAMP) )
+    {
+        bracketStep = 0;
+    }
+    else if ( bracketStep != 0 && interval < DCBS_BRACKET_MIN_GAP )
+    {
+        interval = DCBS_BRACKET_MIN_GAP;
+    }
+
+    // A shooting command on channel 0 replaces any running program
+    if ( mask & BV(0) )
+    {
+        stopProgram();
+    }
+    stopChannels( mask );
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+
+        if ( !(mask & BV(ch)) )
+        {
+            continue;
+        }
+
+        pChannel->state = DCBS_CHANNEL_WAIT;
+        pChannel->options = options;
+        pChannel->progressCount = 0;
+        pChannel->targetCount = count;
+        pChannel->bracketStep = bracketStep;
+        pChannel->baseExposure = exposure;
+        pChannel->interval = interval;
+        if ( options & BLESHUTTER_SHOOTING_OPT_SYNCED )
+        {
+            pChannel->syncDeadline = delay;
+            pChannel->frameDeadline = DCBSSync_ToLocal( delay );
+        }
+        else
+        {
+            pChannel->frameDeadline = now + delay;
+        }
+        pChannel->due = pChannel->frameDeadline;
+        DCBSRamp_Seek( &pChannel->ramp, 0 );
+        frameExposure( pChannel );
+
+        delay += stagger;
+    }
+
+    // Status follows the lowest channel of the latest command
+    for ( statusChannel = 0; !(mask & BV(statusChannel)); statusChannel++ )
+    {
+    }
+
+    DCBS_LOG_RECORD( DCBS_LOG_SHOOTING, mask, 0 );
+    DCBS_LOG_RECORD( DCBS_LOG_SHOOTING_COUNT, count, 0 );
+    DCBS_LOG_RECORD( DCBS_LOG_SHOOTING_DELAY, channels[statusChannel].due - now, stagger );
+    DCBS_LOG_RECORD( DCBS_LOG_SHOOTING_EXPOSURE, 0, exposure );
+    DCBS_LOG_RECORD( DCBS_LOG_SHOOTING_INTERVAL, 0, interval );
+
+    resetTiming();
+    reportStatus( BLESHUTTER_STATUS_DELAY );
+
+    // Frames due now are pressed straight away, before the flash write
+    // that can stall the CPU
+    dispatchChannels();
+
+    checkpointDirty = TRUE;
+    saveCheckpoint();
+
+    return ( SUCCESS );
 }
 
-static void releaseFocus()
+/*********************************************************************
+ * @fn      stopShooting
+ *
+ * @brief   Stop the channels in a mask along with their focus lines,
+ *          and the program when channel 0 is included.
+ *
+ * @param   mask - channel bit mask
+ *
+ * @return  none
+ */
+static void stopShooting( uint8 mask )
 {
-    FOCUS_SBIT = FOCUS_RELEASE;
+    queueDrop( mask );
+    if ( mask & BV(0) )
+    {
+        stopProgram();
+    }
+    stopChannels( mask );
+
+    focusHeld &= ~channelLines( mask, channelFocusBV );
+    driveLines( channelLines( mask, channelFocusBV ), FALSE );
+    if ( focusHeld == 0 )
+    {
+        osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_FOCUS_RELEASE_EVT );
+    }
+
+    saveCheckpoint();
+    if ( mask & BV(statusChannel) )
+    {
+        reportStatus( BLESHUTTER_STATUS_STOPPED );
+    }
+}
+
+/*********************************************************************
+ * @fn      stopChannels
+ *
+ * @brief   Return the channels in a mask to idle with the shutter
+ *          released. Channels outside the mask that shared a cut short
+ *          Timer 1 pulse are counted as done with that frame.
+ *
+ * @param   mask - channel bit mask
+ *
+ * @return  none
+ */
+static void stopChannels( uint8 mask )
+{
+    uint32 now = osal_GetSystemClock();
+    uint8 ch;
+
+    if ( pulseChannels & mask )
+    {
+        uint8 others = pulseChannels & ~mask;
+
+        DCBSPulse_Cancel();
+        pulseChannels = 0;
+
+        for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+        {
+            if ( others & BV(ch) )
+            {
+                finishFrame( ch, now );
+            }
+        }
+    }
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( (mask & BV(ch)) && channels[ch].state != DCBS_CHANNEL_IDLE )
+        {
+            channels[ch].state = DCBS_CHANNEL_IDLE;
+            checkpointDirty = TRUE;
+        }
+    }
+    pausePending &= ~mask;
+
+    driveLines( channelLines( mask, channelShutterBV ), FALSE );
+    armChannels();
+}
+
+/*********************************************************************
+ * @fn      stopCommand
+ *
+ * @brief   Run a Stop value, from the characteristic or a command.
+ *
+ * @param   pStop - mask(1) op(1), 0 for every channel
+ *
+ * @return  none
+ */
+static void stopCommand( uint8 *pStop )
+{
+    uint8 mask = pStop[0] ? pStop[0] : DCBS_ALL_CHANNELS;
+
+    switch ( pStop[1] )
+    {
+        case BLESHUTTER_STOP_OP_PAUSE:
+            pauseShooting( mask );
+            DCBS_LOG_RECORD( DCBS_LOG_PAUSE, pStop[0], 0 );
+            break;
+
+        case BLESHUTTER_STOP_OP_RESUME:
+        case BLESHUTTER_STOP_OP_RESUME_SHIFTED:
+            resumeShooting( mask, (pStop[1] == BLESHUTTER_STOP_OP_RESUME_SHIFTED) );
+            DCBS_LOG_RECORD( DCBS_LOG_RESUME, pStop[0], pStop[1] );
+            break;
+
+        default:
+            stopShooting( mask );
+            DCBS_LOG_RECORD( DCBS_LOG_STOP, pStop[0], 0 );
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      pauseShooting
+ *
+ * @brief   Hold the shooting runs of the channels in a mask. A channel
+ *          waiting for its next frame is held straight away, one with
+ *          the shutter open once the frame ends; bulb frames and idle
+ *          channels are left as they are.
+ *
+ * @param   mask - channel bit mask
+ *
+ * @return  none
+ */
+static void pauseShooting( uint8 mask )
+{
+    uint32 now = osal_GetSystemClock();
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( !(mask & BV(ch)) )
+        {
+            continue;
+        }
+
+        if ( channels[ch].state == DCBS_CHANNEL_WAIT )
+        {
+            pauseChannel( ch, now );
+        }
+        else if ( channels[ch].state == DCBS_CHANNEL_EXPOSE || channels[ch].state == DCBS_CHANNEL_PULSE )
+        {
+            pausePending |= BV(ch);
+        }
+    }
+
+    armChannels();
+    saveCheckpoint();
+
+    if ( channels[statusChannel].state == DCBS_CHANNEL_PAUSED )
+    {
+        reportStatus( BLESHUTTER_STATUS_PAUSED );
+    }
+}
+
+/*********************************************************************
+ * @fn      pauseChannel
+ *
+ * @brief   Hold a channel waiting for its next frame. Its frame count,
+ *          exposure and deadlines stay as they are, the time that was
+ *          left is due - pausedAt.
+ *
+ * @param   ch - channel, in DCBS_CHANNEL_WAIT
+ * @param   now - current clock (ms)
+ *
+ * @return  none
+ */
+static void pauseChannel( uint8 ch, uint32 now )
+{
+    channels[ch].state = DCBS_CHANNEL_PAUSED;
+    channels[ch].pausedAt = now;
+    pausePending &= ~BV(ch);
+    checkpointDirty = TRUE;
+}
+
+/*********************************************************************
+ * @fn      resumeShooting
+ *
+ * @brief   Carry on with the paused channels in a mask, either on their
+ *          original grid from the first frame time still to come, or
+ *          shifted on by the length of the pause. A pause still waiting
+ *          for its frame to end is called off.
+ *
+ * @param   mask - channel bit mask
+ * @param   shifted - TRUE to move the grid on by the pause
+ *
+ * @return  none
+ */
+static void resumeShooting( uint8 mask, uint8 shifted )
+{
+    uint32 now = osal_GetSystemClock();
+    uint8 ch;
+
+    pausePending &= ~mask;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+        uint32 shift = 0;
+
+        if ( !(mask & BV(ch)) || pChannel->state != DCBS_CHANNEL_PAUSED )
+        {
+            continue;
+        }
+
+        if ( shifted )
+        {
+            shift = now - pChannel->pausedAt;
+        }
+        else if ( (int32)(pChannel->due - now) < 0 )
+        {
+            uint32 period = pChannel->exposure + pChannel->interval;
+
+            // Whole periods, so the frame lands back on the grid
+            shift = (period != 0) ? ((now - pChannel->due + period - 1) / period) * period :
+                    now - pChannel->due;
+        }
+
+        pChannel->frameDeadline += shift;
+        pChannel->due += shift;
+        if ( pChannel->options & BLESHUTTER_SHOOTING_OPT_SYNCED )
+        {
+            pChannel->syncDeadline += shift;
+            pChannel->frameDeadline = DCBSSync_ToLocal( pChannel->syncDeadline );
+            pChannel->due = pChannel->frameDeadline;
+        }
+        pChannel->state = DCBS_CHANNEL_WAIT;
+        checkpointDirty = TRUE;
+
+        if ( ch == statusChannel )
+        {
+            reportStatus( BLESHUTTER_STATUS_SHOOTING );
+        }
+    }
+
+    // Frames due now are pressed straight away, before the flash write
+    dispatchChannels();
+
+    saveCheckpoint();
+}
+
+/*********************************************************************
+ * @fn      dispatchChannels
+ *
+ * @brief   Handle every channel whose press or release is due, then
+ *          re-arm DCBS_SHOOTING_EVT for the earliest one left. Presses
+ *          due together are driven with a single port write.
+ *
+ * @return  none
+ */
+static void dispatchChannels()
+{
+    uint32 now = osal_GetSystemClock();
+    uint8 press = 0;
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+
+        if ( pChannel->state == DCBS_CHANNEL_EXPOSE && (int32)(pChannel->due - now) <= 0 )
+        {
+            driveLines( channelShutterBV[ch], FALSE );
+            finishFrame( ch, now );
+        }
+
+        if ( pChannel->state == DCBS_CHANNEL_WAIT && (int32)(pChannel->due - now) <= 0 )
+        {
+            press |= BV(ch);
+        }
+    }
+
+    if ( press )
+    {
+        pressChannels( press, now );
+    }
+
+    armChannels();
+}
+
+/*********************************************************************
+ * @fn      pressChannels
+ *
+ * @brief   Open the shutter on a set of channels. Channels with a
+ *          short exposure share one Timer 1 pulse when their widths
+ *          match; the rest are released by the dispatcher.
+ *
+ * @param   mask - channel bit mask, all in DCBS_CHANNEL_WAIT
+ * @param   now - current clock (ms)
+ *
+ * @return  none
+ */
+static void pressChannels( uint8 mask, uint32 now )
+{
+    uint8 lines = 0;
+    uint8 pulse = 0;
+    uint32 pulseWidthUs = 0;
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+
+        if ( !(mask & BV(ch)) )
+        {
+            continue;
+        }
+
+        if ( ch == statusChannel )
+        {
+            lastShotTime = now;
+            lastShotDrift = (int32)(now - pChannel->frameDeadline);
+            recordTiming( (int32)(now - pChannel->due) );
+        }
+
+        if ( pChannel->exposure == DCBS_BULB_EXPOSURE )
+        {
+            pChannel->state = DCBS_CHANNEL_BULB;
+            lines |= channelShutterBV[ch];
+        }
+        else if ( pChannel->pulseWidthUs && !DCBSPulse_Busy() &&
+                  (pulse == 0 || pChannel->pulseWidthUs == pulseWidthUs) )
+        {
+            pChannel->state = DCBS_CHANNEL_PULSE;
+            pulse |= BV(ch);
+            pulseWidthUs = pChannel->pulseWidthUs;
+        }
+        else
+        {
+            pChannel->state = DCBS_CHANNEL_EXPOSE;
+            pChannel->due = (pChannel->options & BLESHUTTER_SHOOTING_OPT_ANCHORED) ?
+                    pChannel->frameDeadline + pChannel->exposure : now + pChannel->exposure;
+            lines |= channelShutterBV[ch];
+        }
+    }
+
+    if ( pulse )
+    {
+        uint8 pulseLines = channelLines( pulse, channelShutterBV );
+
+        if ( DCBSPulse_Start( pulseLines, pulseWidthUs ) == SUCCESS )
+        {
+            // Timer 1 releases the shutters and raises DCBS_PULSE_DONE_EVT.
+            // An earlier pulse may still wait for its event, so add to the set.
+            pulseChannels |= pulse;
+            linesChanged( pulseLines, TRUE );
+        }
+        else
+        {
+            for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+            {
+                dcbsChannel_t *pChannel = &channels[ch];
+
+                if ( pulse & BV(ch) )
+                {
+                    pChannel->state = DCBS_CHANNEL_EXPOSE;
+                    pChannel->due = (pChannel->options & BLESHUTTER_SHOOTING_OPT_ANCHORED) ?
+                            pChannel->frameDeadline + pChannel->exposure : now + pChannel->exposure;
+                }
+            }
+            lines |= pulseLines;
+        }
+    }
+
+    driveLines( lines, TRUE );
+
+    if ( mask & BV(statusChannel) )
+    {
+        reportStatus( BLESHUTTER_STATUS_SHOOTING );
+    }
+}
+
+/*********************************************************************
+ * @fn      pulseDone
+ *
+ * @brief   Timer 1 released the shutters of pulsed channels. Only the
+ *          channels whose lines the interrupt released are finished, a
+ *          pulse started since keeps its channels.
+ *
+ * @return  none
+ */
+static void pulseDone()
+{
+    uint32 now = osal_GetSystemClock();
+    uint8 released = DCBSPulse_Done();
+    uint8 done = 0;
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( (pulseChannels & BV(ch)) && (released & channelShutterBV[ch]) )
+        {
+            done |= BV(ch);
+        }
+    }
+    pulseChannels &= ~done;
+    linesChanged( channelLines( done, channelShutterBV ), FALSE );
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( (done & BV(ch)) && channels[ch].state == DCBS_CHANNEL_PULSE )
+        {
+            finishFrame( ch, now );
+        }
+    }
+
+    armChannels();
+}
+
+/*********************************************************************
+ * @fn      finishFrame
+ *
+ * @brief   Count a frame whose shutter has been released and schedule
+ *          the next one. Anchored channels advance their deadline by a
+ *          whole period so dispatch latency never accumulates.
+ *
+ * @param   ch - channel index
+ * @param   now - current clock (ms)
+ *
+ * @return  none
+ */
+static void finishFrame( uint8 ch, uint32 now )
+{
+    dcbsChannel_t *pChannel = &channels[ch];
+
+    pChannel->progressCount++;
+    if ( pChannel->progressCount >= pChannel->targetCount )
+    {
+        pChannel->state = DCBS_CHANNEL_IDLE;
+        pausePending &= ~BV(ch);
+        checkpointDirty = TRUE;
+
+        if ( queueCount != 0 )
+        {
+            queueFrom = now;
+            osal_set_event( dslrCameraBLEShutter_TaskID, DCBS_QUEUE_EVT );
+        }
+    }
+    else
+    {
+        // Kept in relative mode too, it's what drift is measured against
+        pChannel->frameDeadline += pChannel->exposure + pChannel->interval;
+        if ( pChannel->options & BLESHUTTER_SHOOTING_OPT_SYNCED )
+        {
+            // Follows the latest estimate, adaptors stay together over long runs
+            pChannel->syncDeadline += pChannel->exposure + pChannel->interval;
+            pChannel->frameDeadline = DCBSSync_ToLocal( pChannel->syncDeadline );
+        }
+        pChannel->due = (pChannel->options & BLESHUTTER_SHOOTING_OPT_ANCHORED) ?
+                pChannel->frameDeadline : now + pChannel->interval;
+        pChannel->state = DCBS_CHANNEL_WAIT;
+
+        if ( pausePending & BV(ch) )
+        {
+            pauseChannel( ch, now );
+        }
+
+        if ( pChannel->options & BLESHUTTER_SHOOTING_OPT_RAMP )
+        {
+            DCBSRamp_Advance( &pChannel->ramp );
+            frameExposure( pChannel );
+        }
+        else if ( pChannel->bracketStep != 0 )
+        {
+            frameExposure( pChannel );
+        }
+    }
+
+    if ( ch == statusChannel )
+    {
+        reportStatus( (pChannel->state == DCBS_CHANNEL_IDLE) ? BLESHUTTER_STATUS_DONE :
+                (pChannel->state == DCBS_CHANNEL_PAUSED) ? BLESHUTTER_STATUS_PAUSED :
+                BLESHUTTER_STATUS_SHOOTING );
+    }
+
+    saveCheckpoint();
+
+    if ( busyChannels() == 0 && queueCount == 0 )
+    {
+        linkRunDone();
+    }
+}
+
+/*********************************************************************
+ * @fn      frameExposure
+ *
+ * @brief   Set the exposure of the channel's next frame. A ramp takes
+ *          exposure (and interval) from its position on the curve. A
+ *          bracket is centred on the base exposure, frame n being
+ *          bracketStep thirds of a stop times (n - (count - 1) / 2)
+ *          away from it, so 3 frames at step 3 give -1, 0 and +1 EV.
+ *
+ * @param   pChannel - channel with its base exposure, progress and
+ *                     ramp position set
+ *
+ * @return  none
+ */
+static void frameExposure( dcbsChannel_t *pChannel )
+{
+    uint32 exposure = pChannel->baseExposure;
+
+    pChannel->pulseWidthUs = 0;
+
+    if ( pChannel->options & BLESHUTTER_SHOOTING_OPT_RAMP )
+    {
+        DCBSRamp_Value( &pChannel->ramp, &exposure, &pChannel->interval );
+    }
+    else if ( exposure == DCBS_BULB_EXPOSURE )
+    {
+        pChannel->exposure = exposure;
+        return;
+    }
+    else if ( pChannel->bracketStep != 0 )
+    {
+        int32 frame = (int32)pChannel->progressCount - ((int32)pChannel->targetCount - 1) / 2;
+
+        exposure = bracketExposure( exposure, frame * pChannel->bracketStep );
+    }
+
+    if ( pChannel->options & BLESHUTTER_SHOOTING_OPT_EXPOSURE_US )
+    {
+        pChannel->pulseWidthUs = exposure;
+        // OSAL side keeps scheduling in whole milliseconds
+        exposure = (exposure / 1000) + ((exposure % 1000) ? 1 : 0);
+    }
+    else if ( exposure <= DCBS_PULSE_MAX_US / 1000 )
+    {
+        pChannel->pulseWidthUs = exposure * 1000;
+    }
+
+    pChannel->exposure = exposure;
+}
+
+/*********************************************************************
+ * @fn      bracketExposure
+ *
+ * @brief   Scale an exposure by 2^(thirds / 3) in integer arithmetic.
+ *          The result is at least 1 and never reaches
+ *          DCBS_BULB_EXPOSURE.
+ *
+ * @param   base - exposure, ms or us
+ * @param   thirds - stops * 3, negative for shorter
+ *
+ * @return  scaled exposure in the unit of base
+ */
+static uint32 bracketExposure( uint32 base, int32 thirds )
+{
+    // 2^(0/3), 2^(1/3) and 2^(2/3) in 8.8 fixed point
+    static CONST uint16 thirdScale[3] = { 256, 323, 406 };
+    int32 stops = thirds / 3;
+    int8 third = (int8)(thirds % 3);
+    uint32 exposure = base;
+
+    // Round the stops down so the third is always positive
+    if ( third < 0 )
+    {
+        third += 3;
+        stops--;
+    }
+
+    if ( third != 0 )
+    {
+        exposure = (exposure < 0x00A00000) ? (exposure * thirdScale[third]) >> 8 :
+                (exposure >> 8) * thirdScale[third];
+    }
+
+    if ( stops > 0 )
+    {
+        exposure = (stops < 32 && exposure <= ((DCBS_BULB_EXPOSURE - 1) >> stops)) ?
+                exposure << stops : DCBS_BULB_EXPOSURE - 1;
+    }
+    else if ( stops < 0 )
+    {
+        exposure = (stops > -32) ? exposure >> -stops : 0;
+    }
+
+    return ( (exposure != 0) ? exposure : 1 );
+}
+
+/*********************************************************************
+ * @fn      armChannels
+ *
+ * @brief   Arm DCBS_SHOOTING_EVT for the earliest pending press or
+ *          release, or stop it when nothing is pending.
+ *
+ * @return  none
+ */
+static void armChannels()
+{
+    uint32 now = osal_GetSystemClock();
+    int32 earliest = 0;
+    uint8 armed = FALSE;
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+
+        if ( pChannel->state == DCBS_CHANNEL_WAIT || pChannel->state == DCBS_CHANNEL_EXPOSE )
+        {
+            int32 remaining = (int32)(pChannel->due - now);
+
+            if ( !armed || remaining < earliest )
+            {
+                earliest = remaining;
+                armed = TRUE;
+            }
+        }
+    }
+
+    if ( armed )
+    {
+        startTimerAt( DCBS_SHOOTING_EVT, now + (uint32)earliest );
+    }
+    else
+    {
+        osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_SHOOTING_EVT );
+    }
+}
+
+/*********************************************************************
+ * @fn      runningChannels
+ *
+ * @brief   Find the channels that are not idle.
+ *
+ * @return  channel bit mask
+ */
+static uint8 runningChannels()
+{
+    uint8 mask = 0;
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( channels[ch].state != DCBS_CHANNEL_IDLE )
+        {
+            mask |= BV(ch);
+        }
+    }
+
+    return ( mask );
+}
+
+/*********************************************************************
+ * @fn      busyChannels
+ *
+ * @brief   Get the channels a queued Shooting value has to wait for,
+ *          channel 0 being busy while a program runs too.
+ *
+ * @return  channel bit mask
+ */
+static uint8 busyChannels()
+{
+    return ( runningChannels() | (DCBSProgram_Running() ? BV(0) : 0) );
+}
+
+/*********************************************************************
+ * @fn      shootingMask
+ *
+ * @brief   Get the channels of a Shooting value.
+ *
+ * @param   pShooting - Shooting value, BLESHUTTER_SHOOTING_LEN bytes
+ *
+ * @return  channel bit mask, channel 0 when it has none
+ */
+static uint8 shootingMask( uint8 *pShooting )
+{
+    uint8 mask = pShooting[15] & DCBS_ALL_CHANNELS;
+
+    // Older clients leave the channel out
+    return ( mask ? mask : BV(0) );
+}
+
+/*********************************************************************
+ * @fn      queueNext
+ *
+ * @brief   Start the queued Shooting values whose channels are free,
+ *          oldest first, anchored to the moment they came free so a
+ *          run follows the one before it without a gap.
+ *
+ * @return  none
+ */
+static void queueNext()
+{
+    while ( queueCount != 0 )
+    {
+        uint8 *pShooting = shootingQueue[queueHead];
+
+        if ( busyChannels() & shootingMask( pShooting ) )
+        {
+            break;
+        }
+
+        queueHead = (queueHead + 1) % DCBS_QUEUE_LEN;
+        queueCount--;
+        if ( startShooting( pShooting, queueFrom ) != SUCCESS )
+        {
+            // Its sync or wall time went since it was queued
+            reportStatus( BLESHUTTER_STATUS_REJECTED );
+        }
+        DCBSPool_Free( pShooting );
+    }
+}
+
+/*********************************************************************
+ * @fn      queueDrop
+ *
+ * @brief   Drop the queued Shooting values on any channel in a mask.
+ *
+ * @param   mask - channel bit mask
+ *
+ * @return  none
+ */
+static void queueDrop( uint8 mask )
+{
+    uint8 kept = 0;
+    uint8 i;
+
+    for ( i = 0; i < queueCount; i++ )
+    {
+        uint8 *pShooting = shootingQueue[(queueHead + i) % DCBS_QUEUE_LEN];
+
+        if ( shootingMask( pShooting ) & mask )
+        {
+            DCBSPool_Free( pShooting );
+        }
+        else
+        {
+            shootingQueue[(queueHead + kept) % DCBS_QUEUE_LEN] = pShooting;
+            kept++;
+        }
+    }
+
+    queueCount = kept;
+}
+
+/*********************************************************************
+ * @fn      channelLines
+ *
+ * @brief   Map a channel mask to port 0 lines.
+ *
+ * @param   mask - channel bit mask
+ * @param   pLines - channelShutterBV or channelFocusBV
+ *
+ * @return  port 0 bit mask
+ */
+static uint8 channelLines( uint8 mask, CONST uint8 *pLines )
+{
+    uint8 lines = 0;
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( mask & BV(ch) )
+        {
+            lines |= pLines[ch];
+        }
+    }
+
+    return ( lines );
+}
+
+/*********************************************************************
+ * @fn      activeFocus
+ *
+ * @brief   Half-press the channels' focus lines, released again by
+ *          DCBS_FOCUS_RELEASE_EVT after DCBS_DEFAULT_ACTIVE_PERIOD.
+ *
+ * @param   mask - channel bit mask
+ *
+ * @return  none
+ */
+static void activeFocus( uint8 mask )
+{
+    uint8 lines = channelLines( mask, channelFocusBV );
+
+    focusHeld |= lines;
+    driveLines( lines, TRUE );
+
+    osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_FOCUS_RELEASE_EVT, DCBS_DEFAULT_ACTIVE_PERIOD );
+}
+
+/*********************************************************************
+ * @fn      releaseFocus
+ *
+ * @brief   Release every focus line activeFocus holds.
+ *
+ * @return  none
+ */
+static void releaseFocus()
+{
+    driveLines( focusHeld, FALSE );
+    focusHeld = 0;
+}
+
+/*********************************************************************
+ * @fn      loadProgram
+ *
+ * @brief   Replace whatever runs on channel 0 with a new shot sequence
+ *          program and start it. An invalid program leaves the channel
+ *          stopped.
+ *
+ * @param   pCode - program bytes
+ * @param   len - program length
+ *
+ * @return  none
+ */
+static void loadProgram( uint8 *pCode, uint8 len )
+{
+    // Program takes the channel 0 lines over from whatever ran before
+    stopProgram();
+    stopChannels( BV(0) );
+    focusHeld &= ~channelFocusBV[0];
+    driveLines( channelFocusBV[0], FALSE );
+
+    statusChannel = 0;
+    channels[0].progressCount = 0;
+    channels[0].targetCount = 0;
+    if ( DCBSProgram_Load( pCode, len ) == SUCCESS )
+    {
+        // Keep the code next to the checkpoint so a reset can reload it
+        if ( osal_snv_write( DCBS_NVID_PROGRAM, len, pCode ) == SUCCESS )
+        {
+            programLen = len;
+        }
+        else
+        {
+            programLen = 0;
+        }
+
+        checkpointDirty = TRUE;
+        reportStatus( BLESHUTTER_STATUS_PROGRAM );
+        runProgram();
+    }
+    else
+    {
+        uint8 state = BLESHUTTER_UPLOAD_FAILED;
+        BLEShutter_SetParameter( BLESHUTTER_UPLOAD, sizeof ( uint8 ), &state );
+    }
+
+    DCBS_LOG_RECORD( DCBS_LOG_PROGRAM, len, 0 );
+}
+
+/*********************************************************************
+ * @fn      runProgram
+ *
+ * @brief   Run the shot sequence program until it waits, then arm
+ *          DCBS_PROGRAM_EVT to pick it up again.
+ *
+ * @return  none
+ */
+static void runProgram()
+{
+    uint32 now = osal_GetSystemClock();
+    uint32 wait = 0;
+
+    switch ( DCBSProgram_Run( now, &wait ) )
+    {
+        case DCBS_PROGRAM_WAIT:
+            if ( wait )
+            {
+                osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_PROGRAM_EVT, wait );
+                programDue = now + wait;
+                saveCheckpoint();
+                break;
+            }
+            // Nothing to wait for, carry on as a yield
+            // fall through
+        case DCBS_PROGRAM_YIELD:
+            // Let the stack tasks run before continuing
+            osal_set_event( dslrCameraBLEShutter_TaskID, DCBS_PROGRAM_EVT );
+            break;
+
+        default:
+            // Program ended, don't leave the camera half pressed
+            driveLines( channelShutterBV[0] | channelFocusBV[0], FALSE );
+            saveCheckpoint();
+            reportStatus( BLESHUTTER_STATUS_DONE );
+            if ( queueCount != 0 )
+            {
+                queueFrom = now;
+                osal_set_event( dslrCameraBLEShutter_TaskID, DCBS_QUEUE_EVT );
+            }
+            else if ( runningChannels() == 0 )
+            {
+                linkRunDone();
+            }
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      stopProgram
+ *
+ * @brief   Stop the shot sequence program and its pending wait.
+ *
+ * @return  none
+ */
+static void stopProgram()
+{
+    if ( DCBSProgram_Running() )
+    {
+        DCBSProgram_Stop();
+        osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_PROGRAM_EVT );
+        osal_clear_event( dslrCameraBLEShutter_TaskID, DCBS_PROGRAM_EVT );
+        driveLines( channelShutterBV[0] | channelFocusBV[0], FALSE );
+        checkpointDirty = TRUE;
+    }
+}
+
+/*********************************************************************
+ * @fn      programLinesCB
+ *
+ * @brief   Callback from the shot sequence program to drive the lines.
+ *          Programs run on channel 0.
+ *
+ * @param   lines - DCBS_PROGRAM_LINE_SHUTTER and/or DCBS_PROGRAM_LINE_FOCUS
+ * @param   active - TRUE to press, FALSE to release
+ *
+ * @return  none
+ */
+static void programLinesCB( uint8 lines, uint8 active )
+{
+    uint8 p0Lines = 0;
+
+    if ( lines & DCBS_PROGRAM_LINE_SHUTTER )
+    {
+        p0Lines |= channelShutterBV[0];
+    }
+
+    if ( lines & DCBS_PROGRAM_LINE_FOCUS )
+    {
+        p0Lines |= channelFocusBV[0];
+    }
+
+    driveLines( p0Lines, active );
+}
+
+/*********************************************************************
+ * @fn      driveLines
+ *
+ * @brief   Drive shutter and focus outputs (active low). Every line
+ *          change outside the pulse interrupt goes through here and is
+ *          passed to linesChanged.
+ *
+ * @param   lines - port 0 bit mask
+ * @param   active - TRUE to press, FALSE to release
+ *
+ * @return  none
+ */
+static void driveLines( uint8 lines, uint8 active )
+{
+    if ( lines == 0 )
+    {
+        return;
+    }
+
+    // Single read-modify-write instruction, safe against the pulse interrupt
+    if ( active )
+    {
+        P0 &= ~lines;
+    }
+    else
+    {
+        P0 |= lines;
+    }
+
+    linesChanged( lines, active );
+}
+
+/*********************************************************************
+ * @fn      linesChanged
+ *
+ * @brief   Account for a shutter/focus line change, including those
+ *          Timer 1 makes for a pulse, trace it and pass it to
+ *          DCBS_LINE_HOOK.
+ *
+ * @param   lines - port 0 bit mask
+ * @param   active - TRUE when pressed, FALSE when released
+ *
+ * @return  none
+ */
+static void linesChanged( uint8 lines, uint8 active )
+{
+    if ( active )
+    {
+        uint8 presses = 0;
+        uint8 rest;
+
+        for ( rest = lines; rest; rest &= rest - 1 )
+        {
+            presses++;
+        }
+        DCBSStats_Count( DCBS_STATS_PULSES, presses );
+    }
+
+    DCBSTrace_Record( DCBS_TRACE_LINES, active, lines );
+    DCBS_LINE_HOOK( lines, active );
+}
+
+/*********************************************************************
+ * @fn      programProgressCB
+ *
+ * @brief   Callback from the shot sequence program when a frame is done.
+ *
+ * @return  none
+ */
+static void programProgressCB( void )
+{
+    channels[0].progressCount++;
+    lastShotTime = osal_GetSystemClock();
+    lastShotDrift = 0;
+    reportStatus( BLESHUTTER_STATUS_PROGRAM );
+}
+
+/*********************************************************************
+ * @fn      loadRamp
+ *
+ * @brief   Load an exposure ramp curve for Shooting commands with the
+ *          ramp option. Channels already ramping pick the new curve up
+ *          from their current frame.
+ *
+ * @param   pCurve - curve bytes
+ * @param   len - curve length
+ *
+ * @return  none
+ */
+static void loadRamp( uint8 *pCurve, uint8 len )
+{
+    uint8 ch;
+
+    if ( DCBSRamp_Load( pCurve, len ) != SUCCESS )
+    {
+        uint8 state = BLESHUTTER_UPLOAD_FAILED;
+        BLEShutter_SetParameter( BLESHUTTER_UPLOAD, sizeof ( uint8 ), &state );
+        return;
+    }
+
+    // Keep the curve next to the checkpoint so a reset can reload it
+    rampLen = (osal_snv_write( DCBS_NVID_RAMP, len, pCurve ) == SUCCESS) ? len : 0;
+    checkpointDirty = TRUE;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+
+        if ( pChannel->state == DCBS_CHANNEL_IDLE || !(pChannel->options & BLESHUTTER_SHOOTING_OPT_RAMP) )
+        {
+            continue;
+        }
+
+        DCBSRamp_Seek( &pChannel->ramp, pChannel->progressCount );
+        if ( pChannel->state == DCBS_CHANNEL_WAIT || pChannel->state == DCBS_CHANNEL_PAUSED )
+        {
+            frameExposure( pChannel );
+        }
+    }
+
+    DCBS_LOG_RECORD( DCBS_LOG_RAMP, len, 0 );
+}
+
+/*********************************************************************
+ * @fn      saveCheckpoint
+ *
+ * @brief   Write the state of the running channels and program to SNV.
+ *          A run starting, stopping or finishing is always written,
+ *          progress within a run at most every DCBS_CHECKPOINT_PERIOD
+ *          and only the frame counts in between. Bulb holds aren't
+ *          resumable and are saved as idle.
+ *
+ * @return  none
+ */
+static void saveCheckpoint()
+{
+    dcbsCheckpoint_t *pCheckpoint = &checkpointBuf;
+    uint32 now = osal_GetSystemClock();
+    uint8 run = DCBS_RUN_NONE;
+    uint8 ch;
+
+    VOID osal_memset( pCheckpoint, 0, sizeof ( dcbsCheckpoint_t ) );
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+        dcbsChannelSave_t *pSave = &pCheckpoint->channels[ch];
+
+        if ( pChannel->state == DCBS_CHANNEL_IDLE || pChannel->state == DCBS_CHANNEL_BULB )
+        {
+            continue;
+        }
+
+        // A frame cut short by the reset is taken again straight away
+        if ( pChannel->state == DCBS_CHANNEL_WAIT && (int32)(pChannel->due - now) > 0 )
+        {
+            pSave->untilNext = pChannel->due - now;
+        }
+        else if ( pChannel->state == DCBS_CHANNEL_PAUSED )
+        {
+            // Stays paused, with the time that was left when it was
+            if ( (int32)(pChannel->due - pChannel->pausedAt) > 0 )
+            {
+                pSave->untilNext = pChannel->due - pChannel->pausedAt;
+            }
+            pSave->paused = TRUE;
+        }
+
+        pSave->running = TRUE;
+        pSave->options = pChannel->options;
+        pSave->progressCount = pChannel->progressCount;
+        pSave->targetCount = pChannel->targetCount;
+        pSave->bracketStep = pChannel->bracketStep;
+        pSave->baseExposure = pChannel->baseExposure;
+        pSave->interval = pChannel->interval;
+        run |= DCBS_RUN_SHOOTING;
+    }
+
+    if ( run & DCBS_RUN_SHOOTING )
+    {
+        pCheckpoint->rampLen = rampLen;
+    }
+
+    if ( DCBSProgram_Running() && programLen != 0 )
+    {
+        run |= DCBS_RUN_PROGRAM;
+        pCheckpoint->programLen = programLen;
+        pCheckpoint->programProgress = channels[0].progressCount;
+        if ( (int32)(programDue - now) > 0 )
+        {
+            pCheckpoint->programUntilNext = programDue - now;
+        }
+        DCBSProgram_SaveState( now, &pCheckpoint->program );
+    }
+
+    if ( !checkpointDirty && run == checkpointRun &&
+         (run == DCBS_RUN_NONE || (now - checkpointTime) < DCBS_CHECKPOINT_PERIOD) )
+    {
+        if ( run != DCBS_RUN_NONE )
+        {
+            saveFrames( pCheckpoint );
+        }
+        return;
+    }
+
+    pCheckpoint->version = DCBS_CHECKPOINT_VERSION;
+    pCheckpoint->seq = checkpointSeq + 1;
+    pCheckpoint->run = run;
+    pCheckpoint->statusChannel = statusChannel;
+
+    if ( osal_snv_write( DCBS_NVID_CHECKPOINT, sizeof ( dcbsCheckpoint_t ), pCheckpoint ) == SUCCESS )
+    {
+        checkpointRun = run;
+        checkpointTime = now;
+        checkpointSeq = pCheckpoint->seq;
+        checkpointDirty = FALSE;
+
+        // Frame records from before no longer apply
+        resetFrames( pCheckpoint );
+    }
+}
+
+/*********************************************************************
+ * @fn      saveFrames
+ *
+ * @brief   Write the frame counts and the time to the next step of the
+ *          run to SNV when a frame has been counted since the last
+ *          checkpoint or frame record, so a reset between checkpoints
+ *          neither repeats nor skips frames.
+ *
+ * @param   pCheckpoint - the state saveCheckpoint gathered
+ *
+ * @return  none
+ */
+static void saveFrames( dcbsCheckpoint_t *pCheckpoint )
+{
+    dcbsFrames_t *pFrames = &framesBuf;
+    uint8 changed = (pCheckpoint->programProgress != pFrames->programProgress);
+    uint8 ch;
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( pCheckpoint->channels[ch].progressCount != pFrames->progressCount[ch] )
+        {
+            changed = TRUE;
+        }
+    }
+
+    if ( !changed )
+    {
+        return;
+    }
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        pFrames->progressCount[ch] = pCheckpoint->channels[ch].progressCount;
+        pFrames->untilNext[ch] = pCheckpoint->channels[ch].untilNext;
+    }
+    pFrames->programProgress = pCheckpoint->programProgress;
+    pFrames->programUntilNext = pCheckpoint->programUntilNext;
+    VOID osal_memcpy( &pFrames->program, &pCheckpoint->program, sizeof ( dcbsProgramState_t ) );
+
+    VOID osal_snv_write( DCBS_NVID_FRAMES, sizeof ( dcbsFrames_t ), pFrames );
+}
+
+/*********************************************************************
+ * @fn      resetFrames
+ *
+ * @brief   Start the frame record over from a checkpoint, so the next
+ *          one is written once a frame is counted after it.
+ *
+ * @param   pCheckpoint - the checkpoint written or restored
+ *
+ * @return  none
+ */
+static void resetFrames( dcbsCheckpoint_t *pCheckpoint )
+{
+    uint8 ch;
+
+    VOID osal_memset( &framesBuf, 0, sizeof ( dcbsFrames_t ) );
+    framesBuf.seq = pCheckpoint->seq;
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        framesBuf.progressCount[ch] = pCheckpoint->channels[ch].progressCount;
+    }
+    framesBuf.programProgress = pCheckpoint->programProgress;
+}
+
+/*********************************************************************
+ * @fn      restoreCheckpoint
+ *
+ * @brief   Resume the channels and program saved in SNV, if any. The
+ *          OSAL clock restarts from zero and nothing records how long
+ *          the device was down, so each run continues from boot with
+ *          the frame count and the time to the next step it had at the
+ *          checkpoint, or at the frame record written after it.
+ *
+ * @return  none
+ */
+static void restoreCheckpoint()
+{
+    // Program or ramp curve read back from SNV, kept off the stack
+    static uint8 code[DCBS_PROGRAM_MAX_LEN];
+    dcbsCheckpoint_t *pCheckpoint = &checkpointBuf;
+    uint32 now = osal_GetSystemClock();
+    uint8 ch;
+
+    if ( osal_snv_read( DCBS_NVID_CHECKPOINT, sizeof ( dcbsCheckpoint_t ), pCheckpoint ) != SUCCESS ||
+         pCheckpoint->version != DCBS_CHECKPOINT_VERSION || pCheckpoint->run == DCBS_RUN_NONE )
+    {
+        return;
+    }
+
+    // Frames counted since the checkpoint replace its counts and times
+    if ( osal_snv_read( DCBS_NVID_FRAMES, sizeof ( dcbsFrames_t ), &framesBuf ) == SUCCESS &&
+         framesBuf.seq == pCheckpoint->seq )
+    {
+        for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+        {
+            pCheckpoint->channels[ch].progressCount = framesBuf.progressCount[ch];
+            pCheckpoint->channels[ch].untilNext = framesBuf.untilNext[ch];
+        }
+        if ( framesBuf.programProgress != pCheckpoint->programProgress )
+        {
+            pCheckpoint->programProgress = framesBuf.programProgress;
+            pCheckpoint->programUntilNext = framesBuf.programUntilNext;
+            VOID osal_memcpy( &pCheckpoint->program, &framesBuf.program, sizeof ( dcbsProgramState_t ) );
+        }
+    }
+    else
+    {
+        resetFrames( pCheckpoint );
+    }
+
+    checkpointRun = pCheckpoint->run;
+    checkpointTime = now;
+    checkpointSeq = pCheckpoint->seq;
+    statusChannel = (pCheckpoint->statusChannel < DCBS_NUM_CHANNELS) ? pCheckpoint->statusChannel : 0;
+
+    if ( pCheckpoint->rampLen != 0 && pCheckpoint->rampLen <= DCBS_RAMP_MAX_LEN &&
+         osal_snv_read( DCBS_NVID_RAMP, pCheckpoint->rampLen, code ) == SUCCESS &&
+         DCBSRamp_Load( code, pCheckpoint->rampLen ) == SUCCESS )
+    {
+        rampLen = pCheckpoint->rampLen;
+    }
+
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        dcbsChannel_t *pChannel = &channels[ch];
+        dcbsChannelSave_t *pSave = &pCheckpoint->channels[ch];
+
+        if ( !pSave->running || pSave->progressCount >= pSave->targetCount )
+        {
+            continue;
+        }
+
+        pChannel->state = DCBS_CHANNEL_WAIT;
+        // The timebase doesn't survive a reset, carry on with the local clock
+        pChannel->options = pSave->options & ~BLESHUTTER_SHOOTING_OPT_SYNCED;
+        pChannel->progressCount = pSave->progressCount;
+        pChannel->targetCount = pSave->targetCount;
+        pChannel->bracketStep = pSave->bracketStep;
+        pChannel->baseExposure = pSave->baseExposure;
+        pChannel->interval = pSave->interval;
+        pChannel->frameDeadline = now + pSave->untilNext;
+        pChannel->due = pChannel->frameDeadline;
+        if ( pSave->paused )
+        {
+            pChannel->state = DCBS_CHANNEL_PAUSED;
+            pChannel->pausedAt = now;
+        }
+
+        // Without its curve a ramp carries on at the base exposure
+        if ( !DCBSRamp_Loaded() )
+        {
+            pChannel->options &= ~BLESHUTTER_SHOOTING_OPT_RAMP;
+        }
+        DCBSRamp_Seek( &pChannel->ramp, pChannel->progressCount );
+        frameExposure( pChannel );
+    }
+    armChannels();
+
+    if ( pCheckpoint->run & DCBS_RUN_PROGRAM )
+    {
+        if ( pCheckpoint->programLen == 0 || pCheckpoint->programLen > DCBS_PROGRAM_MAX_LEN ||
+             osal_snv_read( DCBS_NVID_PROGRAM, pCheckpoint->programLen, code ) != SUCCESS ||
+             DCBSProgram_Load( code, pCheckpoint->programLen ) != SUCCESS ||
+             DCBSProgram_RestoreState( now, &pCheckpoint->program ) != SUCCESS )
+        {
+            DCBSProgram_Stop();
+            checkpointDirty = TRUE;
+            saveCheckpoint();
+        }
+        else
+        {
+            programLen = pCheckpoint->programLen;
+            channels[0].progressCount = pCheckpoint->programProgress;
+            programDue = now + pCheckpoint->programUntilNext;
+            startTimerAt( DCBS_PROGRAM_EVT, programDue );
+        }
+    }
+
+    reportStatus( (DCBSProgram_Running() && statusChannel == 0) ? BLESHUTTER_STATUS_PROGRAM :
+            (channels[statusChannel].state == DCBS_CHANNEL_PAUSED) ? BLESHUTTER_STATUS_PAUSED :
+            BLESHUTTER_STATUS_SHOOTING );
+
+    DCBS_LOG_RECORD( DCBS_LOG_RESUMED, runningChannels(), 0 );
+}
+
+/*********************************************************************
+ * @fn      reportStatus
+ *
+ * @brief   Queue a Status/Progress update. A state change goes out at
+ *          once; updates within a state are coalesced so at most
+ *          statusRate notifications are sent per second, the last one
+ *          always carrying the latest count.
+ *
+ * @param   state - BLESHUTTER_STATUS_*
+ *
+ * @return  none
+ */
+static void reportStatus( uint8 state )
+{
+    uint32 elapsed;
+    uint32 period;
+
+    if ( state != statusState )
+    {
+        statusState = state;
+        sendStatus();
+        return;
+    }
+
+    if ( statusPending )
+    {
+        return;
+    }
+
+    statusPending = TRUE;
+    if ( statusRate == 0 )
+    {
+        // Held back until the next state change
+        return;
+    }
+
+    elapsed = osal_GetSystemClock() - statusSentTime;
+    period = 1000 / statusRate;
+    if ( elapsed >= period )
+    {
+        sendStatus();
+    }
+    else
+    {
+        osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_STATUS_EVT, period - elapsed );
+    }
+}
+
+/*********************************************************************
+ * @fn      sendStatus
+ *
+ * @brief   Notify the current Status record and Progress count of the
+ *          status channel.
+ *
+ * @return  none
+ */
+static void sendStatus()
+{
+    uint8 status[BLESHUTTER_STATUS_LEN];
+    dcbsChannel_t *pChannel = &channels[statusChannel];
+
+    osal_stop_timerEx( dslrCameraBLEShutter_TaskID, DCBS_STATUS_EVT );
+    statusPending = FALSE;
+    statusSentTime = osal_GetSystemClock();
+
+    status[0] = statusState;
+    status[1] = LO_UINT16( pChannel->progressCount );
+    status[2] = HI_UINT16( pChannel->progressCount );
+    status[3] = LO_UINT16( pChannel->targetCount );
+    status[4] = HI_UINT16( pChannel->targetCount );
+    status[5] = BREAK_UINT32( lastShotTime, 0 );
+    status[6] = BREAK_UINT32( lastShotTime, 1 );
+    status[7] = BREAK_UINT32( lastShotTime, 2 );
+    status[8] = BREAK_UINT32( lastShotTime, 3 );
+    status[9] = BREAK_UINT32( lastShotDrift, 0 );
+    status[10] = BREAK_UINT32( lastShotDrift, 1 );
+    status[11] = BREAK_UINT32( lastShotDrift, 2 );
+    status[12] = BREAK_UINT32( lastShotDrift, 3 );
+
+    BLEShutter_SetParameter( BLESHUTTER_STATUS, BLESHUTTER_STATUS_LEN, status );
+    BLEShutter_SetParameter( BLESHUTTER_PROGRESS, BLESHUTTER_PROGRESS_LEN, &pChannel->progressCount );
+    DCBSStats_Count( DCBS_STATS_NOTIFICATIONS, BLEShutter_Notifying( BLESHUTTER_STATUS ) +
+            BLEShutter_Notifying( BLESHUTTER_PROGRESS ) );
+}
+
+/*********************************************************************
+ * @fn      resetTiming
+ *
+ * @brief   Clear the frame timing histogram for a new run.
+ *
+ * @return  none
+ */
+static void resetTiming()
+{
+    VOID osal_memset( timingBins, 0, sizeof ( timingBins ) );
+    timingMaxLate = 0;
+    lastShotDrift = 0;
+    publishTiming();
+}
+
+/*********************************************************************
+ * @fn      recordTiming
+ *
+ * @brief   Count one frame in the lateness histogram and publish it on
+ *          the Timing characteristic. Bins double in width so the
+ *          client can estimate p50/p99 from the counts.
+ *
+ * @param   late - ms the frame fired after its due time, negative if early
+ *
+ * @return  none
+ */
+static void recordTiming( int32 late )
+{
+    uint8 bin;
+
+    if ( late < 0 )
+    {
+        bin = 0;
+    }
+    else
+    {
+        // 0 -> 1, 1 -> 2, 2..3 -> 3, 4..7 -> 4 ... saturating at the last bin
+        uint32 v = (uint32)late;
+
+        for ( bin = 1; v != 0 && bin < BLESHUTTER_TIMING_BINS - 1; bin++ )
+        {
+            v >>= 1;
+        }
+
+        if ( v != 0 )
+        {
+            bin = BLESHUTTER_TIMING_BINS - 1;
+        }
+
+        if ( (uint32)late > timingMaxLate )
+        {
+            timingMaxLate = (late > 0xFFFF) ? 0xFFFF : (uint16)late;
+        }
+    }
+
+    if ( timingBins[bin] != 0xFFFF )
+    {
+        timingBins[bin]++;
+    }
+
+    publishTiming();
+}
+
+/*********************************************************************
+ * @fn      publishTiming
+ *
+ * @brief   Copy the histogram into the Timing characteristic.
+ *
+ * @return  none
+ */
+static void publishTiming()
+{
+    uint8 timing[BLESHUTTER_TIMING_LEN];
+    uint8 i;
+
+    for ( i = 0; i < BLESHUTTER_TIMING_BINS; i++ )
+    {
+        timing[i * 2] = LO_UINT16( timingBins[i] );
+        timing[i * 2 + 1] = HI_UINT16( timingBins[i] );
+    }
+    timing[16] = LO_UINT16( timingMaxLate );
+    timing[17] = HI_UINT16( timingMaxLate );
+    timing[18] = BREAK_UINT32( lastShotDrift, 0 );
+    timing[19] = BREAK_UINT32( lastShotDrift, 1 );
+    timing[20] = BREAK_UINT32( lastShotDrift, 2 );
+    timing[21] = BREAK_UINT32( lastShotDrift, 3 );
+
+    BLEShutter_SetParameter( BLESHUTTER_TIMING, BLESHUTTER_TIMING_LEN, timing );
+}
+
+/*********************************************************************
+ * @fn      syncCommand
+ *
+ * @brief   Handle a write to the Sync characteristic.
+ *
+ * @param   arrival - clock (ms) when the write arrived
+ *
+ * @return  none
+ */
+static void syncCommand( uint32 arrival )
+{
+    uint8 command[BLESHUTTER_SYNC_LEN + 1];
+    BLEShutter_GetParameter( BLESHUTTER_SYNC, command );
+
+    switch ( command[1] )
+    {
+        case BLESHUTTER_SYNC_SYNC:
+            DCBSSync_Stamp( command[2], arrival );
+            break;
+
+        case BLESHUTTER_SYNC_FOLLOW_UP:
+            VOID DCBSSync_FollowUp( command[2],
+                    BUILD_UINT32( command[3], command[4], command[5], command[6] ),
+                    BUILD_UINT16( command[7], command[8] ) );
+            syncState();
+            break;
+
+        default:
+            // should not reach here, the service checks the command
+            break;
+    }
+}
+
+/*********************************************************************
+ * @fn      syncState
+ *
+ * @brief   Update the value read from the Sync characteristic.
+ *
+ * @return  none
+ */
+static void syncState()
+{
+    uint8 state[BLESHUTTER_SYNC_STATE_LEN];
+    int16 skew = DCBSSync_Skew();
+    int16 error = DCBSSync_LastError();
+
+    state[0] = DCBSSync_Synced();
+    state[1] = LO_UINT16( skew );
+    state[2] = HI_UINT16( skew );
+    state[3] = LO_UINT16( error );
+    state[4] = HI_UINT16( error );
+
+    BLEShutter_SetParameter( BLESHUTTER_SYNC, BLESHUTTER_SYNC_STATE_LEN, state );
+}
+
+/*********************************************************************
+ * @fn      timeCommand
+ *
+ * @brief   Handle a write to the Time characteristic.
+ *
+ * @param   arrival - clock (ms) when the write arrived
+ *
+ * @return  none
+ */
+static void timeCommand( uint32 arrival )
+{
+    uint8 time[BLESHUTTER_TIME_LEN];
+    BLEShutter_GetParameter( BLESHUTTER_TIME, time );
+
+    DCBSSync_SetWall( BUILD_UINT32( time[0], time[1], time[2], time[3] ),
+            BUILD_UINT16( time[4], time[5] ), arrival );
+
+    // Starts accepted against the old setting keep their local time
+    timeState( 0, 0 );
+}
+
+/*********************************************************************
+ * @fn      timeState
+ *
+ * @brief   Update the value read from the Time characteristic.
+ *
+ * @param   utc - wall clock start accepted, 0 for none
+ * @param   ms - ms within that second
+ *
+ * @return  none
+ */
+static void timeState( uint32 utc, uint16 ms )
+{
+    uint8 state[BLESHUTTER_TIME_STATE_LEN];
+
+    state[0] = TRUE;
+    state[1] = BREAK_UINT32( utc, 0 );
+    state[2] = BREAK_UINT32( utc, 1 );
+    state[3] = BREAK_UINT32( utc, 2 );
+    state[4] = BREAK_UINT32( utc, 3 );
+    state[5] = LO_UINT16( ms );
+    state[6] = HI_UINT16( ms );
+
+    BLEShutter_SetParameter( BLESHUTTER_TIME, BLESHUTTER_TIME_STATE_LEN, state );
+}
+
+/*********************************************************************
+ * @fn      commandReceived
+ *
+ * @brief   Run a command written to the Command characteristic and ack
+ *          it. The lines move before the ack is queued, and a command
+ *          repeating the seq of the last one is acked with the result
+ *          it had, without running it again.
+ *
+ * @return  none
+ */
+static void commandReceived()
+{
+    uint8 command[BLESHUTTER_COMMAND_LEN + 1];
+    uint8 len;
+    uint8 seq;
+    uint8 op;
+    uint8 *pParams;
+    uint8 result = BLESHUTTER_COMMAND_OK;
+
+    BLEShutter_GetParameter( BLESHUTTER_COMMAND, command );
+    len = command[0] - BLESHUTTER_COMMAND_HDR_LEN;
+    seq = command[1];
+    op = command[2];
+    pParams = command + 1 + BLESHUTTER_COMMAND_HDR_LEN;
+
+    if ( commandSeen && seq == commandSeq )
+    {
+        commandAck( seq, op, commandResult | BLESHUTTER_COMMAND_REPEAT );
+        return;
+    }
+
+    switch ( op )
+    {
+        case BLESHUTTER_COMMAND_FOCUS:
+            result = commandCheck( BLESHUTTER_FOCUS, pParams, len );
+            if ( result != BLESHUTTER_COMMAND_OK )
+            {
+                break;
+            }
+
+            activeFocus( pParams[0] ? pParams[0] : BV(0) );
+            DCBS_LOG_RECORD( DCBS_LOG_FOCUS, pParams[0], 0 );
+            break;
+
+        case BLESHUTTER_COMMAND_SHOOT:
+            result = commandCheck( BLESHUTTER_SHOOTING, pParams, len );
+            if ( result != BLESHUTTER_COMMAND_OK )
+            {
+                break;
+            }
+
+            {
+                uint8 shooting[BLESHUTTER_SHOOTING_LEN];
+
+                // Trailing fields left out are 0, as on the Shooting characteristic
+                VOID osal_memset( shooting, 0, BLESHUTTER_SHOOTING_LEN );
+                VOID osal_memcpy( shooting, pParams, len );
+
+                result = shootingCommand( shooting );
+                if ( result != BLESHUTTER_COMMAND_OK )
+                {
+                    break;
+                }
+
+                // Becomes the Shooting value as well
+                BLEShutter_SetParameter( BLESHUTTER_SHOOTING, BLESHUTTER_SHOOTING_LEN, shooting );
+            }
+            break;
+
+        case BLESHUTTER_COMMAND_STOP:
+            result = commandCheck( BLESHUTTER_STOP, pParams, len );
+            if ( result != BLESHUTTER_COMMAND_OK )
+            {
+                break;
+            }
+
+            {
+                uint8 stop[BLESHUTTER_STOP_LEN] = { 0 };
+
+                // A mask alone is a stop, as on the Stop characteristic
+                VOID osal_memcpy( stop, pParams, len );
+                stopCommand( stop );
+            }
+            break;
+
+        default:
+            result = BLESHUTTER_COMMAND_BAD_OP;
+            break;
+    }
+
+    commandSeq = seq;
+    commandResult = result;
+    commandSeen = TRUE;
+
+    commandAck( seq, op, result );
+}
+
+/*********************************************************************
+ * @fn      commandCheck
+ *
+ * @brief   Hold the parameters of a command to the rules of the
+ *          characteristic that takes the same value.
+ *
+ * @param   param - parameter ID of that characteristic
+ * @param   pParams - parameters
+ * @param   len - their length
+ *
+ * @return  BLESHUTTER_COMMAND_OK ...
+ */
+static uint8 commandCheck( uint8 param, uint8 *pParams, uint8 len )
+{
+    switch ( BLEShutter_CheckParameter( param, len, pParams ) )
+    {
+        case SUCCESS:
+            return ( BLESHUTTER_COMMAND_OK );
+
+        case ATT_ERR_INVALID_VALUE_SIZE:
+            return ( BLESHUTTER_COMMAND_BAD_LEN );
+
+        default:
+            return ( BLESHUTTER_COMMAND_BAD_VALUE );
+    }
+}
+
+/*********************************************************************
+ * @fn      commandAck
+ *
+ * @brief   Notify the result of a command.
+ *
+ * @param   seq - seq of the command
+ * @param   op - its op
+ * @param   result - BLESHUTTER_COMMAND_OK ...
+ *
+ * @return  none
+ */
+static void commandAck( uint8 seq, uint8 op, uint8 result )
+{
+    uint8 ack[BLESHUTTER_COMMAND_ACK_LEN];
+
+    ack[0] = seq;
+    ack[1] = op;
+    ack[2] = result;
+
+    BLEShutter_SetParameter( BLESHUTTER_COMMAND, BLESHUTTER_COMMAND_ACK_LEN, ack );
+    DCBSStats_Count( DCBS_STATS_NOTIFICATIONS, BLEShutter_Notifying( BLESHUTTER_COMMAND ) );
+}
+
+/*********************************************************************
+ * @fn      linkActivity
+ *
+ * @brief   Ask for the short connection interval and restart the timer
+ *          that relaxes it again once the user goes quiet.
+ *
+ * @return  none
+ */
+static void linkActivity()
+{
+    setLinkMode( DCBS_LINK_ACTIVE );
+    osal_start_timerEx( dslrCameraBLEShutter_TaskID, DCBS_LINK_IDLE_EVT, DCBS_ACTIVE_LINK_TIMEOUT );
+}
+
+/*********************************************************************
+ * @fn      linkIdle
+ *
+ * @brief   No command for DCBS_ACTIVE_LINK_TIMEOUT, or no link at all.
+ *          Long autonomous runs get a long interval with slave latency,
+ *          longer still with slow advertising in power save mode, and
+ *          anything else goes back to the default parameters.
+ *
+ * @return  none
+ */
+static void linkIdle()
+{
+    uint8 longRun = DCBSProgram_Running();
+    uint8 ch;
+
+    // Every running channel has to be slow enough for the long interval
+    for ( ch = 0; ch < DCBS_NUM_CHANNELS; ch++ )
+    {
+        if ( channels[ch].state != DCBS_CHANNEL_IDLE )
+        {
+            if ( channels[ch].interval < DCBS_LONGRUN_MIN_INTERVAL )
+            {
+                longRun = FALSE;
+                break;
+            }
+            longRun = TRUE;
+        }
+    }
+
+    if ( longRun && powerMode == BLESHUTTER_POWER_SAVE )
+    {
+        setLinkMode( DCBS_LINK_SAVE );
+        slowAdvertising( TRUE );
+    }
+    else
+    {
+        setLinkMode( longRun ? DCBS_LINK_LONGRUN : DCBS_LINK_IDLE );
+        slowAdvertising( FALSE );
+    }
+}
+
+/*********************************************************************
+ * @fn      linkRunDone
+ *
+ * @brief   Undo what a long run relaxed once nothing runs any more.
+ *
+ * @return  none
+ */
+static void linkRunDone()
+{
+    if ( linkMode == DCBS_LINK_LONGRUN || linkMode == DCBS_LINK_SAVE )
+    {
+        setLinkMode( DCBS_LINK_IDLE );
+    }
+    slowAdvertising( FALSE );
+}
+
+/*********************************************************************
+ * @fn      slowAdvertising
+ *
+ * @brief   Switch between the default and the power save advertising
+ *          interval. The stack picks the interval up when advertising
+ *          next starts, which for a run left alone is right after the
+ *          link drops.
+ *
+ * @param   slow - TRUE for DCBS_SAVE_ADVERTISING_INTERVAL
+ *
+ * @return  none
+ */
+static void slowAdvertising( uint8 slow )
+{
+    uint16 advInt = slow ? DCBS_SAVE_ADVERTISING_INTERVAL : DEFAULT_ADVERTISING_INTERVAL;
+
+    if ( slow == advertSlow )
+    {
+        return;
+    }
+
+    GAP_SetParamValue( TGAP_LIM_DISC_ADV_INT_MIN, advInt );
+    GAP_SetParamValue( TGAP_LIM_DISC_ADV_INT_MAX, advInt );
+    GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MIN, advInt );
+    GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MAX, advInt );
+
+    advertSlow = slow;
+}
+
+/*********************************************************************
+ * @fn      restorePower
+ *
+ * @brief   Load the power mode from SNV.
+ *
+ * @return  none
+ */
+static void restorePower()
+{
+    if ( osal_snv_read( DCBS_NVID_POWER, sizeof ( uint8 ), &powerMode ) != SUCCESS ||
+         powerMode > BLESHUTTER_POWER_SAVE )
+    {
+        powerMode = BLESHUTTER_POWER_NORMAL;
+    }
+
+    BLEShutter_SetParameter( BLESHUTTER_POWER, BLESHUTTER_POWER_LEN, &powerMode );
+}
+
+/*********************************************************************
+ * @fn      setLinkMode
+ *
+ * @brief   Request the connection parameters for a link mode through
+ *          the peripheral role. Nothing is sent if the mode is already
+ *          in effect or there is no connection.
+ *
+ * @param   mode - DCBS_LINK_IDLE, DCBS_LINK_ACTIVE, DCBS_LINK_LONGRUN or
+ *                 DCBS_LINK_SAVE
+ *
+ * @return  none
+ */
+static void setLinkMode( uint8 mode )
+{
+    if ( mode == linkMode ||
+         (gapProfileState != GAPROLE_CONNECTED && gapProfileState != GAPROLE_CONNECTED_ADV) )
+    {
+        return;
+    }
+
+    // Count the events so far at the interval the last request settled on
+    statsLink();
+
+    switch ( mode )
+    {
+        case DCBS_LINK_ACTIVE:
+            VOID GAPRole_SendUpdateParam( DCBS_ACTIVE_MIN_CONN_INTERVAL, DCBS_ACTIVE_MAX_CONN_INTERVAL,
+                    DCBS_ACTIVE_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT, GAPROLE_NO_ACTION );
+            break;
+
+        case DCBS_LINK_LONGRUN:
+            VOID GAPRole_SendUpdateParam( DCBS_LONGRUN_MIN_CONN_INTERVAL, DCBS_LONGRUN_MAX_CONN_INTERVAL,
+                    DCBS_LONGRUN_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT, GAPROLE_NO_ACTION );
+            break;
+
+        case DCBS_LINK_SAVE:
+            VOID GAPRole_SendUpdateParam( DCBS_SAVE_MIN_CONN_INTERVAL, DCBS_SAVE_MAX_CONN_INTERVAL,
+                    DCBS_SAVE_SLAVE_LATENCY, DCBS_SAVE_CONN_TIMEOUT, GAPROLE_NO_ACTION );
+            break;
+
+        default:
+            VOID GAPRole_SendUpdateParam( DEFAULT_DESIRED_MIN_CONN_INTERVAL, DEFAULT_DESIRED_MAX_CONN_INTERVAL,
+                    DEFAULT_DESIRED_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT, GAPROLE_NO_ACTION );
+            break;
+    }
+
+    linkMode = mode;
+}
+
+/*********************************************************************
+ * @fn      statsLink
+ *
+ * @brief   Give the stats the connection interval now in effect. The
+ *          peripheral role doesn't report a parameter update, so this
+ *          runs on connecting, before each update request, after each
+ *          application event and on a Stats read.
+ *
+ * @return  none
+ */
+static void statsLink()
+{
+    uint16 interval = 0;
+
+    VOID GAPRole_GetParameter( GAPROLE_CONN_INTERVAL, &interval );
+    DCBSStats_Link( interval );
+}
+
+/*********************************************************************
+ * @fn      startTimerAt
+ *
+ * @brief   Arm an application event for an absolute OSAL clock time.
+ *          A deadline already in the past is raised immediately so the
+ *          sequence catches up instead of slipping the whole grid.
+ *
+ * @param   event - application event to raise
+ * @param   deadline - OSAL clock time (ms), compared modulo 2^32
+ *
+ * @return  none
+ */
+static void startTimerAt( uint16 event, uint32 deadline )
+{
+    int32 remaining = (int32)(deadline - osal_GetSystemClock());
+
+    if ( remaining > 0 )
+    {
+        osal_start_timerEx( dslrCameraBLEShutter_TaskID, event, (uint32)remaining );
+    }
+    else
+    {
+        osal_set_event( dslrCameraBLEShutter_TaskID, event );
+    }
 }
 
 #if (defined HAL_LCD) && (HAL_LCD == TRUE)
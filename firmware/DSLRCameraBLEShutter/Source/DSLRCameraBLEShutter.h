@@ -25,16 +25,36 @@ extern "C"
 // DSLR Camera BLE Shutter Task Events
 #define DCBS_START_DEVICE_EVT                               0x0001
 #define DCBS_FOCUS_RELEASE_EVT                              0x0002
-#define DCBS_SHOOTING_ACTIVE_EVT                            0x0004
-#define DCBS_SHOOTING_RELEASE_EVT                           0x0008
+#define DCBS_SHOOTING_EVT                                   0x0004
+#define DCBS_PULSE_DONE_EVT                                 0x0008
+#define DCBS_PROGRAM_EVT                                    0x0010
+#define DCBS_LINK_IDLE_EVT                                  0x0020
+#define DCBS_STATUS_EVT                                     0x0040
+#define DCBS_ADV_EVENT_EVT                                  0x0200
+#define DCBS_LOG_EVT                                        0x0400
+#define DCBS_QUEUE_EVT                                      0x0800
 
 #define DCBS_DEFAULT_ACTIVE_PERIOD                          500
 
+// Independent shutter/focus channels. The keyfob has a button on P0.0,
+// the focus line of the fourth channel, so it has three.
+#if defined( CC2540_MINIDK )
+#define DCBS_NUM_CHANNELS                                   3
+#else
+#define DCBS_NUM_CHANNELS                                   4
+#endif // CC2540_MINIDK
+
 
 /*********************************************************************
  * MACROS
  */
 
+// Called after every shutter/focus line change (port 0 bit mask) made by the task. Empty on
+// target; a simulation or trace build defines it to record the edges.
+#ifndef DCBS_LINE_HOOK
+#define DCBS_LINE_HOOK( lines, active )
+#endif
+
 /*********************************************************************
  * FUNCTIONS
  */
@@ -0,0 +1,185 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Log.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the deferred display log. Command handling and
+                  frames only note a record id and its values; the strings are
+                  formatted and written to the display later, one record per task
+                  call, after everything else the task had to do. Without a
+                  display none of it is built.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "hal_lcd.h"
+
+#include "DSLRCameraBLEShutter_Log.h"
+
+#if (DCBS_LOG == TRUE)
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// How a record is shown
+#define LOG_FORM_STRING                     0       // label only
+#define LOG_FORM_VALUE                      1       // label and a
+#define LOG_FORM_VALUE_VALUE                2       // label, a and b
+#define LOG_FORM_SPLIT                      3       // label, then b as two halves
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    char    *pLabel;
+    uint8   line;
+    uint8   form;
+    uint8   radix;
+} logFormat_t;
+
+typedef struct
+{
+    uint8   id;
+    uint16  a;
+    uint32  b;
+} logRecord_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Indexed by record id
+static CONST logFormat_t logFormats[] =
+{
+    { "Shooting Event",     HAL_LCD_LINE_8, LOG_FORM_STRING,        10 },   // DCBS_LOG_SHOOTING_EVENT
+    { "Pulse Done Event",   HAL_LCD_LINE_8, LOG_FORM_STRING,        10 },   // DCBS_LOG_PULSE_DONE_EVENT
+    { "Focus:",             HAL_LCD_LINE_3, LOG_FORM_VALUE,         10 },   // DCBS_LOG_FOCUS
+    { "Stop:",              HAL_LCD_LINE_3, LOG_FORM_VALUE,         10 },   // DCBS_LOG_STOP
+    { "Shooting:",          HAL_LCD_LINE_3, LOG_FORM_VALUE,         16 },   // DCBS_LOG_SHOOTING
+    { "- count:",           HAL_LCD_LINE_4, LOG_FORM_VALUE,         10 },   // DCBS_LOG_SHOOTING_COUNT
+    { "- delay:",           HAL_LCD_LINE_5, LOG_FORM_VALUE_VALUE,   10 },   // DCBS_LOG_SHOOTING_DELAY
+    { "- exposure:",        HAL_LCD_LINE_6, LOG_FORM_SPLIT,         10 },   // DCBS_LOG_SHOOTING_EXPOSURE
+    { "- interval:",        HAL_LCD_LINE_7, LOG_FORM_SPLIT,         10 },   // DCBS_LOG_SHOOTING_INTERVAL
+    { "Program:",           HAL_LCD_LINE_3, LOG_FORM_VALUE,         10 },   // DCBS_LOG_PROGRAM
+    { "Ramp:",              HAL_LCD_LINE_3, LOG_FORM_VALUE,         10 },   // DCBS_LOG_RAMP
+    { "Resumed:",           HAL_LCD_LINE_3, LOG_FORM_VALUE,         16 },   // DCBS_LOG_RESUMED
+    { "Pause:",             HAL_LCD_LINE_3, LOG_FORM_VALUE,         10 },   // DCBS_LOG_PAUSE
+    { "Resume:",            HAL_LCD_LINE_3, LOG_FORM_VALUE,         10 },   // DCBS_LOG_RESUME
+};
+
+static logRecord_t logRecords[DCBS_LOG_RECORDS];
+static uint8  logNext = 0;
+static uint8  logCount = 0;
+
+static uint8  logTaskId = 0;
+static uint16 logEvent = 0;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSLog_Init
+ *
+ * @brief   Set the event that has the task show the records.
+ *
+ * @param   taskId - task to show them
+ * @param   event - event it shows them on, lowest priority of its events
+ *
+ * @return  none
+ */
+void DCBSLog_Init( uint8 taskId, uint16 event )
+{
+    logTaskId = taskId;
+    logEvent = event;
+}
+
+/*********************************************************************
+ * @fn      DCBSLog_Record
+ *
+ * @brief   Keep a record to be shown later. Only the first record
+ *          waiting raises the event.
+ *
+ * @param   id - DCBS_LOG_SHOOTING_EVENT ...
+ * @param   a - first value
+ * @param   b - second value
+ *
+ * @return  none
+ */
+void DCBSLog_Record( uint8 id, uint16 a, uint32 b )
+{
+    logRecord_t *pRecord = &logRecords[logNext];
+
+    pRecord->id = id;
+    pRecord->a = a;
+    pRecord->b = b;
+
+    logNext = (logNext + 1) % DCBS_LOG_RECORDS;
+    if ( logCount < DCBS_LOG_RECORDS )
+    {
+        if ( logCount++ == 0 )
+        {
+            VOID osal_set_event( logTaskId, logEvent );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      DCBSLog_Show
+ *
+ * @brief   Write the oldest record waiting to the display.
+ *
+ * @param   none
+ *
+ * @return  TRUE while there are more
+ */
+uint8 DCBSLog_Show( void )
+{
+    logRecord_t *pRecord;
+    CONST logFormat_t *pFormat;
+
+    if ( logCount == 0 )
+    {
+        return ( FALSE );
+    }
+
+    pRecord = &logRecords[(logNext + DCBS_LOG_RECORDS - logCount) % DCBS_LOG_RECORDS];
+    pFormat = &logFormats[pRecord->id];
+    logCount--;
+
+    switch ( pFormat->form )
+    {
+        case LOG_FORM_VALUE:
+            HalLcdWriteStringValue( pFormat->pLabel, pRecord->a, pFormat->radix, pFormat->line );
+            break;
+
+        case LOG_FORM_VALUE_VALUE:
+            HalLcdWriteStringValueValue( pFormat->pLabel, pRecord->a, pFormat->radix,
+                    (uint16)pRecord->b, pFormat->radix, pFormat->line );
+            break;
+
+        case LOG_FORM_SPLIT:
+            HalLcdWriteStringValueValue( pFormat->pLabel, (uint16)(pRecord->b >> 16), pFormat->radix,
+                    (uint16)pRecord->b, pFormat->radix, pFormat->line );
+            break;
+
+        default:
+            HalLcdWriteString( pFormat->pLabel, pFormat->line );
+            break;
+    }
+
+    return ( logCount != 0 );
+}
+
+#endif // (DCBS_LOG == TRUE)
+
+/*********************************************************************
+ *********************************************************************/
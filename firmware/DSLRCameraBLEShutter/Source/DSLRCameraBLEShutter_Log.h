@@ -0,0 +1,105 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Log.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the deferred display log definitions and
+                  prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_LOG_H
+#define DSLRCAMERABLESHUTTER_LOG_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// The log is built when there is a display to show it on, and can be
+// turned off with DCBS_LOG=FALSE even then
+#if !defined( DCBS_LOG )
+#if (defined HAL_LCD) && (HAL_LCD == TRUE)
+#define DCBS_LOG                            TRUE
+#else
+#define DCBS_LOG                            FALSE
+#endif // (defined HAL_LCD) && (HAL_LCD == TRUE)
+#endif // !defined( DCBS_LOG )
+
+// Records waiting to be shown, the oldest is overwritten
+#define DCBS_LOG_RECORDS                    8
+
+// Records, see the table in DSLRCameraBLEShutter_Log.c for how each is shown
+#define DCBS_LOG_SHOOTING_EVENT             0       // no values
+#define DCBS_LOG_PULSE_DONE_EVENT           1       // no values
+#define DCBS_LOG_FOCUS                      2       // a: channel mask
+#define DCBS_LOG_STOP                       3       // a: channel mask
+#define DCBS_LOG_SHOOTING                   4       // a: channel mask
+#define DCBS_LOG_SHOOTING_COUNT             5       // a: count
+#define DCBS_LOG_SHOOTING_DELAY             6       // a: delay (ms), b: stagger (ms)
+#define DCBS_LOG_SHOOTING_EXPOSURE          7       // b: exposure
+#define DCBS_LOG_SHOOTING_INTERVAL          8       // b: interval (ms)
+#define DCBS_LOG_PROGRAM                    9       // a: length
+#define DCBS_LOG_RAMP                       10      // a: length
+#define DCBS_LOG_RESUMED                    11      // a: channel mask
+#define DCBS_LOG_PAUSE                      12      // a: channel mask
+#define DCBS_LOG_RESUME                     13      // a: channel mask, b: Stop op
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+// What the application calls, gone entirely without a log
+#if (DCBS_LOG == TRUE)
+#define DCBS_LOG_INIT( taskId, event )      DCBSLog_Init( (taskId), (event) )
+#define DCBS_LOG_RECORD( id, a, b )         DCBSLog_Record( (id), (uint16)(a), (uint32)(b) )
+#else
+#define DCBS_LOG_INIT( taskId, event )
+#define DCBS_LOG_RECORD( id, a, b )
+#endif // (DCBS_LOG == TRUE)
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+#if (DCBS_LOG == TRUE)
+
+/*
+ * DCBSLog_Init - Set the event that has the task show the records.
+ */
+extern void DCBSLog_Init( uint8 taskId, uint16 event );
+
+/*
+ * DCBSLog_Record - Keep a record to be shown later.
+ *
+ *    id - DCBS_LOG_SHOOTING_EVENT ...
+ *    a, b - values, depending on the record
+ */
+extern void DCBSLog_Record( uint8 id, uint16 a, uint32 b );
+
+/*
+ * DCBSLog_Show - Show the oldest record waiting on the display.
+ *
+ *    returns TRUE while there are more
+ */
+extern uint8 DCBSLog_Show( void );
+
+#endif // (DCBS_LOG == TRUE)
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_LOG_H */
@@ -0,0 +1,151 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Pool.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the block pool. Storage the application
+                  needs a varying amount of, such as queued Shooting values,
+                  comes from a fixed set of equal blocks reserved at build
+                  time, kept on a free list so taking or giving back a block
+                  is a single step. The OSAL heap is left to the stack, where
+                  days of small allocations would fragment it.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+
+#include "DSLRCameraBLEShutter_Pool.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Free list links, a taken block links to POOL_TAKEN
+#define POOL_END                            0xFF
+#define POOL_TAKEN                          0xFE
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint8 poolBlocks[DCBS_POOL_BLOCKS][DCBS_POOL_BLOCK_LEN];
+static uint8 poolNext[DCBS_POOL_BLOCKS];
+static uint8 poolFree = POOL_END;
+
+static uint8 poolInUse = 0;
+static uint8 poolHighWater = 0;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSPool_Init
+ *
+ * @brief   Put every block on the free list.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSPool_Init( void )
+{
+    uint8 i;
+
+    for ( i = 0; i < DCBS_POOL_BLOCKS; i++ )
+    {
+        poolNext[i] = (i + 1 < DCBS_POOL_BLOCKS) ? i + 1 : POOL_END;
+    }
+    poolFree = 0;
+    poolInUse = 0;
+}
+
+/*********************************************************************
+ * @fn      DCBSPool_Alloc
+ *
+ * @brief   Take the block at the head of the free list.
+ *
+ * @param   none
+ *
+ * @return  the block, or NULL when all are taken
+ */
+uint8 *DCBSPool_Alloc( void )
+{
+    uint8 index = poolFree;
+
+    if ( index == POOL_END )
+    {
+        return ( NULL );
+    }
+
+    poolFree = poolNext[index];
+    poolNext[index] = POOL_TAKEN;
+
+    if ( ++poolInUse > poolHighWater )
+    {
+        poolHighWater = poolInUse;
+    }
+
+    return ( poolBlocks[index] );
+}
+
+/*********************************************************************
+ * @fn      DCBSPool_Free
+ *
+ * @brief   Put a block back at the head of the free list. A pointer
+ *          that isn't a taken block is ignored.
+ *
+ * @param   pBlock - block from DCBSPool_Alloc
+ *
+ * @return  none
+ */
+void DCBSPool_Free( uint8 *pBlock )
+{
+    uint16 offset = (uint16)(pBlock - poolBlocks[0]);
+    uint8 index = (uint8)(offset / DCBS_POOL_BLOCK_LEN);
+
+    if ( pBlock < poolBlocks[0] || index >= DCBS_POOL_BLOCKS ||
+         (offset % DCBS_POOL_BLOCK_LEN) != 0 || poolNext[index] != POOL_TAKEN )
+    {
+        return;
+    }
+
+    poolNext[index] = poolFree;
+    poolFree = index;
+    poolInUse--;
+}
+
+/*********************************************************************
+ * @fn      DCBSPool_InUse
+ *
+ * @brief   Get the number of blocks taken.
+ *
+ * @param   none
+ *
+ * @return  blocks taken
+ */
+uint8 DCBSPool_InUse( void )
+{
+    return ( poolInUse );
+}
+
+/*********************************************************************
+ * @fn      DCBSPool_HighWater
+ *
+ * @brief   Get the most blocks taken at once since reset.
+ *
+ * @param   none
+ *
+ * @return  high-water mark in blocks
+ */
+uint8 DCBSPool_HighWater( void )
+{
+    return ( poolHighWater );
+}
+
+/*********************************************************************
+ *********************************************************************/
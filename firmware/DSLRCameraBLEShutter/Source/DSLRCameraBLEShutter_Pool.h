@@ -0,0 +1,80 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Pool.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the block pool definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_POOL_H
+#define DSLRCAMERABLESHUTTER_POOL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Bytes in a block, room for a Shooting value or a command
+#define DCBS_POOL_BLOCK_LEN                 24
+
+// Blocks reserved. They come out of static RAM, not the INT_HEAP_LEN heap
+// the stack allocates from, so the application never takes heap of its own.
+#ifndef DCBS_POOL_BLOCKS
+#define DCBS_POOL_BLOCKS                    4
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSPool_Init - Put every block on the free list.
+ */
+extern void DCBSPool_Init( void );
+
+/*
+ * DCBSPool_Alloc - Take a block off the free list.
+ *
+ *    returns the block, DCBS_POOL_BLOCK_LEN bytes, or NULL when all are taken
+ */
+extern uint8 *DCBSPool_Alloc( void );
+
+/*
+ * DCBSPool_Free - Put a block back on the free list.
+ *
+ *    pBlock - block from DCBSPool_Alloc
+ */
+extern void DCBSPool_Free( uint8 *pBlock );
+
+/*
+ * DCBSPool_InUse - Get the number of blocks taken.
+ */
+extern uint8 DCBSPool_InUse( void );
+
+/*
+ * DCBSPool_HighWater - Get the most blocks ever taken at once since reset.
+ */
+extern uint8 DCBSPool_HighWater( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_POOL_H */
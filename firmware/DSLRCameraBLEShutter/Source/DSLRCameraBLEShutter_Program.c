@@ -0,0 +1,439 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Program.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the shot sequence program interpreter. A program
+                  is uploaded once and run from the application task, so a sequence
+                  keeps going after the phone disconnects.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+
+#include "DSLRCameraBLEShutter_Program.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Read a little endian 32-bit operand
+#define PROGRAM_IMM32( p )  BUILD_UINT32( (p)[0], (p)[1], (p)[2], (p)[3] )
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define PROGRAM_NUM_OPS                     ( DCBS_OP_PROGRESS + 1 )
+
+// Instruction length (opcode + operands) indexed by opcode
+static CONST uint8 programOpLen[PROGRAM_NUM_OPS] =
+{
+    1,  // END
+    1,  // FOCUS_ON
+    1,  // FOCUS_OFF
+    1,  // SHUTTER_ON
+    1,  // SHUTTER_OFF
+    5,  // WAIT imm32
+    2,  // WAIT_VAR reg
+    6,  // SET_VAR reg imm32
+    6,  // ADD_VAR reg imm32
+    3,  // SHL_VAR reg n
+    3,  // SHR_VAR reg n
+    3,  // LOOP reg addr
+    2,  // JUMP addr
+    1,  // MARK
+    5,  // WAIT_MARK imm32
+    1   // PROGRESS
+};
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static dcbsProgramCBs_t *program_AppCBs = NULL;
+
+static uint8  programCode[DCBS_PROGRAM_MAX_LEN];
+static uint8  programLen      = 0;
+static uint8  programPC       = 0;
+static uint8  programRunning  = FALSE;
+static uint32 programVars[DCBS_PROGRAM_NUM_VARS];
+static uint32 programAnchor   = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 programValidate( uint8 *pCode, uint8 len );
+static void programLines( uint8 lines, uint8 active );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSProgram_RegisterCBs
+ *
+ * @brief   Register the callbacks used to drive outputs.
+ *
+ * @param   pCBs - pointer to callbacks
+ *
+ * @return  none
+ */
+void DCBSProgram_RegisterCBs( dcbsProgramCBs_t *pCBs )
+{
+    program_AppCBs = pCBs;
+}
+
+/*********************************************************************
+ * @fn      DCBSProgram_Load
+ *
+ * @brief   Validate and load a program. Every instruction, operand and
+ *          jump target is checked here so DCBSProgram_Run never has to
+ *          bounds check again.
+ *
+ * @param   pCode - program bytes
+ * @param   len - program length
+ *
+ * @return  SUCCESS, bleInvalidRange or INVALIDPARAMETER
+ */
+bStatus_t DCBSProgram_Load( uint8 *pCode, uint8 len )
+{
+    if ( len == 0 || len > DCBS_PROGRAM_MAX_LEN )
+    {
+        return ( bleInvalidRange );
+    }
+
+    if ( !programValidate( pCode, len ) )
+    {
+        return ( INVALIDPARAMETER );
+    }
+
+    VOID osal_memcpy( programCode, pCode, len );
+    VOID osal_memset( programVars, 0, sizeof ( programVars ) );
+    programLen = len;
+    programPC = 0;
+    programAnchor = 0;
+    programRunning = TRUE;
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSProgram_Stop
+ *
+ * @brief   Stop the running program. Outputs are left to the caller.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSProgram_Stop( void )
+{
+    programRunning = FALSE;
+}
+
+/*********************************************************************
+ * @fn      DCBSProgram_Running
+ *
+ * @brief   Check whether a program is running.
+ *
+ * @param   none
+ *
+ * @return  TRUE while a loaded program hasn't ended
+ */
+uint8 DCBSProgram_Running( void )
+{
+    return ( programRunning );
+}
+
+/*********************************************************************
+ * @fn      DCBSProgram_SaveState
+ *
+ * @brief   Capture the execution state of the running program. The
+ *          MARK anchor is stored relative to now since the clock
+ *          restarts from zero after a reset.
+ *
+ * @param   now - current clock (ms)
+ * @param   pState - filled with the state
+ *
+ * @return  none
+ */
+void DCBSProgram_SaveState( uint32 now, dcbsProgramState_t *pState )
+{
+    pState->pc = programPC;
+    pState->anchorOffset = (int32)(programAnchor - now);
+    VOID osal_memcpy( pState->vars, programVars, sizeof ( programVars ) );
+}
+
+/*********************************************************************
+ * @fn      DCBSProgram_RestoreState
+ *
+ * @brief   Continue the loaded program from a saved state. The program
+ *          counter must land on an instruction of the loaded program.
+ *
+ * @param   now - current clock (ms)
+ * @param   pState - state from DCBSProgram_SaveState
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t DCBSProgram_RestoreState( uint32 now, dcbsProgramState_t *pState )
+{
+    uint8 pc;
+
+    // Walk the program, pc == programLen is the same as END
+    for ( pc = 0; pc < pState->pc; pc += programOpLen[programCode[pc]] )
+    {
+        if ( pc >= programLen )
+        {
+            return ( INVALIDPARAMETER );
+        }
+    }
+
+    if ( pc != pState->pc )
+    {
+        return ( INVALIDPARAMETER );
+    }
+
+    programPC = pState->pc;
+    programAnchor = now + (uint32)pState->anchorOffset;
+    VOID osal_memcpy( programVars, pState->vars, sizeof ( programVars ) );
+    programRunning = TRUE;
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSProgram_Run
+ *
+ * @brief   Execute instructions until the program waits, spends its
+ *          step budget or ends.
+ *
+ * @param   now - current clock (ms)
+ * @param   pWait - wait in ms when DCBS_PROGRAM_WAIT is returned
+ *
+ * @return  DCBS_PROGRAM_WAIT, DCBS_PROGRAM_YIELD, DCBS_PROGRAM_DONE
+ *          or DCBS_PROGRAM_ERROR
+ */
+uint8 DCBSProgram_Run( uint32 now, uint32 *pWait )
+{
+    uint8 steps;
+
+    if ( !programRunning )
+    {
+        return ( DCBS_PROGRAM_DONE );
+    }
+
+    for ( steps = 0; steps < DCBS_PROGRAM_STEP_BUDGET; steps++ )
+    {
+        uint8 *pInst;
+        uint8 op;
+
+        // Running off the end is the same as END
+        if ( programPC >= programLen )
+        {
+            programRunning = FALSE;
+            return ( DCBS_PROGRAM_DONE );
+        }
+
+        pInst = programCode + programPC;
+        op = pInst[0];
+        programPC += programOpLen[op];
+
+        switch ( op )
+        {
+            case DCBS_OP_END:
+                programRunning = FALSE;
+                return ( DCBS_PROGRAM_DONE );
+
+            case DCBS_OP_FOCUS_ON:
+                programLines( DCBS_PROGRAM_LINE_FOCUS, TRUE );
+                break;
+
+            case DCBS_OP_FOCUS_OFF:
+                programLines( DCBS_PROGRAM_LINE_FOCUS, FALSE );
+                break;
+
+            case DCBS_OP_SHUTTER_ON:
+                programLines( DCBS_PROGRAM_LINE_SHUTTER, TRUE );
+                break;
+
+            case DCBS_OP_SHUTTER_OFF:
+                programLines( DCBS_PROGRAM_LINE_SHUTTER, FALSE );
+                break;
+
+            case DCBS_OP_WAIT:
+                *pWait = PROGRAM_IMM32( pInst + 1 );
+                return ( DCBS_PROGRAM_WAIT );
+
+            case DCBS_OP_WAIT_VAR:
+                *pWait = programVars[pInst[1]];
+                return ( DCBS_PROGRAM_WAIT );
+
+            case DCBS_OP_SET_VAR:
+                programVars[pInst[1]] = PROGRAM_IMM32( pInst + 2 );
+                break;
+
+            case DCBS_OP_ADD_VAR:
+                programVars[pInst[1]] += PROGRAM_IMM32( pInst + 2 );
+                break;
+
+            case DCBS_OP_SHL_VAR:
+                programVars[pInst[1]] <<= pInst[2];
+                break;
+
+            case DCBS_OP_SHR_VAR:
+                programVars[pInst[1]] >>= pInst[2];
+                break;
+
+            case DCBS_OP_LOOP:
+                if ( --programVars[pInst[1]] != 0 )
+                {
+                    programPC = pInst[2];
+                }
+                break;
+
+            case DCBS_OP_JUMP:
+                programPC = pInst[1];
+                break;
+
+            case DCBS_OP_MARK:
+                programAnchor = now;
+                break;
+
+            case DCBS_OP_WAIT_MARK:
+                {
+                    int32 remaining;
+
+                    programAnchor += PROGRAM_IMM32( pInst + 1 );
+                    remaining = (int32)(programAnchor - now);
+
+                    // Already late, carry on so the grid isn't shifted
+                    if ( remaining > 0 )
+                    {
+                        *pWait = (uint32)remaining;
+                        return ( DCBS_PROGRAM_WAIT );
+                    }
+                }
+                break;
+
+            case DCBS_OP_PROGRESS:
+                if ( program_AppCBs && program_AppCBs->pfnProgress )
+                {
+                    program_AppCBs->pfnProgress();
+                }
+                break;
+
+            default:
+                // should not reach here, programValidate rejects it
+                programRunning = FALSE;
+                return ( DCBS_PROGRAM_ERROR );
+        }
+    }
+
+    return ( DCBS_PROGRAM_YIELD );
+}
+
+/*********************************************************************
+ * @fn      programValidate
+ *
+ * @brief   Check that every instruction is known and complete, every
+ *          variable index is in range and every jump lands on the start
+ *          of an instruction.
+ *
+ * @param   pCode - program bytes
+ * @param   len - program length
+ *
+ * @return  TRUE if the program is well formed
+ */
+static uint8 programValidate( uint8 *pCode, uint8 len )
+{
+    // Bit set for every offset an instruction starts at, kept off the stack
+    static uint8 starts[(DCBS_PROGRAM_MAX_LEN + 7) / 8];
+    uint8 pc;
+
+    VOID osal_memset( starts, 0, sizeof ( starts ) );
+
+    for ( pc = 0; pc < len; pc += programOpLen[pCode[pc]] )
+    {
+        uint8 op = pCode[pc];
+
+        if ( op >= PROGRAM_NUM_OPS || (uint16)pc + programOpLen[op] > len )
+        {
+            return ( FALSE );
+        }
+
+        switch ( op )
+        {
+            case DCBS_OP_WAIT_VAR:
+            case DCBS_OP_SET_VAR:
+            case DCBS_OP_ADD_VAR:
+            case DCBS_OP_LOOP:
+                if ( pCode[pc + 1] >= DCBS_PROGRAM_NUM_VARS )
+                {
+                    return ( FALSE );
+                }
+                break;
+
+            case DCBS_OP_SHL_VAR:
+            case DCBS_OP_SHR_VAR:
+                // A shift as wide as the variable is undefined
+                if ( pCode[pc + 1] >= DCBS_PROGRAM_NUM_VARS || pCode[pc + 2] >= 32 )
+                {
+                    return ( FALSE );
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        starts[pc >> 3] |= BV( pc & 0x07 );
+    }
+
+    // Second pass, jump targets must be instruction starts
+    for ( pc = 0; pc < len; pc += programOpLen[pCode[pc]] )
+    {
+        uint8 target;
+
+        if ( pCode[pc] == DCBS_OP_LOOP )
+        {
+            target = pCode[pc + 2];
+        }
+        else if ( pCode[pc] == DCBS_OP_JUMP )
+        {
+            target = pCode[pc + 1];
+        }
+        else
+        {
+            continue;
+        }
+
+        if ( target >= len || !(starts[target >> 3] & BV( target & 0x07 )) )
+        {
+            return ( FALSE );
+        }
+    }
+
+    return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      programLines
+ *
+ * @brief   Forward a line change to the application.
+ *
+ * @param   lines - DCBS_PROGRAM_LINE_SHUTTER and/or DCBS_PROGRAM_LINE_FOCUS
+ * @param   active - TRUE to drive the lines active
+ *
+ * @return  none
+ */
+static void programLines( uint8 lines, uint8 active )
+{
+    if ( program_AppCBs && program_AppCBs->pfnLines )
+    {
+        program_AppCBs->pfnLines( lines, active );
+    }
+}
+
+/*********************************************************************
+ *********************************************************************/
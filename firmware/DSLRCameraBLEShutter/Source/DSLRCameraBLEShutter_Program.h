@@ -0,0 +1,154 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Program.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the shot sequence program interpreter
+                  definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_PROGRAM_H
+#define DSLRCAMERABLESHUTTER_PROGRAM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Largest program the interpreter holds, jump targets are one byte
+#define DCBS_PROGRAM_MAX_LEN                240
+
+// Number of 32-bit program variables
+#define DCBS_PROGRAM_NUM_VARS               4
+
+// Instructions executed per DCBSProgram_Run call before yielding
+#define DCBS_PROGRAM_STEP_BUDGET            32
+
+// Opcodes, operands follow little endian
+// (reg = 1 byte variable index, imm32 = 4 bytes, addr = 1 byte program offset)
+#define DCBS_OP_END                         0x00    // stop the program
+#define DCBS_OP_FOCUS_ON                    0x01
+#define DCBS_OP_FOCUS_OFF                   0x02
+#define DCBS_OP_SHUTTER_ON                  0x03
+#define DCBS_OP_SHUTTER_OFF                 0x04
+#define DCBS_OP_WAIT                        0x05    // imm32: wait ms
+#define DCBS_OP_WAIT_VAR                    0x06    // reg: wait var ms
+#define DCBS_OP_SET_VAR                     0x07    // reg imm32: var = imm
+#define DCBS_OP_ADD_VAR                     0x08    // reg imm32: var += imm (two's complement)
+#define DCBS_OP_SHL_VAR                     0x09    // reg n: var <<= n (n < 32), one stop brighter per bit
+#define DCBS_OP_SHR_VAR                     0x0A    // reg n: var >>= n (n < 32)
+#define DCBS_OP_LOOP                        0x0B    // reg addr: if --var != 0 jump to addr
+#define DCBS_OP_JUMP                        0x0C    // addr: jump
+#define DCBS_OP_MARK                        0x0D    // anchor = now
+#define DCBS_OP_WAIT_MARK                   0x0E    // imm32: anchor += imm, wait until anchor
+#define DCBS_OP_PROGRESS                    0x0F    // count one frame
+
+// Lines passed to the lines callback
+#define DCBS_PROGRAM_LINE_SHUTTER           0x01
+#define DCBS_PROGRAM_LINE_FOCUS             0x02
+
+// DCBSProgram_Run results
+#define DCBS_PROGRAM_WAIT                   0       // call again after *pWait ms
+#define DCBS_PROGRAM_YIELD                  1       // step budget spent, call again soon
+#define DCBS_PROGRAM_DONE                   2       // END reached or no program
+#define DCBS_PROGRAM_ERROR                  3       // bad state, program stopped
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Drive a line active (TRUE) or released (FALSE)
+typedef void (*dcbsProgramLines_t)( uint8 lines, uint8 active );
+
+// One frame completed
+typedef void (*dcbsProgramProgress_t)( void );
+
+typedef struct
+{
+    dcbsProgramLines_t      pfnLines;       // Called on FOCUS/SHUTTER ops
+    dcbsProgramProgress_t   pfnProgress;    // Called on PROGRESS op
+} dcbsProgramCBs_t;
+
+// Execution state of a running program, enough to continue it after a reset
+typedef struct
+{
+    uint8   pc;
+    int32   anchorOffset;                   // MARK anchor relative to the save time
+    uint32  vars[DCBS_PROGRAM_NUM_VARS];
+} dcbsProgramState_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSProgram_RegisterCBs - Register the output callbacks.
+ */
+extern void DCBSProgram_RegisterCBs( dcbsProgramCBs_t *pCBs );
+
+/*
+ * DCBSProgram_Load - Validate and load a program, ready to run from
+ *          offset 0 with all variables cleared.
+ *
+ *    pCode - program bytes
+ *    len - program length
+ *
+ *    returns SUCCESS, bleInvalidRange on a bad length or INVALIDPARAMETER
+ *    on a malformed program (nothing is loaded then)
+ */
+extern bStatus_t DCBSProgram_Load( uint8 *pCode, uint8 len );
+
+/*
+ * DCBSProgram_Stop - Stop the running program.
+ */
+extern void DCBSProgram_Stop( void );
+
+/*
+ * DCBSProgram_Running - TRUE while a loaded program hasn't ended.
+ */
+extern uint8 DCBSProgram_Running( void );
+
+/*
+ * DCBSProgram_SaveState - Capture the execution state of the running program.
+ *
+ *    now - current clock (ms)
+ *    pState - filled with the state
+ */
+extern void DCBSProgram_SaveState( uint32 now, dcbsProgramState_t *pState );
+
+/*
+ * DCBSProgram_RestoreState - Continue the loaded program from a saved state.
+ *
+ *    now - current clock (ms)
+ *    pState - state from DCBSProgram_SaveState
+ *
+ *    returns SUCCESS or INVALIDPARAMETER if the state doesn't fit the program
+ */
+extern bStatus_t DCBSProgram_RestoreState( uint32 now, dcbsProgramState_t *pState );
+
+/*
+ * DCBSProgram_Run - Execute until the program waits, yields or ends.
+ *
+ *    now - current clock (ms), used by MARK/WAIT_MARK
+ *    pWait - set to the wait in ms on DCBS_PROGRAM_WAIT
+ */
+extern uint8 DCBSProgram_Run( uint32 now, uint32 *pWait );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_PROGRAM_H */
@@ -0,0 +1,249 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Pulse.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the shutter pulse engine. Timer 1 times the
+                  pulse width and its compare interrupt releases the lines, so the
+                  trailing edge doesn't wait behind other OSAL tasks.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_PwrMgr.h"
+#include "hal_mcu.h"
+
+#include "DSLRCameraBLEShutter_Pulse.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// log2( DCBS_PULSE_TICK_US )
+#define PULSE_TICK_SHIFT                    2
+
+// T1CTL: tick / 128, free running
+#define T1CTL_DIV_128                       0x0C
+#define T1CTL_MODE_FREE                     0x01
+#define T1CTL_MODE_SUSPEND                  0x00
+
+// T1CCTL0: compare mode with interrupt
+#define T1CCTL_IM                           0x40
+#define T1CCTL_MODE_COMPARE                 0x04
+
+// T1STAT: channel 0 compare flag
+#define T1STAT_CH0IF                        0x01
+
+// TIMIF: Timer 1 overflow interrupt mask
+#define TIMIF_T1OVFIM                       0x40
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint8 pulse_TaskID = INVALID_TASK_ID;
+static uint16 pulse_DoneEvent = 0;
+
+// Port 0 lines held active by the running pulse, 0 when idle
+static volatile uint8 pulseLines = 0;
+
+// Lines the interrupt released that the task hasn't collected yet
+static volatile uint8 pulseReleased = 0;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSPulse_Init
+ *
+ * @brief   Configure Timer 1 channel 0 for compare interrupts. The
+ *          timer stays suspended until a pulse is started.
+ *
+ * @param   taskId - task to notify when a pulse ends
+ * @param   doneEvent - event raised on that task after the trailing edge
+ *
+ * @return  none
+ */
+void DCBSPulse_Init( uint8 taskId, uint16 doneEvent )
+{
+    pulse_TaskID = taskId;
+    pulse_DoneEvent = doneEvent;
+
+    T1CTL = T1CTL_MODE_SUSPEND;
+    T1CCTL0 = T1CCTL_IM | T1CCTL_MODE_COMPARE;
+    TIMIF &= ~TIMIF_T1OVFIM;
+    T1STAT = 0;
+    T1IF = 0;
+    T1IE = 1;
+}
+
+/*********************************************************************
+ * @fn      DCBSPulse_Start
+ *
+ * @brief   Drive lines active (low) now and release them from the
+ *          Timer 1 compare interrupt after widthUs. The power manager
+ *          is held off while the pulse runs since Timer 1 stops in
+ *          PM2/PM3.
+ *
+ * @param   lines - bit mask of port 0 outputs to pulse
+ * @param   widthUs - pulse width in microseconds
+ *
+ * @return  SUCCESS, bleInvalidRange or bleAlreadyInRequestedMode
+ */
+bStatus_t DCBSPulse_Start( uint8 lines, uint32 widthUs )
+{
+    halIntState_t intState;
+    uint16 ticks;
+
+    if ( widthUs > DCBS_PULSE_MAX_US )
+    {
+        return ( bleInvalidRange );
+    }
+
+    if ( pulseLines )
+    {
+        return ( bleAlreadyInRequestedMode );
+    }
+
+    ticks = (uint16)( (widthUs + (DCBS_PULSE_TICK_US / 2)) >> PULSE_TICK_SHIFT );
+    if ( ticks == 0 )
+    {
+        ticks = 1;
+    }
+
+    VOID osal_pwrmgr_task_state( pulse_TaskID, PWRMGR_HOLD );
+
+    HAL_ENTER_CRITICAL_SECTION( intState );
+
+    T1CTL = T1CTL_MODE_SUSPEND;
+    T1CNTL = 0;                     // any write clears the counter
+    T1CC0L = LO_UINT16( ticks );
+    T1CC0H = HI_UINT16( ticks );    // high byte write latches the compare value
+    T1STAT = 0;
+    T1IF = 0;
+
+    pulseLines = lines;
+    P0 &= ~lines;
+    T1CTL = T1CTL_DIV_128 | T1CTL_MODE_FREE;
+
+    HAL_EXIT_CRITICAL_SECTION( intState );
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSPulse_Cancel
+ *
+ * @brief   Release a running pulse immediately. The done event is not
+ *          raised.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSPulse_Cancel( void )
+{
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );
+
+    T1CTL = T1CTL_MODE_SUSPEND;
+    T1STAT = 0;
+    T1IF = 0;
+    P0 |= pulseLines;
+    pulseLines = 0;
+
+    HAL_EXIT_CRITICAL_SECTION( intState );
+
+    VOID osal_pwrmgr_task_state( pulse_TaskID, PWRMGR_CONSERVE );
+}
+
+/*********************************************************************
+ * @fn      DCBSPulse_Done
+ *
+ * @brief   Collect the pulses the interrupt ended, called by the task
+ *          on the done event. A new pulse can start, and even end,
+ *          while the event waits behind others, so the released lines
+ *          are accumulated rather than taken from the running pulse.
+ *          Lets the power manager sleep again unless a pulse is still
+ *          running.
+ *
+ * @param   none
+ *
+ * @return  lines released since the last call
+ */
+uint8 DCBSPulse_Done( void )
+{
+    halIntState_t intState;
+    uint8 released;
+    uint8 running;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );
+
+    released = pulseReleased;
+    pulseReleased = 0;
+    running = pulseLines;
+
+    HAL_EXIT_CRITICAL_SECTION( intState );
+
+    if ( running == 0 )
+    {
+        VOID osal_pwrmgr_task_state( pulse_TaskID, PWRMGR_CONSERVE );
+    }
+
+    return ( released );
+}
+
+/*********************************************************************
+ * @fn      DCBSPulse_Busy
+ *
+ * @brief   Check whether a pulse is in progress.
+ *
+ * @param   none
+ *
+ * @return  TRUE while a pulse is running
+ */
+uint8 DCBSPulse_Busy( void )
+{
+    return ( pulseLines != 0 );
+}
+
+/*********************************************************************
+ * @fn      dcbsPulseTimer1Isr
+ *
+ * @brief   Timer 1 interrupt. Releases the pulse lines on the channel 0
+ *          compare and hands the rest of the work to the owning task.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+HAL_ISR_FUNCTION( dcbsPulseTimer1Isr, T1_VECTOR )
+{
+    if ( T1STAT & T1STAT_CH0IF )
+    {
+        P0 |= pulseLines;
+        T1CTL = T1CTL_MODE_SUSPEND;
+
+        // The power manager mask is not safe to touch from here, the
+        // task gives the hold back in DCBSPulse_Done
+        if ( pulseLines )
+        {
+            pulseReleased |= pulseLines;
+            pulseLines = 0;
+            VOID osal_set_event( pulse_TaskID, pulse_DoneEvent );
+        }
+    }
+
+    // Clear module flags before the CPU flag
+    T1STAT = 0;
+    T1IF = 0;
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,85 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Pulse.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the hardware timer backed shutter pulse engine
+                  definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_PULSE_H
+#define DSLRCAMERABLESHUTTER_PULSE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Timer 1 runs from the 32 MHz tick divided by 128, one tick every 4us
+#define DCBS_PULSE_TICK_US                  4
+
+// Longest pulse the 16-bit compare can time in one go (~262ms)
+#define DCBS_PULSE_MAX_US                   ( 0xFFFFUL * DCBS_PULSE_TICK_US )
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSPulse_Init - Prepare Timer 1 for pulse generation.
+ *
+ *    taskId - task to notify when a pulse ends
+ *    doneEvent - event raised on that task after the trailing edge
+ */
+extern void DCBSPulse_Init( uint8 taskId, uint16 doneEvent );
+
+/*
+ * DCBSPulse_Start - Drive lines active (low) now and release them from
+ *          the timer compare interrupt after widthUs.
+ *
+ *    lines - bit mask of port 0 outputs to pulse
+ *    widthUs - pulse width in microseconds, at most DCBS_PULSE_MAX_US
+ *
+ *    returns SUCCESS, bleInvalidRange if the width can't be timed or
+ *    bleAlreadyInRequestedMode if a pulse is already running
+ */
+extern bStatus_t DCBSPulse_Start( uint8 lines, uint32 widthUs );
+
+/*
+ * DCBSPulse_Cancel - Release a running pulse immediately without
+ *          raising the done event.
+ */
+extern void DCBSPulse_Cancel( void );
+
+/*
+ * DCBSPulse_Done - Collect the pulses the interrupt ended, from the task
+ *          on the done event.
+ *
+ *    returns the lines released since the last call, a pulse started
+ *    and ended before the task got to the event included
+ */
+extern uint8 DCBSPulse_Done( void );
+
+/*
+ * DCBSPulse_Busy - TRUE while a pulse is in progress.
+ */
+extern uint8 DCBSPulse_Busy( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_PULSE_H */
@@ -0,0 +1,290 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Ramp.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the exposure ramp curve. A curve is uploaded
+                  once and walked frame by frame with fixed-point stepping, the
+                  only division being one per segment.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+
+#include "DSLRCameraBLEShutter_Ramp.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Fields of point n
+#define RAMP_POINT( n )         ( rampCurve + DCBS_RAMP_HDR_LEN + (n) * DCBS_RAMP_POINT_LEN )
+#define RAMP_FRAMES( p )        BUILD_UINT16( (p)[0], (p)[1] )
+#define RAMP_SHAPE( p )         ( (p)[2] )
+#define RAMP_EXPOSURE( p )      BUILD_UINT32( (p)[3], (p)[4], (p)[5], (p)[6] )
+#define RAMP_INTERVAL( p )      BUILD_UINT32( (p)[7], (p)[8], (p)[9], (p)[10] )
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint8 rampCurve[DCBS_RAMP_MAX_LEN];
+static uint8 rampPoints = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void rampSegment( dcbsRampState_t *pState, uint8 point );
+static uint16 rampShape( uint8 shape, uint16 frac );
+static uint32 rampLerp( uint32 from, uint32 to, uint16 frac );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSRamp_Load
+ *
+ * @brief   Validate and load a curve. Every segment must span at least
+ *          one frame and every exposure must be a timed one.
+ *
+ * @param   pCurve - curve bytes
+ * @param   len - curve length
+ *
+ * @return  SUCCESS, bleInvalidRange or INVALIDPARAMETER
+ */
+bStatus_t DCBSRamp_Load( uint8 *pCurve, uint8 len )
+{
+    uint8 points;
+    uint8 n;
+
+    if ( len < DCBS_RAMP_HDR_LEN + DCBS_RAMP_POINT_LEN || len > DCBS_RAMP_MAX_LEN ||
+         (len - DCBS_RAMP_HDR_LEN) % DCBS_RAMP_POINT_LEN != 0 )
+    {
+        return ( bleInvalidRange );
+    }
+
+    points = (len - DCBS_RAMP_HDR_LEN) / DCBS_RAMP_POINT_LEN;
+
+    for ( n = 0; n < points; n++ )
+    {
+        uint8 *pPoint = pCurve + DCBS_RAMP_HDR_LEN + n * DCBS_RAMP_POINT_LEN;
+        uint32 exposure = RAMP_EXPOSURE( pPoint );
+
+        if ( exposure == 0 || exposure == 0xFFFFFFFF ||
+             RAMP_SHAPE( pPoint ) > DCBS_RAMP_SHAPE_EASED ||
+             (n != 0 && RAMP_FRAMES( pPoint ) == 0) )
+        {
+            return ( INVALIDPARAMETER );
+        }
+    }
+
+    VOID osal_memcpy( rampCurve, pCurve, len );
+    rampPoints = points;
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSRamp_Loaded
+ *
+ * @brief   Check whether a curve is loaded.
+ *
+ * @param   none
+ *
+ * @return  TRUE once a curve has been loaded
+ */
+uint8 DCBSRamp_Loaded( void )
+{
+    return ( rampPoints != 0 );
+}
+
+/*********************************************************************
+ * @fn      DCBSRamp_Seek
+ *
+ * @brief   Move a state to a frame of the curve. Used when a run starts
+ *          or resumes; frames in between are never stepped through.
+ *
+ * @param   pState - state to set
+ * @param   frame - frame number, 0 is the first point
+ *
+ * @return  none
+ */
+void DCBSRamp_Seek( dcbsRampState_t *pState, uint16 frame )
+{
+    uint8 point;
+
+    for ( point = 1; point < rampPoints; point++ )
+    {
+        uint16 frames = RAMP_FRAMES( RAMP_POINT( point ) );
+
+        if ( frame < frames )
+        {
+            break;
+        }
+        frame -= frames;
+    }
+
+    rampSegment( pState, point );
+    if ( point < rampPoints )
+    {
+        pState->pos = pState->step * frame;
+    }
+}
+
+/*********************************************************************
+ * @fn      DCBSRamp_Advance
+ *
+ * @brief   Move a state on by one frame. Within a segment this is a
+ *          single addition.
+ *
+ * @param   pState - state to advance
+ *
+ * @return  none
+ */
+void DCBSRamp_Advance( dcbsRampState_t *pState )
+{
+    uint32 pos;
+
+    if ( pState->point >= rampPoints )
+    {
+        return;
+    }
+
+    pos = pState->pos + pState->step;
+
+    // Wrapped past the end of the segment
+    if ( pos < pState->pos || pState->step == 0 )
+    {
+        rampSegment( pState, pState->point + 1 );
+    }
+    else
+    {
+        pState->pos = pos;
+    }
+}
+
+/*********************************************************************
+ * @fn      DCBSRamp_Value
+ *
+ * @brief   Interpolate the curve at a state.
+ *
+ * @param   pState - position on the curve
+ * @param   pExposure - set to the exposure
+ * @param   pInterval - set to the interval when the curve ramps it
+ *
+ * @return  none
+ */
+void DCBSRamp_Value( dcbsRampState_t *pState, uint32 *pExposure, uint32 *pInterval )
+{
+    uint8 *pTo;
+
+    if ( rampPoints == 0 )
+    {
+        return;
+    }
+
+    if ( pState->point >= rampPoints )
+    {
+        pTo = RAMP_POINT( rampPoints - 1 );
+        *pExposure = RAMP_EXPOSURE( pTo );
+        if ( rampCurve[0] & DCBS_RAMP_FLAG_INTERVAL )
+        {
+            *pInterval = RAMP_INTERVAL( pTo );
+        }
+    }
+    else
+    {
+        uint8 *pFrom = RAMP_POINT( pState->point - 1 );
+        uint16 frac;
+
+        pTo = RAMP_POINT( pState->point );
+        frac = rampShape( RAMP_SHAPE( pTo ), (uint16)(pState->pos >> 16) );
+
+        *pExposure = rampLerp( RAMP_EXPOSURE( pFrom ), RAMP_EXPOSURE( pTo ), frac );
+        if ( rampCurve[0] & DCBS_RAMP_FLAG_INTERVAL )
+        {
+            *pInterval = rampLerp( RAMP_INTERVAL( pFrom ), RAMP_INTERVAL( pTo ), frac );
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      rampSegment
+ *
+ * @brief   Start the segment ending at a point. The per-frame step is
+ *          worked out here, once per segment.
+ *
+ * @param   pState - state to set
+ * @param   point - point the segment ends at, rampPoints past the end
+ *
+ * @return  none
+ */
+static void rampSegment( dcbsRampState_t *pState, uint8 point )
+{
+    pState->point = point;
+    pState->pos = 0;
+    pState->step = 0;
+
+    if ( point < rampPoints )
+    {
+        uint16 frames = RAMP_FRAMES( RAMP_POINT( point ) );
+
+        // A one frame segment has nothing in between, step 0 moves on next frame
+        if ( frames > 1 )
+        {
+            pState->step = 0xFFFFFFFF / frames + 1;
+        }
+    }
+}
+
+/*********************************************************************
+ * @fn      rampShape
+ *
+ * @brief   Map a linear position within a segment onto its shape.
+ *
+ * @param   shape - DCBS_RAMP_SHAPE_*
+ * @param   frac - linear position, 0.16 fixed point
+ *
+ * @return  shaped position, 0.16 fixed point
+ */
+static uint16 rampShape( uint8 shape, uint16 frac )
+{
+    uint32 square;
+
+    if ( shape != DCBS_RAMP_SHAPE_EASED )
+    {
+        return ( frac );
+    }
+
+    // smoothstep t^2 (3 - 2t), the second factor taken down 2 bits to stay in 32 bits
+    square = ((uint32)frac * frac) >> 16;
+    return ( (uint16)((square * ((0x30000UL - 2 * (uint32)frac) >> 2)) >> 14) );
+}
+
+/*********************************************************************
+ * @fn      rampLerp
+ *
+ * @brief   Interpolate between two values without a division or a
+ *          product wider than 32 bits.
+ *
+ * @param   from - value at 0
+ * @param   to - value at 1.0
+ * @param   frac - position, 0.16 fixed point
+ *
+ * @return  interpolated value
+ */
+static uint32 rampLerp( uint32 from, uint32 to, uint16 frac )
+{
+    uint32 delta = (to >= from) ? to - from : from - to;
+    uint32 part = (delta >> 16) * frac + (((delta & 0xFFFF) * frac) >> 16);
+
+    return ( (to >= from) ? from + part : from - part );
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,105 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Ramp.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the exposure ramp (bulb ramping) curve
+                  definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_RAMP_H
+#define DSLRCAMERABLESHUTTER_RAMP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// A curve is flags(1) followed by 1 to DCBS_RAMP_MAX_POINTS points of
+// frames(2) shape(1) exposure(4) interval(4), little endian. Frames is the
+// number of frames from the previous point to this one (ignored on the first
+// point), shape how the segment ending at this point is interpolated.
+// Exposure is in the unit of the Shooting command, interval in ms. After the
+// last point the curve holds its values.
+#define DCBS_RAMP_HDR_LEN                   1
+#define DCBS_RAMP_POINT_LEN                 11
+#define DCBS_RAMP_MAX_POINTS                16
+#define DCBS_RAMP_MAX_LEN                   ( DCBS_RAMP_HDR_LEN + DCBS_RAMP_MAX_POINTS * DCBS_RAMP_POINT_LEN )
+
+// Curve flags bit fields
+#define DCBS_RAMP_FLAG_INTERVAL             0x01    // interval follows the curve too
+
+// Segment shapes
+#define DCBS_RAMP_SHAPE_LINEAR              0x00
+#define DCBS_RAMP_SHAPE_EASED               0x01    // smoothstep, flat at both points
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Position of one channel on the curve
+typedef struct
+{
+    uint8   point;                  // point the current segment ends at
+    uint32  pos;                    // position within the segment, 0.32 fixed point
+    uint32  step;                   // pos increment per frame
+} dcbsRampState_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSRamp_Load - Validate and load a curve.
+ *
+ *    pCurve - curve bytes
+ *    len - curve length
+ *
+ *    returns SUCCESS, bleInvalidRange on a bad length or INVALIDPARAMETER
+ *    on a malformed curve (the loaded curve is kept then)
+ */
+extern bStatus_t DCBSRamp_Load( uint8 *pCurve, uint8 len );
+
+/*
+ * DCBSRamp_Loaded - TRUE once a curve has been loaded.
+ */
+extern uint8 DCBSRamp_Loaded( void );
+
+/*
+ * DCBSRamp_Seek - Move a state to a frame of the curve, frame 0 being
+ *          the first point.
+ */
+extern void DCBSRamp_Seek( dcbsRampState_t *pState, uint16 frame );
+
+/*
+ * DCBSRamp_Advance - Move a state on by one frame.
+ */
+extern void DCBSRamp_Advance( dcbsRampState_t *pState );
+
+/*
+ * DCBSRamp_Value - Get the curve values at a state.
+ *
+ *    pExposure - set to the exposure
+ *    pInterval - set to the interval when the curve ramps it, left alone
+ *                otherwise
+ */
+extern void DCBSRamp_Value( dcbsRampState_t *pState, uint32 *pExposure, uint32 *pInterval );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_RAMP_H */
@@ -0,0 +1,283 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Stats.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the energy and duty cycle accounting. The
+                  application brackets its work with Begin/End, timed on the
+                  sleep timer since it is the one clock that keeps running in
+                  PM2, and counts the radio, notification and line activity
+                  that make up the rest of the charge drawn.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "hal_mcu.h"
+#include "att.h"
+
+#include "DSLRCameraBLEShutter_Stats.h"
+#include "DSLRCameraBLEShutter_Pool.h"
+#include "DSLRCameraBLEShutter_Program.h"
+#include "DSLRCameraBLEShutter_Ramp.h"
+#include "DSLRCameraBLEShutter_Trace.h"
+#include "DSLRCameraBLEShutterService.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// The sleep timer is 24 bits wide
+#define STATS_TICK_MASK                     0x00FFFFFFUL
+
+// Static RAM set aside for data of varying size: the pool, a program, the
+// ramp curve, an upload in progress and the trace ring. Reported with the
+// pool use so a client sees what a bigger pool would compete with.
+#define STATS_FIXED_BYTES                   ( DCBS_POOL_BLOCKS * DCBS_POOL_BLOCK_LEN + \
+                                              DCBS_PROGRAM_MAX_LEN + DCBS_RAMP_MAX_LEN + \
+                                              BLESHUTTER_UPLOAD_MAX_LEN + \
+                                              DCBS_TRACE_ENTRIES * DCBS_TRACE_ENTRY_LEN )
+
+// Four connection intervals take a whole number of ms, interval * 5
+#define STATS_CONN_EVENTS_PER_PERIOD        4
+#define STATS_CONN_PERIOD_MS( interval )    ( (uint32)(interval) * 5 )
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static uint32 statsActive = 0;
+static uint32 statsCounters[DCBS_STATS_COUNTERS];
+
+// Connection interval (1.25 ms units, 0 when not connected) since
+// statsLinkSince, and the part of a connection event carried over
+static uint16 statsLinkInterval = 0;
+static uint32 statsLinkSince = 0;
+static uint16 statsLinkRest = 0;
+
+// What the Stats characteristic reads, taken at offset 0
+static uint8  statsSnapshot[BLESHUTTER_STATS_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void statsBuild( uint8 *pValue );
+static void statsLinkCount( uint32 now );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSStats_Begin
+ *
+ * @brief   Note the start of a stretch of application work.
+ *
+ * @param   none
+ *
+ * @return  sleep timer ticks
+ */
+uint32 DCBSStats_Begin( void )
+{
+    return ( DCBSStats_Ticks() );
+}
+
+/*********************************************************************
+ * @fn      DCBSStats_End
+ *
+ * @brief   Add the time since DCBSStats_Begin to the active time. Most
+ *          stretches are shorter than a tick, but they start at no
+ *          particular phase of it, so the ticks they span add up to the
+ *          time spent over many of them.
+ *
+ * @param   begin - what DCBSStats_Begin returned
+ *
+ * @return  none
+ */
+void DCBSStats_End( uint32 begin )
+{
+    statsActive += (DCBSStats_Ticks() - begin) & STATS_TICK_MASK;
+}
+
+/*********************************************************************
+ * @fn      DCBSStats_Count
+ *
+ * @brief   Add to a counter.
+ *
+ * @param   counter - DCBS_STATS_EVENTS ...
+ * @param   n - amount to add
+ *
+ * @return  none
+ */
+void DCBSStats_Count( uint8 counter, uint8 n )
+{
+    statsCounters[counter] += n;
+}
+
+/*********************************************************************
+ * @fn      DCBSStats_Link
+ *
+ * @brief   Note the connection interval in effect from now on.
+ *          Connection events are counted from the interval and the
+ *          time connected, so the link layer needn't wake the task on
+ *          every one of them. The same interval again changes nothing,
+ *          so it can be given after every event.
+ *
+ * @param   interval - connection interval (1.25 ms units), 0 when
+ *                     there is no connection
+ *
+ * @return  none
+ */
+void DCBSStats_Link( uint16 interval )
+{
+    if ( interval == statsLinkInterval )
+    {
+        return;
+    }
+
+    statsLinkCount( osal_GetSystemClock() );
+    statsLinkInterval = interval;
+    statsLinkRest = 0;
+}
+
+/*********************************************************************
+ * @fn      DCBSStats_Ticks
+ *
+ * @brief   Read the sleep timer. Reading ST0 latches ST1 and ST2, so
+ *          the bytes are read in that order with interrupts held off.
+ *
+ * @param   none
+ *
+ * @return  sleep timer ticks, 24 bits
+ */
+uint32 DCBSStats_Ticks( void )
+{
+    halIntState_t intState;
+    uint32 ticks;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );
+    ticks = ST0;
+    ticks |= (uint32)ST1 << 8;
+    ticks |= (uint32)ST2 << 16;
+    HAL_EXIT_CRITICAL_SECTION( intState );
+
+    return ( ticks );
+}
+
+/*********************************************************************
+ * @fn      DCBSStats_Read
+ *
+ * @brief   Read part of the Stats characteristic value. The value is
+ *          longer than a default ATT_MTU, so a read at offset 0 takes a
+ *          snapshot and the Read Blobs after it continue that one.
+ *
+ * @param   offset - offset of the first byte
+ * @param   pValue - filled with the value
+ * @param   pLen - set to the number of bytes filled in
+ * @param   maxLen - room in pValue
+ *
+ * @return  SUCCESS or ATT_ERR_INVALID_OFFSET
+ */
+bStatus_t DCBSStats_Read( uint16 offset, uint8 *pValue, uint8 *pLen, uint8 maxLen )
+{
+    if ( offset > BLESHUTTER_STATS_LEN )
+    {
+        *pLen = 0;
+        return ( ATT_ERR_INVALID_OFFSET );
+    }
+
+    if ( offset == 0 )
+    {
+        statsBuild( statsSnapshot );
+    }
+
+    *pLen = MIN( maxLen, BLESHUTTER_STATS_LEN - offset );
+    VOID osal_memcpy( pValue, statsSnapshot + offset, *pLen );
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      statsBuild
+ *
+ * @brief   Fill in the Stats characteristic value: uptime, active time,
+ *          the counters, the pool use and the fixed buffer sizes, each
+ *          4 bytes little endian.
+ *
+ * @param   pValue - BLESHUTTER_STATS_LEN bytes
+ *
+ * @return  none
+ */
+static void statsBuild( uint8 *pValue )
+{
+    uint32 uptime = osal_GetSystemClock();
+    uint8 i;
+
+    statsLinkCount( uptime );
+
+    pValue[0] = BREAK_UINT32( uptime, 0 );
+    pValue[1] = BREAK_UINT32( uptime, 1 );
+    pValue[2] = BREAK_UINT32( uptime, 2 );
+    pValue[3] = BREAK_UINT32( uptime, 3 );
+    pValue[4] = BREAK_UINT32( statsActive, 0 );
+    pValue[5] = BREAK_UINT32( statsActive, 1 );
+    pValue[6] = BREAK_UINT32( statsActive, 2 );
+    pValue[7] = BREAK_UINT32( statsActive, 3 );
+    pValue += 8;
+
+    for ( i = 0; i < DCBS_STATS_COUNTERS; i++ )
+    {
+        *pValue++ = BREAK_UINT32( statsCounters[i], 0 );
+        *pValue++ = BREAK_UINT32( statsCounters[i], 1 );
+        *pValue++ = BREAK_UINT32( statsCounters[i], 2 );
+        *pValue++ = BREAK_UINT32( statsCounters[i], 3 );
+    }
+
+    // Pool blocks, the high-water mark shows how close a long run came
+    // to running out
+    VOID osal_memset( pValue, 0, 16 );
+    pValue[0] = DCBSPool_InUse();
+    pValue[4] = DCBSPool_HighWater();
+    pValue[8] = DCBS_POOL_BLOCKS;
+    pValue[12] = LO_UINT16( STATS_FIXED_BYTES );
+    pValue[13] = HI_UINT16( STATS_FIXED_BYTES );
+}
+
+/*********************************************************************
+ * @fn      statsLinkCount
+ *
+ * @brief   Add the connection events since the last count at the
+ *          interval in effect. Whole periods of four events are
+ *          counted first so the multiply can't overflow, the fraction
+ *          of an event left over is carried to the next count.
+ *
+ * @param   now - current clock (ms)
+ *
+ * @return  none
+ */
+static void statsLinkCount( uint32 now )
+{
+    uint32 elapsed = now - statsLinkSince;
+    uint32 period;
+    uint32 rest;
+
+    statsLinkSince = now;
+
+    if ( statsLinkInterval == 0 )
+    {
+        return;
+    }
+
+    period = STATS_CONN_PERIOD_MS( statsLinkInterval );
+    rest = (elapsed % period) * STATS_CONN_EVENTS_PER_PERIOD + statsLinkRest;
+
+    statsCounters[DCBS_STATS_CONN_EVENTS] += (elapsed / period) * STATS_CONN_EVENTS_PER_PERIOD +
+            rest / period;
+    statsLinkRest = (uint16)(rest % period);
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,100 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Stats.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the energy and duty cycle accounting
+                  definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_STATS_H
+#define DSLRCAMERABLESHUTTER_STATS_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Counters
+#define DCBS_STATS_EVENTS                   0       // application task dispatches
+#define DCBS_STATS_CONN_EVENTS              1       // connection events, from the interval and time connected
+#define DCBS_STATS_ADV_EVENTS               2       // advertising events sent
+#define DCBS_STATS_NOTIFICATIONS            3       // Status and Progress updates sent
+#define DCBS_STATS_PULSES                   4       // shutter/focus line presses
+#define DCBS_STATS_COUNTERS                 5
+
+// Active time is counted in sleep timer ticks (32768 Hz)
+#define DCBS_STATS_TICK_HZ                  32768
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSStats_Begin - Note the start of a stretch of application work.
+ *
+ *    returns the sleep timer, pass it to DCBSStats_End
+ */
+extern uint32 DCBSStats_Begin( void );
+
+/*
+ * DCBSStats_End - Add the time since DCBSStats_Begin to the active time.
+ */
+extern void DCBSStats_End( uint32 begin );
+
+/*
+ * DCBSStats_Count - Add to a counter.
+ *
+ *    counter - DCBS_STATS_EVENTS ...
+ *    n - amount to add
+ */
+extern void DCBSStats_Count( uint8 counter, uint8 n );
+
+/*
+ * DCBSStats_Link - Note the connection interval from now on, for the
+ *          connection event count.
+ *
+ *    interval - connection interval (1.25 ms units), 0 when not connected
+ */
+extern void DCBSStats_Link( uint16 interval );
+
+/*
+ * DCBSStats_Ticks - Read the sleep timer, 24 bits of DCBS_STATS_TICK_HZ.
+ */
+extern uint32 DCBSStats_Ticks( void );
+
+/*
+ * DCBSStats_Read - Read part of the Stats characteristic value. A read
+ *          at offset 0 takes a new snapshot, the rest continue it.
+ *
+ *    offset - offset of the first byte
+ *    pValue - filled with the value
+ *    pLen - set to the number of bytes filled in
+ *    maxLen - room in pValue
+ *
+ *    returns SUCCESS or ATT_ERR_INVALID_OFFSET
+ */
+extern bStatus_t DCBSStats_Read( uint16 offset, uint8 *pValue, uint8 *pLen, uint8 maxLen );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_STATS_H */
@@ -0,0 +1,479 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Sync.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the shared timebase. The master (the phone)
+                  stamps a SYNC write when it sends it and when the response comes
+                  back, then tells the adaptor the midpoint in a FOLLOW_UP. Each
+                  pair is a sample of master time against the local clock; the
+                  adaptor keeps an offset and skew estimate disciplined by them, so
+                  shots scheduled in master time line up across adaptors. The
+                  wall clock the phone sets for absolute start times runs on the
+                  same estimate.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+
+#include "DSLRCameraBLEShutter_Sync.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Phase loop gain as a right shift once settled, an eighth of the phase
+// error (rounded) is taken out per sample so link jitter is averaged over
+// several
+#define SYNC_PHASE_GAIN_SHIFT               3
+
+// The reference master time carries a fraction of a ms in this many bits,
+// without it the skew over the few seconds between samples and any phase
+// correction below a ms would be rounded away at every sample
+#define SYNC_FRAC_SHIFT                     8
+#define SYNC_FRAC_MASK                      ( BV(SYNC_FRAC_SHIFT) - 1 )
+
+// Largest drift (ms) over a frequency span that can be shifted into skew
+// units in 32 bits
+#define SYNC_MAX_DRIFT                      ( 1L << (31 - DCBS_SYNC_SKEW_SHIFT) )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    uint8   valid;
+    uint8   seq;
+    uint32  local;
+} syncStamp_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static syncStamp_t syncStamps[DCBS_SYNC_STAMPS];
+static uint8  syncNextStamp = 0;
+
+static uint8  syncValid     = FALSE;
+static uint32 syncRefLocal  = 0;
+static uint32 syncRefMaster = 0;
+static uint8  syncRefFrac   = 0;
+static int16  syncSkew      = 0;
+static int16  syncLastError = 0;
+
+// Phase gain in use, starts at a half so the first samples pull the estimate
+// in quickly and halves every BV(gain) samples down to SYNC_PHASE_GAIN_SHIFT
+static uint8  syncGain      = 1;
+static uint8  syncGainCount = 0;
+
+// Frequency anchor, the skew is measured from here so link jitter is
+// divided by a long span instead of the gap between two samples
+static uint32 syncFreqLocal  = 0;
+static uint32 syncFreqMaster = 0;
+static uint8  syncFreqFrac   = 0;
+
+// Next frequency anchor, taken halfway through the span so the span never
+// falls back below half of DCBS_SYNC_FREQ_SPAN when the anchor moves
+static uint8  syncNextSet    = FALSE;
+static uint32 syncNextLocal  = 0;
+static uint32 syncNextMaster = 0;
+static uint8  syncNextFrac   = 0;
+
+// Wall clock, set from the phone and run on the local clock
+static uint8  syncWallSet    = FALSE;
+static uint32 syncWallUtc    = 0;
+static uint16 syncWallMs     = 0;
+static uint32 syncWallLocal  = 0;
+
+// Best round trip seen lately, creeps up so a slower link is followed
+static uint16 syncMinRtt    = 0xFFFF;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint32 syncEstimate( uint32 local, uint8 *pFrac );
+static int32 syncScale( int32 span );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSSync_Reset
+ *
+ * @brief   Forget the timebase and any pending SYNC.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSSync_Reset( void )
+{
+    VOID osal_memset( syncStamps, 0, sizeof ( syncStamps ) );
+    syncValid = FALSE;
+    syncSkew = 0;
+    syncLastError = 0;
+    syncMinRtt = 0xFFFF;
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_Stamp
+ *
+ * @brief   Record the local arrival time of a SYNC. The oldest stamp
+ *          is overwritten when its FOLLOW_UP never came.
+ *
+ * @param   seq - sequence number of the SYNC
+ * @param   local - local clock (ms)
+ *
+ * @return  none
+ */
+void DCBSSync_Stamp( uint8 seq, uint32 local )
+{
+    syncStamp_t *pStamp = &syncStamps[syncNextStamp];
+
+    pStamp->valid = TRUE;
+    pStamp->seq = seq;
+    pStamp->local = local;
+
+    syncNextStamp = (syncNextStamp + 1) % DCBS_SYNC_STAMPS;
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_FollowUp
+ *
+ * @brief   Pair a FOLLOW_UP with its SYNC and discipline the timebase.
+ *          The first sample sets the offset and a large error steps it.
+ *          Otherwise the phase error is slewed out over several samples
+ *          and the skew is measured from the frequency anchor to the
+ *          disciplined estimate, both kept to a fraction of a ms. The
+ *          anchor moves up every half DCBS_SYNC_FREQ_SPAN, which keeps
+ *          the arithmetic in 32 bits without the span falling back to a
+ *          few samples.
+ *
+ * @param   seq - sequence number of the SYNC
+ * @param   master - master clock (ms) when the SYNC arrived
+ * @param   rtt - round trip (ms) measured by the master
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or FAILURE
+ */
+bStatus_t DCBSSync_FollowUp( uint8 seq, uint32 master, uint16 rtt )
+{
+    uint32 local;
+    uint32 estimate;
+    uint32 span;
+    int32 error;
+    int32 adjust;
+    uint8 frac;
+    uint8 i;
+
+    for ( i = 0; i < DCBS_SYNC_STAMPS; i++ )
+    {
+        if ( syncStamps[i].valid && syncStamps[i].seq == seq )
+        {
+            break;
+        }
+    }
+
+    if ( i == DCBS_SYNC_STAMPS )
+    {
+        return ( INVALIDPARAMETER );
+    }
+
+    syncStamps[i].valid = FALSE;
+    local = syncStamps[i].local;
+
+    // Round trip filter, the best recent link delay gives the tightest midpoint
+    if ( rtt < syncMinRtt )
+    {
+        syncMinRtt = rtt;
+    }
+    else if ( syncMinRtt < 0xFFFF )
+    {
+        syncMinRtt++;
+    }
+
+    if ( rtt > syncMinRtt + DCBS_SYNC_RTT_SLACK )
+    {
+        return ( FAILURE );
+    }
+
+    if ( !syncValid )
+    {
+        syncRefLocal = syncFreqLocal = local;
+        syncRefMaster = syncFreqMaster = master;
+        syncRefFrac = syncFreqFrac = 0;
+        syncNextSet = FALSE;
+        syncGain = 1;
+        syncGainCount = 0;
+        syncLastError = 0;
+        syncValid = TRUE;
+
+        return ( SUCCESS );
+    }
+
+    estimate = syncEstimate( local, &frac );
+    error = (int32)(master - estimate);
+
+    if ( error > DCBS_SYNC_STEP_MS || error < -DCBS_SYNC_STEP_MS )
+    {
+        // Way off (master clock changed, samples missed), step and keep the skew
+        syncRefLocal = syncFreqLocal = local;
+        syncRefMaster = syncFreqMaster = master;
+        syncRefFrac = syncFreqFrac = 0;
+        syncNextSet = FALSE;
+        syncGain = 1;
+        syncGainCount = 0;
+        syncLastError = (error > 0) ? 0x7FFF : -0x7FFF;
+
+        return ( SUCCESS );
+    }
+
+    syncLastError = (int16)error;
+
+    // Phase: move the reference to this sample, taking out part of the
+    // error, both in fractions of a ms
+    adjust = (error << SYNC_FRAC_SHIFT) - (int32)frac;
+    adjust = (int32)frac + ((adjust + BV(syncGain - 1)) >> syncGain);
+    syncRefMaster = estimate + (uint32)(adjust >> SYNC_FRAC_SHIFT);
+    syncRefFrac = (uint8)(adjust & SYNC_FRAC_MASK);
+    syncRefLocal = local;
+
+    if ( syncGain < SYNC_PHASE_GAIN_SHIFT && ++syncGainCount >= BV(syncGain) )
+    {
+        syncGain++;
+        syncGainCount = 0;
+    }
+
+    // Frequency: filtered master span against local span since the anchor
+    span = local - syncFreqLocal;
+    if ( span >= DCBS_SYNC_MIN_SPAN )
+    {
+        int32 drift = (int32)(syncRefMaster - syncFreqMaster) - (int32)span;
+        int32 skew = DCBS_SYNC_MAX_SKEW;
+
+        // Anything past the clamp would also overflow the shift
+        if ( drift < SYNC_MAX_DRIFT && drift > -SYNC_MAX_DRIFT )
+        {
+            drift = (drift << SYNC_FRAC_SHIFT) + (int32)syncRefFrac - (int32)syncFreqFrac;
+            skew = (drift << (DCBS_SYNC_SKEW_SHIFT - SYNC_FRAC_SHIFT)) / (int32)span;
+        }
+        else if ( drift < 0 )
+        {
+            skew = -DCBS_SYNC_MAX_SKEW;
+        }
+
+        if ( skew > DCBS_SYNC_MAX_SKEW )
+        {
+            skew = DCBS_SYNC_MAX_SKEW;
+        }
+        else if ( skew < -DCBS_SYNC_MAX_SKEW )
+        {
+            skew = -DCBS_SYNC_MAX_SKEW;
+        }
+        syncSkew = (int16)skew;
+    }
+
+    if ( span >= DCBS_SYNC_FREQ_SPAN / 2 && !syncNextSet )
+    {
+        syncNextLocal = syncRefLocal;
+        syncNextMaster = syncRefMaster;
+        syncNextFrac = syncRefFrac;
+        syncNextSet = TRUE;
+    }
+
+    if ( span >= DCBS_SYNC_FREQ_SPAN && syncNextSet )
+    {
+        syncFreqLocal = syncNextLocal;
+        syncFreqMaster = syncNextMaster;
+        syncFreqFrac = syncNextFrac;
+        syncNextSet = FALSE;
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_Synced
+ *
+ * @brief   Check whether there is a timebase.
+ *
+ * @param   none
+ *
+ * @return  TRUE once a sample has been taken
+ */
+uint8 DCBSSync_Synced( void )
+{
+    return ( syncValid );
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_ToMaster
+ *
+ * @brief   Convert a local time to master time.
+ *
+ * @param   local - local clock (ms)
+ *
+ * @return  master clock (ms)
+ */
+uint32 DCBSSync_ToMaster( uint32 local )
+{
+    uint8 frac;
+
+    return ( syncEstimate( local, &frac ) );
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_ToLocal
+ *
+ * @brief   Convert a master time to local time. The skew is tiny, so
+ *          scaling the master span is as good as an exact inverse.
+ *
+ * @param   master - master clock (ms)
+ *
+ * @return  local clock (ms)
+ */
+uint32 DCBSSync_ToLocal( uint32 master )
+{
+    int32 span = (int32)(master - syncRefMaster);
+    int32 adjust = BV(SYNC_FRAC_SHIFT - 1) - (int32)syncRefFrac - syncScale( span );
+
+    return ( syncRefLocal + (uint32)(span + (adjust >> SYNC_FRAC_SHIFT)) );
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_SetWall
+ *
+ * @brief   Set the wall clock. It runs on the local clock, which keeps
+ *          counting through sleep, corrected by the skew estimate when
+ *          the master keeps a timebase going.
+ *
+ * @param   utc - seconds since 2000-01-01 00:00 UTC
+ * @param   ms - ms within that second
+ * @param   local - local clock (ms) it was read at
+ *
+ * @return  none
+ */
+void DCBSSync_SetWall( uint32 utc, uint16 ms, uint32 local )
+{
+    syncWallUtc = utc;
+    syncWallMs = ms;
+    syncWallLocal = local;
+    syncWallSet = TRUE;
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_WallToLocal
+ *
+ * @brief   Convert a wall clock time to local time.
+ *
+ * @param   utc - seconds since 2000-01-01 00:00 UTC
+ * @param   ms - ms within that second
+ * @param   pLocal - set to the local clock (ms)
+ *
+ * @return  SUCCESS, FAILURE or bleInvalidRange
+ */
+bStatus_t DCBSSync_WallToLocal( uint32 utc, uint16 ms, uint32 *pLocal )
+{
+    int32 seconds = (int32)(utc - syncWallUtc);
+    int32 span;
+
+    if ( !syncWallSet )
+    {
+        return ( FAILURE );
+    }
+
+    if ( seconds > (int32)DCBS_SYNC_MAX_WALL_SPAN || seconds < -(int32)DCBS_SYNC_MAX_WALL_SPAN )
+    {
+        return ( bleInvalidRange );
+    }
+
+    span = seconds * 1000 + (int32)ms - (int32)syncWallMs;
+    *pLocal = syncWallLocal +
+              (uint32)(span - ((syncScale( span ) + BV(SYNC_FRAC_SHIFT - 1)) >> SYNC_FRAC_SHIFT));
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_Skew
+ *
+ * @brief   Get the skew estimate.
+ *
+ * @param   none
+ *
+ * @return  skew in 2^-DCBS_SYNC_SKEW_SHIFT units
+ */
+int16 DCBSSync_Skew( void )
+{
+    return ( syncSkew );
+}
+
+/*********************************************************************
+ * @fn      DCBSSync_LastError
+ *
+ * @brief   Get the phase error of the last sample used, saturated to
+ *          0x7FFF when it caused a step.
+ *
+ * @param   none
+ *
+ * @return  error in ms, master minus local estimate
+ */
+int16 DCBSSync_LastError( void )
+{
+    return ( syncLastError );
+}
+
+/*********************************************************************
+ * @fn      syncEstimate
+ *
+ * @brief   Convert a local time to master time, keeping the fraction.
+ *
+ * @param   local - local clock (ms)
+ * @param   pFrac - set to the fraction of a ms, 2^-SYNC_FRAC_SHIFT units
+ *
+ * @return  master clock (ms), rounded down
+ */
+static uint32 syncEstimate( uint32 local, uint8 *pFrac )
+{
+    int32 span = (int32)(local - syncRefLocal);
+    int32 adjust = (int32)syncRefFrac + syncScale( span );
+
+    *pFrac = (uint8)(adjust & SYNC_FRAC_MASK);
+
+    return ( syncRefMaster + (uint32)(span + (adjust >> SYNC_FRAC_SHIFT)) );
+}
+
+/*********************************************************************
+ * @fn      syncScale
+ *
+ * @brief   Scale a span by the skew without overflowing 32 bits. The
+ *          span is split at bit 11 so both products stay below 2^31
+ *          for any span and skews up to DCBS_SYNC_MAX_SKEW, and the
+ *          result is rounded to a fraction of a ms rather than
+ *          truncated.
+ *
+ * @param   span - ms
+ *
+ * @return  span * skew / 2^DCBS_SYNC_SKEW_SHIFT, 2^-SYNC_FRAC_SHIFT ms units
+ */
+static int32 syncScale( int32 span )
+{
+    uint32 magnitude = (span < 0) ? (uint32)(-span) : (uint32)span;
+    uint16 skew = (syncSkew < 0) ? (uint16)(-syncSkew) : (uint16)syncSkew;
+    uint32 scaled;
+
+    // In units of 2^11 first, then down the remaining shift with rounding
+    scaled = (magnitude >> 11) * skew + (((magnitude & 0x7FF) * skew) >> 11);
+    scaled = (scaled + BV(DCBS_SYNC_SKEW_SHIFT - SYNC_FRAC_SHIFT - 12)) >>
+             (DCBS_SYNC_SKEW_SHIFT - SYNC_FRAC_SHIFT - 11);
+
+    return ( ((span < 0) != (syncSkew < 0)) ? -(int32)scaled : (int32)scaled );
+}
+
+/*********************************************************************
+ *********************************************************************/
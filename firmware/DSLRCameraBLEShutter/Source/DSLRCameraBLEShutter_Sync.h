@@ -0,0 +1,141 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Sync.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the shared timebase (clock sync) and wall
+                  clock definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_SYNC_H
+#define DSLRCAMERABLESHUTTER_SYNC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Skew is master ms per local ms minus one, in units of 2^-20 (about 0.95 ppm)
+#define DCBS_SYNC_SKEW_SHIFT                20
+
+// Largest skew the loop will follow, 500 ppm in 2^-20 units
+#define DCBS_SYNC_MAX_SKEW                  524
+
+// A phase error (ms) above this steps the clock instead of slewing it
+#define DCBS_SYNC_STEP_MS                   50
+
+// Span (ms) from the frequency anchor before the skew is measured, and
+// after which the anchor moves up to the estimate taken halfway through
+#define DCBS_SYNC_MIN_SPAN                  60000
+#define DCBS_SYNC_FREQ_SPAN                 600000
+
+// Samples whose round trip is more than this (ms) above the best recent
+// one are dropped, their midpoint is too uncertain
+#define DCBS_SYNC_RTT_SLACK                 10
+
+// SYNC arrivals remembered while waiting for their FOLLOW_UP
+#define DCBS_SYNC_STAMPS                    4
+
+// Furthest a wall clock time (s) can be from the last set and still be
+// converted, keeps the span in ms within 31 bits
+#define DCBS_SYNC_MAX_WALL_SPAN             2000000UL
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSSync_Reset - Forget the timebase.
+ */
+extern void DCBSSync_Reset( void );
+
+/*
+ * DCBSSync_Stamp - Record the local arrival time of a SYNC.
+ *
+ *    seq - sequence number of the SYNC
+ *    local - local clock (ms) when it arrived
+ */
+extern void DCBSSync_Stamp( uint8 seq, uint32 local );
+
+/*
+ * DCBSSync_FollowUp - Discipline the timebase with the master time of
+ *          an earlier SYNC.
+ *
+ *    seq - sequence number of the SYNC
+ *    master - master clock (ms) when the SYNC arrived
+ *    rtt - round trip (ms) the master measured for it
+ *
+ *    returns SUCCESS when the sample was used, INVALIDPARAMETER when the
+ *    SYNC is unknown and FAILURE when the sample was filtered out
+ */
+extern bStatus_t DCBSSync_FollowUp( uint8 seq, uint32 master, uint16 rtt );
+
+/*
+ * DCBSSync_Synced - TRUE once a sample has been taken.
+ */
+extern uint8 DCBSSync_Synced( void );
+
+/*
+ * DCBSSync_ToMaster - Convert a local time to master time.
+ */
+extern uint32 DCBSSync_ToMaster( uint32 local );
+
+/*
+ * DCBSSync_ToLocal - Convert a master time to local time.
+ */
+extern uint32 DCBSSync_ToLocal( uint32 master );
+
+/*
+ * DCBSSync_SetWall - Set the wall clock.
+ *
+ *    utc - seconds since 2000-01-01 00:00 UTC (OSAL UTCTime)
+ *    ms - ms within that second
+ *    local - local clock (ms) it was read at
+ */
+extern void DCBSSync_SetWall( uint32 utc, uint16 ms, uint32 local );
+
+/*
+ * DCBSSync_WallToLocal - Convert a wall clock time to local time, with the
+ *          skew applied when there is a timebase.
+ *
+ *    utc - seconds since 2000-01-01 00:00 UTC
+ *    ms - ms within that second
+ *    pLocal - set to the local clock (ms)
+ *
+ *    returns SUCCESS, FAILURE before the wall clock is set or
+ *    bleInvalidRange more than DCBS_SYNC_MAX_WALL_SPAN s away
+ */
+extern bStatus_t DCBSSync_WallToLocal( uint32 utc, uint16 ms, uint32 *pLocal );
+
+/*
+ * DCBSSync_Skew - Current skew estimate, DCBS_SYNC_SKEW_SHIFT units.
+ */
+extern int16 DCBSSync_Skew( void );
+
+/*
+ * DCBSSync_LastError - Phase error (ms) of the last sample used.
+ */
+extern int16 DCBSSync_LastError( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_SYNC_H */
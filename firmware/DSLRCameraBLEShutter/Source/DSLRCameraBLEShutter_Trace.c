@@ -0,0 +1,234 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Trace.c
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the event trace. The task stamps every event
+                  it handles, every characteristic write and every line change
+                  into a fixed ring in RAM, so a late shot can be read back with
+                  what held it up. Entries are stamped with the sleep timer, the
+                  clock that keeps running in PM2, at 30.5us resolution.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "att.h"
+
+#include "DSLRCameraBLEShutter_Trace.h"
+#include "DSLRCameraBLEShutter_Stats.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// One step of the 24 bit sleep timer
+#define TRACE_TICK_WRAP                     0x01000000UL
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+    uint32  time;
+    uint8   type;
+    uint8   arg;
+    uint16  data;
+} traceEntry_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static traceEntry_t traceRing[DCBS_TRACE_ENTRIES];
+static uint8  traceNext = 0;
+static uint8  traceCount = 0;
+static uint16 traceDropped = 0;
+
+// Held while a dump is read, so its entries don't move under the reader
+static uint8  traceHeld = FALSE;
+
+// Sleep timer extended to 32 bits, a wrap is missed only if nothing at
+// all is recorded for the 512s the timer takes to go round
+static uint32 traceHigh = 0;
+static uint32 traceLast = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 traceByte( uint16 offset );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      DCBSTrace_Record
+ *
+ * @brief   Add an entry, overwriting the oldest when the ring is full.
+ *
+ * @param   type - DCBS_TRACE_EVENT ...
+ * @param   arg - depends on the type
+ * @param   data - depends on the type
+ *
+ * @return  none
+ */
+void DCBSTrace_Record( uint8 type, uint8 arg, uint16 data )
+{
+    traceEntry_t *pEntry;
+    uint32 ticks;
+
+    if ( traceHeld )
+    {
+        if ( traceDropped < 0xFFFF )
+        {
+            traceDropped++;
+        }
+        return;
+    }
+
+    ticks = DCBSStats_Ticks();
+    if ( ticks < traceLast )
+    {
+        traceHigh += TRACE_TICK_WRAP;
+    }
+    traceLast = ticks;
+
+    pEntry = &traceRing[traceNext];
+    pEntry->time = traceHigh | ticks;
+    pEntry->type = type;
+    pEntry->arg = arg;
+    pEntry->data = data;
+
+    traceNext = (traceNext + 1) % DCBS_TRACE_ENTRIES;
+    if ( traceCount < DCBS_TRACE_ENTRIES )
+    {
+        traceCount++;
+    }
+}
+
+/*********************************************************************
+ * @fn      DCBSTrace_Read
+ *
+ * @brief   Read part of the dump. The dump is longer than one ATT_MTU,
+ *          so a read at offset 0 holds the trace and the Read Blobs
+ *          after it walk through the same entries; recording goes on
+ *          once the last byte is out.
+ *
+ * @param   offset - offset of the first byte
+ * @param   pValue - filled with the dump
+ * @param   pLen - set to the number of bytes filled in
+ * @param   maxLen - room in pValue
+ *
+ * @return  SUCCESS or ATT_ERR_INVALID_OFFSET
+ */
+bStatus_t DCBSTrace_Read( uint16 offset, uint8 *pValue, uint8 *pLen, uint8 maxLen )
+{
+    uint16 len = DCBS_TRACE_HDR_LEN + (uint16)traceCount * DCBS_TRACE_ENTRY_LEN;
+    uint8 i;
+
+    if ( offset == 0 )
+    {
+        traceHeld = TRUE;
+    }
+
+    if ( offset > len )
+    {
+        *pLen = 0;
+        return ( ATT_ERR_INVALID_OFFSET );
+    }
+
+    *pLen = (uint8)MIN( maxLen, len - offset );
+    for ( i = 0; i < *pLen; i++ )
+    {
+        pValue[i] = traceByte( offset + i );
+    }
+
+    if ( offset + *pLen >= len )
+    {
+        traceHeld = FALSE;
+    }
+
+    return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      DCBSTrace_Resume
+ *
+ * @brief   Start recording again after a dump that was not read to the
+ *          end, the reader having gone away.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void DCBSTrace_Resume( void )
+{
+    traceHeld = FALSE;
+}
+
+/*********************************************************************
+ * @fn      traceByte
+ *
+ * @brief   Get one byte of the dump, entries oldest first and fields
+ *          little endian.
+ *
+ * @param   offset - offset in the dump
+ *
+ * @return  the byte
+ */
+static uint8 traceByte( uint16 offset )
+{
+    traceEntry_t *pEntry;
+    uint8 index;
+
+    if ( offset < DCBS_TRACE_HDR_LEN )
+    {
+        switch ( offset )
+        {
+            case 0:
+                return ( traceCount );
+
+            case 1:
+                return ( DCBS_TRACE_ENTRY_LEN );
+
+            case 2:
+                return ( LO_UINT16( traceDropped ) );
+
+            default:
+                return ( HI_UINT16( traceDropped ) );
+        }
+    }
+
+    offset -= DCBS_TRACE_HDR_LEN;
+    index = (uint8)(offset / DCBS_TRACE_ENTRY_LEN);
+    pEntry = &traceRing[(traceNext + DCBS_TRACE_ENTRIES - traceCount + index) % DCBS_TRACE_ENTRIES];
+
+    switch ( offset % DCBS_TRACE_ENTRY_LEN )
+    {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            return ( BREAK_UINT32( pEntry->time, offset % DCBS_TRACE_ENTRY_LEN ) );
+
+        case 4:
+            return ( pEntry->type );
+
+        case 5:
+            return ( pEntry->arg );
+
+        case 6:
+            return ( LO_UINT16( pEntry->data ) );
+
+        default:
+            return ( HI_UINT16( pEntry->data ) );
+    }
+}
+
+/*********************************************************************
+ *********************************************************************/
@@ -0,0 +1,89 @@
+/**************************************************************************************************
+  Filename:       DSLRCameraBLEShutter_Trace.h
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    This file contains the event trace definitions and prototypes.
+**************************************************************************************************/
+
+#ifndef DSLRCAMERABLESHUTTER_TRACE_H
+#define DSLRCAMERABLESHUTTER_TRACE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Entries kept, the oldest is overwritten. The whole dump must fit the
+// 512 byte ATT value limit.
+#ifndef DCBS_TRACE_ENTRIES
+#define DCBS_TRACE_ENTRIES                  48
+#endif
+
+// Dump is count(1), entry length(1), dropped(2), then count entries oldest
+// first, each time(4, sleep timer ticks) type(1) arg(1) data(2)
+#define DCBS_TRACE_HDR_LEN                  4
+#define DCBS_TRACE_ENTRY_LEN                8
+#define DCBS_TRACE_MAX_LEN                  ( DCBS_TRACE_HDR_LEN + DCBS_TRACE_ENTRIES * DCBS_TRACE_ENTRY_LEN )
+
+// Entry types
+#define DCBS_TRACE_EVENT                    0x01    // task called, data: events passed in
+#define DCBS_TRACE_EVENT_DONE               0x02    // task returned, data: events left
+#define DCBS_TRACE_WRITE                    0x03    // characteristic write, arg: parameter ID
+#define DCBS_TRACE_WRITE_DONE               0x04    // write handled, arg: parameter ID
+#define DCBS_TRACE_LINES                    0x05    // line change, arg: pressed, data: port 0 lines
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * DCBSTrace_Record - Add an entry, stamped with the sleep timer.
+ *
+ *    type - DCBS_TRACE_EVENT ...
+ *    arg - depends on the type
+ *    data - depends on the type
+ */
+extern void DCBSTrace_Record( uint8 type, uint8 arg, uint16 data );
+
+/*
+ * DCBSTrace_Read - Read part of the dump. A read at offset 0 holds the
+ *          trace until the last byte has been read.
+ *
+ *    offset - offset of the first byte
+ *    pValue - filled with the dump
+ *    pLen - set to the number of bytes filled in
+ *    maxLen - room in pValue
+ *
+ *    returns SUCCESS or ATT_ERR_INVALID_OFFSET
+ */
+extern bStatus_t DCBSTrace_Read( uint16 offset, uint8 *pValue, uint8 *pLen, uint8 maxLen );
+
+/*
+ * DCBSTrace_Resume - Start recording again after a dump that was not
+ *          read to the end.
+ */
+extern void DCBSTrace_Resume( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DSLRCAMERABLESHUTTER_TRACE_H */
@@ -0,0 +1,110 @@
+"""
+  Filename:       dcbs_trace.py
+  Author:         Joe Shang <shangchuanren@gmail.com>
+  Description:    Decodes a dump of the Trace characteristic (0xFFFF) into a
+                  timeline. Each task call is shown with how long it ran and
+                  the gap since the previous one, so a late frame can be traced
+                  back to a busy task, a slow write or a stack that held the
+                  task off.
+
+  Usage:          python dcbs_trace.py DUMP
+
+                  DUMP is the value read from the characteristic, as hex text
+                  (spaces, colons and 0x prefixes are ignored) or, with -b, as
+                  a binary file.
+"""
+
+import struct
+import sys
+
+TICK_US = 1000000.0 / 32768
+
+EVENTS = [
+    (0x8000, 'SYS_EVENT_MSG'),
+    (0x0001, 'START_DEVICE'),
+    (0x0002, 'FOCUS_RELEASE'),
+    (0x0004, 'SHOOTING'),
+    (0x0008, 'PULSE_DONE'),
+    (0x0010, 'PROGRAM'),
+    (0x0020, 'LINK_IDLE'),
+    (0x0040, 'STATUS'),
+    (0x0200, 'ADV_EVENT'),
+    (0x0400, 'LOG'),
+    (0x0800, 'QUEUE'),
+]
+
+PARAMS = {
+    1: 'Focus', 2: 'Shooting', 3: 'Stop', 4: 'Progress', 5: 'Program',
+    6: 'Upload', 7: 'Status', 8: 'Rate', 9: 'Timing',
+    11: 'Sync', 12: 'Time', 13: 'Power', 14: 'Stats', 15: 'Trace', 16: 'Command',
+}
+
+TRACE_EVENT, TRACE_EVENT_DONE, TRACE_WRITE, TRACE_WRITE_DONE, TRACE_LINES = range(1, 6)
+
+
+def events_str(mask):
+    names = [name for bit, name in EVENTS if mask & bit]
+    rest = mask & ~sum(bit for bit, _ in EVENTS)
+    if rest:
+        names.append('0x%04X' % rest)
+    return '|'.join(names) or '-'
+
+
+def parse(dump):
+    count, entry_len, dropped = struct.unpack_from('<BBH', dump, 0)
+    entries = []
+    for i in range(count):
+        time, kind, arg, data = struct.unpack_from('<IBBH', dump, 4 + i * entry_len)
+        entries.append((time, kind, arg, data))
+    return entries, dropped
+
+
+def timeline(entries):
+    lines = []
+    start = None
+    last_end = None
+    for time, kind, arg, data in entries:
+        us = (time - entries[0][0]) * TICK_US
+        if kind == TRACE_EVENT:
+            gap = '' if last_end is None else '  (+%.0fus idle)' % ((time - last_end) * TICK_US)
+            lines.append('%12.0f  event   %s%s' % (us, events_str(data), gap))
+            start = time
+        elif kind == TRACE_EVENT_DONE:
+            ran = '' if start is None else '%.0fus' % ((time - start) * TICK_US)
+            lines.append('%12.0f  done    %s, left %s' % (us, ran, events_str(data)))
+            last_end = time
+            start = None
+        elif kind == TRACE_WRITE:
+            lines.append('%12.0f  write   %s' % (us, PARAMS.get(arg, arg)))
+            start = time
+        elif kind == TRACE_WRITE_DONE:
+            ran = '' if start is None else '%.0fus' % ((time - start) * TICK_US)
+            lines.append('%12.0f  written %s %s' % (us, PARAMS.get(arg, arg), ran))
+            last_end = time
+            start = None
+        elif kind == TRACE_LINES:
+            lines.append('%12.0f  lines   P0 0x%02X %s' % (us, data, 'pressed' if arg else 'released'))
+        else:
+            lines.append('%12.0f  type %d arg %d data 0x%04X' % (us, kind, arg, data))
+    return lines
+
+
+def main(argv):
+    if len(argv) == 3 and argv[1] == '-b':
+        dump = open(argv[2], 'rb').read()
+    elif len(argv) == 2:
+        text = open(argv[1]).read().replace('0x', '')
+        dump = bytearray.fromhex(''.join(c for c in text if c in '0123456789abcdefABCDEF'))
+    else:
+        sys.stderr.write(__doc__)
+        return 1
+
+    entries, dropped = parse(bytes(dump))
+    print('%d entries, %d dropped during earlier dumps' % (len(entries), dropped))
+    for line in timeline(entries):
+        print(line)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
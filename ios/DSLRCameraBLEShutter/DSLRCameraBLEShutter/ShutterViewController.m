@@ -13,6 +13,14 @@
 #define kBLEShutterShootingUUID             @"FFF2"
 #define kBLEShutterStopUUID                 @"FFF3"
 #define kBLEShutterProgressUUID             @"FFF4"
+#define kBLEShutterCommandUUID              @"FFEF"
+
+#define kBLEShutterShootingOptionAnchored   0x01
+
+#define kBLEShutterCommandFocus             0x01
+#define kBLEShutterCommandShoot             0x02
+#define kBLEShutterCommandStop              0x03
+#define kBLEShutterCommandRepeat            0x80
 
 typedef struct
 {
@@ -26,6 +34,7 @@ typedef struct
 @property (nonatomic, assign) DCBSTimeUnit delay;
 @property (nonatomic, assign) DCBSTimeUnit interval;
 @property (nonatomic, assign) DCBSTimeUnit exposure;
+@property (nonatomic, assign) u_int8_t commandSeq;
 
 - (void)focus;
 - (void)shootingWithCount:(int)count
@@ -33,6 +42,8 @@ typedef struct
                  interval:(int)interval
                  exposure:(int)exposure;
 - (void)stop;
+- (BOOL)sendCommand:(u_int8_t)op params:(const void *)params length:(int)length;
+- (CBCharacteristic *)characteristicForUUID:(CBUUID *)uuid;
 
 @end
 
@@ -196,6 +207,10 @@ typedef struct
     if (self.peripheral)
     {
         u_int8_t focus = 1;
+        if ([self sendCommand:kBLEShutterCommandFocus params:&focus length:1])
+        {
+            return;
+        }
         [self writeValue:[NSData dataWithBytes:&focus length:1]
                  forUUID:[CBUUID UUIDWithString:kBLEShutterFocusUUID]];
     }
@@ -218,8 +233,12 @@ typedef struct
         index += 4;
         memcpy(command + index, &interval, 4);
         index += 4;
-        command[index] = 0;
+        command[index] = kBLEShutterShootingOptionAnchored;
         
+        if ([self sendCommand:kBLEShutterCommandShoot params:command length:15])
+        {
+            return;
+        }
         [self writeValue:[NSData dataWithBytes:command length:15]
                  forUUID:[CBUUID UUIDWithString:kBLEShutterShootingUUID]];
     }
@@ -230,19 +249,38 @@ typedef struct
     if (self.peripheral)
     {
         u_int8_t stop = 1;
+        if ([self sendCommand:kBLEShutterCommandStop params:&stop length:1])
+        {
+            return;
+        }
         [self writeValue:[NSData dataWithBytes:&stop length:1]
                  forUUID:[CBUUID UUIDWithString:kBLEShutterStopUUID]];
     }
 }
 
-- (void)writeValue:(NSData *)data forUUID:(CBUUID *)uuid
+// Send through the Command characteristic when the shutter has it. It is
+// written without response, the result comes back in a notification.
+- (BOOL)sendCommand:(u_int8_t)op params:(const void *)params length:(int)length
 {
-    if (!self.peripheral)
+    CBCharacteristic *target = [self characteristicForUUID:[CBUUID UUIDWithString:kBLEShutterCommandUUID]];
+    if (!target)
     {
-        return;
+        return NO;
     }
     
-    CBCharacteristic *target = nil;
+    NSMutableData *data = [NSMutableData dataWithCapacity:length + 2];
+    u_int8_t header[2] = { ++self.commandSeq, op };
+    [data appendBytes:header length:2];
+    [data appendBytes:params length:length];
+    
+    [self.peripheral writeValue:data
+              forCharacteristic:target
+                           type:CBCharacteristicWriteWithoutResponse];
+    return YES;
+}
+
+- (CBCharacteristic *)characteristicForUUID:(CBUUID *)uuid
+{
     for (CBService *service in self.peripheral.services)
     {
         if ([service.UUID isEqual:[CBUUID UUIDWithString:kBLEShutterServiceUUID]])
@@ -251,13 +289,23 @@ typedef struct
             {
                 if ([characteristic.UUID isEqual:uuid])
                 {
-                    target = characteristic;
-                    break;
+                    return characteristic;
                 }
             }
         }
     }
     
+    return nil;
+}
+
+- (void)writeValue:(NSData *)data forUUID:(CBUUID *)uuid
+{
+    if (!self.peripheral)
+    {
+        return;
+    }
+    
+    CBCharacteristic *target = [self characteristicForUUID:uuid];
     if (target)
     {
         if(target.properties & CBCharacteristicPropertyWriteWithoutResponse)
@@ -383,7 +431,8 @@ didDiscoverCharacteristicsForService:(CBService *)service
     {
         for (CBCharacteristic *characteristic in service.characteristics)
         {
-            if ([characteristic.UUID isEqual:[CBUUID UUIDWithString:kBLEShutterProgressUUID]])
+            if ([characteristic.UUID isEqual:[CBUUID UUIDWithString:kBLEShutterProgressUUID]] ||
+                [characteristic.UUID isEqual:[CBUUID UUIDWithString:kBLEShutterCommandUUID]])
             {
                 [peripheral setNotifyValue:YES forCharacteristic:characteristic];
             }
@@ -407,6 +456,15 @@ didUpdateValueForCharacteristic:(CBCharacteristic *)characteristic
             
             NSLog(@"progress = %d", progress);
         }
+        else if ([characteristic.UUID isEqual:[CBUUID UUIDWithString:kBLEShutterCommandUUID]] &&
+                 characteristic.value.length >= 3)
+        {
+            const u_int8_t *data = [characteristic.value bytes];
+            
+            NSLog(@"command %d op %d result %d%@", data[0], data[1],
+                  data[2] & ~kBLEShutterCommandRepeat,
+                  (data[2] & kBLEShutterCommandRepeat) ? @" (repeat)" : @"");
+        }
     }
     else
     {